@@ -11,11 +11,30 @@
 
 static const char *TAG = "adaptive_pid";
 
+// Идентификация: RLS с забыванием, кандидаты задержки 0..ADAPTIVE_PID_ID_DELAYS-1 тактов
+#define ID_FORGETTING           0.98f   // Фактор забывания RLS
+#define ID_COST_DECAY           0.9f    // Сглаживание ошибки предсказания
+#define ID_P0                   100.0f  // Начальная ковариация
+#define ID_P_MAX                1.0e6f  // Сброс ковариации при разгоне
+#define ID_TAIL_TICKS           6       // Тактов после задержки, пока отклик дозы учитывается
+#define ID_MIN_UPDATES          8
+#define ID_MIN_DOSES            2
+#define ID_A_MAX                0.98f   // τ не больше ~50 тактов
+#define ID_NO_DOSE              0xFF
+
 // Вспомогательные функции
 static pid_zone_t determine_zone(const adaptive_pid_t *pid, float error);
 static void apply_anti_windup(adaptive_pid_t *pid, float output);
 static void adapt_coefficients(adaptive_pid_t *pid, float error, float output);
 static bool check_safety_interval(const adaptive_pid_t *pid);
+static esp_err_t compute_output(adaptive_pid_t *pid, float current, float dt, float *output);
+static void ident_reset(pid_ident_t *id);
+static void ident_restart(pid_ident_t *id);
+static void ident_step(adaptive_pid_t *pid, float current, float dt, float dose);
+static void tune_from_model(adaptive_pid_t *pid);
+static bool smith_model(const adaptive_pid_t *pid, float *gain, float *tau, float *theta);
+static float smith_update(adaptive_pid_t *pid);
+static void smith_add_dose(adaptive_pid_t *pid, float dose);
 
 esp_err_t adaptive_pid_init(adaptive_pid_t *pid, float setpoint,
                             float kp_close, float ki_close, float kd_close) {
@@ -59,6 +78,11 @@ esp_err_t adaptive_pid_init(adaptive_pid_t *pid, float setpoint,
     pid->auto_tune_enabled = true;
     pid->adaptation_rate = 0.05f;  // 5% за итерацию
     
+    // Идентификация объекта
+    pid->ident.enabled = true;
+    pid->ident.lambda_factor = 1.5f;
+    ident_reset(&pid->ident);
+    
     // Флаги
     pid->enabled = true;
     pid->emergency_stop = false;
@@ -180,6 +204,20 @@ esp_err_t adaptive_pid_compute(adaptive_pid_t *pid, float current, float dt, flo
         return ESP_ERR_INVALID_ARG;
     }
     
+    // Предиктор Смита: PID видит и дозы, которые датчик ещё не видит
+    float predicted = current + smith_update(pid);
+    
+    esp_err_t err = compute_output(pid, predicted, dt, output);
+    smith_add_dose(pid, *output);
+    
+    // Отклик на дозы наблюдается на каждом вызове, в том числе в мёртвой
+    // зоне и внутри safety интервала; модель строится по измеренному значению
+    ident_step(pid, current, dt, *output);
+    
+    return err;
+}
+
+static esp_err_t compute_output(adaptive_pid_t *pid, float current, float dt, float *output) {
     // Проверка safety интервала
     if (!check_safety_interval(pid)) {
         ESP_LOGD(TAG, "Safety interval not elapsed");
@@ -289,8 +327,9 @@ esp_err_t adaptive_pid_compute(adaptive_pid_t *pid, float current, float dt, flo
     // Скользящее среднее ошибки
     pid->stats.avg_error = (pid->stats.avg_error * 0.9f) + (fabsf(error) * 0.1f);
     
-    // Адаптация коэффициентов (если включена)
-    if (pid->auto_tune_enabled && raw_output > 0.0f) {
+    // Адаптация коэффициентов (если включена): эвристика - только пока
+    // модель объекта не идентифицирована
+    if (pid->auto_tune_enabled && raw_output > 0.0f && !pid->ident.model.ready) {
         adapt_coefficients(pid, error, raw_output);
     }
     
@@ -334,6 +373,85 @@ esp_err_t adaptive_pid_set_auto_tune(adaptive_pid_t *pid, bool enable, float ada
     return ESP_OK;
 }
 
+esp_err_t adaptive_pid_set_identification(adaptive_pid_t *pid, bool enable, float lambda_factor) {
+    if (!pid) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (lambda_factor < 0.5f || lambda_factor > 5.0f) {
+        ESP_LOGW(TAG, "Invalid lambda factor: %.2f (must be 0.5-5.0)", lambda_factor);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // Выключение сбрасывает модель - автоподстройка возвращается к эвристике
+    if (!enable) {
+        ident_reset(&pid->ident);
+    }
+    pid->ident.enabled = enable;
+    pid->ident.lambda_factor = lambda_factor;
+    
+    if (enable && pid->ident.model.ready && pid->auto_tune_enabled) {
+        tune_from_model(pid);
+    }
+    
+    ESP_LOGI(TAG, "Identification %s (lambda=%.2f)", enable ? "enabled" : "disabled", lambda_factor);
+    
+    return ESP_OK;
+}
+
+float adaptive_pid_ki_from_ti(const adaptive_pid_t *pid, float kp, float ti_s, float dt) {
+    if (!pid || ti_s <= 0.0f || dt <= 0.0f) {
+        return 0.0f;
+    }
+    
+    float ts_ctrl = pid->min_interval_ms / 1000.0f;
+    if (ts_ctrl < dt) {
+        ts_ctrl = dt;
+    }
+    return kp * ts_ctrl / (ti_s * dt);
+}
+
+const pid_model_t* adaptive_pid_get_model(const adaptive_pid_t *pid) {
+    return pid ? &pid->ident.model : NULL;
+}
+
+esp_err_t adaptive_pid_reset_model(adaptive_pid_t *pid) {
+    if (!pid) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    ident_reset(&pid->ident);
+    
+    ESP_LOGI(TAG, "Plant model reset");
+    
+    return ESP_OK;
+}
+
+esp_err_t adaptive_pid_set_smith_predictor(adaptive_pid_t *pid, bool enable, float gain,
+                                           float time_constant_s, float dead_time_s) {
+    if (!pid) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (gain < 0.0f || time_constant_s < 0.0f ||
+        dead_time_s < 0.0f || dead_time_s > ADAPTIVE_PID_SMITH_MAX_DEAD_S) {
+        ESP_LOGW(TAG, "Invalid Smith predictor params: K=%.3f, tau=%.1f, dead=%.1f",
+                 gain, time_constant_s, dead_time_s);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(&pid->smith, 0, sizeof(pid_smith_t));
+    pid->smith.enabled = enable;
+    pid->smith.gain = gain;
+    pid->smith.time_constant_s = time_constant_s;
+    pid->smith.dead_time_s = dead_time_s;
+    
+    ESP_LOGI(TAG, "Smith predictor %s (K=%.3f, tau=%.0f s, dead=%.0f s, 0 = identified)",
+             enable ? "enabled" : "disabled", gain, time_constant_s, dead_time_s);
+    
+    return ESP_OK;
+}
+
 esp_err_t adaptive_pid_emergency_stop(adaptive_pid_t *pid) {
     if (!pid) {
         return ESP_ERR_INVALID_ARG;
@@ -448,6 +566,313 @@ static void adapt_coefficients(adaptive_pid_t *pid, float error, float output) {
     }
 }
 
+// ============================================================================
+// ИДЕНТИФИКАЦИЯ ОБЪЕКТА
+// ============================================================================
+//
+// Доза u (мл) действует на значение как звено первого порядка с задержкой:
+// итоговое изменение K·u, постоянная смешивания τ, задержка θ. На такте Ts
+// приращения значения Δy подчиняются
+//
+//     Δy[k] = a·Δy[k-1] + b·u[k-1-d],   a = exp(-Ts/τ), b = K·(1 - a)
+//
+// Для каждого кандидата задержки d (0..ADAPTIVE_PID_ID_DELAYS-1 тактов)
+// ведётся своя RLS оценка [a, b]; задержкой считается кандидат с наименьшей
+// сглаженной ошибкой предсказания. Оценки обновляются только в окне отклика
+// после дозы: без возбуждения RLS с забыванием разгоняет ковариацию.
+
+static void ident_restart(pid_ident_t *id) {
+    memset(id->u_hist, 0, sizeof(id->u_hist));
+    id->u_bin = 0.0f;
+    id->elapsed_s = 0.0f;
+    id->primed = 0;
+    id->since_dose = ID_NO_DOSE;
+}
+
+static void ident_reset(pid_ident_t *id) {
+    for (int d = 0; d < ADAPTIVE_PID_ID_DELAYS; d++) {
+        pid_rls_t *rls = &id->rls[d];
+        rls->theta[0] = 0.5f;
+        rls->theta[1] = 0.0f;
+        rls->P[0][0] = ID_P0;
+        rls->P[0][1] = 0.0f;
+        rls->P[1][0] = 0.0f;
+        rls->P[1][1] = ID_P0;
+        rls->cost = 0.0f;
+    }
+    memset(&id->model, 0, sizeof(id->model));
+    id->best_delay = 0;
+    id->dy_prev = 0.0f;
+    id->y_prev = 0.0f;
+    id->last_call_us = 0;
+    ident_restart(id);
+}
+
+static void rls_update(pid_rls_t *rls, float phi0, float phi1, float y) {
+    float pphi0 = rls->P[0][0] * phi0 + rls->P[0][1] * phi1;
+    float pphi1 = rls->P[1][0] * phi0 + rls->P[1][1] * phi1;
+    float denom = ID_FORGETTING + phi0 * pphi0 + phi1 * pphi1;
+    float k0 = pphi0 / denom;
+    float k1 = pphi1 / denom;
+    
+    // Ошибка априорного предсказания - мера качества кандидата задержки
+    float err = y - (rls->theta[0] * phi0 + rls->theta[1] * phi1);
+    rls->cost = rls->cost * ID_COST_DECAY + err * err;
+    
+    rls->theta[0] += k0 * err;
+    rls->theta[1] += k1 * err;
+    
+    // P = (P - k·(P·phi)ᵀ) / λ, симметрично
+    float p00 = (rls->P[0][0] - k0 * pphi0) / ID_FORGETTING;
+    float p01 = (rls->P[0][1] - k0 * pphi1) / ID_FORGETTING;
+    float p11 = (rls->P[1][1] - k1 * pphi1) / ID_FORGETTING;
+    if (p00 > ID_P_MAX || p11 > ID_P_MAX) {
+        p00 = ID_P0;
+        p01 = 0.0f;
+        p11 = ID_P0;
+    }
+    rls->P[0][0] = p00;
+    rls->P[0][1] = p01;
+    rls->P[1][0] = p01;
+    rls->P[1][1] = p11;
+}
+
+static void ident_update_model(adaptive_pid_t *pid) {
+    pid_ident_t *id = &pid->ident;
+    
+    int best = -1;
+    for (int d = 0; d < ADAPTIVE_PID_ID_DELAYS; d++) {
+        const pid_rls_t *rls = &id->rls[d];
+        if (rls->theta[0] < 0.0f || rls->theta[0] >= ID_A_MAX || rls->theta[1] <= 0.0f) {
+            continue;
+        }
+        if (best < 0 || rls->cost < id->rls[best].cost) {
+            best = d;
+        }
+    }
+    
+    if (best < 0 || id->model.updates < ID_MIN_UPDATES || id->model.doses < ID_MIN_DOSES) {
+        return;
+    }
+    
+    float a = id->rls[best].theta[0];
+    float b = id->rls[best].theta[1];
+    id->best_delay = (uint8_t)best;
+    id->model.gain = b / (1.0f - a);
+    id->model.time_constant_s = (a > 1e-3f) ? -id->ts_s / logf(a) : 0.0f;
+    id->model.dead_time_s = best * id->ts_s;
+    
+    if (!id->model.ready) {
+        id->model.ready = true;
+        ESP_LOGI(TAG, "Plant model identified: K=%.4f/ml, tau=%.0f s, dead time=%.0f s",
+                 id->model.gain, id->model.time_constant_s, id->model.dead_time_s);
+    } else {
+        ESP_LOGD(TAG, "Plant model: K=%.4f/ml, tau=%.0f s, dead time=%.0f s",
+                 id->model.gain, id->model.time_constant_s, id->model.dead_time_s);
+    }
+    
+    if (pid->auto_tune_enabled) {
+        tune_from_model(pid);
+    }
+}
+
+static void ident_tick(adaptive_pid_t *pid, float current) {
+    pid_ident_t *id = &pid->ident;
+    
+    float dy = current - id->y_prev;
+    id->y_prev = current;
+    
+    // u_hist[0] - дозы только что закончившегося такта (u[k-1])
+    for (int d = ADAPTIVE_PID_ID_DELAYS - 1; d > 0; d--) {
+        id->u_hist[d] = id->u_hist[d - 1];
+    }
+    id->u_hist[0] = id->u_bin;
+    id->u_bin = 0.0f;
+    
+    if (id->u_hist[0] > 0.0f) {
+        id->since_dose = 0;
+        id->model.doses++;
+    } else if (id->since_dose != ID_NO_DOSE) {
+        id->since_dose++;
+    }
+    
+    if (id->primed < 2) {
+        id->primed++;
+    } else if (id->since_dose < ADAPTIVE_PID_ID_DELAYS + ID_TAIL_TICKS) {
+        for (int d = 0; d < ADAPTIVE_PID_ID_DELAYS; d++) {
+            rls_update(&id->rls[d], id->dy_prev, id->u_hist[d], dy);
+        }
+        id->model.updates++;
+        ident_update_model(pid);
+    }
+    
+    id->dy_prev = dy;
+}
+
+static void ident_step(adaptive_pid_t *pid, float current, float dt, float dose) {
+    pid_ident_t *id = &pid->ident;
+    if (!id->enabled) {
+        return;
+    }
+    
+    uint64_t now = esp_timer_get_time();
+    
+    // Пропуск вызовов (контур другого направления, пауза) или смена периода -
+    // цепочка Δy прервана, начинаем заново; оценки RLS сохраняются
+    bool gap = id->last_call_us != 0 &&
+               (now - id->last_call_us) > (uint64_t)(dt * 3.0f * 1000000.0f);
+    if (gap || fabsf(dt - id->dt_s) > 1e-3f) {
+        ident_restart(id);
+        id->dt_s = dt;
+        float ticks = ceilf(ADAPTIVE_PID_ID_PERIOD_S / dt - 1e-3f);
+        id->ts_s = (ticks < 1.0f ? 1.0f : ticks) * dt;
+    }
+    id->last_call_us = now;
+    
+    if (id->primed == 0) {
+        // Первое значение цепочки - опорное, такт начинается сейчас
+        id->y_prev = current;
+        id->primed = 1;
+    } else {
+        id->elapsed_s += dt;
+        if (id->elapsed_s >= id->ts_s - dt * 0.5f) {
+            id->elapsed_s = 0.0f;
+            ident_tick(pid, current);
+        }
+    }
+    
+    // Доза этого вызова действует с начала следующего интервала
+    id->u_bin += dose;
+}
+
+/**
+ * Lambda-настройка PI (SIMC) по модели. Для контура объект интегрирующий:
+ * каждая доза сдвигает значение навсегда, dy/dt = K·q при расходе q (мл/с)
+ * с дозами раз в Ts_ctrl. Задержка и смешивание объединяются в
+ * θ_eff = θ + τ. Kc = 1 / (K·(λ + θ_eff)), Ti = 4·(λ + θ_eff). Доза за шаг =
+ * Kc·Ts_ctrl·e, поэтому kp <= 1/K - один шаг не перекрывает ошибку.
+ */
+static void tune_from_model(adaptive_pid_t *pid) {
+    const pid_ident_t *id = &pid->ident;
+    const pid_model_t *m = &id->model;
+    if (!m->ready || m->gain <= 0.0f || id->dt_s <= 0.0f) {
+        return;
+    }
+    
+    float ts_ctrl = pid->min_interval_ms / 1000.0f;
+    if (ts_ctrl < id->dt_s) {
+        ts_ctrl = id->dt_s;
+    }
+    // Задержку компенсирует предиктор Смита - остаётся только смешивание
+    float k, tau, theta;
+    float theta_eff = smith_model(pid, &k, &tau, &theta) ?
+                      m->time_constant_s : m->dead_time_s + m->time_constant_s;
+    float lambda_close = id->lambda_factor * theta_eff;
+    // Дальняя зона - вдвое быстрее
+    const float lambdas[2] = { lambda_close, lambda_close * 0.5f };
+    pid_coeffs_t *coeffs[2] = { &pid->coeffs_close, &pid->coeffs_far };
+    
+    for (int i = 0; i < 2; i++) {
+        float denom = lambdas[i] + theta_eff;
+        if (denom < ts_ctrl) {
+            denom = ts_ctrl;
+        }
+        float kp = ts_ctrl / (m->gain * denom);
+        float ti = 4.0f * denom;
+        coeffs[i]->kp = kp;
+        coeffs[i]->ki = adaptive_pid_ki_from_ti(pid, kp, ti, id->dt_s);
+        coeffs[i]->kd = 0.0f;
+    }
+    
+    ESP_LOGD(TAG, "Model tuning: close Kp=%.3f Ki=%.4f, far Kp=%.3f Ki=%.4f",
+             pid->coeffs_close.kp, pid->coeffs_close.ki, pid->coeffs_far.kp, pid->coeffs_far.ki);
+}
+
+// ============================================================================
+// ПРЕДИКТОР СМИТА
+// ============================================================================
+//
+// Каждая доза u добавляет K·u к установившемуся отклику модели. Ветка fast
+// идёт к нему сразу с постоянной τ, ветка delayed - после θ (до этого доза
+// лежит в pending). Поправка fast - delayed - эффект доз, не дошедших до
+// датчика. Модель линейна, поэтому обе ветки держатся около нуля сдвигом на
+// delayed. Состояние считается по реальному времени, а не по dt: PID
+// направления вызывается не на каждом шаге контура.
+
+static bool smith_model(const adaptive_pid_t *pid, float *gain, float *tau, float *theta) {
+    const pid_smith_t *s = &pid->smith;
+    const pid_model_t *m = &pid->ident.model;
+    if (!s->enabled) {
+        return false;
+    }
+    
+    *gain = s->gain > 0.0f ? s->gain : (m->ready ? m->gain : 0.0f);
+    *tau = s->time_constant_s > 0.0f ? s->time_constant_s : (m->ready ? m->time_constant_s : 0.0f);
+    *theta = s->dead_time_s > 0.0f ? s->dead_time_s : (m->ready ? m->dead_time_s : 0.0f);
+    return *gain > 0.0f;
+}
+
+static float smith_update(adaptive_pid_t *pid) {
+    pid_smith_t *s = &pid->smith;
+    float k, tau, theta;
+    if (!smith_model(pid, &k, &tau, &theta)) {
+        s->correction = 0.0f;
+        return 0.0f;
+    }
+    
+    uint64_t now = esp_timer_get_time();
+    float elapsed_s = s->last_update_us ? (now - s->last_update_us) / 1000000.0f : 0.0f;
+    s->last_update_us = now;
+    
+    // Дозы, задержка которых прошла, переходят в ветку delayed
+    uint64_t theta_us = (uint64_t)(theta * 1000000.0f);
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < s->pending_count; i++) {
+        if (now - s->pending_us[i] >= theta_us) {
+            s->delayed_target += s->pending_effect[i];
+        } else {
+            s->pending_us[kept] = s->pending_us[i];
+            s->pending_effect[kept] = s->pending_effect[i];
+            kept++;
+        }
+    }
+    s->pending_count = kept;
+    
+    float alpha = (tau > 0.0f) ? 1.0f - expf(-elapsed_s / tau) : 1.0f;
+    s->fast += (s->fast_target - s->fast) * alpha;
+    s->delayed += (s->delayed_target - s->delayed) * alpha;
+    
+    float base = s->delayed;
+    s->fast -= base;
+    s->fast_target -= base;
+    s->delayed = 0.0f;
+    s->delayed_target -= base;
+    
+    s->correction = s->fast;
+    return s->correction;
+}
+
+static void smith_add_dose(adaptive_pid_t *pid, float dose) {
+    pid_smith_t *s = &pid->smith;
+    float k, tau, theta;
+    if (dose <= 0.0f || !smith_model(pid, &k, &tau, &theta)) {
+        return;
+    }
+    
+    float effect = k * dose;
+    s->fast_target += effect;
+    if (theta <= 0.0f) {
+        s->delayed_target += effect;
+    } else if (s->pending_count < ADAPTIVE_PID_SMITH_PENDING) {
+        s->pending_us[s->pending_count] = esp_timer_get_time();
+        s->pending_effect[s->pending_count] = effect;
+        s->pending_count++;
+    } else {
+        // Очередь полна - к последней дозе (датчик увидит её чуть раньше)
+        s->pending_effect[s->pending_count - 1] += effect;
+    }
+}
+
 esp_err_t adaptive_pid_set_target(adaptive_pid_t *pid, float target) {
     if (pid == NULL) {
         return ESP_ERR_INVALID_ARG;
@@ -458,9 +883,8 @@ esp_err_t adaptive_pid_set_target(adaptive_pid_t *pid, float target) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    pid->target = target;
     ESP_LOGI(TAG, "PID target set to %.2f", target);
     
-    return ESP_OK;
+    return adaptive_pid_set_setpoint(pid, target);
 }
 
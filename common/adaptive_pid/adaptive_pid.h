@@ -8,6 +8,8 @@
  * - Anti-windup с умным ограничением интеграла
  * - Safety механизмы (макс доза, макс частота)
  * - Учет инерционности системы
+ * - Идентификация объекта (RLS): усиление, постоянная времени, задержка
+ * - Предиктор Смита: компенсация задержки отклика на дозу
  * - Статистика и диагностика
  */
 
@@ -49,6 +51,81 @@ typedef struct {
     float kd;           ///< Дифференциальный
 } pid_coeffs_t;
 
+#define ADAPTIVE_PID_ID_DELAYS      8       ///< Кандидаты задержки, тактов идентификации
+#define ADAPTIVE_PID_ID_PERIOD_S    10.0f   ///< Минимальный такт идентификации (с)
+
+/**
+ * @brief RLS оценка для одного кандидата задержки d
+ *
+ * Δy[k] = a·Δy[k-1] + b·u[k-1-d]: отклик значения на дозу u (мл) -
+ * первый порядок с задержкой; a = exp(-Ts/τ), b = K·(1 - a)
+ */
+typedef struct {
+    float theta[2];                     ///< [a, b]
+    float P[2][2];                      ///< Ковариация оценки
+    float cost;                         ///< Сглаженный квадрат ошибки предсказания
+} pid_rls_t;
+
+/**
+ * @brief Идентифицированная модель доза → значение
+ */
+typedef struct {
+    float gain;                         ///< K: итоговое изменение значения на 1 мл
+    float time_constant_s;              ///< τ: постоянная смешивания (с)
+    float dead_time_s;                  ///< θ: транспортная задержка (с)
+    uint32_t updates;                   ///< Шагов RLS с откликом на дозу
+    uint32_t doses;                     ///< Доз, попавших в идентификацию
+    bool ready;                         ///< Модель достоверна
+} pid_model_t;
+
+/**
+ * @brief Состояние идентификации
+ */
+typedef struct {
+    bool enabled;
+    float lambda_factor;                ///< λ = factor·(θ + τ) для зоны CLOSE
+    pid_rls_t rls[ADAPTIVE_PID_ID_DELAYS];
+    float u_hist[ADAPTIVE_PID_ID_DELAYS]; ///< u[k-1] ... u[k-D] (мл за такт)
+    float u_bin;                        ///< Дозы текущего такта
+    float y_prev;                       ///< Значение на начале такта
+    float dy_prev;                      ///< Δy прошлого такта
+    float elapsed_s;                    ///< Время в текущем такте
+    float ts_s;                         ///< Такт идентификации (с)
+    float dt_s;                         ///< Период вызова compute (с)
+    uint64_t last_call_us;
+    uint8_t primed;                     ///< 0 - нет y_prev, 1 - нет Δy, 2 - готово
+    uint8_t since_dose;                 ///< Тактов после последней дозы
+    uint8_t best_delay;                 ///< Кандидат с наименьшей ошибкой
+    pid_model_t model;
+} pid_ident_t;
+
+#define ADAPTIVE_PID_SMITH_PENDING  8       ///< Доз внутри задержки предиктора
+#define ADAPTIVE_PID_SMITH_MAX_DEAD_S 600.0f
+
+/**
+ * @brief Предиктор Смита
+ *
+ * Модель первого порядка с задержкой считает отклик на выданные дозы
+ * дважды: без задержки (fast) и с задержкой (delayed). PID получает
+ * значение + (fast - delayed) - измеренное плюс то, что дозы ещё
+ * "в пути" к датчику. Параметр 0 - берётся из идентифицированной модели.
+ */
+typedef struct {
+    bool enabled;
+    float gain;                         ///< K (на 1 мл), 0 - из модели
+    float time_constant_s;              ///< τ (с), 0 - из модели
+    float dead_time_s;                  ///< θ (с), 0 - из модели
+    float fast;                         ///< Отклик модели без задержки
+    float fast_target;
+    float delayed;                      ///< Отклик модели с задержкой
+    float delayed_target;
+    float correction;                   ///< Последняя поправка к значению
+    uint64_t last_update_us;
+    uint64_t pending_us[ADAPTIVE_PID_SMITH_PENDING];
+    float pending_effect[ADAPTIVE_PID_SMITH_PENDING]; ///< K·доза, ещё внутри θ
+    uint8_t pending_count;
+} pid_smith_t;
+
 /**
  * @brief Статистика работы PID
  */
@@ -99,6 +176,12 @@ typedef struct {
     // Статистика
     pid_stats_t stats;
     
+    // Идентификация объекта
+    pid_ident_t ident;
+    
+    // Компенсация задержки
+    pid_smith_t smith;
+    
     // Флаги
     bool enabled;                       ///< Включен ли контроллер
     bool emergency_stop;                ///< Аварийная остановка
@@ -210,6 +293,70 @@ esp_err_t adaptive_pid_reset(adaptive_pid_t *pid);
  */
 esp_err_t adaptive_pid_set_auto_tune(adaptive_pid_t *pid, bool enable, float adaptation_rate);
 
+/**
+ * @brief Ki для adaptive_pid_compute() по постоянной интегрирования Ti
+ *
+ * Интеграл копится (ошибка·dt) только на шагах с разрешённой дозой - раз в
+ * safety интервал при периоде вызова dt. Ki = Kp·Ts/(Ti·dt), Ts - safety
+ * интервал (не меньше dt), даёт интегральную дозу Kp/Ti·∫e·dt по реальному
+ * времени.
+ *
+ * @param pid Указатель на структуру PID (safety интервал)
+ * @param kp Пропорциональный коэффициент (мл на единицу ошибки)
+ * @param ti_s Постоянная интегрирования (с)
+ * @param dt Период вызова adaptive_pid_compute() (с)
+ * @return Ki (0 при некорректных аргументах)
+ */
+float adaptive_pid_ki_from_ti(const adaptive_pid_t *pid, float kp, float ti_s, float dt);
+
+/**
+ * @brief Настройка идентификации объекта
+ *
+ * RLS оценивает отклик значения на дозу (K, τ, θ) по каждому вызову
+ * adaptive_pid_compute(). Когда модель достоверна и автоподстройка
+ * включена, коэффициенты CLOSE/FAR выводятся из модели (lambda-настройка
+ * PI для интегрирующего объекта), эвристика по тренду ошибки больше не
+ * применяется. По умолчанию включено, lambda_factor = 1.5.
+ *
+ * @param pid Указатель на структуру PID
+ * @param enable true - оценивать модель
+ * @param lambda_factor Желаемая постоянная замкнутого контура в долях
+ *                      (θ + τ): больше - мягче, меньше перерегулирование (0.5-5)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG
+ */
+esp_err_t adaptive_pid_set_identification(adaptive_pid_t *pid, bool enable, float lambda_factor);
+
+/**
+ * @brief Идентифицированная модель (ready = false пока данных мало)
+ */
+const pid_model_t* adaptive_pid_get_model(const adaptive_pid_t *pid);
+
+/**
+ * @brief Сброс модели (замена насоса, другой бак)
+ */
+esp_err_t adaptive_pid_reset_model(adaptive_pid_t *pid);
+
+/**
+ * @brief Предиктор Смита (компенсация задержки отклика на дозу)
+ *
+ * PID работает по предсказанному значению: измеренное плюс ожидаемый
+ * эффект доз, которые датчик ещё не видит. Без него в течение задержки
+ * смешивания ошибка не меняется, интеграл копится и следующая доза
+ * перекрывает цель. Параметры 0 берутся из идентифицированной модели
+ * (adaptive_pid_get_model); пока модели нет и усиление не задано -
+ * поправка 0. Когда предиктор работает, настройка по модели считает
+ * задержку скомпенсированной (θ_eff = τ). По умолчанию выключен.
+ *
+ * @param pid Указатель на структуру PID
+ * @param enable true - включить
+ * @param gain Изменение значения на 1 мл дозы, 0 - из модели
+ * @param time_constant_s Постоянная смешивания (с), 0 - из модели
+ * @param dead_time_s Задержка (с, до 600), 0 - из модели
+ * @return ESP_OK, ESP_ERR_INVALID_ARG
+ */
+esp_err_t adaptive_pid_set_smith_predictor(adaptive_pid_t *pid, bool enable, float gain,
+                                           float time_constant_s, float dead_time_s);
+
 /**
  * @brief Аварийная остановка PID
  * 
@@ -7,6 +7,7 @@
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "rtos_static.h"
 #include "driver/gpio.h"
 
 static const char *TAG = "buzzer_led";
@@ -18,6 +19,8 @@ static gpio_num_t s_button_gpio = GPIO_NUM_NC;
 static led_mode_t s_current_mode = LED_MODE_OFF;
 static TaskHandle_t s_led_task = NULL;
 static TaskHandle_t s_button_task = NULL;
+RTOS_STATIC_TASK(led_task_mem, 2048);
+RTOS_STATIC_TASK(button_task_mem, 2048);
 static button_press_callback_t s_button_cb = NULL;
 
 // Forward declarations
@@ -67,11 +70,11 @@ esp_err_t buzzer_led_init(gpio_num_t led_gpio, gpio_num_t buzzer_gpio, gpio_num_
         ESP_ERROR_CHECK(gpio_config(&io_conf));
         
         // Запуск задачи обработки кнопки
-        xTaskCreate(button_task, "button_task", 2048, NULL, 5, &s_button_task);
+        rtos_static_task_create(&button_task_mem, button_task, "button_task", NULL, 5, &s_button_task);
     }
 
     // Запуск задачи LED
-    xTaskCreate(led_task, "led_task", 2048, NULL, 5, &s_led_task);
+    rtos_static_task_create(&led_task_mem, led_task, "led_task", NULL, 5, &s_led_task);
 
     ESP_LOGI(TAG, "Buzzer/LED/Button initialized (LED=%d, Buzzer=%d, Button=%d)",
              led_gpio, buzzer_gpio, button_gpio);
@@ -0,0 +1,325 @@
+/**
+ * @file cjson_arena.c
+ * @brief Реализация арены cJSON
+ *
+ * Хуки cJSON глобальные, поэтому решение "арена или heap" принимается на
+ * каждом вызове: malloc смотрит на thread-local активную арену задачи,
+ * free - попадает ли указатель в буфер какой-либо арены (их единицы,
+ * проверка - пара сравнений на арену). Так объекты, созданные в одной
+ * задаче и удалённые в другой, освобождаются корректно.
+ */
+
+#include "cjson_arena.h"
+#include "mem_policy.h"
+#include "esp_log.h"
+
+static const char *TAG = "cjson_arena";
+
+#ifdef CONFIG_CJSON_ARENA_ENABLE
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN             8       // cJSON содержит double
+#define ARENA_POISON_BYTE       0xA5
+
+struct cjson_arena {
+    const char *name;
+    uint8_t *buf;
+    size_t size;
+    size_t top;                 // Занято в буфере
+    size_t demand;              // Запрошено за область (включая ушедшее в heap)
+    bool overflowed;            // В области были выделения из heap
+    uint16_t depth;             // Вложенность cjson_arena_begin()
+    TaskHandle_t owner;         // Задача открытой области (NULL - закрыта)
+    cjson_arena_t *prev;        // Активная арена до begin
+    int label_count;
+    cjson_arena_stats_t stats[CJSON_ARENA_MAX_LABELS];
+};
+
+static cjson_arena_t *s_arenas[CJSON_ARENA_MAX_ARENAS];
+static int s_arena_count = 0;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Активная арена задачи
+static __thread cjson_arena_t *s_active = NULL;
+
+static bool owned_by_arena(const void *ptr) {
+    int count = __atomic_load_n(&s_arena_count, __ATOMIC_ACQUIRE);
+    const uint8_t *p = (const uint8_t *)ptr;
+    for (int i = 0; i < count; i++) {
+        const cjson_arena_t *a = s_arenas[i];
+        if (p >= a->buf && p < a->buf + a->size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void *arena_malloc(size_t size) {
+    cjson_arena_t *a = s_active;
+    if (a) {
+        size_t need = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+        a->demand += need;
+        if (need <= a->size - a->top) {
+            void *p = a->buf + a->top;
+            a->top += need;
+            return p;
+        }
+        a->overflowed = true;
+    }
+    return malloc(size);
+}
+
+static void arena_free(void *ptr) {
+    // Память арены возвращается целиком в cjson_arena_end()
+    if (ptr && !owned_by_arena(ptr)) {
+        free(ptr);
+    }
+}
+
+esp_err_t cjson_arena_install(void) {
+    cJSON_Hooks hooks = {
+        .malloc_fn = arena_malloc,
+        .free_fn = arena_free,
+    };
+    cJSON_InitHooks(&hooks);
+    ESP_LOGI(TAG, "cJSON arena hooks installed");
+    return ESP_OK;
+}
+
+cjson_arena_t* cjson_arena_create(const char *name, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    // Арена - горячий путь каждого сообщения: только внутренняя RAM
+    cjson_arena_t *a = calloc(1, sizeof(*a));
+    uint8_t *buf = mem_policy_calloc("cjson_arena", MEM_HOT, size);
+    if (!a || !buf) {
+        ESP_LOGE(TAG, "No memory for arena %s (%u bytes)", name, (unsigned)size);
+        free(a);
+        free(buf);
+        return NULL;
+    }
+    a->name = name;
+    a->buf = buf;
+    a->size = size;
+
+    bool added = false;
+    portENTER_CRITICAL(&s_lock);
+    if (s_arena_count < CJSON_ARENA_MAX_ARENAS) {
+        s_arenas[s_arena_count] = a;
+        __atomic_store_n(&s_arena_count, s_arena_count + 1, __ATOMIC_RELEASE);
+        added = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!added) {
+        ESP_LOGE(TAG, "No free arena slots for %s", name);
+        free(buf);
+        free(a);
+        return NULL;
+    }
+
+    ESP_LOGI(TAG, "Arena %s: %u bytes", name, (unsigned)size);
+    return a;
+}
+
+void cjson_arena_begin(cjson_arena_t *arena) {
+    if (!arena) {
+        return;
+    }
+    // top/depth не атомарны: вторая задача в открытой области портит
+    // выделения первой - у каждой задачи своя арена
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    assert(arena->depth == 0 || arena->owner == self);
+    if (arena->depth++ == 0) {
+        arena->owner = self;
+        arena->prev = s_active;
+        s_active = arena;
+    }
+}
+
+static cjson_arena_stats_t *find_label(cjson_arena_t *a, const char *label) {
+    for (int i = 0; i < a->label_count; i++) {
+        if (a->stats[i].label == label) {
+            return &a->stats[i];
+        }
+    }
+    for (int i = 0; i < a->label_count; i++) {
+        if (strcmp(a->stats[i].label, label) == 0) {
+            return &a->stats[i];
+        }
+    }
+    if (a->label_count < CJSON_ARENA_MAX_LABELS) {
+        cjson_arena_stats_t *st = &a->stats[a->label_count];
+        memset(st, 0, sizeof(*st));
+        st->label = label;
+        a->label_count++;
+        return st;
+    }
+    return NULL;
+}
+
+void cjson_arena_end(cjson_arena_t *arena, const char *label) {
+    if (!arena || arena->depth == 0) {
+        return;
+    }
+    assert(arena->owner == xTaskGetCurrentTaskHandle());
+    if (--arena->depth > 0) {
+        return;
+    }
+    s_active = arena->prev;
+    arena->prev = NULL;
+    arena->owner = NULL;
+
+    portENTER_CRITICAL(&s_lock);
+    cjson_arena_stats_t *st = find_label(arena, label ? label : "other");
+    if (st) {
+        st->messages++;
+        if (arena->demand > st->peak_bytes) {
+            st->peak_bytes = arena->demand;
+        }
+        if (arena->overflowed) {
+            st->overflows++;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (arena->overflowed) {
+        ESP_LOGD(TAG, "Arena %s overflow on %s: %u of %u bytes", arena->name,
+                 label ? label : "other", (unsigned)arena->demand, (unsigned)arena->size);
+    }
+
+#ifdef CONFIG_CJSON_ARENA_POISON
+    // Обращение к памяти после сброса - заметный мусор вместо тихой порчи
+    memset(arena->buf, ARENA_POISON_BYTE, arena->top);
+#endif
+
+    arena->top = 0;
+    arena->demand = 0;
+    arena->overflowed = false;
+}
+
+void* cjson_arena_suspend(void) {
+    cjson_arena_t *a = s_active;
+    s_active = NULL;
+    return a;
+}
+
+void cjson_arena_resume(void *token) {
+    s_active = (cjson_arena_t *)token;
+}
+
+int cjson_arena_get_stats(const cjson_arena_t *arena, cjson_arena_stats_t *out) {
+    if (!arena || !out) {
+        return 0;
+    }
+    portENTER_CRITICAL(&s_lock);
+    int count = arena->label_count;
+    memcpy(out, arena->stats, count * sizeof(*out));
+    portEXIT_CRITICAL(&s_lock);
+    return count;
+}
+
+void cjson_arena_add_to_json(cJSON *obj, bool detailed) {
+    if (!obj) {
+        return;
+    }
+
+    int count = __atomic_load_n(&s_arena_count, __ATOMIC_ACQUIRE);
+    if (count == 0) {
+        return;
+    }
+
+    cjson_arena_stats_t stats[CJSON_ARENA_MAX_LABELS];
+    cJSON *out = detailed ? cJSON_CreateObject() : cJSON_CreateArray();
+    if (!out) {
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        const cjson_arena_t *a = s_arenas[i];
+        int n = cjson_arena_get_stats(a, stats);
+
+        if (detailed) {
+            cJSON *entry = cJSON_AddObjectToObject(out, a->name);
+            if (!entry) {
+                break;
+            }
+            cJSON_AddNumberToObject(entry, "size", a->size);
+            cJSON *types = cJSON_AddObjectToObject(entry, "types");
+            if (!types) {
+                break;
+            }
+            for (int k = 0; k < n; k++) {
+                const int row[3] = { (int)stats[k].messages, (int)stats[k].peak_bytes, (int)stats[k].overflows };
+                cJSON_AddItemToObject(types, stats[k].label, cJSON_CreateIntArray(row, 3));
+            }
+        } else {
+            uint32_t peak = 0, overflows = 0;
+            for (int k = 0; k < n; k++) {
+                if (stats[k].peak_bytes > peak) {
+                    peak = stats[k].peak_bytes;
+                }
+                overflows += stats[k].overflows;
+            }
+            cJSON *row = cJSON_CreateArray();
+            if (!row) {
+                break;
+            }
+            cJSON_AddItemToArray(row, cJSON_CreateString(a->name));
+            cJSON_AddItemToArray(row, cJSON_CreateNumber(a->size));
+            cJSON_AddItemToArray(row, cJSON_CreateNumber(peak));
+            cJSON_AddItemToArray(row, cJSON_CreateNumber(overflows));
+            cJSON_AddItemToArray(out, row);
+        }
+    }
+
+    cJSON_AddItemToObject(obj, "arena", out);
+}
+
+#else // CONFIG_CJSON_ARENA_ENABLE
+
+esp_err_t cjson_arena_install(void) {
+    ESP_LOGD(TAG, "cJSON arena disabled in Kconfig");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+cjson_arena_t* cjson_arena_create(const char *name, size_t size) {
+    (void)name;
+    (void)size;
+    return NULL;
+}
+
+void cjson_arena_begin(cjson_arena_t *arena) {
+    (void)arena;
+}
+
+void cjson_arena_end(cjson_arena_t *arena, const char *label) {
+    (void)arena;
+    (void)label;
+}
+
+void* cjson_arena_suspend(void) {
+    return NULL;
+}
+
+void cjson_arena_resume(void *token) {
+    (void)token;
+}
+
+int cjson_arena_get_stats(const cjson_arena_t *arena, cjson_arena_stats_t *out) {
+    (void)arena;
+    (void)out;
+    return 0;
+}
+
+void cjson_arena_add_to_json(cJSON *obj, bool detailed) {
+    (void)obj;
+    (void)detailed;
+}
+
+#endif // CONFIG_CJSON_ARENA_ENABLE
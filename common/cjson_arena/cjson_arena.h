@@ -0,0 +1,140 @@
+/**
+ * @file cjson_arena.h
+ * @brief Арена (bump allocator) для cJSON на время обработки одного сообщения
+ *
+ * cjson_arena_install() ставит хуки cJSON_InitHooks. Пока в задаче
+ * открыта область арены (cjson_arena_begin ... cjson_arena_end), все
+ * выделения cJSON (объекты, строки, буфер cJSON_Print) берутся из её
+ * буфера сдвигом указателя, free() для них - пустой, а cjson_arena_end()
+ * сбрасывает арену за O(1). Вне области и при переполнении арены память
+ * берётся из heap как раньше.
+ *
+ * - Арена принадлежит одной задаче (активная арена - thread-local);
+ *   cjson_arena_begin() из другой задачи при открытой области - assert
+ * - Всё, что выделено в области, недействительно после cjson_arena_end():
+ *   данные, которые должны жить дольше (копия в реестре), выделяются
+ *   между cjson_arena_suspend() / cjson_arena_resume()
+ * - Строку из cJSON_Print освобождать cJSON_free(), не free()
+ * - Пиковое использование считается по меткам (тип сообщения)
+ *
+ * Выключено в Kconfig (CJSON_ARENA_ENABLE=n) - хуки не ставятся,
+ * cjson_arena_create() возвращает NULL, остальные функции пустые.
+ */
+
+#ifndef CJSON_ARENA_H
+#define CJSON_ARENA_H
+
+#include "esp_err.h"
+#include "cJSON.h"
+#include "sdkconfig.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CJSON_ARENA_MAX_ARENAS      6       ///< Арен на всю прошивку
+#define CJSON_ARENA_MAX_LABELS      10      ///< Меток статистики на арену
+
+#ifdef CONFIG_CJSON_ARENA_SIZE
+#define CJSON_ARENA_DEFAULT_SIZE    CONFIG_CJSON_ARENA_SIZE
+#else
+#define CJSON_ARENA_DEFAULT_SIZE    0
+#endif
+
+typedef struct cjson_arena cjson_arena_t;
+
+/**
+ * @brief Статистика по одной метке (типу сообщения)
+ */
+typedef struct {
+    const char *label;          ///< Метка из cjson_arena_end()
+    uint32_t messages;          ///< Обработано сообщений
+    uint32_t peak_bytes;        ///< Пик потребности на сообщение (арена + heap)
+    uint32_t overflows;         ///< Сообщений, не уместившихся в арену
+} cjson_arena_stats_t;
+
+/**
+ * @brief Установка хуков cJSON
+ *
+ * Вызывать в начале app_main. Объекты, созданные до установки, остаются
+ * корректными - free() для указателей вне арен уходит в heap.
+ *
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED если выключено в Kconfig
+ */
+esp_err_t cjson_arena_install(void);
+
+/**
+ * @brief Создание арены
+ *
+ * Буфер выделяется один раз при создании (при старте, пока heap не
+ * фрагментирован) и не освобождается.
+ *
+ * @param name Имя для статистики (строка должна жить всё время работы)
+ * @param size Размер буфера (байт)
+ * @return Арена, NULL если нет памяти, слоты кончились или выключено в Kconfig
+ */
+cjson_arena_t* cjson_arena_create(const char *name, size_t size);
+
+/**
+ * @brief Открытие области: выделения cJSON этой задачи идут в арену
+ *
+ * Области одной арены могут вкладываться - сброс делает внешняя.
+ * Пока область открыта, арена принадлежит открывшей задаче: вход
+ * другой задачи - assert (у каждой задачи своя арена).
+ *
+ * @param arena Арена (NULL - ничего не делает)
+ */
+void cjson_arena_begin(cjson_arena_t *arena);
+
+/**
+ * @brief Закрытие области, сброс арены и учёт пика
+ *
+ * @param arena Арена (NULL - ничего не делает)
+ * @param label Метка статистики - литерал или строка из
+ *              mesh_protocol_msg_type_to_str() (сравнивается по указателю)
+ */
+void cjson_arena_end(cjson_arena_t *arena, const char *label);
+
+/**
+ * @brief Временный выход из арены (выделения снова идут в heap)
+ *
+ * @return Маркер для cjson_arena_resume()
+ */
+void* cjson_arena_suspend(void);
+
+/**
+ * @brief Возврат в арену после cjson_arena_suspend()
+ *
+ * @param token Маркер из cjson_arena_suspend()
+ */
+void cjson_arena_resume(void *token);
+
+/**
+ * @brief Копия статистики арены
+ *
+ * @param arena Арена
+ * @param out Массив на CJSON_ARENA_MAX_LABELS элементов
+ * @return Число заполненных элементов
+ */
+int cjson_arena_get_stats(const cjson_arena_t *arena, cjson_arena_stats_t *out);
+
+/**
+ * @brief Добавление сводки "arena" в JSON объект
+ *
+ * Кратко (heartbeat): "arena":[[name,size,peak,overflows],...]
+ * Подробно (метрики ROOT): "arena":{"<name>":{"size":N,
+ *     "types":{"<label>":[messages,peak,overflows],...}},...}
+ *
+ * @param obj JSON объект
+ * @param detailed Разбивка по меткам
+ */
+void cjson_arena_add_to_json(cJSON *obj, bool detailed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CJSON_ARENA_H
@@ -8,20 +8,25 @@
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "rtos_static.h"
+#include "event_bus.h"
+#include "sdkconfig.h"
 
 static const char *TAG = "conn_monitor";
 
-// Пороги переключения состояний (мс)
-#define DEGRADED_THRESHOLD_MS   10000   // 10 сек без контакта
-#define AUTONOMOUS_THRESHOLD_MS 30000   // 30 сек без контакта
+// Пороги переключения состояний (мс), Kconfig
+#define DEGRADED_THRESHOLD_MS   CONFIG_CONN_MONITOR_DEGRADED_MS
+#define AUTONOMOUS_THRESHOLD_MS CONFIG_CONN_MONITOR_AUTONOMOUS_MS
 
 static connection_state_t s_current_state = CONN_STATE_ONLINE;
 static uint64_t s_last_root_contact_ms = 0;
 static TaskHandle_t s_monitor_task = NULL;
+RTOS_STATIC_TASK(conn_monitor, 3072);
 static connection_state_changed_cb_t s_state_cb = NULL;
 
 // Forward declaration
 static void connection_monitor_task(void *arg);
+static uint32_t next_check_ms(uint64_t elapsed_ms);
 static void change_state(connection_state_t new_state);
 static const char* state_to_string(connection_state_t state);
 
@@ -39,12 +44,12 @@ esp_err_t connection_monitor_start(void) {
         return ESP_OK;
     }
 
-    BaseType_t ret = xTaskCreate(connection_monitor_task,
-                                  "conn_monitor",
-                                  3072,
-                                  NULL,
-                                  5,
-                                  &s_monitor_task);
+    BaseType_t ret = rtos_static_task_create(&conn_monitor,
+                                             connection_monitor_task,
+                                             "conn_monitor",
+                                             NULL,
+                                             5,
+                                             &s_monitor_task);
     
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create monitor task");
@@ -57,6 +62,7 @@ esp_err_t connection_monitor_start(void) {
 
 esp_err_t connection_monitor_stop(void) {
     if (s_monitor_task != NULL) {
+        event_bus_unsubscribe_task(s_monitor_task);
         vTaskDelete(s_monitor_task);
         s_monitor_task = NULL;
         ESP_LOGI(TAG, "Connection Monitor stopped");
@@ -90,7 +96,19 @@ uint64_t connection_monitor_get_time_since_last_contact(void) {
 static void connection_monitor_task(void *arg) {
     ESP_LOGI(TAG, "Monitor task running");
 
+    // Любое сообщение от ROOT - контакт, потеря родителя - сразу DEGRADED
+    event_bus_subscribe_task(EVENT_BUS_BIT(EVENT_BUS_MESSAGE) | EVENT_BUS_BIT(EVENT_BUS_MESH_DOWN),
+                             EVENT_BUS_MSG_ALL, xTaskGetCurrentTaskHandle());
+    uint32_t events = 0;
+
     while (1) {
+        if (events & EVENT_BUS_BIT(EVENT_BUS_MESSAGE)) {
+            connection_monitor_mark_root_contact();
+        }
+        if ((events & EVENT_BUS_BIT(EVENT_BUS_MESH_DOWN)) && s_current_state == CONN_STATE_ONLINE) {
+            change_state(CONN_STATE_DEGRADED);
+        }
+
         uint64_t elapsed_ms = connection_monitor_get_time_since_last_contact();
 
         // Машина состояний
@@ -104,7 +122,7 @@ static void connection_monitor_task(void *arg) {
             case CONN_STATE_DEGRADED:
                 if (elapsed_ms > AUTONOMOUS_THRESHOLD_MS) {
                     change_state(CONN_STATE_AUTONOMOUS);
-                } else if (elapsed_ms < DEGRADED_THRESHOLD_MS) {
+                } else if (elapsed_ms < DEGRADED_THRESHOLD_MS && event_bus_mesh_is_up()) {
                     change_state(CONN_STATE_ONLINE);
                 }
                 break;
@@ -124,8 +142,29 @@ static void connection_monitor_task(void *arg) {
                 break;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(5000));  // Проверка каждые 5 сек
+        // Сон до ближайшего порога или до события
+        events = event_bus_task_wait(pdMS_TO_TICKS(next_check_ms(connection_monitor_get_time_since_last_contact())));
+    }
+}
+
+// Время до следующего порога без контакта
+static uint32_t next_check_ms(uint64_t elapsed_ms) {
+    switch (s_current_state) {
+        case CONN_STATE_ONLINE:
+            if (elapsed_ms <= DEGRADED_THRESHOLD_MS) {
+                return (uint32_t)(DEGRADED_THRESHOLD_MS - elapsed_ms) + 1;
+            }
+            break;
+        case CONN_STATE_DEGRADED:
+            if (elapsed_ms <= AUTONOMOUS_THRESHOLD_MS) {
+                return (uint32_t)(AUTONOMOUS_THRESHOLD_MS - elapsed_ms) + 1;
+            }
+            break;
+        default:
+            // Дальше только по событию (контакт с ROOT)
+            return 60000;
     }
+    return 1000;
 }
 
 // Изменение состояния с уведомлением
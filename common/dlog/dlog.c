@@ -0,0 +1,544 @@
+/**
+ * @file dlog.c
+ * @brief Реализация отложенного логирования
+ *
+ * Кольцо - несколько производителей (любые задачи, оба ядра), один
+ * потребитель (задача вывода). Производитель резервирует место CAS по
+ * head, пишет запись и выставляет state = COMMITTED; потребитель идёт от
+ * tail, форматирует подтверждённые записи и сдвигает tail. Запись не
+ * переходит через конец буфера: остаток в конце закрывается записью SKIP.
+ */
+
+#include "dlog.h"
+
+static const char *TAG = "dlog";
+
+#ifdef CONFIG_DLOG_ENABLE
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "rtos_static.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#define DLOG_BUFFER_SIZE        CONFIG_DLOG_BUFFER_SIZE
+#define DLOG_MAX_STR            CONFIG_DLOG_MAX_STR
+#define DLOG_LINE_LEN           256
+#define DLOG_TAG_SLOTS          32
+#define DLOG_TASK_STACK         3072
+#define DLOG_IDLE_POLL_MS       20
+
+_Static_assert((DLOG_BUFFER_SIZE & (DLOG_BUFFER_SIZE - 1)) == 0, "DLOG_BUFFER_SIZE must be a power of two");
+
+#define DLOG_STATE_FREE         0
+#define DLOG_STATE_COMMITTED    1
+#define DLOG_STATE_SKIP         2
+
+typedef struct {
+    uint32_t state;
+    uint16_t len;               // Вся запись с аргументами, кратно 8
+    uint8_t level;
+    uint8_t nargs;
+    const char *tag;
+    const char *fmt;
+    uint32_t timestamp_ms;
+} dlog_entry_t;
+
+typedef struct {
+    const char *tag;            // Указатель TAG (сравнение по указателю на горячем пути)
+    uint16_t per_sec;           // 0 - без лимита
+    uint16_t burst;
+    uint32_t tokens_x1000;      // Токены * 1000
+    uint32_t last_ms;
+    uint32_t suppressed;        // С последнего отчёта
+} dlog_tag_slot_t;
+
+typedef struct {
+    char name[16];
+    uint16_t per_sec;
+    uint16_t burst;
+} dlog_tag_override_t;
+
+static uint8_t s_buf[DLOG_BUFFER_SIZE] __attribute__((aligned(8)));
+static uint32_t s_head = 0;     // Резерв производителей
+static uint32_t s_tail = 0;     // Позиция потребителя
+static uint32_t s_dropped = 0;
+static uint32_t s_suppressed_total = 0;
+
+static dlog_tag_slot_t s_tags[DLOG_TAG_SLOTS];
+static dlog_tag_override_t s_overrides[8];
+static int s_override_count = 0;
+
+static TaskHandle_t s_task = NULL;
+static SemaphoreHandle_t s_drain_mutex = NULL;
+RTOS_STATIC_TASK(dlog, DLOG_TASK_STACK);
+RTOS_STATIC_MUTEX(dlog_drain);
+
+// ============================================================================
+// Лимиты тегов
+// ============================================================================
+
+static dlog_tag_slot_t *tag_slot(const char *tag) {
+    uint32_t h = ((uintptr_t)tag >> 2) % DLOG_TAG_SLOTS;
+    for (int i = 0; i < DLOG_TAG_SLOTS; i++) {
+        dlog_tag_slot_t *slot = &s_tags[(h + i) % DLOG_TAG_SLOTS];
+        const char *cur = __atomic_load_n(&slot->tag, __ATOMIC_ACQUIRE);
+        if (cur == tag) {
+            return slot;
+        }
+        if (cur == NULL) {
+            // Первое сообщение тега: лимит из переопределений или Kconfig
+            const char *expected = NULL;
+            if (!__atomic_compare_exchange_n(&slot->tag, &expected, tag, false,
+                                             __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                if (expected == tag) {
+                    return slot;
+                }
+                continue;
+            }
+            slot->per_sec = CONFIG_DLOG_RATE_PER_SEC;
+            slot->burst = CONFIG_DLOG_RATE_BURST;
+            for (int j = 0; j < s_override_count; j++) {
+                if (strcmp(s_overrides[j].name, tag) == 0) {
+                    slot->per_sec = s_overrides[j].per_sec;
+                    slot->burst = s_overrides[j].burst;
+                    break;
+                }
+            }
+            slot->tokens_x1000 = slot->burst * 1000;
+            slot->last_ms = esp_log_timestamp();
+            return slot;
+        }
+    }
+    return NULL;    // Таблица заполнена - без лимита
+}
+
+// Приблизительный token bucket: гонки между задачами допускают лишнее
+// сообщение, но не блокируют
+static bool rate_allow(const char *tag, uint32_t now_ms) {
+    dlog_tag_slot_t *slot = tag_slot(tag);
+    if (!slot || slot->per_sec == 0) {
+        return true;
+    }
+
+    uint32_t elapsed = now_ms - slot->last_ms;
+    if (elapsed > 0) {
+        if (elapsed > 60000) {
+            elapsed = 60000;
+        }
+        uint32_t refill = elapsed * slot->per_sec;
+        uint32_t cap = slot->burst * 1000;
+        slot->tokens_x1000 = (cap - slot->tokens_x1000 < refill) ? cap : slot->tokens_x1000 + refill;
+        slot->last_ms = now_ms;
+    }
+
+    if (slot->tokens_x1000 >= 1000) {
+        slot->tokens_x1000 -= 1000;
+        return true;
+    }
+
+    __atomic_add_fetch(&slot->suppressed, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&s_suppressed_total, 1, __ATOMIC_RELAXED);
+    return false;
+}
+
+// ============================================================================
+// Производитель
+// ============================================================================
+
+static size_t args_size(int nargs, const dlog_arg_t *args) {
+    size_t size = 0;
+    for (int i = 0; i < nargs; i++) {
+        switch (args[i].type) {
+            case DLOG_ARG_U64:
+            case DLOG_ARG_F64:
+                size += 1 + 8;
+                break;
+            case DLOG_ARG_STR: {
+                size_t len = args[i].str ? strnlen(args[i].str, DLOG_MAX_STR) : 0;
+                size += 1 + 1 + len;
+                break;
+            }
+            default:
+                size += 1 + 4;
+                break;
+        }
+    }
+    return size;
+}
+
+static void args_pack(uint8_t *p, int nargs, const dlog_arg_t *args) {
+    for (int i = 0; i < nargs; i++) {
+        *p++ = args[i].type;
+        switch (args[i].type) {
+            case DLOG_ARG_U64:
+                memcpy(p, &args[i].u64, 8);
+                p += 8;
+                break;
+            case DLOG_ARG_F64:
+                memcpy(p, &args[i].f64, 8);
+                p += 8;
+                break;
+            case DLOG_ARG_STR: {
+                // Строка копируется: к моменту вывода буфер вызывающего уже свободен
+                uint8_t len = args[i].str ? strnlen(args[i].str, DLOG_MAX_STR) : 0;
+                *p++ = len;
+                memcpy(p, args[i].str, len);
+                p += len;
+                break;
+            }
+            case DLOG_ARG_PTR: {
+                uint32_t v = (uint32_t)(uintptr_t)args[i].ptr;
+                memcpy(p, &v, 4);
+                p += 4;
+                break;
+            }
+            default:
+                memcpy(p, &args[i].u32, 4);
+                p += 4;
+                break;
+        }
+    }
+}
+
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt,
+                int nargs, const dlog_arg_t *args) {
+    // Уровень тега (esp_log_level_set) проверяется при выводе; здесь - только лимит
+    uint32_t now_ms = esp_log_timestamp();
+    if (!rate_allow(tag, now_ms)) {
+        return;
+    }
+
+    if (nargs > DLOG_MAX_ARGS) {
+        nargs = DLOG_MAX_ARGS;
+    }
+    // Кратность 8: остаток до конца буфера всегда вмещает state и len записи SKIP
+    uint32_t len = (sizeof(dlog_entry_t) + args_size(nargs, args) + 7) & ~7u;
+
+    uint32_t head;
+    uint32_t pad;
+    do {
+        head = __atomic_load_n(&s_head, __ATOMIC_RELAXED);
+        uint32_t tail = __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE);
+        uint32_t off = head & (DLOG_BUFFER_SIZE - 1);
+        pad = (off + len > DLOG_BUFFER_SIZE) ? DLOG_BUFFER_SIZE - off : 0;
+        if (head + pad + len - tail > DLOG_BUFFER_SIZE) {
+            __atomic_add_fetch(&s_dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&s_head, &head, head + pad + len, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    if (pad) {
+        dlog_entry_t *skip = (dlog_entry_t *)&s_buf[head & (DLOG_BUFFER_SIZE - 1)];
+        skip->len = pad;
+        __atomic_store_n(&skip->state, DLOG_STATE_SKIP, __ATOMIC_RELEASE);
+        head += pad;
+    }
+
+    dlog_entry_t *e = (dlog_entry_t *)&s_buf[head & (DLOG_BUFFER_SIZE - 1)];
+    e->len = len;
+    e->level = level;
+    e->nargs = nargs;
+    e->tag = tag;
+    e->fmt = fmt;
+    e->timestamp_ms = now_ms;
+    args_pack((uint8_t *)(e + 1), nargs, args);
+    __atomic_store_n(&e->state, DLOG_STATE_COMMITTED, __ATOMIC_RELEASE);
+}
+
+// ============================================================================
+// Потребитель: форматирование
+// ============================================================================
+
+/*
+ * Спецификатор формата выводится через snprintf с одним аргументом;
+ * модификатор длины заменяется на тот, что соответствует сохранённому типу.
+ */
+static int format_one(char *out, size_t size, const char *spec, size_t spec_len,
+                      char conv, const uint8_t **p, const uint8_t *end) {
+    char f[24];
+    size_t n = 0;
+    for (size_t i = 0; i < spec_len - 1 && n < sizeof(f) - 4; i++) {
+        char c = spec[i];
+        if (c != 'l' && c != 'h' && c != 'z' && c != 'j' && c != 't' && c != 'L' && c != 'q') {
+            f[n++] = c;
+        }
+    }
+
+    if (*p >= end) {
+        return snprintf(out, size, "<?>");
+    }
+    uint8_t type = *(*p)++;
+    uint64_t u = 0;
+    double d = 0;
+    char str[DLOG_MAX_STR + 1];
+
+    switch (type) {
+        case DLOG_ARG_U64:
+            memcpy(&u, *p, 8);
+            *p += 8;
+            break;
+        case DLOG_ARG_F64:
+            memcpy(&d, *p, 8);
+            *p += 8;
+            break;
+        case DLOG_ARG_STR: {
+            uint8_t len = *(*p)++;
+            memcpy(str, *p, len);
+            str[len] = '\0';
+            *p += len;
+            break;
+        }
+        default: {
+            uint32_t v;
+            memcpy(&v, *p, 4);
+            *p += 4;
+            // Знак восстанавливается по спецификатору (%d от int32)
+            u = (conv == 'd' || conv == 'i') ? (uint64_t)(int64_t)(int32_t)v : v;
+            break;
+        }
+    }
+
+    switch (conv) {
+        case 'd': case 'i':
+            f[n++] = 'l'; f[n++] = 'l'; f[n++] = conv; f[n] = '\0';
+            return snprintf(out, size, f, (long long)u);
+        case 'u': case 'x': case 'X': case 'o':
+            f[n++] = 'l'; f[n++] = 'l'; f[n++] = conv; f[n] = '\0';
+            return snprintf(out, size, f, (unsigned long long)u);
+        case 'c':
+            f[n++] = 'c'; f[n] = '\0';
+            return snprintf(out, size, f, (int)u);
+        case 'p':
+            f[n++] = 'p'; f[n] = '\0';
+            return snprintf(out, size, f, (void *)(uintptr_t)u);
+        case 's':
+            f[n++] = 's'; f[n] = '\0';
+            return snprintf(out, size, f, type == DLOG_ARG_STR ? str : "<?>");
+        default:    // f F e E g G a A
+            f[n++] = conv; f[n] = '\0';
+            return snprintf(out, size, f, type == DLOG_ARG_F64 ? d : (double)u);
+    }
+}
+
+static void format_entry(const dlog_entry_t *e, char *line, size_t size) {
+    const char *fmt = e->fmt;
+    const uint8_t *p = (const uint8_t *)(e + 1);
+    const uint8_t *end = (const uint8_t *)e + e->len;
+    size_t pos = 0;
+
+    while (*fmt && pos < size - 1) {
+        if (*fmt != '%') {
+            line[pos++] = *fmt++;
+            continue;
+        }
+        if (fmt[1] == '%') {
+            line[pos++] = '%';
+            fmt += 2;
+            continue;
+        }
+
+        // %[флаги][ширина][.точность][длина]преобразование
+        const char *spec = fmt++;
+        while (*fmt && strchr("-+ #0123456789.lhzjtLq", *fmt)) {
+            fmt++;
+        }
+        if (!*fmt) {
+            break;
+        }
+        char conv = *fmt++;
+        int w = format_one(line + pos, size - pos, spec, fmt - spec, conv, &p, end);
+        if (w > 0) {
+            pos += ((size_t)w < size - pos) ? (size_t)w : size - pos - 1;
+        }
+    }
+    line[pos] = '\0';
+}
+
+static char level_letter(uint8_t level) {
+    switch (level) {
+        case ESP_LOG_ERROR: return 'E';
+        case ESP_LOG_WARN:  return 'W';
+        case ESP_LOG_INFO:  return 'I';
+        case ESP_LOG_DEBUG: return 'D';
+        default:            return 'V';
+    }
+}
+
+// Вывод подтверждённых записей; false - кольцо пусто или запись ещё пишется
+static bool drain_one(char *line) {
+    uint32_t tail = __atomic_load_n(&s_tail, __ATOMIC_RELAXED);
+    if (tail == __atomic_load_n(&s_head, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    dlog_entry_t *e = (dlog_entry_t *)&s_buf[tail & (DLOG_BUFFER_SIZE - 1)];
+    uint32_t state = __atomic_load_n(&e->state, __ATOMIC_ACQUIRE);
+    if (state == DLOG_STATE_FREE) {
+        return false;
+    }
+
+    uint16_t len = e->len;
+    if (state == DLOG_STATE_COMMITTED && esp_log_level_get(e->tag) >= e->level) {
+        format_entry(e, line, DLOG_LINE_LEN);
+        esp_log_write(e->level, e->tag, "%c (%lu) %s: %s\n", level_letter(e->level),
+                      (unsigned long)e->timestamp_ms, e->tag, line);
+    }
+
+    // Обнуление: новая запись может начаться посреди аргументов старой, и
+    // её state до подтверждения должен читаться как FREE
+    memset(e, 0, len);
+    __atomic_store_n(&s_tail, tail + len, __ATOMIC_RELEASE);
+    return true;
+}
+
+static void report_losses(void) {
+    uint32_t dropped = __atomic_exchange_n(&s_dropped, 0, __ATOMIC_RELAXED);
+    if (dropped) {
+        ESP_LOGW(TAG, "%lu messages dropped (buffer full)", (unsigned long)dropped);
+    }
+
+    for (int i = 0; i < DLOG_TAG_SLOTS; i++) {
+        if (s_tags[i].tag && s_tags[i].suppressed) {
+            uint32_t n = __atomic_exchange_n(&s_tags[i].suppressed, 0, __ATOMIC_RELAXED);
+            ESP_LOGW(TAG, "%s: %lu messages suppressed (limit %u/s)", s_tags[i].tag,
+                     (unsigned long)n, s_tags[i].per_sec);
+        }
+    }
+}
+
+static void dlog_task(void *arg) {
+    static char line[DLOG_LINE_LEN];
+    uint32_t last_report = 0;
+
+    while (1) {
+        xSemaphoreTake(s_drain_mutex, portMAX_DELAY);
+        bool more = drain_one(line);
+        xSemaphoreGive(s_drain_mutex);
+
+        if (!more) {
+            uint32_t now = esp_log_timestamp();
+            if (now - last_report >= 10000) {
+                report_losses();
+                last_report = now;
+            }
+            vTaskDelay(pdMS_TO_TICKS(DLOG_IDLE_POLL_MS));
+        }
+    }
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+esp_err_t dlog_init(void) {
+    if (s_task) {
+        return ESP_OK;
+    }
+
+    s_drain_mutex = rtos_static_mutex_create(&dlog_drain);
+    if (!s_drain_mutex) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // IDLE приоритет: вывод только когда ядру больше нечего делать
+    BaseType_t ret = rtos_static_task_create(&dlog, dlog_task, "dlog", NULL, tskIDLE_PRIORITY, &s_task);
+    if (ret != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Deferred logging: %d byte ring, floor %d, %d msg/s per tag",
+             DLOG_BUFFER_SIZE, CONFIG_DLOG_FLOOR, CONFIG_DLOG_RATE_PER_SEC);
+    return ESP_OK;
+}
+
+esp_err_t dlog_set_tag_rate(const char *tag, uint16_t per_sec, uint16_t burst) {
+    if (!tag) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (burst == 0) {
+        burst = per_sec ? per_sec : 1;
+    }
+
+    // Уже встречавшиеся теги (все указатели с таким именем)
+    for (int i = 0; i < DLOG_TAG_SLOTS; i++) {
+        if (s_tags[i].tag && strcmp(s_tags[i].tag, tag) == 0) {
+            s_tags[i].per_sec = per_sec;
+            s_tags[i].burst = burst;
+            s_tags[i].tokens_x1000 = burst * 1000;
+        }
+    }
+
+    for (int i = 0; i < s_override_count; i++) {
+        if (strcmp(s_overrides[i].name, tag) == 0) {
+            s_overrides[i].per_sec = per_sec;
+            s_overrides[i].burst = burst;
+            return ESP_OK;
+        }
+    }
+    if (s_override_count >= (int)(sizeof(s_overrides) / sizeof(s_overrides[0]))) {
+        return ESP_ERR_NO_MEM;
+    }
+    dlog_tag_override_t *o = &s_overrides[s_override_count];
+    strncpy(o->name, tag, sizeof(o->name) - 1);
+    o->name[sizeof(o->name) - 1] = '\0';
+    o->per_sec = per_sec;
+    o->burst = burst;
+    s_override_count++;
+    return ESP_OK;
+}
+
+void dlog_flush(void) {
+    static char line[DLOG_LINE_LEN];
+    // До dlog_init() задачи вывода нет - блокировка не нужна
+    if (s_drain_mutex) {
+        xSemaphoreTake(s_drain_mutex, portMAX_DELAY);
+    }
+    while (drain_one(line)) {
+    }
+    if (s_drain_mutex) {
+        xSemaphoreGive(s_drain_mutex);
+    }
+    report_losses();
+}
+
+void dlog_get_stats(uint32_t *dropped, uint32_t *suppressed) {
+    if (dropped) {
+        *dropped = __atomic_load_n(&s_dropped, __ATOMIC_RELAXED);
+    }
+    if (suppressed) {
+        *suppressed = __atomic_load_n(&s_suppressed_total, __ATOMIC_RELAXED);
+    }
+}
+
+#else // CONFIG_DLOG_ENABLE
+
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt,
+                int nargs, const dlog_arg_t *args) {
+}
+
+esp_err_t dlog_init(void) {
+    ESP_LOGD(TAG, "Deferred logging disabled in Kconfig");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t dlog_set_tag_rate(const char *tag, uint16_t per_sec, uint16_t burst) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void dlog_flush(void) {
+}
+
+void dlog_get_stats(uint32_t *dropped, uint32_t *suppressed) {
+    if (dropped) {
+        *dropped = 0;
+    }
+    if (suppressed) {
+        *suppressed = 0;
+    }
+}
+
+#endif // CONFIG_DLOG_ENABLE
@@ -0,0 +1,181 @@
+/**
+ * @file dlog.h
+ * @brief Отложенное логирование: горячий путь пишет формат и сырые аргументы
+ *
+ * DLOG_I(TAG, "Pump %d: %lu ms", pump, duration) кладёт в lock-free кольцо
+ * указатель на формат, тег, метку времени и аргументы (строки копируются,
+ * до CONFIG_DLOG_MAX_STR символов). Форматирование и вывод в UART делает
+ * задача с приоритетом IDLE через esp_log_write() - уровни тегов
+ * esp_log_level_set() продолжают действовать.
+ *
+ * - Компиляционный порог CONFIG_DLOG_FLOOR: вызовы ниже него не компилируются
+ * - Лимит сообщений на тег (token bucket), подавленные считаются и
+ *   выводятся одной строкой
+ * - Кольцо полно - сообщение отбрасывается (счётчик), вызывающий не ждёт
+ * - DLOG выключен в Kconfig - макросы превращаются в обычные ESP_LOGx
+ *
+ * Аргументов - до DLOG_MAX_ARGS. Поддерживаются спецификаторы
+ * d i u x X o c p s f F e E g G a A (длина l/ll/h/z/j/t допускается), '*' - нет.
+ */
+
+#ifndef DLOG_H
+#define DLOG_H
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DLOG_MAX_ARGS           10
+
+/**
+ * @brief Тип аргумента в кольце
+ */
+typedef enum {
+    DLOG_ARG_U32 = 0,
+    DLOG_ARG_U64,
+    DLOG_ARG_F64,
+    DLOG_ARG_PTR,
+    DLOG_ARG_STR,
+} dlog_arg_type_t;
+
+/**
+ * @brief Аргумент до записи в кольцо
+ */
+typedef struct {
+    uint8_t type;                   ///< dlog_arg_type_t
+    union {
+        uint32_t u32;
+        uint64_t u64;
+        double f64;
+        const void *ptr;
+        const char *str;
+    };
+} dlog_arg_t;
+
+static inline dlog_arg_t dlog_arg_u32(uint32_t v) { dlog_arg_t a = { .type = DLOG_ARG_U32 }; a.u32 = v; return a; }
+static inline dlog_arg_t dlog_arg_u64(uint64_t v) { dlog_arg_t a = { .type = DLOG_ARG_U64 }; a.u64 = v; return a; }
+static inline dlog_arg_t dlog_arg_f64(double v) { dlog_arg_t a = { .type = DLOG_ARG_F64 }; a.f64 = v; return a; }
+static inline dlog_arg_t dlog_arg_ptr(const void *v) { dlog_arg_t a = { .type = DLOG_ARG_PTR }; a.ptr = v; return a; }
+static inline dlog_arg_t dlog_arg_str(const char *v) { dlog_arg_t a = { .type = DLOG_ARG_STR }; a.str = v; return a; }
+
+// Тип аргумента определяется при компиляции
+#define DLOG_ARG(x) _Generic((x),                                   \
+    char *: dlog_arg_str, const char *: dlog_arg_str,               \
+    float: dlog_arg_f64, double: dlog_arg_f64,                      \
+    long long: dlog_arg_u64, unsigned long long: dlog_arg_u64,      \
+    void *: dlog_arg_ptr, const void *: dlog_arg_ptr,               \
+    uint8_t *: dlog_arg_ptr, const uint8_t *: dlog_arg_ptr,         \
+    default: dlog_arg_u32)(x)
+
+/**
+ * @brief Запись сообщения в кольцо (вызывается макросами DLOG_x)
+ *
+ * @param level Уровень
+ * @param tag Тег (строка должна жить всё время работы)
+ * @param fmt Формат (строка должна жить всё время работы - литерал)
+ * @param nargs Число аргументов
+ * @param args Аргументы
+ */
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt,
+                int nargs, const dlog_arg_t *args);
+
+/**
+ * @brief Запуск задачи вывода
+ *
+ * До запуска сообщения копятся в кольце.
+ *
+ * @return ESP_OK, ESP_ERR_NO_MEM, ESP_ERR_NOT_SUPPORTED если выключено в Kconfig
+ */
+esp_err_t dlog_init(void);
+
+/**
+ * @brief Лимит сообщений для тега (вместо CONFIG_DLOG_RATE_PER_SEC)
+ *
+ * @param tag Тег
+ * @param per_sec Сообщений в секунду (0 - без лимита)
+ * @param burst Допустимая пачка
+ * @return ESP_OK, ESP_ERR_NO_MEM если таблица тегов заполнена
+ */
+esp_err_t dlog_set_tag_rate(const char *tag, uint16_t per_sec, uint16_t burst);
+
+/**
+ * @brief Синхронный вывод всего накопленного (перед esp_restart)
+ */
+void dlog_flush(void);
+
+/**
+ * @brief Счётчики
+ *
+ * @param dropped Отброшено из-за полного кольца (может быть NULL)
+ * @param suppressed Подавлено лимитами тегов (может быть NULL)
+ */
+void dlog_get_stats(uint32_t *dropped, uint32_t *suppressed);
+
+// ============================================================================
+// Макросы
+// ============================================================================
+
+#define DLOG_NARGS(...)     DLOG_NARGS_(0, ##__VA_ARGS__, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, N, ...) N
+
+#define DLOG_CAT(a, b)      DLOG_CAT_(a, b)
+#define DLOG_CAT_(a, b)     a##b
+
+#define DLOG_ARGS_0()                                   NULL
+#define DLOG_ARGS_1(a)                                  (const dlog_arg_t[]){ DLOG_ARG(a) }
+#define DLOG_ARGS_2(a, b)                               (const dlog_arg_t[]){ DLOG_ARG(a), DLOG_ARG(b) }
+#define DLOG_ARGS_3(a, b, c)                            (const dlog_arg_t[]){ DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c) }
+#define DLOG_ARGS_4(a, b, c, d)                         (const dlog_arg_t[]){ DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c), DLOG_ARG(d) }
+#define DLOG_ARGS_5(a, b, c, d, e)                      (const dlog_arg_t[]){ DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c), DLOG_ARG(d), DLOG_ARG(e) }
+#define DLOG_ARGS_6(a, b, c, d, e, f)                   (const dlog_arg_t[]){ DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c), DLOG_ARG(d), DLOG_ARG(e), DLOG_ARG(f) }
+#define DLOG_ARGS_7(a, b, c, d, e, f, g)                (const dlog_arg_t[]){ DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c), DLOG_ARG(d), DLOG_ARG(e), DLOG_ARG(f), DLOG_ARG(g) }
+#define DLOG_ARGS_8(a, b, c, d, e, f, g, h)             (const dlog_arg_t[]){ DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c), DLOG_ARG(d), DLOG_ARG(e), DLOG_ARG(f), DLOG_ARG(g), DLOG_ARG(h) }
+#define DLOG_ARGS_9(a, b, c, d, e, f, g, h, i)          (const dlog_arg_t[]){ DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c), DLOG_ARG(d), DLOG_ARG(e), DLOG_ARG(f), DLOG_ARG(g), DLOG_ARG(h), DLOG_ARG(i) }
+#define DLOG_ARGS_10(a, b, c, d, e, f, g, h, i, j)      (const dlog_arg_t[]){ DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c), DLOG_ARG(d), DLOG_ARG(e), DLOG_ARG(f), DLOG_ARG(g), DLOG_ARG(h), DLOG_ARG(i), DLOG_ARG(j) }
+
+#define DLOG_LEVEL(level, tag, fmt, ...) \
+    dlog_write((level), (tag), (fmt), DLOG_NARGS(__VA_ARGS__), DLOG_CAT(DLOG_ARGS_, DLOG_NARGS(__VA_ARGS__))(__VA_ARGS__))
+
+#ifdef CONFIG_DLOG_ENABLE
+
+// Порог: ERROR=1, WARN=2, INFO=3, DEBUG=4 (как esp_log_level_t)
+#if CONFIG_DLOG_FLOOR >= 1
+#define DLOG_E(tag, fmt, ...)   DLOG_LEVEL(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_E(tag, fmt, ...)   ((void)0)
+#endif
+#if CONFIG_DLOG_FLOOR >= 2
+#define DLOG_W(tag, fmt, ...)   DLOG_LEVEL(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_W(tag, fmt, ...)   ((void)0)
+#endif
+#if CONFIG_DLOG_FLOOR >= 3
+#define DLOG_I(tag, fmt, ...)   DLOG_LEVEL(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_I(tag, fmt, ...)   ((void)0)
+#endif
+#if CONFIG_DLOG_FLOOR >= 4
+#define DLOG_D(tag, fmt, ...)   DLOG_LEVEL(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_D(tag, fmt, ...)   ((void)0)
+#endif
+
+#else // CONFIG_DLOG_ENABLE
+
+#define DLOG_E(tag, fmt, ...)   ESP_LOGE(tag, fmt, ##__VA_ARGS__)
+#define DLOG_W(tag, fmt, ...)   ESP_LOGW(tag, fmt, ##__VA_ARGS__)
+#define DLOG_I(tag, fmt, ...)   ESP_LOGI(tag, fmt, ##__VA_ARGS__)
+#define DLOG_D(tag, fmt, ...)   ESP_LOGD(tag, fmt, ##__VA_ARGS__)
+
+#endif // CONFIG_DLOG_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DLOG_H
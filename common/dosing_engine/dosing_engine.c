@@ -0,0 +1,482 @@
+/**
+ * @file dosing_engine.c
+ * @brief Реализация контуров дозирования
+ *
+ * LOOPS[] - константная таблица контуров узла (во flash), s_loops[] - два
+ * adaptive_pid на контур: [0] повышение, [1] понижение, и состояние
+ * релейной автонастройки.
+ */
+
+#include "dosing_engine.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <math.h>
+#include <string.h>
+
+static const char *TAG = "dosing";
+
+#define DOSING_PUMPS_PER_DIR    3
+#define DOSING_PUMP_GAP_MS      100     // Пауза между насосами одного направления
+
+#define AUTOTUNE_DOSE_FRACTION  0.1f    // Доза реле по умолчанию от max_dose_ml
+#define AUTOTUNE_CYCLES         4
+#define AUTOTUNE_CYCLES_MIN     2
+#define AUTOTUNE_CYCLES_MAX     8
+#define AUTOTUNE_TIMEOUT_US     (4ULL * 3600ULL * 1000000ULL)
+
+/**
+ * @brief Насосы направления и доли дозы
+ */
+typedef struct {
+    uint8_t count;                      ///< 0 - направление не управляется
+    pump_id_t pumps[DOSING_PUMPS_PER_DIR];
+    float split[DOSING_PUMPS_PER_DIR];
+} dosing_channel_t;
+
+/**
+ * @brief Описание контура
+ */
+typedef struct {
+    const char *name;
+    dosing_channel_t raise;
+    dosing_channel_t lower;
+    pid_zones_config_t zones;
+    float max_dose_ml;
+    uint32_t min_interval_ms;
+} dosing_loop_def_t;
+
+static const dosing_loop_def_t LOOPS[DOSING_LOOP_COUNT] = {
+#ifdef CONFIG_DOSING_HAS_PH
+    [DOSING_LOOP_PH] = {
+        .name = "ph",
+        .raise = { 1, { PUMP_PH_UP }, { 1.0f } },
+        .lower = { 1, { PUMP_PH_DOWN }, { 1.0f } },
+        .zones = { 0.1f, 0.3f, 1.0f },
+        .max_dose_ml = 5.0f,
+        .min_interval_ms = 60000,
+    },
+#endif
+#ifdef CONFIG_DOSING_HAS_EC
+    // EC не понижается насосами - только разбавлением
+    [DOSING_LOOP_EC] = {
+        .name = "ec",
+        .raise = { 3, { PUMP_EC_A, PUMP_EC_B, PUMP_EC_C }, { 0.5f, 0.4f, 0.1f } },
+        .lower = { 0 },
+        .zones = { 0.2f, 0.5f, 1.5f },
+        .max_dose_ml = 10.0f,
+        .min_interval_ms = 60000,
+    },
+#endif
+};
+
+/**
+ * @brief Релейный эксперимент контура
+ */
+typedef struct {
+    dosing_autotune_t pub;
+    dosing_dir_t relay;                 ///< NONE до первого шага
+    float hysteresis;
+    uint64_t start_us;
+    uint64_t last_dose_us;
+    uint64_t last_rise_us;              ///< Последнее пересечение цели вверх
+    bool measuring;                     ///< Было первое пересечение вверх
+    bool settled;                       ///< Первое колебание (переходное) пропущено
+    bool pending;                       ///< Есть новое для autotune_poll
+    float peak_max;
+    float peak_min;
+    float sum_period_s;
+    float sum_amplitude;
+} autotune_state_t;
+
+typedef struct {
+    adaptive_pid_t pid[2];              ///< [0] повышение, [1] понижение
+    float target;
+    autotune_state_t at;
+} loop_state_t;
+
+static loop_state_t s_loops[DOSING_LOOP_COUNT];
+
+static void autotune_step(dosing_loop_t loop, float value, float dt_s, dosing_result_t *res);
+
+// Насосы направления по очереди, доза делится по долям канала
+static void run_channel(const dosing_channel_t *ch, float dose_ml) {
+    for (int i = 0; i < ch->count; i++) {
+        if (i > 0) {
+            vTaskDelay(pdMS_TO_TICKS(DOSING_PUMP_GAP_MS));
+        }
+        pump_controller_run_dose(ch->pumps[i], dose_ml * ch->split[i]);
+    }
+}
+
+static void init_direction(adaptive_pid_t *pid, const dosing_loop_def_t *def,
+                           const dosing_channel_t *ch, float setpoint,
+                           const pump_pid_t pump_pid[PUMP_MAX]) {
+    const pump_pid_t *coeffs = &pump_pid[ch->pumps[0]];
+    adaptive_pid_init(pid, setpoint, coeffs->kp, coeffs->ki, coeffs->kd);
+    adaptive_pid_set_zones(pid, def->zones.dead_zone, def->zones.close_zone, def->zones.far_zone);
+    adaptive_pid_set_safety(pid, def->max_dose_ml, def->min_interval_ms);
+    adaptive_pid_set_output_limits(pid, 0.0f, def->max_dose_ml);
+#ifdef CONFIG_DOSING_SMITH_PREDICTOR
+    // Усиление и смешивание - из идентифицированной модели направления
+    adaptive_pid_set_smith_predictor(pid, true, 0.0f, 0.0f, (float)CONFIG_DOSING_SMITH_DEAD_TIME_S);
+#endif
+}
+
+esp_err_t dosing_engine_init(const float targets[DOSING_LOOP_COUNT],
+                             const pump_pid_t pump_pid[PUMP_MAX]) {
+    if (targets == NULL || pump_pid == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int i = 0; i < DOSING_LOOP_COUNT; i++) {
+        const dosing_loop_def_t *def = &LOOPS[i];
+        loop_state_t *st = &s_loops[i];
+
+        st->target = targets[i];
+        init_direction(&st->pid[0], def, &def->raise, targets[i], pump_pid);
+        // Понижение - зеркальная ошибка: setpoint = -target, вход = -value
+        if (def->lower.count > 0) {
+            init_direction(&st->pid[1], def, &def->lower, -targets[i], pump_pid);
+        }
+
+        ESP_LOGI(TAG, "Loop %s: target %.2f, %d raise / %d lower pumps", def->name,
+                 targets[i], def->raise.count, def->lower.count);
+    }
+    return ESP_OK;
+}
+
+esp_err_t dosing_engine_set_target(dosing_loop_t loop, float target) {
+    if (loop >= DOSING_LOOP_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    loop_state_t *st = &s_loops[loop];
+    st->target = target;
+    adaptive_pid_set_setpoint(&st->pid[0], target);
+    if (LOOPS[loop].lower.count > 0) {
+        adaptive_pid_set_setpoint(&st->pid[1], -target);
+    }
+    return ESP_OK;
+}
+
+float dosing_engine_get_target(dosing_loop_t loop) {
+    return loop < DOSING_LOOP_COUNT ? s_loops[loop].target : 0.0f;
+}
+
+esp_err_t dosing_engine_control(dosing_loop_t loop, float value, float dt_s,
+                                dosing_result_t *result) {
+    dosing_result_t res = { .dir = DOSING_NONE, .dose_ml = 0.0f, .zone = ZONE_DEAD };
+    if (result) {
+        *result = res;
+    }
+    if (loop >= DOSING_LOOP_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const dosing_loop_def_t *def = &LOOPS[loop];
+    loop_state_t *st = &s_loops[loop];
+    const dosing_channel_t *ch;
+    adaptive_pid_t *pid;
+    float input;
+
+    // Автонастройка: реле вместо PID
+    if (st->at.pub.state == DOSING_AUTOTUNE_RUNNING) {
+        autotune_step(loop, value, dt_s, &res);
+        if (result) {
+            *result = res;
+        }
+        return ESP_OK;
+    }
+
+    if (value < st->target) {
+        res.dir = DOSING_RAISE;
+        ch = &def->raise;
+        pid = &st->pid[0];
+        input = value;
+    } else if (value > st->target && def->lower.count > 0) {
+        res.dir = DOSING_LOWER;
+        ch = &def->lower;
+        pid = &st->pid[1];
+        input = -value;
+    } else {
+        return ESP_OK;
+    }
+
+    float output = 0.0f;
+    esp_err_t err = adaptive_pid_compute(pid, input, dt_s, &output);
+    res.zone = adaptive_pid_get_zone(pid);
+    if (err != ESP_OK || output <= 0.0f) {
+        res.dir = DOSING_NONE;
+        if (result) {
+            *result = res;
+        }
+        return err;
+    }
+    res.dose_ml = output;
+
+    ESP_LOGI(TAG, "%s %s: %.2f ml [%s zone] (current=%.2f, target=%.2f)", def->name,
+             res.dir == DOSING_RAISE ? "raise" : "lower", output,
+             adaptive_pid_zone_to_str(res.zone), value, st->target);
+
+    run_channel(ch, output);
+
+    if (result) {
+        *result = res;
+    }
+    return ESP_OK;
+}
+
+adaptive_pid_t* dosing_engine_get_pid(dosing_loop_t loop, dosing_dir_t dir) {
+    if (loop >= DOSING_LOOP_COUNT) {
+        return NULL;
+    }
+    if (dir == DOSING_RAISE) {
+        return &s_loops[loop].pid[0];
+    }
+    if (dir == DOSING_LOWER && LOOPS[loop].lower.count > 0) {
+        return &s_loops[loop].pid[1];
+    }
+    return NULL;
+}
+
+// ============================================================================
+// РЕЛЕЙНАЯ АВТОНАСТРОЙКА
+// ============================================================================
+//
+// Реле с гистерезисом ε: ниже цели - доза d повышения, выше - доза d
+// понижения (или пауза), дозы не чаще safety интервала Ts. Значение
+// колеблется вокруг цели с амплитудой a и периодом Pu; по описывающей
+// функции реле предельное усиление Ku = 4h / (π·√(a² - ε²)), где h = d для
+// двустороннего реле и d/2 для одностороннего. Ku - в единицах Kp
+// adaptive_pid (мл за дозу на единицу ошибки), так как PID тоже дозирует
+// раз в Ts.
+
+static void autotune_fail(loop_state_t *st, const char *reason) {
+    st->at.pub.state = DOSING_AUTOTUNE_FAILED;
+    st->at.pub.error = reason;
+    st->at.pending = true;
+}
+
+static void autotune_finish(dosing_loop_t loop, float dt_s) {
+    const dosing_loop_def_t *def = &LOOPS[loop];
+    loop_state_t *st = &s_loops[loop];
+    autotune_state_t *at = &st->at;
+    dosing_autotune_t *r = &at->pub;
+
+    r->amplitude = at->sum_amplitude / r->cycles;
+    r->pu_s = at->sum_period_s / r->cycles;
+    if (r->amplitude <= at->hysteresis || r->pu_s <= 0.0f) {
+        ESP_LOGW(TAG, "Autotune %s: no oscillation (a=%.3f)", def->name, r->amplitude);
+        autotune_fail(st, "no oscillation");
+        return;
+    }
+
+    float a_eff = sqrtf(r->amplitude * r->amplitude - at->hysteresis * at->hysteresis);
+    float h = def->lower.count > 0 ? r->dose_ml : r->dose_ml * 0.5f;
+    r->ku = 4.0f * h / ((float)M_PI * a_eff);
+
+    // CLOSE - Tyreus–Luyben PI (мало перерегулирования), FAR - Ziegler–Nichols PI
+    adaptive_pid_t *ref = &st->pid[0];
+    r->close.kp = r->ku / 3.2f;
+    r->close.ki = adaptive_pid_ki_from_ti(ref, r->close.kp, 2.2f * r->pu_s, dt_s);
+    r->close.kd = 0.0f;
+    r->far.kp = 0.45f * r->ku;
+    r->far.ki = adaptive_pid_ki_from_ti(ref, r->far.kp, r->pu_s / 1.2f, dt_s);
+    r->far.kd = 0.0f;
+
+    for (int i = 0; i < (def->lower.count > 0 ? 2 : 1); i++) {
+        adaptive_pid_t *pid = &st->pid[i];
+        adaptive_pid_set_zone_coeffs(pid, ZONE_CLOSE, r->close.kp, r->close.ki, r->close.kd);
+        adaptive_pid_set_zone_coeffs(pid, ZONE_FAR, r->far.kp, r->far.ki, r->far.kd);
+        adaptive_pid_reset(pid);
+    }
+
+    r->state = DOSING_AUTOTUNE_DONE;
+    at->pending = true;
+    ESP_LOGI(TAG, "Autotune %s done: Ku=%.3f, Pu=%.0f s, a=%.3f -> close Kp=%.3f Ki=%.4f",
+             def->name, r->ku, r->pu_s, r->amplitude, r->close.kp, r->close.ki);
+}
+
+// Пересечение цели вверх - граница колебания
+static void autotune_rise(dosing_loop_t loop, float value, float dt_s, uint64_t now) {
+    autotune_state_t *at = &s_loops[loop].at;
+
+    if (at->measuring) {
+        if (!at->settled) {
+            at->settled = true;
+        } else {
+            at->sum_period_s += (now - at->last_rise_us) / 1000000.0f;
+            at->sum_amplitude += (at->peak_max - at->peak_min) * 0.5f;
+            at->pub.cycles++;
+            at->pending = true;
+            ESP_LOGI(TAG, "Autotune %s: cycle %d/%d", LOOPS[loop].name,
+                     at->pub.cycles, at->pub.cycles_needed);
+        }
+    }
+    at->measuring = true;
+    at->last_rise_us = now;
+    at->peak_max = value;
+    at->peak_min = value;
+
+    if (at->pub.cycles >= at->pub.cycles_needed) {
+        autotune_finish(loop, dt_s);
+    }
+}
+
+static void autotune_step(dosing_loop_t loop, float value, float dt_s, dosing_result_t *res) {
+    const dosing_loop_def_t *def = &LOOPS[loop];
+    loop_state_t *st = &s_loops[loop];
+    autotune_state_t *at = &st->at;
+    uint64_t now = esp_timer_get_time();
+    float error = value - st->target;
+
+    // Эксперимент ограничен дальней зоной контура и по времени
+    if (fabsf(error) > def->zones.far_zone) {
+        ESP_LOGW(TAG, "Autotune %s aborted: %.2f out of bounds", def->name, value);
+        autotune_fail(st, "out of bounds");
+        return;
+    }
+    if (now - at->start_us > AUTOTUNE_TIMEOUT_US) {
+        ESP_LOGW(TAG, "Autotune %s aborted: timeout", def->name);
+        autotune_fail(st, "timeout");
+        return;
+    }
+
+    if (at->relay == DOSING_NONE) {
+        at->relay = error < 0.0f ? DOSING_RAISE : DOSING_LOWER;
+    }
+    if (at->relay == DOSING_RAISE && error > at->hysteresis) {
+        at->relay = DOSING_LOWER;
+        autotune_rise(loop, value, dt_s, now);
+        if (at->pub.state != DOSING_AUTOTUNE_RUNNING) {
+            return;
+        }
+    } else if (at->relay == DOSING_LOWER && error < -at->hysteresis) {
+        at->relay = DOSING_RAISE;
+    }
+
+    if (at->measuring) {
+        at->peak_max = fmaxf(at->peak_max, value);
+        at->peak_min = fminf(at->peak_min, value);
+    }
+
+    const dosing_channel_t *ch = at->relay == DOSING_RAISE ? &def->raise : &def->lower;
+    uint64_t interval_us = (uint64_t)def->min_interval_ms * 1000;
+    if (ch->count == 0 || (at->last_dose_us != 0 && now - at->last_dose_us < interval_us)) {
+        return;
+    }
+
+    res->dir = at->relay;
+    res->dose_ml = at->pub.dose_ml;
+    res->zone = ZONE_CLOSE;
+    run_channel(ch, at->pub.dose_ml);
+    at->last_dose_us = now;
+}
+
+esp_err_t dosing_engine_autotune_start(dosing_loop_t loop, float dose_ml, uint8_t cycles,
+                                       const pump_calibration_t calibration[PUMP_MAX]) {
+    if (loop >= DOSING_LOOP_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const dosing_loop_def_t *def = &LOOPS[loop];
+    autotune_state_t *at = &s_loops[loop].at;
+    if (at->pub.state == DOSING_AUTOTUNE_RUNNING) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (dose_ml == 0.0f) {
+        dose_ml = def->max_dose_ml * AUTOTUNE_DOSE_FRACTION;
+    }
+    if (cycles == 0) {
+        cycles = AUTOTUNE_CYCLES;
+    }
+    if (dose_ml < 0.0f || dose_ml > def->max_dose_ml * 0.5f ||
+        cycles < AUTOTUNE_CYCLES_MIN || cycles > AUTOTUNE_CYCLES_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Доза реле - объём, без калибровки насосов результат не имеет смысла
+    if (calibration) {
+        const dosing_channel_t *chs[2] = { &def->raise, &def->lower };
+        for (int c = 0; c < 2; c++) {
+            for (int i = 0; i < chs[c]->count; i++) {
+                pump_id_t pump = chs[c]->pumps[i];
+                if (!calibration[pump].is_calibrated) {
+                    ESP_LOGW(TAG, "Autotune %s: pump %s not calibrated", def->name,
+                             pump_controller_name(pump));
+                    return ESP_ERR_INVALID_STATE;
+                }
+            }
+        }
+    }
+
+    memset(at, 0, sizeof(*at));
+    at->pub.state = DOSING_AUTOTUNE_RUNNING;
+    at->pub.cycles_needed = cycles;
+    at->pub.dose_ml = dose_ml;
+    at->relay = DOSING_NONE;
+    at->hysteresis = def->zones.dead_zone * 0.5f;
+    at->start_us = esp_timer_get_time();
+
+    ESP_LOGI(TAG, "Autotune %s started: dose %.2f ml, %d cycles, hysteresis %.3f",
+             def->name, dose_ml, cycles, at->hysteresis);
+    return ESP_OK;
+}
+
+esp_err_t dosing_engine_autotune_stop(dosing_loop_t loop) {
+    if (loop >= DOSING_LOOP_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_loops[loop].at.pub.state != DOSING_AUTOTUNE_RUNNING) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    autotune_fail(&s_loops[loop], "stopped");
+    ESP_LOGI(TAG, "Autotune %s stopped", LOOPS[loop].name);
+    return ESP_OK;
+}
+
+bool dosing_engine_autotune_poll(dosing_loop_t loop, dosing_autotune_t *status) {
+    if (loop >= DOSING_LOOP_COUNT) {
+        return false;
+    }
+
+    autotune_state_t *at = &s_loops[loop].at;
+    if (status) {
+        *status = at->pub;
+    }
+    bool pending = at->pending;
+    at->pending = false;
+    return pending;
+}
+
+esp_err_t dosing_engine_autotune_apply(dosing_loop_t loop, pump_pid_t pump_pid[PUMP_MAX]) {
+    if (loop >= DOSING_LOOP_COUNT || pump_pid == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const dosing_loop_def_t *def = &LOOPS[loop];
+    const dosing_autotune_t *r = &s_loops[loop].at.pub;
+    if (r->state != DOSING_AUTOTUNE_DONE) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // После перезагрузки FAR снова выводится из CLOSE (adaptive_pid_init)
+    const dosing_channel_t *chs[2] = { &def->raise, &def->lower };
+    for (int c = 0; c < 2; c++) {
+        for (int i = 0; i < chs[c]->count; i++) {
+            pump_pid_t *pp = &pump_pid[chs[c]->pumps[i]];
+            pp->kp = r->close.kp;
+            pp->ki = r->close.ki;
+            pp->kd = r->close.kd;
+        }
+    }
+    return ESP_OK;
+}
+
+const char* dosing_engine_loop_name(dosing_loop_t loop) {
+    return loop < DOSING_LOOP_COUNT ? LOOPS[loop].name : "unknown";
+}
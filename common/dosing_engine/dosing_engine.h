@@ -0,0 +1,195 @@
+/**
+ * @file dosing_engine.h
+ * @brief Контуры дозирования pH/EC: таблица контуров времени компиляции
+ *
+ * Один код управления для node_ph, node_ec и node_ph_ec. Набор контуров
+ * следует типу узла из Kconfig (DOSING_NODE_PH / EC / PH_EC, меню
+ * "Dosing Hardware" компонента pump_controller):
+ *
+ * - pH: повышение PH_UP, понижение PH_DOWN, зоны 0.1 / 0.3 / 1.0,
+ *   доза до 5 мл
+ * - EC: повышение A 50% + B 40% + C 10%, понижения нет (разбавление),
+ *   зоны 0.2 / 0.5 / 1.5, доза до 10 мл
+ *
+ * Минимальный интервал между дозами контура - 60 с. Таблица и номера
+ * насосов - константы, контур - прямой индекс, косвенных вызовов нет.
+ *
+ * Каждое направление - свой adaptive_pid с коэффициентами из
+ * pump_pid[] конфигурации (насос повышения / понижения). PID понижения
+ * считает зеркальную ошибку (значение - цель), чтобы его выход тоже был
+ * дозой >= 0.
+ *
+ * С CONFIG_DOSING_SMITH_PREDICTOR PID направлений работают с предиктором
+ * Смита по идентифицированной модели дозы.
+ *
+ * Автонастройка контура - релейный эксперимент (Åström–Hägglund): пока он
+ * идёт, dosing_engine_control() вместо PID дозирует фиксированную малую
+ * дозу по знаку ошибки и измеряет колебания значения.
+ */
+
+#ifndef DOSING_ENGINE_H
+#define DOSING_ENGINE_H
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "adaptive_pid.h"
+#include "pump_controller.h"
+#include "node_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Контуры узла
+ */
+typedef enum {
+#ifdef CONFIG_DOSING_HAS_PH
+    DOSING_LOOP_PH,
+#endif
+#ifdef CONFIG_DOSING_HAS_EC
+    DOSING_LOOP_EC,
+#endif
+    DOSING_LOOP_COUNT
+} dosing_loop_t;
+
+/**
+ * @brief Направление коррекции
+ */
+typedef enum {
+    DOSING_NONE = 0,        ///< Доза не нужна или не разрешена (зона, интервал)
+    DOSING_RAISE,           ///< Повышение значения
+    DOSING_LOWER,           ///< Понижение значения
+} dosing_dir_t;
+
+/**
+ * @brief Результат шага контура
+ */
+typedef struct {
+    dosing_dir_t dir;
+    float dose_ml;          ///< Общая доза (до распределения по насосам)
+    pid_zone_t zone;        ///< Зона PID направления
+} dosing_result_t;
+
+/**
+ * @brief Состояние автонастройки контура
+ */
+typedef enum {
+    DOSING_AUTOTUNE_IDLE = 0,
+    DOSING_AUTOTUNE_RUNNING,    ///< Релейный эксперимент идёт
+    DOSING_AUTOTUNE_DONE,       ///< Коэффициенты рассчитаны и применены
+    DOSING_AUTOTUNE_FAILED,     ///< Прервано (error - причина)
+} dosing_autotune_state_t;
+
+/**
+ * @brief Ход и результат автонастройки
+ */
+typedef struct {
+    dosing_autotune_state_t state;
+    uint8_t cycles;             ///< Измерено полных колебаний
+    uint8_t cycles_needed;
+    float dose_ml;              ///< Доза реле
+    float amplitude;            ///< Средняя амплитуда колебаний
+    float ku;                   ///< Предельное усиление (мл на единицу ошибки за дозу)
+    float pu_s;                 ///< Период колебаний (с)
+    pid_coeffs_t close;         ///< Зона CLOSE (Tyreus–Luyben PI)
+    pid_coeffs_t far;           ///< Зона FAR (Ziegler–Nichols PI)
+    const char *error;          ///< Причина FAILED
+} dosing_autotune_t;
+
+/**
+ * @brief Инициализация PID всех контуров
+ *
+ * Повторный вызов (новые коэффициенты) сбрасывает состояние PID.
+ *
+ * @param targets Цели контуров, индекс - dosing_loop_t
+ * @param pump_pid Коэффициенты, индекс - pump_id_t (pump_pid[] конфигурации узла)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG
+ */
+esp_err_t dosing_engine_init(const float targets[DOSING_LOOP_COUNT],
+                             const pump_pid_t pump_pid[PUMP_MAX]);
+
+/**
+ * @brief Новая цель контура
+ */
+esp_err_t dosing_engine_set_target(dosing_loop_t loop, float target);
+
+/**
+ * @brief Цель контура (0 для неизвестного контура)
+ */
+float dosing_engine_get_target(dosing_loop_t loop);
+
+/**
+ * @brief Шаг контура: расчёт PID и запуск насосов направления
+ *
+ * Несколько насосов направления запускаются по очереди с паузой 100 мс
+ * (вызывающая задача блокируется на это время).
+ *
+ * @param loop Контур
+ * @param value Текущее значение (с калибровкой)
+ * @param dt_s Период вызова (с), 0 < dt_s <= 10
+ * @param result Результат (может быть NULL)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG
+ */
+esp_err_t dosing_engine_control(dosing_loop_t loop, float value, float dt_s,
+                                dosing_result_t *result);
+
+/**
+ * @brief PID направления контура (статистика, настройка зон)
+ *
+ * @return NULL для неизвестного контура или направления без насоса
+ */
+adaptive_pid_t* dosing_engine_get_pid(dosing_loop_t loop, dosing_dir_t dir);
+
+/**
+ * @brief Запуск релейной автонастройки контура
+ *
+ * Ниже цели - доза dose_ml повышения, выше - понижения (для EC без насоса
+ * понижения - пауза, колебания дают потребление и разбавление). Дозы не
+ * чаще safety интервала контура, гистерезис реле - половина мёртвой зоны.
+ * Эксперимент прерывается, если значение уходит от цели дальше дальней
+ * зоны, и через 4 часа. По завершении коэффициенты CLOSE/FAR применяются к
+ * PID обоих направлений.
+ *
+ * @param loop Контур
+ * @param dose_ml Доза реле, 0 - 10% максимальной дозы контура; не больше половины
+ * @param cycles Колебаний для усреднения, 0 - 4 (2..8)
+ * @param calibration Калибровка насосов, индекс - pump_id_t; NULL - без проверки
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_INVALID_STATE (уже идёт или
+ *         насос контура не откалиброван)
+ */
+esp_err_t dosing_engine_autotune_start(dosing_loop_t loop, float dose_ml, uint8_t cycles,
+                                       const pump_calibration_t calibration[PUMP_MAX]);
+
+/**
+ * @brief Остановка автонастройки (команда, emergency); состояние FAILED
+ */
+esp_err_t dosing_engine_autotune_stop(dosing_loop_t loop);
+
+/**
+ * @brief Новое в автонастройке с прошлого вызова (колебание, завершение, ошибка)
+ *
+ * @param loop Контур
+ * @param status Текущее состояние (копия)
+ * @return true - есть о чём сообщить
+ */
+bool dosing_engine_autotune_poll(dosing_loop_t loop, dosing_autotune_t *status);
+
+/**
+ * @brief Запись коэффициентов CLOSE последней автонастройки в pump_pid[]
+ *        насосов контура (для сохранения в NVS)
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_STATE (нет результата), ESP_ERR_INVALID_ARG
+ */
+esp_err_t dosing_engine_autotune_apply(dosing_loop_t loop, pump_pid_t pump_pid[PUMP_MAX]);
+
+/**
+ * @brief Имя контура ("ph", "ec")
+ */
+const char* dosing_engine_loop_name(dosing_loop_t loop);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DOSING_ENGINE_H
@@ -0,0 +1,202 @@
+/**
+ * @file event_bus.c
+ * @brief Реализация шины событий
+ *
+ * Таблица подписчиков фиксированного размера. Занятая часть таблицы
+ * только растёт (s_sub_count), освобождённый слот помечается events = 0
+ * и переиспользуется следующей подпиской - публикующий читает таблицу без
+ * блокировки, как реестр арен в cjson_arena.
+ */
+
+#include "event_bus.h"
+#include "esp_log.h"
+#include "freertos/event_groups.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "event_bus";
+
+#ifdef CONFIG_EVENT_BUS_MAX_SUBSCRIBERS
+#define EVENT_BUS_MAX_SUBSCRIBERS   CONFIG_EVENT_BUS_MAX_SUBSCRIBERS
+#else
+#define EVENT_BUS_MAX_SUBSCRIBERS   16
+#endif
+
+#define STATE_MESH_UP               (1 << 0)
+
+typedef struct {
+    uint32_t events;                // 0 - слот свободен
+    uint32_t msg_types;
+    event_bus_handler_t handler;    // NULL - подписка задачи
+    void *ctx;
+    TaskHandle_t task;
+} subscriber_t;
+
+static subscriber_t s_subs[EVENT_BUS_MAX_SUBSCRIBERS];
+static int s_sub_count = 0;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static StaticEventGroup_t s_state_buf;
+static EventGroupHandle_t s_state = NULL;
+
+static EventGroupHandle_t state_group(void) {
+    if (!s_state) {
+        portENTER_CRITICAL(&s_lock);
+        if (!s_state) {
+            s_state = xEventGroupCreateStatic(&s_state_buf);
+        }
+        portEXIT_CRITICAL(&s_lock);
+    }
+    return s_state;
+}
+
+static esp_err_t add_subscriber(uint32_t events, uint32_t msg_types,
+                                event_bus_handler_t handler, void *ctx, TaskHandle_t task) {
+    if (events == 0 || (events >> EVENT_BUS_EVENT_COUNT) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    portENTER_CRITICAL(&s_lock);
+    int count = s_sub_count;
+    int slot = count;
+    for (int i = 0; i < count; i++) {
+        if (s_subs[i].events == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < EVENT_BUS_MAX_SUBSCRIBERS) {
+        subscriber_t *s = &s_subs[slot];
+        s->msg_types = msg_types;
+        s->handler = handler;
+        s->ctx = ctx;
+        s->task = task;
+        __atomic_store_n(&s->events, events, __ATOMIC_RELEASE);
+        if (slot == count) {
+            __atomic_store_n(&s_sub_count, count + 1, __ATOMIC_RELEASE);
+        }
+        ret = ESP_OK;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "No free subscriber slots (%d)", EVENT_BUS_MAX_SUBSCRIBERS);
+    }
+    return ret;
+}
+
+esp_err_t event_bus_subscribe(uint32_t events, uint32_t msg_types,
+                              event_bus_handler_t handler, void *ctx) {
+    if (!handler) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return add_subscriber(events, msg_types, handler, ctx, NULL);
+}
+
+esp_err_t event_bus_subscribe_task(uint32_t events, uint32_t msg_types, TaskHandle_t task) {
+    if (!task) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return add_subscriber(events, msg_types, NULL, NULL, task);
+}
+
+void event_bus_unsubscribe(event_bus_handler_t handler, void *ctx) {
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < s_sub_count; i++) {
+        if (s_subs[i].handler == handler && s_subs[i].ctx == ctx) {
+            __atomic_store_n(&s_subs[i].events, 0, __ATOMIC_RELEASE);
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void event_bus_unsubscribe_task(TaskHandle_t task) {
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < s_sub_count; i++) {
+        if (s_subs[i].handler == NULL && s_subs[i].task == task) {
+            __atomic_store_n(&s_subs[i].events, 0, __ATOMIC_RELEASE);
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+int event_bus_publish(const event_bus_event_t *event) {
+    if (!event || event->id >= EVENT_BUS_EVENT_COUNT) {
+        return 0;
+    }
+    if (event->id == EVENT_BUS_MESSAGE && !event->message.msg) {
+        return 0;
+    }
+
+    if (event->id == EVENT_BUS_MESH_UP) {
+        xEventGroupSetBits(state_group(), STATE_MESH_UP);
+    } else if (event->id == EVENT_BUS_MESH_DOWN) {
+        xEventGroupClearBits(state_group(), STATE_MESH_UP);
+    }
+
+    const uint32_t bit = EVENT_BUS_BIT(event->id);
+    int count = __atomic_load_n(&s_sub_count, __ATOMIC_ACQUIRE);
+    int delivered = 0;
+
+    for (int i = 0; i < count; i++) {
+        const subscriber_t *s = &s_subs[i];
+        if (!(__atomic_load_n(&s->events, __ATOMIC_ACQUIRE) & bit)) {
+            continue;
+        }
+        if (event->id == EVENT_BUS_MESSAGE && s->msg_types != EVENT_BUS_MSG_ALL &&
+            !(s->msg_types & EVENT_BUS_MSG_BIT(event->message.msg->type))) {
+            continue;
+        }
+
+        if (s->handler) {
+            s->handler(event, s->ctx);
+        } else {
+            xTaskNotify(s->task, bit, eSetBits);
+        }
+        delivered++;
+    }
+
+    ESP_LOGD(TAG, "Event %d delivered to %d subscribers", (int)event->id, delivered);
+    return delivered;
+}
+
+int event_bus_publish_message(const mesh_message_t *msg) {
+    event_bus_event_t event = {
+        .id = EVENT_BUS_MESSAGE,
+        .message = { .msg = msg },
+    };
+    return event_bus_publish(&event);
+}
+
+int event_bus_publish_config_changed(const char *source) {
+    event_bus_event_t event = {
+        .id = EVENT_BUS_CONFIG_CHANGED,
+        .config = { .source = source },
+    };
+    return event_bus_publish(&event);
+}
+
+int event_bus_publish_emergency(bool active, const char *reason) {
+    event_bus_event_t event = {
+        .id = EVENT_BUS_EMERGENCY,
+        .emergency = { .active = active, .reason = reason },
+    };
+    return event_bus_publish(&event);
+}
+
+uint32_t event_bus_task_wait(TickType_t timeout) {
+    uint32_t bits = 0;
+    if (xTaskNotifyWait(0, UINT32_MAX, &bits, timeout) != pdTRUE) {
+        return 0;
+    }
+    return bits;
+}
+
+bool event_bus_mesh_is_up(void) {
+    return (xEventGroupGetBits(state_group()) & STATE_MESH_UP) != 0;
+}
+
+bool event_bus_wait_mesh_up(TickType_t timeout) {
+    EventBits_t bits = xEventGroupWaitBits(state_group(), STATE_MESH_UP, pdFALSE, pdTRUE, timeout);
+    return (bits & STATE_MESH_UP) != 0;
+}
@@ -0,0 +1,183 @@
+/**
+ * @file event_bus.h
+ * @brief Типизированная шина событий узла (publish/subscribe)
+ *
+ * Вместо опроса mesh_manager_is_connected() в циклах и единственного
+ * recv callback компоненты подписываются на события и просыпаются по ним:
+ *
+ * - Обработчик (event_bus_subscribe) вызывается синхронно в контексте
+ *   публикующего (задача mesh_recv, задача esp_event, задача менеджера).
+ *   Данные события не копируются: все подписчики получают один и тот же
+ *   указатель, действительный только на время вызова. Обработчик должен
+ *   быть коротким и не блокироваться.
+ * - Задача (event_bus_subscribe_task) получает бит события в task
+ *   notification и ждёт их в event_bus_task_wait() - долгую работу
+ *   делать так. Уведомления такой задачи не должны использоваться ни для
+ *   чего другого.
+ * - Состояние "mesh подключена" хранится на шине: event_bus_mesh_is_up(),
+ *   блокирующее ожидание - event_bus_wait_mesh_up().
+ *
+ * Подписка и отписка - при инициализации и остановке компонентов,
+ * публикация без блокировок.
+ */
+
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include "esp_err.h"
+#include "mesh_protocol.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Типы событий
+ */
+typedef enum {
+    EVENT_BUS_MESH_UP = 0,          ///< Подключение к родителю / ROOT зафиксирован (mesh)
+    EVENT_BUS_MESH_DOWN,            ///< Потеря родителя, остановка mesh
+    EVENT_BUS_PARENT_CHANGED,       ///< Подключение к другому родителю (mesh)
+    EVENT_BUS_MESH_RX,              ///< Кадр из mesh до разбора (rx)
+    EVENT_BUS_MESSAGE,              ///< Разобранное сообщение для узла (message)
+    EVENT_BUS_CONFIG_CHANGED,       ///< Конфигурация узла обновлена (config)
+    EVENT_BUS_EMERGENCY,            ///< Вход в аварийный режим / выход (emergency)
+    EVENT_BUS_EVENT_COUNT
+} event_bus_id_t;
+
+#define EVENT_BUS_BIT(id)           (1UL << (id))           ///< Маска события
+#define EVENT_BUS_MSG_BIT(type)     (1UL << (type))         ///< Маска типа сообщения (mesh_msg_type_t)
+#define EVENT_BUS_MSG_ALL           0                       ///< Сообщения всех типов
+
+/**
+ * @brief Событие (поле union по типу - в комментарии к event_bus_id_t)
+ */
+typedef struct {
+    event_bus_id_t id;
+    union {
+        struct {
+            uint8_t parent[6];      ///< BSSID родителя (нули для MESH_DOWN)
+            uint8_t layer;          ///< Уровень узла в дереве
+        } mesh;
+        struct {
+            const uint8_t *src;     ///< MAC отправителя
+            const uint8_t *data;
+            size_t len;
+            int64_t time_us;        ///< esp_timer_get_time() сразу после приёма
+        } rx;
+        struct {
+            const mesh_message_t *msg;
+        } message;
+        struct {
+            const char *source;     ///< Кто изменил ("mesh", "button", ...)
+        } config;
+        struct {
+            bool active;            ///< true - вход в аварийный режим
+            const char *reason;
+        } emergency;
+    };
+} event_bus_event_t;
+
+/**
+ * @brief Обработчик события
+ *
+ * @param event Событие (действительно только на время вызова)
+ * @param ctx Контекст из event_bus_subscribe()
+ */
+typedef void (*event_bus_handler_t)(const event_bus_event_t *event, void *ctx);
+
+/**
+ * @brief Подписка обработчика
+ *
+ * @param events Маска EVENT_BUS_BIT(...)
+ * @param msg_types Для EVENT_BUS_MESSAGE: маска EVENT_BUS_MSG_BIT(...),
+ *                  EVENT_BUS_MSG_ALL - все типы
+ * @param handler Обработчик
+ * @param ctx Контекст обработчика
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM если нет свободных слотов
+ */
+esp_err_t event_bus_subscribe(uint32_t events, uint32_t msg_types,
+                              event_bus_handler_t handler, void *ctx);
+
+/**
+ * @brief Подписка задачи: биты событий приходят в её task notification
+ *
+ * @param events Маска EVENT_BUS_BIT(...)
+ * @param msg_types Фильтр типов для EVENT_BUS_MESSAGE
+ * @param task Задача (обычно xTaskGetCurrentTaskHandle())
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM
+ */
+esp_err_t event_bus_subscribe_task(uint32_t events, uint32_t msg_types, TaskHandle_t task);
+
+/**
+ * @brief Отписка обработчика (все подписки с этими handler и ctx)
+ */
+void event_bus_unsubscribe(event_bus_handler_t handler, void *ctx);
+
+/**
+ * @brief Отписка задачи - до vTaskDelete()
+ *
+ * Публикация, уже идущая в другой задаче, может успеть доставить ещё
+ * одно уведомление - задачу удалять после отписки, а не вместо неё.
+ */
+void event_bus_unsubscribe_task(TaskHandle_t task);
+
+/**
+ * @brief Публикация события всем подписчикам
+ *
+ * MESH_UP / MESH_DOWN также меняют состояние event_bus_mesh_is_up().
+ *
+ * @param event Событие
+ * @return Число подписчиков, получивших событие
+ */
+int event_bus_publish(const event_bus_event_t *event);
+
+/**
+ * @brief Публикация разобранного сообщения (EVENT_BUS_MESSAGE)
+ */
+int event_bus_publish_message(const mesh_message_t *msg);
+
+/**
+ * @brief Публикация EVENT_BUS_CONFIG_CHANGED
+ */
+int event_bus_publish_config_changed(const char *source);
+
+/**
+ * @brief Публикация EVENT_BUS_EMERGENCY
+ */
+int event_bus_publish_emergency(bool active, const char *reason);
+
+/**
+ * @brief Ожидание событий текущей задачей (после event_bus_subscribe_task)
+ *
+ * Заменяет vTaskDelay() в цикле задачи: возвращается по первому событию
+ * или по таймауту.
+ *
+ * @param timeout Таймаут (тики)
+ * @return Маска EVENT_BUS_BIT(...) пришедших событий, 0 - таймаут
+ */
+uint32_t event_bus_task_wait(TickType_t timeout);
+
+/**
+ * @brief Mesh подключена (последнее из MESH_UP / MESH_DOWN)
+ */
+bool event_bus_mesh_is_up(void);
+
+/**
+ * @brief Ожидание подключения mesh
+ *
+ * @param timeout Таймаут (тики), portMAX_DELAY - без ограничения
+ * @return true если mesh подключена
+ */
+bool event_bus_wait_mesh_up(TickType_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENT_BUS_H
@@ -0,0 +1,319 @@
+/**
+ * @file instrumentation.c
+ * @brief Реализация runtime статистики
+ */
+
+#include "instrumentation.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/task.h"
+#include "rtos_static.h"
+#include "sdkconfig.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "instrumentation";
+
+#ifdef CONFIG_INSTRUMENTATION_ENABLE
+
+#define INSTR_TASK_STACK        3072
+#define INSTR_TASK_PRIORITY     1       // Выше IDLE, ниже всех задач приложения
+
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t runtime;
+} prev_runtime_t;
+
+static instrumentation_snapshot_t s_snapshot;
+static bool s_has_snapshot = false;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;     // s_snapshot, s_queues
+
+static struct {
+    const char *name;
+    QueueHandle_t queue;
+    uint16_t max_waiting;
+} s_queues[INSTRUMENTATION_MAX_QUEUES];
+static int s_queue_count = 0;
+
+// Только задача сбора
+static TaskStatus_t s_status[INSTRUMENTATION_MAX_TASKS];
+static prev_runtime_t s_prev[INSTRUMENTATION_MAX_TASKS];
+static int s_prev_count = 0;
+static uint32_t s_prev_total = 0;
+static instrumentation_snapshot_t s_work;
+RTOS_STATIC_TASK(instr, INSTR_TASK_STACK);
+
+static uint32_t prev_runtime_of(TaskHandle_t handle) {
+    for (int i = 0; i < s_prev_count; i++) {
+        if (s_prev[i].handle == handle) {
+            return s_prev[i].runtime;
+        }
+    }
+    return 0;   // Новая задача - весь её runtime пришёлся на этот интервал
+}
+
+static void sample_tasks(instrumentation_snapshot_t *snap) {
+    uint32_t total = 0;
+    UBaseType_t n = uxTaskGetSystemState(s_status, INSTRUMENTATION_MAX_TASKS, &total);
+    if (n == 0) {
+        // Задач больше, чем INSTRUMENTATION_MAX_TASKS - массив не заполняется вовсе
+        ESP_LOGW(TAG, "More than %d tasks, task stats skipped", INSTRUMENTATION_MAX_TASKS);
+        snap->task_count = 0;
+        return;
+    }
+
+    uint32_t total_delta = total - s_prev_total;
+
+    for (UBaseType_t i = 0; i < n; i++) {
+        const TaskStatus_t *st = &s_status[i];
+        instrumentation_task_t *t = &snap->tasks[i];
+
+        strncpy(t->name, st->pcTaskName, sizeof(t->name) - 1);
+        t->name[sizeof(t->name) - 1] = '\0';
+        t->priority = (uint8_t)st->uxCurrentPriority;
+        t->stack_free_min = st->usStackHighWaterMark;   // В ESP-IDF - байты
+
+        uint32_t delta = st->ulRunTimeCounter - prev_runtime_of(st->xHandle);
+        uint32_t permille = total_delta ? (uint32_t)((uint64_t)delta * 1000 / total_delta) : 0;
+        t->cpu_permille = (uint16_t)(permille > 1000 ? 1000 : permille);
+    }
+    snap->task_count = (int)n;
+
+    for (UBaseType_t i = 0; i < n; i++) {
+        s_prev[i].handle = s_status[i].xHandle;
+        s_prev[i].runtime = s_status[i].ulRunTimeCounter;
+    }
+    s_prev_count = (int)n;
+    s_prev_total = total;
+
+    // Сортировка вставками по убыванию CPU (n <= 32)
+    for (int i = 1; i < snap->task_count; i++) {
+        instrumentation_task_t tmp = snap->tasks[i];
+        int j = i - 1;
+        while (j >= 0 && snap->tasks[j].cpu_permille < tmp.cpu_permille) {
+            snap->tasks[j + 1] = snap->tasks[j];
+            j--;
+        }
+        snap->tasks[j + 1] = tmp;
+    }
+}
+
+static void sample_heap(instrumentation_heap_t *heap) {
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_INTERNAL);
+
+    heap->free = info.total_free_bytes;
+    heap->min_free = info.minimum_free_bytes;
+    heap->largest_free_block = info.largest_free_block;
+    heap->fragmentation_pct = info.total_free_bytes ?
+        (uint8_t)(100 - (uint64_t)info.largest_free_block * 100 / info.total_free_bytes) : 0;
+}
+
+static void sample_queues(instrumentation_snapshot_t *snap) {
+    portENTER_CRITICAL(&s_lock);
+    int count = s_queue_count;
+    portEXIT_CRITICAL(&s_lock);
+
+    for (int i = 0; i < count; i++) {
+        UBaseType_t waiting = uxQueueMessagesWaiting(s_queues[i].queue);
+        UBaseType_t spaces = uxQueueSpacesAvailable(s_queues[i].queue);
+
+        if (waiting > s_queues[i].max_waiting) {
+            s_queues[i].max_waiting = (uint16_t)waiting;
+        }
+
+        instrumentation_queue_t *q = &snap->queues[i];
+        q->name = s_queues[i].name;
+        q->waiting = (uint16_t)waiting;
+        q->max_waiting = s_queues[i].max_waiting;
+        q->length = (uint16_t)(waiting + spaces);
+    }
+    snap->queue_count = count;
+}
+
+static void instrumentation_task(void *arg) {
+    const TickType_t period = pdMS_TO_TICKS(CONFIG_INSTRUMENTATION_SAMPLE_INTERVAL_S * 1000);
+    TickType_t last_wake = xTaskGetTickCount();
+    uint64_t last_ms = esp_timer_get_time() / 1000;
+
+    // Базовая точка runtime: первый интервал считается от неё
+    sample_tasks(&s_work);
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, period);
+
+        uint64_t now_ms = esp_timer_get_time() / 1000;
+        s_work.timestamp_ms = now_ms;
+        s_work.interval_ms = (uint32_t)(now_ms - last_ms);
+        last_ms = now_ms;
+
+        sample_tasks(&s_work);
+        sample_heap(&s_work.heap);
+        sample_queues(&s_work);
+
+        for (int i = 0; i < s_work.task_count; i++) {
+            if (s_work.tasks[i].stack_free_min < INSTRUMENTATION_STACK_LOW_BYTES) {
+                ESP_LOGW(TAG, "Task %s: only %lu bytes of stack left at peak",
+                         s_work.tasks[i].name, (unsigned long)s_work.tasks[i].stack_free_min);
+            }
+        }
+
+        portENTER_CRITICAL(&s_lock);
+        memcpy(&s_snapshot, &s_work, sizeof(s_snapshot));
+        s_has_snapshot = true;
+        portEXIT_CRITICAL(&s_lock);
+    }
+}
+
+esp_err_t instrumentation_start(void) {
+    BaseType_t ret = rtos_static_task_create(&instr, instrumentation_task, "instr", NULL,
+                                             INSTR_TASK_PRIORITY, NULL);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create instrumentation task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Runtime instrumentation started (every %d s)", CONFIG_INSTRUMENTATION_SAMPLE_INTERVAL_S);
+    return ESP_OK;
+}
+
+esp_err_t instrumentation_register_queue(const char *name, QueueHandle_t queue) {
+    if (!name || !queue) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = ESP_OK;
+    portENTER_CRITICAL(&s_lock);
+    if (s_queue_count < INSTRUMENTATION_MAX_QUEUES) {
+        s_queues[s_queue_count].name = name;
+        s_queues[s_queue_count].queue = queue;
+        s_queues[s_queue_count].max_waiting = 0;
+        s_queue_count++;
+    } else {
+        err = ESP_ERR_NO_MEM;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "No free queue slots for %s", name);
+    }
+    return err;
+}
+
+bool instrumentation_get_snapshot(instrumentation_snapshot_t *out) {
+    if (!out) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    bool ok = s_has_snapshot;
+    if (ok) {
+        memcpy(out, &s_snapshot, sizeof(*out));
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return ok;
+}
+
+static void add_task(cJSON *tasks, const instrumentation_task_t *t) {
+    cJSON *item = cJSON_CreateArray();
+    if (!item) {
+        return;
+    }
+    cJSON_AddItemToArray(item, cJSON_CreateString(t->name));
+    cJSON_AddItemToArray(item, cJSON_CreateNumber(t->cpu_permille));
+    cJSON_AddItemToArray(item, cJSON_CreateNumber(t->stack_free_min));
+    cJSON_AddItemToArray(item, cJSON_CreateNumber(t->priority));
+    cJSON_AddItemToArray(tasks, item);
+}
+
+void instrumentation_add_to_json(cJSON *obj) {
+    if (!obj) {
+        return;
+    }
+
+    // Снимок ~1.5 КБ - не на стеке задачи heartbeat
+    instrumentation_snapshot_t *snap = malloc(sizeof(instrumentation_snapshot_t));
+    if (!snap) {
+        return;
+    }
+    if (!instrumentation_get_snapshot(snap)) {
+        free(snap);
+        return;
+    }
+
+    cJSON *sys = cJSON_CreateObject();
+    if (!sys) {
+        free(snap);
+        return;
+    }
+
+    cJSON *heap = cJSON_CreateArray();
+    if (heap) {
+        cJSON_AddItemToArray(heap, cJSON_CreateNumber(snap->heap.free));
+        cJSON_AddItemToArray(heap, cJSON_CreateNumber(snap->heap.min_free));
+        cJSON_AddItemToArray(heap, cJSON_CreateNumber(snap->heap.largest_free_block));
+        cJSON_AddItemToArray(heap, cJSON_CreateNumber(snap->heap.fragmentation_pct));
+        cJSON_AddItemToObject(sys, "heap", heap);
+    }
+
+    // Сначала задачи на грани переполнения стека, затем самые загруженные
+    cJSON *tasks = cJSON_CreateArray();
+    if (tasks) {
+        int added = 0;
+        bool taken[INSTRUMENTATION_MAX_TASKS] = {false};
+        for (int i = 0; i < snap->task_count && added < CONFIG_INSTRUMENTATION_HEARTBEAT_TASKS; i++) {
+            if (snap->tasks[i].stack_free_min < INSTRUMENTATION_STACK_LOW_BYTES) {
+                add_task(tasks, &snap->tasks[i]);
+                taken[i] = true;
+                added++;
+            }
+        }
+        for (int i = 0; i < snap->task_count && added < CONFIG_INSTRUMENTATION_HEARTBEAT_TASKS; i++) {
+            if (!taken[i]) {
+                add_task(tasks, &snap->tasks[i]);
+                added++;
+            }
+        }
+        cJSON_AddItemToObject(sys, "tasks", tasks);
+    }
+
+    if (snap->queue_count > 0) {
+        cJSON *queues = cJSON_CreateArray();
+        for (int i = 0; queues && i < snap->queue_count; i++) {
+            cJSON *item = cJSON_CreateArray();
+            if (!item) {
+                break;
+            }
+            cJSON_AddItemToArray(item, cJSON_CreateString(snap->queues[i].name));
+            cJSON_AddItemToArray(item, cJSON_CreateNumber(snap->queues[i].waiting));
+            cJSON_AddItemToArray(item, cJSON_CreateNumber(snap->queues[i].max_waiting));
+            cJSON_AddItemToArray(item, cJSON_CreateNumber(snap->queues[i].length));
+            cJSON_AddItemToArray(queues, item);
+        }
+        cJSON_AddItemToObject(sys, "q", queues);
+    }
+
+    cJSON_AddItemToObject(obj, "sys", sys);
+    free(snap);
+}
+
+#else // CONFIG_INSTRUMENTATION_ENABLE
+
+esp_err_t instrumentation_start(void) {
+    ESP_LOGD(TAG, "Runtime instrumentation disabled in Kconfig");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t instrumentation_register_queue(const char *name, QueueHandle_t queue) {
+    return ESP_OK;
+}
+
+bool instrumentation_get_snapshot(instrumentation_snapshot_t *out) {
+    return false;
+}
+
+void instrumentation_add_to_json(cJSON *obj) {
+}
+
+#endif // CONFIG_INSTRUMENTATION_ENABLE
@@ -0,0 +1,121 @@
+/**
+ * @file instrumentation.h
+ * @brief Runtime статистика прошивки: CPU и стек задач, heap, очереди
+ *
+ * Фоновая задача раз в CONFIG_INSTRUMENTATION_SAMPLE_INTERVAL_S снимает
+ * uxTaskGetSystemState() и heap_caps_get_info() и хранит последний снимок.
+ * Узлы кладут компактную сводку в heartbeat, ROOT - в метрики, чтобы
+ * размеры стеков и приоритеты задач подбирать по данным, а не "x2 для
+ * безопасности".
+ *
+ * Выключено в Kconfig (INSTRUMENTATION_ENABLE=n) - все функции пустые,
+ * вызывающему коду #ifdef не нужен.
+ */
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include "esp_err.h"
+#include "cJSON.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INSTRUMENTATION_MAX_TASKS       32      ///< Задач в снимке (лишние отбрасываются)
+#define INSTRUMENTATION_MAX_QUEUES      8       ///< Зарегистрированных очередей
+#define INSTRUMENTATION_TASK_NAME_LEN   16
+#define INSTRUMENTATION_STACK_LOW_BYTES 512     ///< Меньше свободного стека - предупреждение в лог
+
+/**
+ * @brief Статистика задачи за последний интервал
+ */
+typedef struct {
+    char name[INSTRUMENTATION_TASK_NAME_LEN];
+    uint8_t priority;               ///< Текущий приоритет
+    uint16_t cpu_permille;          ///< Загрузка за интервал, ‰ одного ядра
+    uint32_t stack_free_min;        ///< Минимум свободного стека с запуска задачи (байт)
+} instrumentation_task_t;
+
+/**
+ * @brief Состояние heap (внутренняя RAM, MALLOC_CAP_INTERNAL)
+ */
+typedef struct {
+    uint32_t free;                  ///< Свободно сейчас
+    uint32_t min_free;              ///< Минимум свободного с загрузки
+    uint32_t largest_free_block;    ///< Наибольший свободный блок
+    uint8_t fragmentation_pct;      ///< 100 * (1 - largest / free)
+} instrumentation_heap_t;
+
+/**
+ * @brief Глубина очереди
+ */
+typedef struct {
+    const char *name;               ///< Имя из instrumentation_register_queue()
+    uint16_t waiting;               ///< Сообщений в момент снимка
+    uint16_t max_waiting;           ///< Максимум по всем снимкам
+    uint16_t length;                ///< Ёмкость очереди
+} instrumentation_queue_t;
+
+/**
+ * @brief Снимок статистики
+ */
+typedef struct {
+    uint64_t timestamp_ms;          ///< Время снимка (esp_timer)
+    uint32_t interval_ms;           ///< Интервал, за который посчитан CPU
+    int task_count;
+    instrumentation_task_t tasks[INSTRUMENTATION_MAX_TASKS];    ///< По убыванию CPU
+    instrumentation_heap_t heap;
+    int queue_count;
+    instrumentation_queue_t queues[INSTRUMENTATION_MAX_QUEUES];
+} instrumentation_snapshot_t;
+
+/**
+ * @brief Запуск фоновой задачи сбора статистики
+ *
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED если выключено в Kconfig
+ */
+esp_err_t instrumentation_start(void);
+
+/**
+ * @brief Регистрация очереди для наблюдения за глубиной
+ *
+ * @param name Имя (строка должна жить всё время работы)
+ * @param queue Очередь
+ * @return ESP_OK, ESP_ERR_NO_MEM если слоты кончились
+ */
+esp_err_t instrumentation_register_queue(const char *name, QueueHandle_t queue);
+
+/**
+ * @brief Копия последнего снимка
+ *
+ * @param out Снимок
+ * @return true если снимок уже есть (первый - через один интервал после старта)
+ */
+bool instrumentation_get_snapshot(instrumentation_snapshot_t *out);
+
+/**
+ * @brief Добавление компактной сводки "sys" в JSON объект (heartbeat)
+ *
+ * "sys":{"heap":[free,min_free,largest,frag_pct],
+ *        "tasks":[[name,cpu_permille,stack_free_min,prio],...],
+ *        "q":[[name,waiting,max_waiting,length],...]}
+ *
+ * Задачи (до CONFIG_INSTRUMENTATION_HEARTBEAT_TASKS): сначала те, у кого
+ * свободного стека меньше INSTRUMENTATION_STACK_LOW_BYTES, затем самые
+ * загруженные.
+ * Ничего не добавляет, если статистика выключена или снимка ещё нет.
+ *
+ * @param obj JSON объект
+ */
+void instrumentation_add_to_json(cJSON *obj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INSTRUMENTATION_H
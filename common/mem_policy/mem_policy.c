@@ -0,0 +1,149 @@
+/**
+ * @file mem_policy.c
+ * @brief Реализация размещения буферов и карты памяти
+ */
+
+#include "mem_policy.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "mem_policy";
+
+#ifndef CONFIG_MEM_POLICY_MAX_OWNERS
+#define CONFIG_MEM_POLICY_MAX_OWNERS    16
+#endif
+
+#define CAPS_INTERNAL   (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#define CAPS_PSRAM      (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+
+typedef struct {
+    const char *owner;
+    uint32_t internal_bytes;
+    uint32_t psram_bytes;
+    uint16_t blocks;
+    bool is_static;
+} mem_owner_t;
+
+static mem_owner_t s_owners[CONFIG_MEM_POLICY_MAX_OWNERS];
+static int s_owner_count = 0;
+static uint32_t s_cold_fallbacks = 0;      // MEM_COLD, ушедшие во внутреннюю RAM
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+bool mem_policy_psram_available(void) {
+#ifdef CONFIG_MEM_POLICY_COLD_PSRAM
+    return heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+#else
+    return false;
+#endif
+}
+
+void* mem_policy_malloc(mem_class_t cls, size_t size) {
+    if (cls == MEM_COLD && mem_policy_psram_available()) {
+        void *ptr = heap_caps_malloc(size, CAPS_PSRAM);
+        if (ptr) {
+            return ptr;
+        }
+        // PSRAM кончилась - лучше внутренняя RAM, чем отказ
+        portENTER_CRITICAL(&s_lock);
+        s_cold_fallbacks++;
+        portEXIT_CRITICAL(&s_lock);
+    }
+    return heap_caps_malloc(size, CAPS_INTERNAL);
+}
+
+static void account(const char *owner, const void *ptr, size_t size, bool is_static) {
+    bool ext = esp_ptr_external_ram(ptr);
+
+    portENTER_CRITICAL(&s_lock);
+    mem_owner_t *o = NULL;
+    for (int i = 0; i < s_owner_count; i++) {
+        if (s_owners[i].owner == owner || strcmp(s_owners[i].owner, owner) == 0) {
+            o = &s_owners[i];
+            break;
+        }
+    }
+    if (!o && s_owner_count < CONFIG_MEM_POLICY_MAX_OWNERS) {
+        o = &s_owners[s_owner_count++];
+        memset(o, 0, sizeof(*o));
+        o->owner = owner;
+        o->is_static = is_static;
+    }
+    if (o) {
+        if (ext) {
+            o->psram_bytes += size;
+        } else {
+            o->internal_bytes += size;
+        }
+        o->blocks++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void* mem_policy_calloc(const char *owner, mem_class_t cls, size_t size) {
+    void *ptr = mem_policy_malloc(cls, size);
+    if (!ptr) {
+        ESP_LOGE(TAG, "No memory for %s (%u bytes, %s)", owner ? owner : "?",
+                 (unsigned)size, cls == MEM_COLD ? "cold" : "hot");
+        return NULL;
+    }
+    memset(ptr, 0, size);
+    if (owner) {
+        account(owner, ptr, size, false);
+    }
+    return ptr;
+}
+
+void mem_policy_track_static(const char *owner, const void *ptr, size_t size) {
+    if (owner && ptr) {
+        account(owner, ptr, size, true);
+    }
+}
+
+void mem_policy_report(void) {
+    size_t psram_total = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
+
+    ESP_LOGI(TAG, "Memory map:");
+    ESP_LOGI(TAG, "  internal  free %u KB, largest block %u KB, min free %u KB",
+             (unsigned)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024),
+             (unsigned)(heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL) / 1024),
+             (unsigned)(heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL) / 1024));
+    ESP_LOGI(TAG, "  DMA       free %u KB, largest block %u KB",
+             (unsigned)(heap_caps_get_free_size(MALLOC_CAP_DMA) / 1024),
+             (unsigned)(heap_caps_get_largest_free_block(MALLOC_CAP_DMA) / 1024));
+    if (psram_total > 0) {
+        ESP_LOGI(TAG, "  PSRAM     free %u KB of %u KB%s",
+                 (unsigned)(heap_caps_get_free_size(MALLOC_CAP_SPIRAM) / 1024),
+                 (unsigned)(psram_total / 1024),
+                 mem_policy_psram_available() ? "" : " (cold placement off)");
+    } else {
+        ESP_LOGI(TAG, "  PSRAM     none - cold buffers in internal RAM");
+    }
+
+    mem_owner_t owners[CONFIG_MEM_POLICY_MAX_OWNERS];
+    portENTER_CRITICAL(&s_lock);
+    int count = s_owner_count;
+    uint32_t fallbacks = s_cold_fallbacks;
+    memcpy(owners, s_owners, count * sizeof(owners[0]));
+    portEXIT_CRITICAL(&s_lock);
+
+    uint32_t total_internal = 0, total_psram = 0;
+    ESP_LOGI(TAG, "  %-*s %9s %9s %6s", MEM_POLICY_OWNER_LEN, "owner", "internal", "psram", "blocks");
+    for (int i = 0; i < count; i++) {
+        ESP_LOGI(TAG, "  %-*.*s %9lu %9lu %6u%s", MEM_POLICY_OWNER_LEN, MEM_POLICY_OWNER_LEN,
+                 owners[i].owner, (unsigned long)owners[i].internal_bytes,
+                 (unsigned long)owners[i].psram_bytes, owners[i].blocks,
+                 owners[i].is_static ? " static" : "");
+        total_internal += owners[i].internal_bytes;
+        total_psram += owners[i].psram_bytes;
+    }
+    ESP_LOGI(TAG, "  %-*s %9lu %9lu", MEM_POLICY_OWNER_LEN, "total",
+             (unsigned long)total_internal, (unsigned long)total_psram);
+
+    if (fallbacks > 0) {
+        ESP_LOGW(TAG, "%lu cold allocations fell back to internal RAM", (unsigned long)fallbacks);
+    }
+}
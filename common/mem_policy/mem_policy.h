@@ -0,0 +1,92 @@
+/**
+ * @file mem_policy.h
+ * @brief Размещение буферов: внутренняя RAM или PSRAM
+ *
+ * Внутренняя SRAM ESP32-S3 делится с Wi-Fi/mesh стеком и DMA, поэтому
+ * крупные и редко читаемые структуры (история, окна агрегации, снимки,
+ * буферы ответов) выносятся в PSRAM, а горячие (версии реестра, таблица
+ * правил, арены cJSON) закрепляются во внутренней RAM - иначе при
+ * CONFIG_SPIRAM_USE_MALLOC обычный malloc() крупного блока тоже уйдёт
+ * в PSRAM.
+ *
+ * - MEM_HOT  - всегда внутренняя RAM (MALLOC_CAP_INTERNAL)
+ * - MEM_COLD - PSRAM, если она есть и MEM_POLICY_COLD_PSRAM=y, иначе
+ *              внутренняя RAM
+ *
+ * Память освобождается обычным free(). Статические буферы выносятся
+ * в PSRAM атрибутом EXT_RAM_BSS_ATTR (действует при
+ * CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY=y) и регистрируются для
+ * отчёта через mem_policy_track_static().
+ */
+
+#ifndef MEM_POLICY_H
+#define MEM_POLICY_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEM_POLICY_OWNER_LEN    20      ///< Макс. длина имени владельца в отчёте
+
+/**
+ * @brief Класс размещения
+ */
+typedef enum {
+    MEM_HOT = 0,        ///< Горячий путь: внутренняя RAM
+    MEM_COLD,           ///< Крупное и холодное: PSRAM, если есть
+} mem_class_t;
+
+/**
+ * @brief Выделение временного буфера (не учитывается в отчёте)
+ *
+ * @param cls Класс размещения
+ * @param size Размер (байт)
+ * @return Указатель (освобождать free()), NULL если нет памяти
+ */
+void* mem_policy_malloc(mem_class_t cls, size_t size);
+
+/**
+ * @brief Выделение долгоживущего обнулённого буфера с учётом в отчёте
+ *
+ * Выделения одного владельца суммируются. Буферы, которые заменяются
+ * на ходу (таблица правил), выделяются с owner = NULL - без учёта.
+ *
+ * @param owner Владелец (строка должна жить всё время работы), NULL - без учёта
+ * @param cls Класс размещения
+ * @param size Размер (байт)
+ * @return Указатель (освобождать free()), NULL если нет памяти
+ */
+void* mem_policy_calloc(const char *owner, mem_class_t cls, size_t size);
+
+/**
+ * @brief Учёт статического буфера в отчёте
+ *
+ * @param owner Владелец (строка должна жить всё время работы)
+ * @param ptr Буфер
+ * @param size Размер (байт)
+ */
+void mem_policy_track_static(const char *owner, const void *ptr, size_t size);
+
+/**
+ * @brief PSRAM доступна для MEM_COLD
+ */
+bool mem_policy_psram_available(void);
+
+/**
+ * @brief Карта памяти в лог: свободно во внутренней RAM, DMA, PSRAM и
+ *        учтённые буферы по владельцам
+ *
+ * Вызывать в конце app_main, когда основные буферы уже выделены.
+ */
+void mem_policy_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MEM_POLICY_H
@@ -9,19 +9,28 @@
 #include "esp_mac.h"
 #include "esp_event.h"
 #include "nvs_flash.h"
+#include "esp_timer.h"
+#include "rtos_static.h"
+#include "event_bus.h"
+#include "pm_policy.h"
 #include <string.h>
 
 static const char *TAG = "mesh_manager";
 
+// Увеличен в 4 раза для безопасности: 4096 → 16384
+#define MESH_RECV_TASK_STACK    16384
+
 static mesh_manager_config_t s_config;
-static mesh_recv_cb_t s_recv_cb = NULL;
 static bool s_is_mesh_connected = false;
+static uint8_t s_parent[6] = {0};      // Последний родитель (нули - ещё не было)
 static esp_netif_t *s_netif_sta = NULL;
+RTOS_STATIC_TASK(mesh_recv, MESH_RECV_TASK_STACK);
 
 // Forward declarations
 static void ip_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data);
 static void mesh_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data);
 static void mesh_recv_task(void *arg);
+static void set_connected(bool connected, const uint8_t *parent, uint8_t layer);
 
 esp_err_t mesh_manager_init(const mesh_manager_config_t *config) {
     if (config == NULL) {
@@ -185,8 +194,8 @@ esp_err_t mesh_manager_start(void) {
     // Запуск mesh
     ESP_ERROR_CHECK(esp_mesh_start());
 
-    // Запуск задачи приема данных (увеличен stack в 4 раза для безопасности: 4096 → 16384)
-    xTaskCreate(mesh_recv_task, "mesh_recv", 16384, NULL, 5, NULL);
+    // Запуск задачи приема данных
+    rtos_static_task_create(&mesh_recv, mesh_recv_task, "mesh_recv", NULL, 5, NULL);
 
     ESP_LOGI(TAG, "Mesh started");
 
@@ -195,7 +204,7 @@ esp_err_t mesh_manager_start(void) {
 
 esp_err_t mesh_manager_stop(void) {
     ESP_ERROR_CHECK(esp_mesh_stop());
-    s_is_mesh_connected = false;
+    set_connected(false, NULL, 0);
     ESP_LOGI(TAG, "Mesh stopped");
     return ESP_OK;
 }
@@ -225,7 +234,9 @@ esp_err_t mesh_manager_send(const uint8_t *dest_addr, const uint8_t *data, size_
         flag = MESH_DATA_P2P;   // ← Флаг для P2P
     }
 
+    pm_policy_acquire(PM_SITE_MESH_TX);
     esp_err_t err = esp_mesh_send(&addr, &mesh_data, flag, NULL, 0);
+    pm_policy_release(PM_SITE_MESH_TX);
     
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Mesh send failed: %s", esp_err_to_name(err));
@@ -298,8 +309,9 @@ esp_err_t mesh_manager_broadcast(const uint8_t *data, size_t len) {
 
     ESP_LOGI(TAG, "Broadcasting to %d nodes", route_table_size);
 
-    // Отправка данных каждому узлу
+    // Отправка данных каждому узлу - одной пачкой под блокировкой частоты
     int success_count = 0;
+    pm_policy_acquire(PM_SITE_MESH_TX);
     for (int i = 0; i < route_table_size; i++) {
         mesh_addr_t dest_addr;
         memcpy(dest_addr.addr, route_table[i].addr, 6);
@@ -313,15 +325,74 @@ esp_err_t mesh_manager_broadcast(const uint8_t *data, size_t len) {
                      MAC2STR(dest_addr.addr), esp_err_to_name(err));
         }
     }
+    pm_policy_release(PM_SITE_MESH_TX);
 
     ESP_LOGI(TAG, "Broadcast completed: %d/%d nodes", success_count, route_table_size);
 
     return (success_count > 0) ? ESP_OK : ESP_FAIL;
 }
 
+esp_err_t mesh_manager_multicast(const uint8_t (*dest_addrs)[6], int count, const uint8_t *data, size_t len) {
+    if (dest_addrs == NULL || count <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (count == 1) {
+        return mesh_manager_send(dest_addrs[0], data, len);
+    }
+
+    if (!s_is_mesh_connected) {
+        ESP_LOGW(TAG, "Mesh not connected, cannot multicast");
+        return ESP_ERR_MESH_NOT_START;
+    }
+
+    if (!mesh_manager_is_root()) {
+        ESP_LOGW(TAG, "Multicast available only for ROOT node");
+        return ESP_ERR_MESH_NOT_ALLOWED;
+    }
+
+    mesh_data_t mesh_data;
+    mesh_data.data = (uint8_t *)data;
+    mesh_data.size = len;
+    mesh_data.proto = MESH_PROTO_BIN;
+    mesh_data.tos = MESH_TOS_P2P;
+
+    // Адрес назначения - multicast группа, получатели - в опции
+    mesh_addr_t group_addr = { .addr = {0x01, 0x00, 0x5E, 0x00, 0x00, 0x00} };
+    mesh_opt_t opt;
+    opt.type = MESH_OPT_SEND_GROUP;
+    opt.len = count * 6;
+    opt.val = (uint8_t *)dest_addrs;
+
+    pm_policy_acquire(PM_SITE_MESH_TX);
+    esp_err_t err = esp_mesh_send(&group_addr, &mesh_data, MESH_DATA_P2P, &opt, 1);
+    pm_policy_release(PM_SITE_MESH_TX);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Multicast to %d nodes", count);
+        return ESP_OK;
+    }
+
+    // Запасной путь: по одному unicast на узел
+    ESP_LOGW(TAG, "Multicast failed (%s), falling back to unicast", esp_err_to_name(err));
+    int success_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (mesh_manager_send(dest_addrs[i], data, len) == ESP_OK) {
+            success_count++;
+        }
+    }
+
+    return (success_count > 0) ? ESP_OK : ESP_FAIL;
+}
+
+static void recv_cb_adapter(const event_bus_event_t *event, void *ctx) {
+    ((mesh_recv_cb_t)ctx)(event->rx.src, event->rx.data, event->rx.len);
+}
+
 void mesh_manager_register_recv_cb(mesh_recv_cb_t cb) {
-    s_recv_cb = cb;
-    ESP_LOGI(TAG, "✅ Recv callback registered: %p", (void*)cb);
+    if (event_bus_subscribe(EVENT_BUS_BIT(EVENT_BUS_MESH_RX), EVENT_BUS_MSG_ALL,
+                            recv_cb_adapter, (void *)cb) == ESP_OK) {
+        ESP_LOGI(TAG, "✅ Recv callback registered: %p", (void*)cb);
+    }
 }
 
 bool mesh_manager_is_root(void) {
@@ -342,6 +413,41 @@ esp_err_t mesh_manager_get_mac(uint8_t *mac) {
 
 // --- Private functions ---
 
+// Смена состояния связи - события MESH_UP / MESH_DOWN / PARENT_CHANGED на шине
+static void set_connected(bool connected, const uint8_t *parent, uint8_t layer) {
+    event_bus_event_t event = { .id = EVENT_BUS_MESH_DOWN };
+    event.mesh.layer = layer;
+    if (parent) {
+        memcpy(event.mesh.parent, parent, 6);
+    }
+
+    bool was_connected = s_is_mesh_connected;
+    s_is_mesh_connected = connected;
+
+    if (!connected) {
+        if (was_connected) {
+            event_bus_publish(&event);
+        }
+        return;
+    }
+
+    static const uint8_t no_parent[6] = {0};
+    bool parent_changed = parent && memcmp(s_parent, no_parent, 6) != 0 &&
+                          memcmp(s_parent, parent, 6) != 0;
+    if (parent) {
+        memcpy(s_parent, parent, 6);
+    }
+
+    if (!was_connected) {
+        event.id = EVENT_BUS_MESH_UP;
+        event_bus_publish(&event);
+    }
+    if (parent_changed) {
+        event.id = EVENT_BUS_PARENT_CHANGED;
+        event_bus_publish(&event);
+    }
+}
+
 static void ip_event_handler(void *arg, esp_event_base_t event_base,
                               int32_t event_id, void *event_data) {
     if (event_id == IP_EVENT_STA_GOT_IP) {
@@ -364,7 +470,7 @@ static void mesh_event_handler(void *arg, esp_event_base_t event_base, int32_t e
 
         case MESH_EVENT_STOPPED:
             ESP_LOGI(TAG, "Mesh stopped");
-            s_is_mesh_connected = false;
+            set_connected(false, NULL, 0);
             break;
 
         case MESH_EVENT_PARENT_CONNECTED: {
@@ -375,7 +481,7 @@ static void mesh_event_handler(void *arg, esp_event_base_t event_base, int32_t e
             ESP_LOGI(TAG, "  Parent BSSID: %02x:%02x:%02x:%02x:%02x:%02x",
                      MAC2STR(connected->connected.bssid));
             ESP_LOGI(TAG, "========================================");
-            s_is_mesh_connected = true;
+            set_connected(true, connected->connected.bssid, connected->self_layer);
             
             // ROOT зафиксирован ДО подключения к роутеру, поэтому MESH_EVENT_ROOT_FIXED может не прийти
             // Запускаем DHCP клиент здесь для ROOT узла
@@ -395,14 +501,14 @@ static void mesh_event_handler(void *arg, esp_event_base_t event_base, int32_t e
 
         case MESH_EVENT_PARENT_DISCONNECTED:
             ESP_LOGI(TAG, "Parent disconnected");
-            s_is_mesh_connected = false;
+            set_connected(false, NULL, 0);
             break;
 
         case MESH_EVENT_ROOT_FIXED:
             ESP_LOGI(TAG, "========================================");
             ESP_LOGI(TAG, "✓ ROOT node established and fixed!");
             ESP_LOGI(TAG, "========================================");
-            s_is_mesh_connected = true;
+            set_connected(true, NULL, 1);
             
             // ROOT зафиксирован - запускаем DHCP
             if (s_config.mode == MESH_MODE_ROOT && s_netif_sta) {
@@ -450,6 +556,7 @@ static void mesh_recv_task(void *arg) {
         data.size = max_data_size;
         
         esp_err_t err = esp_mesh_recv(&from, &data, portMAX_DELAY, &flag, NULL, 0);
+        int64_t rx_us = esp_timer_get_time();   // До логов: по нему mesh_time считает задержку маяка
         
         if (err == ESP_OK) {
             ESP_LOGI(TAG, "✓ Mesh data received: %d bytes from "MACSTR" (flag=%d)", 
@@ -458,11 +565,12 @@ static void mesh_recv_task(void *arg) {
             // DEBUG: Вывести первые 100 байт данных
             ESP_LOG_BUFFER_HEXDUMP(TAG, data.data, (data.size > 100 ? 100 : data.size), ESP_LOG_INFO);
             
-            if (s_recv_cb != NULL) {
-                ESP_LOGI(TAG, "Calling recv_cb...");
-                s_recv_cb(from.addr, data.data, data.size);
-                ESP_LOGI(TAG, "recv_cb returned");
-            } else {
+            // Все подписчики получают один буфер приёма, без копий
+            event_bus_event_t event = {
+                .id = EVENT_BUS_MESH_RX,
+                .rx = { .src = from.addr, .data = data.data, .len = data.size, .time_us = rx_us },
+            };
+            if (event_bus_publish(&event) == 0) {
                 ESP_LOGW(TAG, "⚠️ No recv callback registered - data dropped!");
             }
         } else {
@@ -107,9 +107,26 @@ esp_err_t mesh_manager_send_to_root(const uint8_t *data, size_t len);
  */
 esp_err_t mesh_manager_broadcast(const uint8_t *data, size_t len);
 
+/**
+ * @brief Multicast данных списку узлов (для ROOT)
+ * 
+ * Одна передача с опцией MESH_OPT_SEND_GROUP вместо N unicast: пакет
+ * копируется только на развилках маршрутов к получателям.
+ * 
+ * @param dest_addrs MAC адреса получателей (по 6 байт подряд)
+ * @param count Количество получателей (1 - обычный unicast)
+ * @param data Указатель на данные
+ * @param len Длина данных
+ * @return ESP_OK при успехе
+ */
+esp_err_t mesh_manager_multicast(const uint8_t (*dest_addrs)[6], int count, const uint8_t *data, size_t len);
+
 /**
  * @brief Регистрация callback для приема данных
  * 
+ * Подписка на EVENT_BUS_MESH_RX шины событий: callback-ов может быть
+ * несколько, каждый получает тот же буфер (действителен на время вызова).
+ * 
  * @param cb Callback функция
  */
 void mesh_manager_register_recv_cb(mesh_recv_cb_t cb);
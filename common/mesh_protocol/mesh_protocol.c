@@ -6,6 +6,9 @@
 #include "mesh_protocol.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <sys/time.h>
@@ -21,6 +24,8 @@ static const char *MSG_TYPE_HEARTBEAT = "heartbeat";
 static const char *MSG_TYPE_REQUEST = "request";
 static const char *MSG_TYPE_RESPONSE = "response";
 static const char *MSG_TYPE_CONFIG_RESPONSE = "config_response";
+static const char *MSG_TYPE_RATE_HINT = "rate_hint";
+static const char *MSG_TYPE_TIME_SYNC = "time_sync";
 
 // Константы уровней событий
 static const char *EVENT_LEVEL_INFO = "info";
@@ -28,6 +33,20 @@ static const char *EVENT_LEVEL_WARNING = "warning";
 static const char *EVENT_LEVEL_CRITICAL = "critical";
 static const char *EVENT_LEVEL_EMERGENCY = "emergency";
 
+// Константы уровней темпа
+static const char *RATE_LEVEL_NORMAL = "normal";
+static const char *RATE_LEVEL_REDUCE = "reduce";
+static const char *RATE_LEVEL_HOLD = "hold";
+
+// Счётчик исходящих сообщений (seq)
+static uint32_t s_tx_seq = 0;
+static portMUX_TYPE s_seq_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Часы mesh: смещение от esp_timer и последнее выданное значение
+static int64_t s_time_offset_us = 0;
+static uint64_t s_time_last_us = 0;
+static portMUX_TYPE s_time_lock = portMUX_INITIALIZER_UNLOCKED;
+
 static mesh_msg_type_t str_to_msg_type(const char *str) {
     if (strcmp(str, MSG_TYPE_TELEMETRY) == 0) return MESH_MSG_TELEMETRY;
     if (strcmp(str, MSG_TYPE_COMMAND) == 0) return MESH_MSG_COMMAND;
@@ -37,10 +56,12 @@ static mesh_msg_type_t str_to_msg_type(const char *str) {
     if (strcmp(str, MSG_TYPE_REQUEST) == 0) return MESH_MSG_REQUEST;
     if (strcmp(str, MSG_TYPE_RESPONSE) == 0) return MESH_MSG_RESPONSE;
     if (strcmp(str, MSG_TYPE_CONFIG_RESPONSE) == 0) return MESH_MSG_RESPONSE;  // Алиас
+    if (strcmp(str, MSG_TYPE_RATE_HINT) == 0) return MESH_MSG_RATE_HINT;
+    if (strcmp(str, MSG_TYPE_TIME_SYNC) == 0) return MESH_MSG_TIME_SYNC;
     return MESH_MSG_UNKNOWN;
 }
 
-static const char* msg_type_to_str(mesh_msg_type_t type) {
+const char* mesh_protocol_msg_type_to_str(mesh_msg_type_t type) {
     switch (type) {
         case MESH_MSG_TELEMETRY: return MSG_TYPE_TELEMETRY;
         case MESH_MSG_COMMAND: return MSG_TYPE_COMMAND;
@@ -49,6 +70,8 @@ static const char* msg_type_to_str(mesh_msg_type_t type) {
         case MESH_MSG_HEARTBEAT: return MSG_TYPE_HEARTBEAT;
         case MESH_MSG_REQUEST: return MSG_TYPE_REQUEST;
         case MESH_MSG_RESPONSE: return MSG_TYPE_RESPONSE;
+        case MESH_MSG_RATE_HINT: return MSG_TYPE_RATE_HINT;
+        case MESH_MSG_TIME_SYNC: return MSG_TYPE_TIME_SYNC;
         default: return "unknown";
     }
 }
@@ -82,6 +105,15 @@ bool mesh_protocol_parse(const char *json_str, mesh_message_t *msg) {
         msg->node_id[0] = '\0';
     }
 
+    // Парсинг node_type (telemetry/heartbeat кладут его в корень, не в data)
+    cJSON *node_type_obj = cJSON_GetObjectItem(root, "node_type");
+    if (node_type_obj != NULL && cJSON_IsString(node_type_obj)) {
+        strncpy(msg->node_type, node_type_obj->valuestring, sizeof(msg->node_type) - 1);
+        msg->node_type[sizeof(msg->node_type) - 1] = '\0';
+    } else {
+        msg->node_type[0] = '\0';
+    }
+
     // Парсинг timestamp
     cJSON *timestamp_obj = cJSON_GetObjectItem(root, "timestamp");
     if (timestamp_obj != NULL && cJSON_IsNumber(timestamp_obj)) {
@@ -90,13 +122,32 @@ bool mesh_protocol_parse(const char *json_str, mesh_message_t *msg) {
         msg->timestamp = mesh_protocol_get_timestamp();
     }
 
+    // Время отправки в мкс (старые прошивки его не присылают)
+    cJSON *ts_us_obj = cJSON_GetObjectItem(root, "ts_us");
+    msg->timestamp_us = (ts_us_obj != NULL && cJSON_IsNumber(ts_us_obj) && ts_us_obj->valuedouble > 0)
+                            ? (uint64_t)ts_us_obj->valuedouble : 0;
+
+    // Парсинг seq (старые прошивки узлов его не присылают)
+    cJSON *seq_obj = cJSON_GetObjectItem(root, "seq");
+    msg->has_seq = (seq_obj != NULL && cJSON_IsNumber(seq_obj));
+    msg->seq = msg->has_seq ? (uint32_t)seq_obj->valuedouble : 0;
+
+    // RSSI к родителю: heartbeat кладёт его в корень, telemetry - в data
+    cJSON *rssi_obj = cJSON_GetObjectItem(root, "rssi_to_parent");
+    cJSON *rssi_data = cJSON_GetObjectItem(root, "data");
+    if (rssi_obj == NULL && rssi_data != NULL) {
+        rssi_obj = cJSON_GetObjectItem(rssi_data, "rssi_to_parent");
+    }
+    msg->rssi = (rssi_obj != NULL && cJSON_IsNumber(rssi_obj)) ? (int8_t)rssi_obj->valueint : 0;
+
     // Парсинг data (детальные данные зависят от типа сообщения)
     cJSON *data_obj = cJSON_GetObjectItem(root, "data");
     if (data_obj != NULL) {
         msg->data = cJSON_Duplicate(data_obj, true);
     } else {
-        // Для команд и конфигов данные могут быть в корне
-        if (msg->type == MESH_MSG_COMMAND || msg->type == MESH_MSG_CONFIG) {
+        // Для команд, конфигов и подсказок темпа данные могут быть в корне
+        if (msg->type == MESH_MSG_COMMAND || msg->type == MESH_MSG_CONFIG ||
+            msg->type == MESH_MSG_RATE_HINT) {
             msg->data = cJSON_Duplicate(root, true);
         } else {
             msg->data = NULL;
@@ -114,6 +165,8 @@ bool mesh_protocol_create_telemetry(const char *node_id, const char *node_type,
     cJSON_AddStringToObject(root, "node_id", node_id);
     cJSON_AddStringToObject(root, "node_type", node_type);
     cJSON_AddNumberToObject(root, "timestamp", (double)mesh_protocol_get_timestamp());
+    cJSON_AddNumberToObject(root, "ts_us", (double)mesh_protocol_get_timestamp_us());
+    cJSON_AddNumberToObject(root, "seq", mesh_protocol_next_seq());
     
     if (data != NULL) {
         cJSON_AddItemToObject(root, "data", cJSON_Duplicate(data, true));
@@ -127,13 +180,13 @@ bool mesh_protocol_create_telemetry(const char *node_id, const char *node_type,
 
     if (strlen(json_str) >= max_len) {
         ESP_LOGW(TAG, "JSON too large: %d bytes", strlen(json_str));
-        free(json_str);
+        cJSON_free(json_str);
         cJSON_Delete(root);
         return false;
     }
 
     strcpy(out_json, json_str);
-    free(json_str);
+    cJSON_free(json_str);
     cJSON_Delete(root);
     
     return true;
@@ -145,6 +198,7 @@ bool mesh_protocol_create_command(const char *node_id, const char *command, cJSO
     cJSON_AddStringToObject(root, "type", MSG_TYPE_COMMAND);
     cJSON_AddStringToObject(root, "node_id", node_id);
     cJSON_AddNumberToObject(root, "timestamp", (double)mesh_protocol_get_timestamp());
+    cJSON_AddNumberToObject(root, "ts_us", (double)mesh_protocol_get_timestamp_us());
     cJSON_AddStringToObject(root, "command", command);
     
     if (params != NULL) {
@@ -159,13 +213,13 @@ bool mesh_protocol_create_command(const char *node_id, const char *command, cJSO
 
     if (strlen(json_str) >= max_len) {
         ESP_LOGW(TAG, "JSON too large: %d bytes", strlen(json_str));
-        free(json_str);
+        cJSON_free(json_str);
         cJSON_Delete(root);
         return false;
     }
 
     strcpy(out_json, json_str);
-    free(json_str);
+    cJSON_free(json_str);
     cJSON_Delete(root);
     
     return true;
@@ -177,6 +231,7 @@ bool mesh_protocol_create_config(const char *node_id, cJSON *config, char *out_j
     cJSON_AddStringToObject(root, "type", MSG_TYPE_CONFIG);
     cJSON_AddStringToObject(root, "node_id", node_id);
     cJSON_AddNumberToObject(root, "timestamp", (double)mesh_protocol_get_timestamp());
+    cJSON_AddNumberToObject(root, "ts_us", (double)mesh_protocol_get_timestamp_us());
     
     if (config != NULL) {
         cJSON_AddItemToObject(root, "config", cJSON_Duplicate(config, true));
@@ -190,13 +245,13 @@ bool mesh_protocol_create_config(const char *node_id, cJSON *config, char *out_j
 
     if (strlen(json_str) >= max_len) {
         ESP_LOGW(TAG, "JSON too large: %d bytes", strlen(json_str));
-        free(json_str);
+        cJSON_free(json_str);
         cJSON_Delete(root);
         return false;
     }
 
     strcpy(out_json, json_str);
-    free(json_str);
+    cJSON_free(json_str);
     cJSON_Delete(root);
     
     return true;
@@ -208,6 +263,8 @@ bool mesh_protocol_create_event(const char *node_id, mesh_event_level_t level, c
     cJSON_AddStringToObject(root, "type", MSG_TYPE_EVENT);
     cJSON_AddStringToObject(root, "node_id", node_id);
     cJSON_AddNumberToObject(root, "timestamp", (double)mesh_protocol_get_timestamp());
+    cJSON_AddNumberToObject(root, "ts_us", (double)mesh_protocol_get_timestamp_us());
+    cJSON_AddNumberToObject(root, "seq", mesh_protocol_next_seq());
     cJSON_AddStringToObject(root, "level", mesh_protocol_event_level_to_str(level));
     cJSON_AddStringToObject(root, "message", message);
     
@@ -223,13 +280,13 @@ bool mesh_protocol_create_event(const char *node_id, mesh_event_level_t level, c
 
     if (strlen(json_str) >= max_len) {
         ESP_LOGW(TAG, "JSON too large: %d bytes", strlen(json_str));
-        free(json_str);
+        cJSON_free(json_str);
         cJSON_Delete(root);
         return false;
     }
 
     strcpy(out_json, json_str);
-    free(json_str);
+    cJSON_free(json_str);
     cJSON_Delete(root);
     
     return true;
@@ -242,6 +299,8 @@ bool mesh_protocol_create_heartbeat(const char *node_id, const char *node_type,
     cJSON_AddStringToObject(root, "node_id", node_id);
     cJSON_AddStringToObject(root, "node_type", node_type);
     cJSON_AddNumberToObject(root, "timestamp", (double)mesh_protocol_get_timestamp());
+    cJSON_AddNumberToObject(root, "ts_us", (double)mesh_protocol_get_timestamp_us());
+    cJSON_AddNumberToObject(root, "seq", mesh_protocol_next_seq());
     cJSON_AddNumberToObject(root, "uptime", uptime);
     cJSON_AddNumberToObject(root, "heap_free", heap_free);
 
@@ -253,13 +312,13 @@ bool mesh_protocol_create_heartbeat(const char *node_id, const char *node_type,
 
     if (strlen(json_str) >= max_len) {
         ESP_LOGW(TAG, "JSON too large: %d bytes", strlen(json_str));
-        free(json_str);
+        cJSON_free(json_str);
         cJSON_Delete(root);
         return false;
     }
 
     strcpy(out_json, json_str);
-    free(json_str);
+    cJSON_free(json_str);
     cJSON_Delete(root);
     
     return true;
@@ -270,6 +329,7 @@ bool mesh_protocol_create_request(const char *from_id, const char *request, char
     
     cJSON_AddStringToObject(root, "type", MSG_TYPE_REQUEST);
     cJSON_AddStringToObject(root, "from", from_id);
+    cJSON_AddNumberToObject(root, "seq", mesh_protocol_next_seq());
     cJSON_AddStringToObject(root, "request", request);
 
     char *json_str = cJSON_PrintUnformatted(root);
@@ -280,13 +340,13 @@ bool mesh_protocol_create_request(const char *from_id, const char *request, char
 
     if (strlen(json_str) >= max_len) {
         ESP_LOGW(TAG, "JSON too large: %d bytes", strlen(json_str));
-        free(json_str);
+        cJSON_free(json_str);
         cJSON_Delete(root);
         return false;
     }
 
     strcpy(out_json, json_str);
-    free(json_str);
+    cJSON_free(json_str);
     cJSON_Delete(root);
     
     return true;
@@ -310,18 +370,84 @@ bool mesh_protocol_create_response(const char *to_id, cJSON *data, char *out_jso
 
     if (strlen(json_str) >= max_len) {
         ESP_LOGW(TAG, "JSON too large: %d bytes", strlen(json_str));
-        free(json_str);
+        cJSON_free(json_str);
         cJSON_Delete(root);
         return false;
     }
 
     strcpy(out_json, json_str);
-    free(json_str);
+    cJSON_free(json_str);
     cJSON_Delete(root);
     
     return true;
 }
 
+bool mesh_protocol_create_rate_hint(mesh_rate_level_t level, uint32_t ttl_s, char *out_json, size_t max_len) {
+    // Сообщение уходит каждому узлу при каждом изменении - собираем без cJSON
+    int n = snprintf(out_json, max_len, "{\"type\":\"%s\",\"level\":\"%s\",\"ttl\":%lu}",
+                     MSG_TYPE_RATE_HINT, mesh_protocol_rate_level_to_str(level),
+                     (unsigned long)ttl_s);
+    if (n < 0 || (size_t)n >= max_len) {
+        ESP_LOGW(TAG, "Rate hint buffer too small: %u bytes", (unsigned)max_len);
+        return false;
+    }
+
+    return true;
+}
+
+bool mesh_protocol_create_time_sync(uint64_t time_us, bool sntp, char *out_json, size_t max_len) {
+    // Маяк уходит каждому узлу раз в период - собираем без cJSON
+    int n = snprintf(out_json, max_len, "{\"type\":\"%s\",\"t\":%llu,\"sntp\":%d}",
+                     MSG_TYPE_TIME_SYNC, (unsigned long long)time_us, sntp ? 1 : 0);
+    if (n < 0 || (size_t)n >= max_len) {
+        ESP_LOGW(TAG, "Time sync buffer too small: %u bytes", (unsigned)max_len);
+        return false;
+    }
+
+    return true;
+}
+
+bool mesh_protocol_parse_time_sync(const uint8_t *data, size_t len, uint64_t *time_us, bool *sntp) {
+    static const char prefix[] = "{\"type\":\"time_sync\",\"t\":";
+    const size_t prefix_len = sizeof(prefix) - 1;
+
+    if (data == NULL || time_us == NULL || len <= prefix_len || len >= MESH_TIME_SYNC_MAX_LEN ||
+        memcmp(data, prefix, prefix_len) != 0) {
+        return false;
+    }
+
+    // Кадр из mesh без '\0' - разбор по копии
+    char buf[MESH_TIME_SYNC_MAX_LEN];
+    memcpy(buf, data, len);
+    buf[len] = '\0';
+
+    char *end = NULL;
+    unsigned long long t = strtoull(buf + prefix_len, &end, 10);
+    if (end == buf + prefix_len) {
+        return false;
+    }
+    *time_us = (uint64_t)t;
+
+    if (sntp) {
+        *sntp = strstr(end, "\"sntp\":1") != NULL;
+    }
+    return true;
+}
+
+bool mesh_protocol_is_for_node(const mesh_message_t *msg, const char *node_id) {
+    if (msg == NULL || node_id == NULL) {
+        return false;
+    }
+    return strcmp(msg->node_id, node_id) == 0 || strcmp(msg->node_id, MESH_NODE_ID_GROUP) == 0;
+}
+
+uint32_t mesh_protocol_next_seq(void) {
+    portENTER_CRITICAL(&s_seq_lock);
+    uint32_t seq = ++s_tx_seq;
+    portEXIT_CRITICAL(&s_seq_lock);
+    return seq;
+}
+
 void mesh_protocol_free_message(mesh_message_t *msg) {
     if (msg != NULL && msg->data != NULL) {
         cJSON_Delete(msg->data);
@@ -335,6 +461,26 @@ uint64_t mesh_protocol_get_timestamp(void) {
     return (uint64_t)tv.tv_sec;
 }
 
+uint64_t mesh_protocol_get_timestamp_us(void) {
+    portENTER_CRITICAL(&s_time_lock);
+    int64_t now = esp_timer_get_time() + s_time_offset_us;
+    uint64_t ts = now > 0 ? (uint64_t)now : 0;
+    // Мелкая коррекция назад - удержание; шаг больше секунды (новые часы ROOT) - принимается
+    if (ts < s_time_last_us && s_time_last_us - ts < 1000000) {
+        ts = s_time_last_us;
+    } else {
+        s_time_last_us = ts;
+    }
+    portEXIT_CRITICAL(&s_time_lock);
+    return ts;
+}
+
+void mesh_protocol_set_time_offset_us(int64_t offset_us) {
+    portENTER_CRITICAL(&s_time_lock);
+    s_time_offset_us = offset_us;
+    portEXIT_CRITICAL(&s_time_lock);
+}
+
 const char* mesh_protocol_event_level_to_str(mesh_event_level_t level) {
     switch (level) {
         case MESH_EVENT_INFO: return EVENT_LEVEL_INFO;
@@ -345,3 +491,22 @@ const char* mesh_protocol_event_level_to_str(mesh_event_level_t level) {
     }
 }
 
+const char* mesh_protocol_rate_level_to_str(mesh_rate_level_t level) {
+    switch (level) {
+        case MESH_RATE_NORMAL: return RATE_LEVEL_NORMAL;
+        case MESH_RATE_REDUCE: return RATE_LEVEL_REDUCE;
+        case MESH_RATE_HOLD: return RATE_LEVEL_HOLD;
+        default: return "unknown";
+    }
+}
+
+bool mesh_protocol_rate_level_from_str(const char *str, mesh_rate_level_t *level) {
+    if (str == NULL || level == NULL) {
+        return false;
+    }
+
+    if (strcmp(str, RATE_LEVEL_NORMAL) == 0) { *level = MESH_RATE_NORMAL; return true; }
+    if (strcmp(str, RATE_LEVEL_REDUCE) == 0) { *level = MESH_RATE_REDUCE; return true; }
+    if (strcmp(str, RATE_LEVEL_HOLD) == 0) { *level = MESH_RATE_HOLD; return true; }
+    return false;
+}
@@ -25,6 +25,8 @@ typedef enum {
     MESH_MSG_HEARTBEAT,      ///< Heartbeat (NODE → ROOT)
     MESH_MSG_REQUEST,        ///< Запрос данных (Display → ROOT)
     MESH_MSG_RESPONSE,       ///< Ответ на запрос (ROOT → Display)
+    MESH_MSG_RATE_HINT,      ///< Подсказка темпа отправки (ROOT → все узлы)
+    MESH_MSG_TIME_SYNC,      ///< Маяк времени mesh (ROOT → все узлы)
     MESH_MSG_UNKNOWN         ///< Неизвестный тип
 } mesh_msg_type_t;
 
@@ -38,13 +40,36 @@ typedef enum {
     MESH_EVENT_EMERGENCY     ///< Авария
 } mesh_event_level_t;
 
+/**
+ * @brief Уровни подсказки темпа (backpressure от ROOT)
+ */
+typedef enum {
+    MESH_RATE_NORMAL = 0,    ///< Обычный темп
+    MESH_RATE_REDUCE,        ///< Растянуть интервалы telemetry
+    MESH_RATE_HOLD           ///< Не слать telemetry, буферизовать локально
+} mesh_rate_level_t;
+
+/**
+ * @brief node_id групповых сообщений ROOT (команда зоне/типу узлов)
+ * 
+ * Адресаты уже выбраны ROOT - узел принимает такое сообщение как своё.
+ */
+#define MESH_NODE_ID_GROUP  "*"
+
+#define MESH_TIME_SYNC_MAX_LEN  64  ///< Буфер маяка времени
+
 /**
  * @brief Базовая структура сообщения
  */
 typedef struct {
     mesh_msg_type_t type;
     char node_id[32];
+    char node_type[16];     // Тип узла из корня сообщения ("" если не указан)
     uint64_t timestamp;
+    uint64_t timestamp_us;  // Время отправки по часам mesh ("ts_us", мкс), 0 - нет
+    uint32_t seq;           // Порядковый номер сообщения отправителя (если has_seq)
+    bool has_seq;           // В сообщении есть поле "seq"
+    int8_t rssi;            // RSSI к родителю из rssi_to_parent (корень или data), 0 - нет
     cJSON *data;  // Дополнительные данные (зависят от типа)
 } mesh_message_t;
 
@@ -140,6 +165,66 @@ bool mesh_protocol_create_request(const char *from_id, const char *request, char
  */
 bool mesh_protocol_create_response(const char *to_id, cJSON *data, char *out_json, size_t max_len);
 
+/**
+ * @brief Создание JSON строки подсказки темпа
+ * 
+ * Компактное broadcast сообщение без node_id:
+ * {"type":"rate_hint","level":"reduce","ttl":60}
+ * 
+ * @param level Уровень темпа
+ * @param ttl_s Время действия подсказки (секунды), по истечении - NORMAL
+ * @param out_json Буфер для JSON строки
+ * @param max_len Размер буфера
+ * @return true при успехе
+ */
+bool mesh_protocol_create_rate_hint(mesh_rate_level_t level, uint32_t ttl_s, char *out_json, size_t max_len);
+
+/**
+ * @brief Создание маяка времени
+ * 
+ * Собирается без cJSON: {"type":"time_sync","t":1734000000123456,"sntp":1}
+ * 
+ * @param time_us Время ROOT в момент отправки (мкс)
+ * @param sntp Время ROOT получено по SNTP (иначе - от загрузки ROOT)
+ * @param out_json Буфер для JSON строки (MESH_TIME_SYNC_MAX_LEN)
+ * @param max_len Размер буфера
+ * @return true при успехе
+ */
+bool mesh_protocol_create_time_sync(uint64_t time_us, bool sntp, char *out_json, size_t max_len);
+
+/**
+ * @brief Быстрый разбор маяка времени из принятого кадра (без cJSON)
+ * 
+ * @param data Кадр (не обязательно с '\0')
+ * @param len Длина кадра
+ * @param time_us Время ROOT (мкс)
+ * @param sntp Признак SNTP (может быть NULL)
+ * @return true если кадр - маяк времени
+ */
+bool mesh_protocol_parse_time_sync(const uint8_t *data, size_t len, uint64_t *time_us, bool *sntp);
+
+/**
+ * @brief Адресовано ли сообщение узлу
+ * 
+ * @param msg Разобранное сообщение
+ * @param node_id ID узла
+ * @return true если node_id совпадает или сообщение групповое (MESH_NODE_ID_GROUP)
+ */
+bool mesh_protocol_is_for_node(const mesh_message_t *msg, const char *node_id);
+
+/**
+ * @brief Следующий порядковый номер исходящего сообщения
+ * 
+ * Общий счётчик устройства для сообщений NODE → ROOT. create_telemetry,
+ * create_event, create_heartbeat и create_request добавляют "seq" сами;
+ * сообщения, собранные вручную, кладут в корень
+ * "seq": mesh_protocol_next_seq(). По разрывам нумерации ROOT считает
+ * потерянные сообщения.
+ * 
+ * @return Номер (с 1 после загрузки)
+ */
+uint32_t mesh_protocol_next_seq(void);
+
 /**
  * @brief Освобождение ресурсов сообщения
  * 
@@ -154,6 +239,24 @@ void mesh_protocol_free_message(mesh_message_t *msg);
  */
 uint64_t mesh_protocol_get_timestamp(void);
 
+/**
+ * @brief Время по часам mesh в микросекундах (поле "ts_us")
+ * 
+ * esp_timer_get_time() плюс смещение от mesh_time: на ROOT - до SNTP,
+ * на узлах - до часов ROOT. До синхронизации - время от загрузки.
+ * Монотонно: коррекция назад не даёт значений меньше уже выданных.
+ * 
+ * @return Микросекунды
+ */
+uint64_t mesh_protocol_get_timestamp_us(void);
+
+/**
+ * @brief Установка смещения часов mesh относительно esp_timer_get_time()
+ * 
+ * @param offset_us Смещение (мкс)
+ */
+void mesh_protocol_set_time_offset_us(int64_t offset_us);
+
 /**
  * @brief Преобразование уровня события в строку
  * 
@@ -162,6 +265,31 @@ uint64_t mesh_protocol_get_timestamp(void);
  */
 const char* mesh_protocol_event_level_to_str(mesh_event_level_t level);
 
+/**
+ * @brief Преобразование типа сообщения в строку
+ * 
+ * @param type Тип сообщения
+ * @return Строка типа ("telemetry", "heartbeat", ..., "unknown")
+ */
+const char* mesh_protocol_msg_type_to_str(mesh_msg_type_t type);
+
+/**
+ * @brief Преобразование уровня темпа в строку
+ * 
+ * @param level Уровень темпа
+ * @return Строка уровня ("normal", "reduce", "hold")
+ */
+const char* mesh_protocol_rate_level_to_str(mesh_rate_level_t level);
+
+/**
+ * @brief Преобразование строки в уровень темпа
+ * 
+ * @param str Строка уровня
+ * @param level Указатель для результата
+ * @return true если строка распознана
+ */
+bool mesh_protocol_rate_level_from_str(const char *str, mesh_rate_level_t *level);
+
 #ifdef __cplusplus
 }
 #endif
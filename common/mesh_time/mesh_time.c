@@ -0,0 +1,281 @@
+/**
+ * @file mesh_time.c
+ * @brief Реализация синхронизации времени в mesh
+ *
+ * Маяк - односторонний: ROOT ставит время в момент esp_mesh_send() для
+ * конкретного узла, узел отмечает время приёма сразу после esp_mesh_recv()
+ * (EVENT_BUS_MESH_RX, rx.time_us). Выборка смещения
+ *
+ *     offset = t_root + (layer - 1) * HOP_DELAY - t_rx
+ *
+ * занижена на задержку в очередях, поэтому из окна последних выборок
+ * берётся наибольшая (наименее задержанный маяк).
+ */
+
+#include "mesh_time.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "mesh_time";
+
+#ifdef CONFIG_MESH_TIME_ENABLE
+
+#include "mesh_protocol.h"
+#include "mesh_manager.h"
+#include "event_bus.h"
+#include "rtos_static.h"
+#include "esp_timer.h"
+#include "esp_netif_sntp.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <sys/time.h>
+
+#define MESH_TIME_MAX_NODES         50
+#define MESH_TIME_SET_CLOCK_US      100000  // Расхождение системных часов, при котором узел их выставляет
+#define MESH_TIME_STEP_US           1000000 // Скачок часов ROOT (SNTP) - окно выборок сбрасывается
+
+static bool s_is_root = false;
+static mesh_time_source_t s_source = MESH_TIME_SOURCE_NONE;
+static uint32_t s_beacons = 0;
+static int64_t s_last_sync_us = -1;         // esp_timer_get_time() последней синхронизации
+static int64_t s_last_correction_us = 0;
+static int64_t s_offset_us = 0;             // Применённое смещение часов mesh
+static uint8_t s_layer = 0;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Окно выборок смещения (узел), обрабатывается только в задаче mesh_recv
+static int64_t s_samples[CONFIG_MESH_TIME_FILTER_WINDOW];
+static int s_sample_count = 0;
+static int s_sample_next = 0;
+
+static TaskHandle_t s_beacon_task = NULL;
+RTOS_STATIC_TASK(mesh_time, 3072);
+
+static void apply_offset(int64_t offset_us, mesh_time_source_t source) {
+    portENTER_CRITICAL(&s_lock);
+    s_last_correction_us = (s_source == MESH_TIME_SOURCE_NONE) ? 0 : offset_us - s_offset_us;
+    s_offset_us = offset_us;
+    s_source = source;
+    s_last_sync_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&s_lock);
+    mesh_protocol_set_time_offset_us(offset_us);
+}
+
+// ============================================================================
+// ROOT: SNTP и маяки
+// ============================================================================
+
+static void sntp_sync_cb(struct timeval *tv) {
+    int64_t epoch_us = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+    bool first = !mesh_time_is_synced();
+    apply_offset(epoch_us - esp_timer_get_time(), MESH_TIME_SOURCE_SNTP);
+    if (first) {
+        ESP_LOGI(TAG, "SNTP synced: %lld s", (long long)tv->tv_sec);
+    }
+}
+
+static void beacon_task(void *arg) {
+    static mesh_node_info_t nodes[MESH_TIME_MAX_NODES];
+    uint8_t self[6] = {0};
+    char beacon[MESH_TIME_SYNC_MAX_LEN];
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_MESH_TIME_BEACON_PERIOD_S * 1000));
+        event_bus_wait_mesh_up(portMAX_DELAY);
+
+        int count = 0;
+        if (mesh_manager_get_routing_table_with_rssi(nodes, MESH_TIME_MAX_NODES, &count) != ESP_OK) {
+            continue;
+        }
+        mesh_manager_get_mac(self);
+        bool sntp = mesh_time_is_synced();
+
+        int sent = 0;
+        for (int i = 0; i < count; i++) {
+            if (memcmp(nodes[i].mac, self, 6) == 0) {
+                continue;
+            }
+            // Время ставится на каждую отправку: рассылка по узлам идёт последовательно
+            if (mesh_protocol_create_time_sync(mesh_protocol_get_timestamp_us(), sntp,
+                                               beacon, sizeof(beacon)) &&
+                mesh_manager_send(nodes[i].mac, (const uint8_t *)beacon, strlen(beacon)) == ESP_OK) {
+                sent++;
+            }
+        }
+
+        portENTER_CRITICAL(&s_lock);
+        s_beacons += sent;
+        portEXIT_CRITICAL(&s_lock);
+        ESP_LOGD(TAG, "Time beacon sent to %d nodes", sent);
+    }
+}
+
+static esp_err_t root_start(void) {
+    esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG(CONFIG_MESH_TIME_SNTP_SERVER);
+    config.sync_cb = sntp_sync_cb;
+    esp_err_t err = esp_netif_sntp_init(&config);
+    if (err != ESP_OK) {
+        // Без SNTP маяки всё равно выравнивают узлы по часам ROOT
+        ESP_LOGW(TAG, "SNTP init failed: %s", esp_err_to_name(err));
+    }
+
+    if (rtos_static_task_create(&mesh_time, beacon_task, "mesh_time", NULL, 4, &s_beacon_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create beacon task");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "ROOT time: SNTP %s, beacon every %d s", CONFIG_MESH_TIME_SNTP_SERVER,
+             CONFIG_MESH_TIME_BEACON_PERIOD_S);
+    return ESP_OK;
+}
+
+// ============================================================================
+// Узел: приём маяков
+// ============================================================================
+
+static void reset_filter(void) {
+    s_sample_count = 0;
+    s_sample_next = 0;
+}
+
+static void handle_beacon(const event_bus_event_t *event) {
+    uint64_t root_us = 0;
+    bool sntp = false;
+    if (!mesh_protocol_parse_time_sync(event->rx.data, event->rx.len, &root_us, &sntp)) {
+        return;
+    }
+
+    int hops = s_layer > 1 ? s_layer - 1 : 1;
+    int64_t sample = (int64_t)root_us + (int64_t)hops * CONFIG_MESH_TIME_HOP_DELAY_US - event->rx.time_us;
+
+    // Часы ROOT сменились (SNTP после загрузки) - прежние выборки о другом времени
+    if (s_sample_count > 0) {
+        int64_t last = s_samples[(s_sample_next + CONFIG_MESH_TIME_FILTER_WINDOW - 1) % CONFIG_MESH_TIME_FILTER_WINDOW];
+        if (sample - last > MESH_TIME_STEP_US || last - sample > MESH_TIME_STEP_US) {
+            reset_filter();
+        }
+    }
+
+    s_samples[s_sample_next] = sample;
+    s_sample_next = (s_sample_next + 1) % CONFIG_MESH_TIME_FILTER_WINDOW;
+    if (s_sample_count < CONFIG_MESH_TIME_FILTER_WINDOW) {
+        s_sample_count++;
+    }
+
+    int64_t best = s_samples[0];
+    for (int i = 1; i < s_sample_count; i++) {
+        if (s_samples[i] > best) {
+            best = s_samples[i];
+        }
+    }
+
+    mesh_time_source_t source = sntp ? MESH_TIME_SOURCE_ROOT_SNTP : MESH_TIME_SOURCE_ROOT;
+    bool first = !mesh_time_is_synced();
+    apply_offset(best, source);
+
+    portENTER_CRITICAL(&s_lock);
+    s_beacons++;
+    portEXIT_CRITICAL(&s_lock);
+
+    // Системные часы - только Unix time ROOT (без SNTP у ROOT время от его загрузки)
+    if (sntp) {
+        int64_t mesh_us = esp_timer_get_time() + best;
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        int64_t sys_us = (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+        if (first || sys_us - mesh_us > MESH_TIME_SET_CLOCK_US || mesh_us - sys_us > MESH_TIME_SET_CLOCK_US) {
+            struct timeval tv = { .tv_sec = mesh_us / 1000000, .tv_usec = mesh_us % 1000000 };
+            settimeofday(&tv, NULL);
+        }
+    }
+
+    if (first) {
+        ESP_LOGI(TAG, "Synced to ROOT (%s, layer %d)", mesh_time_source_to_str(source), s_layer);
+    } else {
+        ESP_LOGD(TAG, "Beacon: sample %lld us, applied %lld us", (long long)sample, (long long)best);
+    }
+}
+
+static void on_event(const event_bus_event_t *event, void *ctx) {
+    switch (event->id) {
+        case EVENT_BUS_MESH_RX:
+            handle_beacon(event);
+            break;
+        case EVENT_BUS_MESH_UP:
+        case EVENT_BUS_PARENT_CHANGED:
+            // Другой путь до ROOT - другая задержка, старые выборки не годятся
+            s_layer = event->mesh.layer;
+            reset_filter();
+            break;
+        default:
+            break;
+    }
+}
+
+esp_err_t mesh_time_init(bool is_root) {
+    s_is_root = is_root;
+    if (is_root) {
+        return root_start();
+    }
+
+    esp_err_t err = event_bus_subscribe(EVENT_BUS_BIT(EVENT_BUS_MESH_RX) |
+                                        EVENT_BUS_BIT(EVENT_BUS_MESH_UP) |
+                                        EVENT_BUS_BIT(EVENT_BUS_PARENT_CHANGED),
+                                        EVENT_BUS_MSG_ALL, on_event, NULL);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to subscribe: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    ESP_LOGI(TAG, "Node time: ROOT beacons, hop delay %d us, window %d",
+             CONFIG_MESH_TIME_HOP_DELAY_US, CONFIG_MESH_TIME_FILTER_WINDOW);
+    return ESP_OK;
+}
+
+bool mesh_time_is_synced(void) {
+    return __atomic_load_n(&s_source, __ATOMIC_RELAXED) != MESH_TIME_SOURCE_NONE;
+}
+
+void mesh_time_get_status(mesh_time_status_t *out) {
+    if (!out) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    out->source = s_source;
+    out->beacons = s_beacons;
+    out->last_correction_us = s_last_correction_us;
+    out->last_sync_age_ms = s_last_sync_us < 0 ? -1 : (esp_timer_get_time() - s_last_sync_us) / 1000;
+    out->layer = s_is_root ? 1 : s_layer;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+#else // CONFIG_MESH_TIME_ENABLE
+
+esp_err_t mesh_time_init(bool is_root) {
+    (void)is_root;
+    ESP_LOGD(TAG, "Mesh time sync disabled in Kconfig");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+bool mesh_time_is_synced(void) {
+    return false;
+}
+
+void mesh_time_get_status(mesh_time_status_t *out) {
+    if (out) {
+        memset(out, 0, sizeof(*out));
+        out->last_sync_age_ms = -1;
+    }
+}
+
+#endif // CONFIG_MESH_TIME_ENABLE
+
+const char* mesh_time_source_to_str(mesh_time_source_t source) {
+    switch (source) {
+        case MESH_TIME_SOURCE_NONE:      return "none";
+        case MESH_TIME_SOURCE_SNTP:      return "sntp";
+        case MESH_TIME_SOURCE_ROOT:      return "root";
+        case MESH_TIME_SOURCE_ROOT_SNTP: return "root_sntp";
+        default:                         return "unknown";
+    }
+}
@@ -0,0 +1,75 @@
+/**
+ * @file mesh_time.h
+ * @brief Синхронизация времени в mesh: SNTP на ROOT, маяки времени узлам
+ *
+ * ROOT берёт время по SNTP и раз в MESH_TIME_BEACON_PERIOD_S рассылает
+ * каждому узлу короткий маяк time_sync со своим временем в мкс. Узел
+ * переводит часы mesh (mesh_protocol_get_timestamp_us()) на время ROOT с
+ * поправкой на число хопов до ROOT; из последних маяков берётся наименее
+ * задержанный. После первого маяка с SNTP временем узел выставляет и
+ * системные часы - time(NULL) и поле "timestamp" становятся Unix time.
+ */
+
+#ifndef MESH_TIME_H
+#define MESH_TIME_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Источник времени
+ */
+typedef enum {
+    MESH_TIME_SOURCE_NONE = 0,      ///< Не синхронизировано - время от загрузки
+    MESH_TIME_SOURCE_SNTP,          ///< ROOT: SNTP
+    MESH_TIME_SOURCE_ROOT,          ///< Узел: маяки ROOT (у ROOT нет SNTP - общее время от загрузки ROOT)
+    MESH_TIME_SOURCE_ROOT_SNTP      ///< Узел: маяки ROOT с SNTP временем
+} mesh_time_source_t;
+
+/**
+ * @brief Состояние синхронизации
+ */
+typedef struct {
+    mesh_time_source_t source;
+    uint32_t beacons;               ///< Маяков отправлено (ROOT) / принято (узел)
+    int64_t last_correction_us;     ///< Последняя поправка часов узла (мкс)
+    int64_t last_sync_age_ms;       ///< С последней синхронизации (мс), -1 - не было
+    uint8_t layer;                  ///< Уровень узла в дереве (для поправки на хопы)
+} mesh_time_status_t;
+
+/**
+ * @brief Запуск синхронизации
+ *
+ * Вызывать после mesh_manager_init(). ROOT - SNTP и задача маяков,
+ * узел - подписка на маяки через event_bus.
+ *
+ * @param is_root true для ROOT
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED если выключено в Kconfig
+ */
+esp_err_t mesh_time_init(bool is_root);
+
+/**
+ * @brief Часы mesh синхронизированы (SNTP на ROOT или маяк на узле)
+ */
+bool mesh_time_is_synced(void);
+
+/**
+ * @brief Состояние синхронизации
+ */
+void mesh_time_get_status(mesh_time_status_t *out);
+
+/**
+ * @brief Строка источника ("none", "sntp", "root", "root_sntp")
+ */
+const char* mesh_time_source_to_str(mesh_time_source_t source);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MESH_TIME_H
@@ -0,0 +1,275 @@
+/**
+ * @file pm_policy.c
+ * @brief Реализация политики питания
+ *
+ * Одна блокировка esp_pm на место, создаётся в pm_policy_init().
+ * Учёт времени - по esp_timer в критической секции: вложенность на место
+ * и общая вложенность "занято" (любая блокировка), время открывается на
+ * первом acquire и закрывается на последнем release.
+ */
+
+#include "pm_policy.h"
+#include "esp_log.h"
+
+static const char *TAG = "pm_policy";
+
+#ifdef CONFIG_PM_POLICY_ENABLE
+
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+#ifdef CONFIG_PM_POLICY_LIGHT_SLEEP
+#define PM_LIGHT_SLEEP      true
+#else
+#define PM_LIGHT_SLEEP      false
+#endif
+
+static const char *SITE_NAMES[PM_SITE_COUNT] = { "i2c", "pump", "mesh_tx" };
+
+// I2C и mesh TX - короткие участки, важна частота CPU; насос - APB для LEDC
+static const esp_pm_lock_type_t SITE_LOCK_TYPES[PM_SITE_COUNT] = {
+    ESP_PM_CPU_FREQ_MAX,
+    ESP_PM_APB_FREQ_MAX,
+    ESP_PM_CPU_FREQ_MAX,
+};
+
+typedef struct {
+    esp_pm_lock_handle_t lock;
+    uint32_t depth;
+    int64_t held_since;
+    pm_policy_site_stats_t stats;
+} site_state_t;
+
+static site_state_t s_sites[PM_SITE_COUNT];
+static uint32_t s_busy_depth = 0;
+static int64_t s_busy_since = 0;
+static uint64_t s_busy_us = 0;
+static int64_t s_start_us = 0;
+static bool s_active = false;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t pm_policy_init(void) {
+    if (s_active) {
+        return ESP_OK;
+    }
+
+    for (int i = 0; i < PM_SITE_COUNT; i++) {
+        if (!s_sites[i].lock) {
+            esp_err_t err = esp_pm_lock_create(SITE_LOCK_TYPES[i], 0, SITE_NAMES[i], &s_sites[i].lock);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Lock %s: %s", SITE_NAMES[i], esp_err_to_name(err));
+                return err;
+            }
+        }
+    }
+
+    esp_pm_config_t config = {
+        .max_freq_mhz = CONFIG_PM_POLICY_MAX_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_PM_POLICY_MIN_FREQ_MHZ,
+        .light_sleep_enable = PM_LIGHT_SLEEP,
+    };
+    esp_err_t err = esp_pm_configure(&config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_pm_configure(%d..%d MHz) failed: %s",
+                 CONFIG_PM_POLICY_MIN_FREQ_MHZ, CONFIG_PM_POLICY_MAX_FREQ_MHZ, esp_err_to_name(err));
+        return err;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_start_us = esp_timer_get_time();
+    s_busy_us = 0;
+    if (s_busy_depth > 0) {
+        s_busy_since = s_start_us;
+    }
+    s_active = true;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "DFS %d..%d MHz, light sleep %s", CONFIG_PM_POLICY_MIN_FREQ_MHZ,
+             CONFIG_PM_POLICY_MAX_FREQ_MHZ, PM_LIGHT_SLEEP ? "on" : "off");
+    return ESP_OK;
+}
+
+void pm_policy_acquire(pm_site_t site) {
+    if (site >= PM_SITE_COUNT) {
+        return;
+    }
+    site_state_t *s = &s_sites[site];
+
+    // Переключение частоты выполняется внутри acquire - это и есть задержка
+    int64_t t0 = esp_timer_get_time();
+    if (s->lock) {
+        esp_pm_lock_acquire(s->lock);
+    }
+    int64_t t1 = esp_timer_get_time();
+    uint32_t latency = (uint32_t)(t1 - t0);
+
+    portENTER_CRITICAL(&s_lock);
+    s->stats.acquires++;
+    s->stats.acquire_us_total += latency;
+    if (latency > s->stats.acquire_us_max) {
+        s->stats.acquire_us_max = latency;
+    }
+    if (s->depth++ == 0) {
+        s->held_since = t1;
+    }
+    if (s_busy_depth++ == 0) {
+        s_busy_since = t1;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void pm_policy_release(pm_site_t site) {
+    if (site >= PM_SITE_COUNT) {
+        return;
+    }
+    site_state_t *s = &s_sites[site];
+    int64_t now = esp_timer_get_time();
+    bool balanced = true;
+
+    portENTER_CRITICAL(&s_lock);
+    if (s->depth == 0) {
+        balanced = false;
+    } else {
+        if (--s->depth == 0) {
+            s->stats.hold_us_total += now - s->held_since;
+        }
+        if (--s_busy_depth == 0) {
+            s_busy_us += now - s_busy_since;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!balanced) {
+        ESP_LOGW(TAG, "Unbalanced release: %s", SITE_NAMES[site]);
+        return;
+    }
+    if (s->lock) {
+        esp_pm_lock_release(s->lock);
+    }
+}
+
+esp_err_t pm_policy_get_site_stats(pm_site_t site, pm_policy_site_stats_t *out) {
+    if (site >= PM_SITE_COUNT || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *out = s_sites[site].stats;
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+void pm_policy_get_status(pm_policy_status_t *out) {
+    if (!out) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    out->max_freq_mhz = CONFIG_PM_POLICY_MAX_FREQ_MHZ;
+    out->min_freq_mhz = CONFIG_PM_POLICY_MIN_FREQ_MHZ;
+    out->light_sleep = PM_LIGHT_SLEEP;
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    out->active = s_active;
+    if (s_active) {
+        out->window_us = now - s_start_us;
+        out->busy_us = s_busy_us;
+        if (s_busy_depth > 0) {
+            out->busy_us += now - s_busy_since;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    // Модель двух режимов: частота max (блокировка) и простой на min / в light sleep
+    if (out->window_us > 0) {
+        uint64_t idle_us = out->window_us - out->busy_us;
+        uint64_t charge = (uint64_t)CONFIG_PM_POLICY_ACTIVE_MA * out->busy_us +
+                          (uint64_t)CONFIG_PM_POLICY_IDLE_MA * idle_us;
+        out->avg_current_ua = (uint32_t)(charge * 1000 / out->window_us);
+    }
+}
+
+const char* pm_policy_site_to_str(pm_site_t site) {
+    return site < PM_SITE_COUNT ? SITE_NAMES[site] : "unknown";
+}
+
+void pm_policy_add_to_json(cJSON *obj) {
+    if (!obj) {
+        return;
+    }
+
+    pm_policy_status_t status;
+    pm_policy_get_status(&status);
+
+    cJSON *pm = cJSON_CreateObject();
+    if (!pm) {
+        return;
+    }
+    const int freq[2] = { status.min_freq_mhz, status.max_freq_mhz };
+    cJSON_AddItemToObject(pm, "f", cJSON_CreateIntArray(freq, 2));
+    cJSON_AddBoolToObject(pm, "ls", status.light_sleep);
+    if (status.window_us > 0) {
+        cJSON_AddNumberToObject(pm, "busy", (double)(status.busy_us * 1000 / status.window_us));
+        cJSON_AddNumberToObject(pm, "ua", status.avg_current_ua);
+    }
+
+    cJSON *locks = cJSON_AddArrayToObject(pm, "locks");
+    for (int i = 0; locks && i < PM_SITE_COUNT; i++) {
+        pm_policy_site_stats_t st;
+        pm_policy_get_site_stats((pm_site_t)i, &st);
+        if (st.acquires == 0) {
+            continue;
+        }
+        cJSON *row = cJSON_CreateArray();
+        if (!row) {
+            break;
+        }
+        cJSON_AddItemToArray(row, cJSON_CreateString(SITE_NAMES[i]));
+        cJSON_AddItemToArray(row, cJSON_CreateNumber(st.acquires));
+        cJSON_AddItemToArray(row, cJSON_CreateNumber((double)(st.acquire_us_total / st.acquires)));
+        cJSON_AddItemToArray(row, cJSON_CreateNumber(st.acquire_us_max));
+        cJSON_AddItemToArray(row, cJSON_CreateNumber((double)(st.hold_us_total / 1000)));
+        cJSON_AddItemToArray(locks, row);
+    }
+
+    cJSON_AddItemToObject(obj, "pm", pm);
+}
+
+#else // CONFIG_PM_POLICY_ENABLE
+
+esp_err_t pm_policy_init(void) {
+    ESP_LOGD(TAG, "Power management disabled in Kconfig");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void pm_policy_acquire(pm_site_t site) {
+    (void)site;
+}
+
+void pm_policy_release(pm_site_t site) {
+    (void)site;
+}
+
+esp_err_t pm_policy_get_site_stats(pm_site_t site, pm_policy_site_stats_t *out) {
+    (void)site;
+    (void)out;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void pm_policy_get_status(pm_policy_status_t *out) {
+    if (out) {
+        *out = (pm_policy_status_t){ 0 };
+    }
+}
+
+const char* pm_policy_site_to_str(pm_site_t site) {
+    static const char *names[PM_SITE_COUNT] = { "i2c", "pump", "mesh_tx" };
+    return site < PM_SITE_COUNT ? names[site] : "unknown";
+}
+
+void pm_policy_add_to_json(cJSON *obj) {
+    (void)obj;
+}
+
+#endif // CONFIG_PM_POLICY_ENABLE
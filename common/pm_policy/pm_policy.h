@@ -0,0 +1,126 @@
+/**
+ * @file pm_policy.h
+ * @brief Управление питанием: DFS и light sleep (esp_pm), блокировки горячих путей
+ *
+ * pm_policy_init() включает динамическое изменение частоты CPU
+ * (max/min из Kconfig) и, если разрешено, автоматический light sleep в
+ * простое. Участки, которым нужна полная частота или непрерывно идущие
+ * периферийные часы, берут блокировку своего места (site):
+ *
+ * - PM_SITE_I2C     - транзакция I2C датчика, CPU на максимуме
+ * - PM_SITE_PUMP    - насос работает: APB на максимуме, без light sleep
+ *                     (LEDC тактируется от APB, PWM не должен плыть)
+ * - PM_SITE_MESH_TX - отправка в mesh, CPU на максимуме
+ *
+ * Блокировки счётные: вложенные и параллельные acquire/release одного
+ * места допустимы, важно только их равенство. Для каждого места
+ * считается задержка acquire (переключение частоты) и время удержания,
+ * по доле времени "занято" оценивается средний ток узла (токи
+ * активного режима и простоя - из Kconfig, это модель, а не измерение).
+ *
+ * Выключено в Kconfig (PM_POLICY_ENABLE=n или PM_ENABLE=n) - частота
+ * фиксирована, pm_policy_init() возвращает ESP_ERR_NOT_SUPPORTED,
+ * acquire/release пустые.
+ */
+
+#ifndef PM_POLICY_H
+#define PM_POLICY_H
+
+#include "esp_err.h"
+#include "cJSON.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Места, берущие блокировку
+ */
+typedef enum {
+    PM_SITE_I2C = 0,        ///< Транзакция I2C датчика (i2c)
+    PM_SITE_PUMP,           ///< Насос работает (pump)
+    PM_SITE_MESH_TX,        ///< Отправка в mesh (mesh_tx)
+    PM_SITE_COUNT
+} pm_site_t;
+
+/**
+ * @brief Статистика места
+ */
+typedef struct {
+    uint32_t acquires;          ///< Число захватов
+    uint32_t acquire_us_max;    ///< Макс. задержка захвата (мкс)
+    uint64_t acquire_us_total;  ///< Суммарная задержка захвата (мкс)
+    uint64_t hold_us_total;     ///< Суммарное время удержания (мкс)
+} pm_policy_site_stats_t;
+
+/**
+ * @brief Состояние и оценка потребления
+ */
+typedef struct {
+    bool active;                ///< esp_pm_configure() выполнен
+    bool light_sleep;           ///< Light sleep разрешён
+    uint16_t max_freq_mhz;
+    uint16_t min_freq_mhz;
+    uint64_t window_us;         ///< Время с pm_policy_init()
+    uint64_t busy_us;           ///< Время, когда удерживалась хотя бы одна блокировка
+    uint32_t avg_current_ua;    ///< Оценка среднего тока (мкА)
+} pm_policy_status_t;
+
+/**
+ * @brief Настройка esp_pm по Kconfig
+ *
+ * Вызывать в начале app_main, до создания задач. Повторный вызов - ESP_OK.
+ *
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED если выключено в Kconfig,
+ *         ошибка esp_pm_configure() (частота не поддерживается чипом)
+ */
+esp_err_t pm_policy_init(void);
+
+/**
+ * @brief Захват блокировки места
+ *
+ * Можно вызывать из задач и callback таймеров FreeRTOS. До
+ * pm_policy_init() только считает статистику.
+ */
+void pm_policy_acquire(pm_site_t site);
+
+/**
+ * @brief Освобождение блокировки места (парное к pm_policy_acquire)
+ */
+void pm_policy_release(pm_site_t site);
+
+/**
+ * @brief Статистика места
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG
+ */
+esp_err_t pm_policy_get_site_stats(pm_site_t site, pm_policy_site_stats_t *out);
+
+/**
+ * @brief Состояние и оценка среднего тока
+ */
+void pm_policy_get_status(pm_policy_status_t *out);
+
+/**
+ * @brief Имя места ("i2c", "pump", "mesh_tx")
+ */
+const char* pm_policy_site_to_str(pm_site_t site);
+
+/**
+ * @brief Сводка "pm" для heartbeat / метрик
+ *
+ * {"f":[min,max],"ls":bool,"busy":промилле,"ua":оценка тока,
+ *  "locks":[[site, захватов, средняя задержка мкс, макс. мкс, удержание мс], ...]}
+ *
+ * Выключено в Kconfig - ничего не добавляет.
+ */
+void pm_policy_add_to_json(cJSON *obj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PM_POLICY_H
@@ -1,15 +1,20 @@
 /**
  * @file pump_controller.c
  * @brief Pump controller implementation
+ *
+ * Таблицы GPIO и имён - из Kconfig, в порядке pump_id_t.
  */
 
 #include "pump_controller.h"
 #include "driver/ledc.h"
 #include "esp_log.h"
+#include "dlog.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/timers.h"
+#include "rtos_static.h"
+#include "pm_policy.h"
 #include <string.h>
 
 static const char *TAG = "pump_ctrl";
@@ -25,8 +30,27 @@ static const char *TAG = "pump_ctrl";
 #define MAX_RUN_TIME_MS   10000  // Макс 10 секунд непрерывной работы
 #define DEFAULT_ML_PER_SEC 2.0f  // Дефолтная производительность
 
-// GPIO пины для насосов
-static const int PUMP_GPIO[PUMP_MAX] = {4, 5, 6, 7, 15};
+// GPIO пины и имена насосов (порядок pump_id_t)
+static const int PUMP_GPIO[PUMP_MAX] = {
+#ifdef CONFIG_DOSING_HAS_PH
+    CONFIG_DOSING_PUMP_PH_UP_GPIO,
+    CONFIG_DOSING_PUMP_PH_DOWN_GPIO,
+#endif
+#ifdef CONFIG_DOSING_HAS_EC
+    CONFIG_DOSING_PUMP_EC_A_GPIO,
+    CONFIG_DOSING_PUMP_EC_B_GPIO,
+    CONFIG_DOSING_PUMP_EC_C_GPIO,
+#endif
+};
+
+static const char *PUMP_NAMES[PUMP_MAX] = {
+#ifdef CONFIG_DOSING_HAS_PH
+    "ph_up", "ph_down",
+#endif
+#ifdef CONFIG_DOSING_HAS_EC
+    "ec_a", "ec_b", "ec_c",
+#endif
+};
 
 // Структура насоса
 typedef struct {
@@ -40,6 +64,7 @@ typedef struct {
 
 static pump_state_t s_pumps[PUMP_MAX];
 static bool s_initialized = false;
+RTOS_STATIC_TIMERS(pump_timers, PUMP_MAX);
 
 // Forward declarations
 static void pump_timer_callback(TimerHandle_t timer);
@@ -52,7 +77,7 @@ esp_err_t pump_controller_init(void) {
         return ESP_OK;
     }
     
-    ESP_LOGI(TAG, "Initializing pump controller...");
+    ESP_LOGI(TAG, "Initializing pump controller (%d pumps)...", PUMP_MAX);
     
     // Настройка PWM таймера
     ledc_timer_config_t timer_conf = {
@@ -85,11 +110,11 @@ esp_err_t pump_controller_init(void) {
         // Создание таймера для автоостановки
         char timer_name[16];
         snprintf(timer_name, sizeof(timer_name), "pump%d", i);
-        s_pumps[i].timer = xTimerCreate(timer_name, pdMS_TO_TICKS(1000), 
-                                        pdFALSE, (void *)(uintptr_t)i, 
-                                        pump_timer_callback);
+        s_pumps[i].timer = rtos_static_timer_create(&pump_timers, i, timer_name,
+                                                    pdMS_TO_TICKS(1000), pdFALSE,
+                                                    (void *)(uintptr_t)i, pump_timer_callback);
         
-        ESP_LOGI(TAG, "Pump %d initialized (GPIO %d)", i, PUMP_GPIO[i]);
+        ESP_LOGI(TAG, "Pump %d (%s) initialized (GPIO %d)", i, PUMP_NAMES[i], PUMP_GPIO[i]);
     }
     
     s_initialized = true;
@@ -99,12 +124,13 @@ esp_err_t pump_controller_init(void) {
 
 esp_err_t pump_controller_run(pump_id_t pump, uint32_t duration_ms) {
     if (pump >= PUMP_MAX) {
+        DLOG_E(TAG, "Invalid pump ID: %d (max: %d)", pump, PUMP_MAX-1);
         return ESP_ERR_INVALID_ARG;
     }
     
     if (duration_ms > MAX_RUN_TIME_MS) {
-        ESP_LOGW(TAG, "Duration %lu ms exceeds max %d ms", 
-                 (unsigned long)duration_ms, MAX_RUN_TIME_MS);
+        DLOG_W(TAG, "Duration %lu ms exceeds max %d ms", 
+               (unsigned long)duration_ms, MAX_RUN_TIME_MS);
         duration_ms = MAX_RUN_TIME_MS;
     }
     
@@ -117,7 +143,7 @@ esp_err_t pump_controller_run_dose(pump_id_t pump, float dose_ml) {
     }
     
     if (dose_ml <= 0.0f) {
-        ESP_LOGW(TAG, "Invalid dose: %.2f ml", dose_ml);
+        DLOG_W(TAG, "Invalid dose: %.2f ml", dose_ml);
         return ESP_ERR_INVALID_ARG;
     }
     
@@ -126,13 +152,13 @@ esp_err_t pump_controller_run_dose(pump_id_t pump, float dose_ml) {
     
     // Ограничение макс времени
     if (duration_ms > MAX_RUN_TIME_MS) {
-        ESP_LOGW(TAG, "Dose %.2f ml requires %lu ms, limiting to %d ms",
-                 dose_ml, (unsigned long)duration_ms, MAX_RUN_TIME_MS);
+        DLOG_W(TAG, "Dose %.2f ml requires %lu ms, limiting to %d ms",
+               dose_ml, (unsigned long)duration_ms, MAX_RUN_TIME_MS);
         duration_ms = MAX_RUN_TIME_MS;
     }
     
-    ESP_LOGI(TAG, "Pump %d: dose %.2f ml = %lu ms", 
-             pump, dose_ml, (unsigned long)duration_ms);
+    DLOG_I(TAG, "Pump %d: dose %.2f ml = %lu ms", 
+           pump, dose_ml, (unsigned long)duration_ms);
     
     return pump_start_internal(pump, duration_ms);
 }
@@ -205,14 +231,21 @@ bool pump_controller_is_running(pump_id_t pump) {
     return s_pumps[pump].is_running;
 }
 
+const char* pump_controller_name(pump_id_t pump) {
+    return pump < PUMP_MAX ? PUMP_NAMES[pump] : "unknown";
+}
+
 // Внутренние функции
 static esp_err_t pump_start_internal(pump_id_t pump, uint32_t duration_ms) {
     if (s_pumps[pump].is_running) {
-        ESP_LOGW(TAG, "Pump %d already running", pump);
+        DLOG_W(TAG, "Pump %d already running", pump);
         return ESP_ERR_INVALID_STATE;
     }
     
-    ESP_LOGI(TAG, "Pump %d START (%lu ms)", pump, (unsigned long)duration_ms);
+    DLOG_I(TAG, "Pump %d START (%lu ms) GPIO=%d duty=100%%", pump, (unsigned long)duration_ms, PUMP_GPIO[pump]);
+    
+    // LEDC тактируется от APB: без блокировки DFS/light sleep сбивают PWM
+    pm_policy_acquire(PM_SITE_PUMP);
     
     // Включение PWM (100% duty)
     ESP_ERROR_CHECK(ledc_set_duty(PWM_MODE, (ledc_channel_t)pump, PWM_MAX_DUTY));
@@ -254,10 +287,11 @@ static esp_err_t pump_stop_internal(pump_id_t pump) {
     float ml = (actual_time / 1000.0f) * s_pumps[pump].ml_per_sec;
     s_pumps[pump].stats.total_ml += ml;
     
-    ESP_LOGI(TAG, "Pump %d STOP (%.2f ml, %llu ms)", 
-             pump, ml, (unsigned long long)actual_time);
+    DLOG_I(TAG, "Pump %d STOP (%.2f ml, %llu ms) GPIO=%d", 
+           pump, ml, (unsigned long long)actual_time, PUMP_GPIO[pump]);
     
     s_pumps[pump].is_running = false;
+    pm_policy_release(PM_SITE_PUMP);
     
     return ESP_OK;
 }
@@ -266,7 +300,7 @@ static esp_err_t pump_stop_internal(pump_id_t pump) {
 static void pump_timer_callback(TimerHandle_t timer) {
     pump_id_t pump = (pump_id_t)(uintptr_t)pvTimerGetTimerID(timer);
     
-    ESP_LOGD(TAG, "Timer callback for pump %d", pump);
+    DLOG_D(TAG, "Timer callback for pump %d", pump);
     pump_stop_internal(pump);
 }
 
@@ -1,12 +1,17 @@
 /**
  * @file pump_controller.h
- * @brief Управление 3 перистальтическими насосами с PWM (EC A/B/C)
+ * @brief Управление перистальтическими насосами дозирующего узла (PWM)
+ *
+ * Набор насосов задаётся типом узла в Kconfig (DOSING_NODE_PH / EC /
+ * PH_EC): pump_id_t и таблица GPIO собираются на этапе компиляции, номер
+ * насоса - прямой индекс в таблицу и номер канала LEDC.
  */
 
 #ifndef PUMP_CONTROLLER_H
 #define PUMP_CONTROLLER_H
 
 #include "esp_err.h"
+#include "sdkconfig.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -15,13 +20,22 @@ extern "C" {
 #endif
 
 /**
- * @brief ID насосов
+ * @brief ID насосов (GPIO - CONFIG_DOSING_PUMP_<имя>_GPIO)
+ *
+ * pH: PH_UP=0, PH_DOWN=1; EC: EC_A=0, EC_B=1, EC_C=2;
+ * pH+EC: PH_UP=0, PH_DOWN=1, EC_A=2, EC_B=3, EC_C=4
  */
 typedef enum {
-    PUMP_EC_A = 0,       // GPIO 2  - EC удобрение A
-    PUMP_EC_B = 1,       // GPIO 3  - EC удобрение B
-    PUMP_EC_C = 2,       // GPIO 4  - EC удобрение C (микроэлементы)
-    PUMP_MAX = 3
+#ifdef CONFIG_DOSING_HAS_PH
+    PUMP_PH_UP,          // pH вверх
+    PUMP_PH_DOWN,        // pH вниз
+#endif
+#ifdef CONFIG_DOSING_HAS_EC
+    PUMP_EC_A,           // EC удобрение A
+    PUMP_EC_B,           // EC удобрение B
+    PUMP_EC_C,           // EC удобрение C (микроэлементы)
+#endif
+    PUMP_MAX
 } pump_id_t;
 
 /**
@@ -37,7 +51,7 @@ typedef struct {
 /**
  * @brief Инициализация контроллера насосов
  * 
- * Настраивает PWM на 3 GPIO (ESP32-C3)
+ * Настраивает PWM на PUMP_MAX GPIO из Kconfig
  * 
  * @return ESP_OK при успехе
  */
@@ -118,6 +132,11 @@ esp_err_t pump_controller_set_calibration(pump_id_t pump, float ml_per_sec);
  */
 bool pump_controller_is_running(pump_id_t pump);
 
+/**
+ * @brief Имя насоса для логов ("ph_up", "ec_a", ...)
+ */
+const char* pump_controller_name(pump_id_t pump);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,81 @@
+/**
+ * @file rate_hint.c
+ * @brief Реализация состояния подсказки темпа
+ */
+
+#include "rate_hint.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "rate_hint";
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static mesh_rate_level_t s_level = MESH_RATE_NORMAL;
+static int64_t s_expires_us = 0;        // 0 - без срока действия
+
+void rate_hint_set(mesh_rate_level_t level, uint32_t ttl_s) {
+    if (ttl_s > RATE_HINT_MAX_TTL_S) {
+        ttl_s = RATE_HINT_MAX_TTL_S;
+    }
+
+    int64_t expires_us = (level != MESH_RATE_NORMAL && ttl_s > 0)
+                             ? esp_timer_get_time() + (int64_t)ttl_s * 1000000
+                             : 0;
+
+    portENTER_CRITICAL(&s_lock);
+    mesh_rate_level_t prev = s_level;
+    s_level = level;
+    s_expires_us = expires_us;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (prev != level) {
+        ESP_LOGW(TAG, "Rate hint: %s -> %s (ttl %lu s)",
+                 mesh_protocol_rate_level_to_str(prev),
+                 mesh_protocol_rate_level_to_str(level), (unsigned long)ttl_s);
+    }
+}
+
+bool rate_hint_handle_message(const mesh_message_t *msg) {
+    if (msg == NULL || msg->type != MESH_MSG_RATE_HINT) {
+        return false;
+    }
+
+    cJSON *level = cJSON_GetObjectItem(msg->data, "level");
+    cJSON *ttl = cJSON_GetObjectItem(msg->data, "ttl");
+
+    mesh_rate_level_t value;
+    if (!cJSON_IsString(level) || !mesh_protocol_rate_level_from_str(level->valuestring, &value)) {
+        ESP_LOGW(TAG, "Invalid rate hint level");
+        return true;
+    }
+
+    rate_hint_set(value, cJSON_IsNumber(ttl) && ttl->valuedouble > 0 ? (uint32_t)ttl->valuedouble : 0);
+    return true;
+}
+
+mesh_rate_level_t rate_hint_get_level(void) {
+    bool expired = false;
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_expires_us != 0 && esp_timer_get_time() >= s_expires_us) {
+        s_level = MESH_RATE_NORMAL;
+        s_expires_us = 0;
+        expired = true;
+    }
+    mesh_rate_level_t level = s_level;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (expired) {
+        ESP_LOGW(TAG, "Rate hint expired -> normal");
+    }
+    return level;
+}
+
+bool rate_hint_is_hold(void) {
+    return rate_hint_get_level() == MESH_RATE_HOLD;
+}
+
+uint32_t rate_hint_scale_interval_ms(uint32_t base_ms) {
+    return (rate_hint_get_level() == MESH_RATE_REDUCE) ? base_ms * RATE_HINT_REDUCE_FACTOR : base_ms;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file rate_hint.h
+ * @brief Состояние подсказки темпа от ROOT на стороне NODE
+ *
+ * ROOT рассылает rate_hint (normal / reduce / hold), когда MQTT недоступен
+ * или его очереди заполняются. Узел хранит последний уровень вместе с TTL:
+ * если обновление не пришло, подсказка истекает и узел возвращается к
+ * обычному темпу сам - потерянный "normal" не оставит узел замолчавшим.
+ *
+ * Heartbeat и события подсказка не затрагивает: по ним ROOT определяет
+ * живость узлов, а события редкие и важные.
+ */
+
+#ifndef RATE_HINT_H
+#define RATE_HINT_H
+
+#include "mesh_protocol.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RATE_HINT_REDUCE_FACTOR     4       ///< Во сколько раз растягивать интервал в REDUCE
+#define RATE_HINT_MAX_TTL_S         600     ///< Верхняя граница TTL из сообщения
+
+/**
+ * @brief Установка уровня темпа
+ *
+ * @param level Уровень
+ * @param ttl_s Время действия (секунды); 0 - до следующей подсказки
+ */
+void rate_hint_set(mesh_rate_level_t level, uint32_t ttl_s);
+
+/**
+ * @brief Обработка входящего mesh сообщения
+ *
+ * Вызывать из recv callback до проверки node_id: подсказка рассылается
+ * всем узлам и адресата не содержит.
+ *
+ * @param msg Разобранное сообщение
+ * @return true если это была подсказка темпа (сообщение обработано)
+ */
+bool rate_hint_handle_message(const mesh_message_t *msg);
+
+/**
+ * @brief Текущий уровень с учётом TTL
+ */
+mesh_rate_level_t rate_hint_get_level(void);
+
+/**
+ * @brief Действует ли HOLD (telemetry не отправлять, копить локально)
+ */
+bool rate_hint_is_hold(void);
+
+/**
+ * @brief Интервал telemetry с учётом подсказки
+ *
+ * В REDUCE интервал растягивается в RATE_HINT_REDUCE_FACTOR раз, в NORMAL и
+ * HOLD возвращается базовый (в HOLD с этим интервалом идёт запись в буфер).
+ *
+ * @param base_ms Обычный интервал
+ * @return Интервал для текущего уровня
+ */
+uint32_t rate_hint_scale_interval_ms(uint32_t base_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RATE_HINT_H
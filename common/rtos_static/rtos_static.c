@@ -0,0 +1,79 @@
+/**
+ * @file rtos_static.c
+ * @brief Создание объектов FreeRTOS в статической памяти или в heap
+ */
+
+#include "rtos_static.h"
+#include "mem_policy.h"
+#include "esp_log.h"
+
+static const char *TAG = "rtos_static";
+
+#define RTOS_STATIC_REUSE_DELAY_MS  20
+
+BaseType_t rtos_static_task_create(rtos_static_task_t *mem, TaskFunction_t fn, const char *name,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *handle) {
+    TaskHandle_t task = NULL;
+
+    if (!mem->stack) {
+        BaseType_t ret = xTaskCreate(fn, name, mem->stack_bytes, arg, priority, &task);
+        if (handle) {
+            *handle = task;
+        }
+        return ret;
+    }
+
+    // Стек и TCB заняты, пока задача не удалена
+    if (mem->handle) {
+        if (eTaskGetState(mem->handle) != eDeleted) {
+            ESP_LOGE(TAG, "Task %s: static memory still in use", name);
+            return pdFAIL;
+        }
+        // Удалившая себя задача ждёт очистки в IDLE - дать ей пройти
+        vTaskDelay(pdMS_TO_TICKS(RTOS_STATIC_REUSE_DELAY_MS));
+    }
+
+    task = xTaskCreateStatic(fn, name, mem->stack_bytes, arg, priority, mem->stack, mem->tcb);
+    if (!task) {
+        return pdFAIL;
+    }
+    if (!mem->handle) {
+        mem_policy_track_static("rtos_static", mem->stack, mem->stack_bytes + sizeof(StaticTask_t));
+    }
+    mem->handle = task;
+    if (handle) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+QueueHandle_t rtos_static_queue_create(rtos_static_queue_t *mem) {
+    if (!mem->queue) {
+        return xQueueCreate(mem->length, mem->item_size);
+    }
+    mem_policy_track_static("rtos_static", mem->storage,
+                            mem->length * mem->item_size + sizeof(StaticQueue_t));
+    return xQueueCreateStatic(mem->length, mem->item_size, mem->storage, mem->queue);
+}
+
+SemaphoreHandle_t rtos_static_mutex_create(rtos_static_mutex_t *mem) {
+    if (!mem->mutex) {
+        return xSemaphoreCreateMutex();
+    }
+    mem_policy_track_static("rtos_static", mem->mutex, sizeof(StaticSemaphore_t));
+    return xSemaphoreCreateMutexStatic(mem->mutex);
+}
+
+TimerHandle_t rtos_static_timer_create(rtos_static_timers_t *mem, uint32_t index, const char *name,
+                                       TickType_t period, UBaseType_t auto_reload, void *timer_id,
+                                       TimerCallbackFunction_t callback) {
+    if (index >= mem->count) {
+        ESP_LOGE(TAG, "Timer %s: index %lu out of %lu", name, (unsigned long)index, (unsigned long)mem->count);
+        return NULL;
+    }
+    if (!mem->timers) {
+        return xTimerCreate(name, period, auto_reload, timer_id, callback);
+    }
+    mem_policy_track_static("rtos_static", &mem->timers[index], sizeof(StaticTimer_t));
+    return xTimerCreateStatic(name, period, auto_reload, timer_id, callback, &mem->timers[index]);
+}
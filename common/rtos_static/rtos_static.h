@@ -0,0 +1,164 @@
+/**
+ * @file rtos_static.h
+ * @brief Задачи, очереди, мьютексы и таймеры FreeRTOS со статической памятью
+ *
+ * Память объекта объявляется в области файла макросом RTOS_STATIC_*,
+ * создаётся объект функцией rtos_static_*_create():
+ *
+ *     RTOS_STATIC_TASK(ph_main, 6144);
+ *     ...
+ *     rtos_static_task_create(&ph_main, main_task, "ph_main", NULL, 5, &s_main_task);
+ *
+ * RTOS_STATIC_ALLOC=y - стек, TCB, буфер очереди и таймеры лежат в .bss
+ * (xTaskCreateStatic / xQueueCreateStatic / xTimerCreateStatic): нехватка
+ * RAM видна при линковке, а не поздним отказом при загрузке, и heap не
+ * фрагментируется. Хранилище называется rtos_budget_<вид>_<имя> -
+ * по этим символам tools/ram_budget.py строит таблицу RAM бюджета
+ * прошивки (idf.py ram_budget).
+ *
+ * RTOS_STATIC_ALLOC=n (по умолчанию) - обычные xTaskCreate и т.д. из heap.
+ */
+
+#ifndef RTOS_STATIC_H
+#define RTOS_STATIC_H
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/timers.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Память задачи
+ */
+typedef struct {
+    uint32_t stack_bytes;           ///< Размер стека (байт, как в xTaskCreate ESP-IDF)
+    StackType_t *stack;             ///< NULL - задача из heap
+    StaticTask_t *tcb;
+    TaskHandle_t handle;            ///< Последняя созданная в этой памяти задача
+} rtos_static_task_t;
+
+/**
+ * @brief Память очереди
+ */
+typedef struct {
+    uint32_t length;
+    uint32_t item_size;
+    uint8_t *storage;               ///< NULL - очередь из heap
+    StaticQueue_t *queue;
+} rtos_static_queue_t;
+
+/**
+ * @brief Память мьютекса
+ */
+typedef struct {
+    StaticSemaphore_t *mutex;       ///< NULL - мьютекс из heap
+} rtos_static_mutex_t;
+
+/**
+ * @brief Память группы таймеров (например, по таймеру на насос)
+ */
+typedef struct {
+    uint32_t count;
+    StaticTimer_t *timers;          ///< NULL - таймеры из heap
+} rtos_static_timers_t;
+
+#ifdef CONFIG_RTOS_STATIC_ALLOC
+
+#define RTOS_STATIC_TASK(name, stack_size)                                          \
+    static StackType_t rtos_budget_stack_##name[(stack_size) / sizeof(StackType_t)]; \
+    static StaticTask_t rtos_budget_tcb_##name;                                     \
+    static rtos_static_task_t name = {                                              \
+        .stack_bytes = (stack_size),                                                \
+        .stack = rtos_budget_stack_##name,                                          \
+        .tcb = &rtos_budget_tcb_##name,                                             \
+    }
+
+#define RTOS_STATIC_QUEUE(name, queue_length, queue_item_size)                      \
+    static uint8_t rtos_budget_qbuf_##name[(queue_length) * (queue_item_size)];     \
+    static StaticQueue_t rtos_budget_queue_##name;                                  \
+    static rtos_static_queue_t name = {                                             \
+        .length = (queue_length),                                                   \
+        .item_size = (queue_item_size),                                             \
+        .storage = rtos_budget_qbuf_##name,                                         \
+        .queue = &rtos_budget_queue_##name,                                         \
+    }
+
+#define RTOS_STATIC_MUTEX(name)                                                     \
+    static StaticSemaphore_t rtos_budget_mutex_##name;                              \
+    static rtos_static_mutex_t name = { .mutex = &rtos_budget_mutex_##name }
+
+#define RTOS_STATIC_TIMERS(name, timer_count)                                       \
+    static StaticTimer_t rtos_budget_timer_##name[timer_count];                     \
+    static rtos_static_timers_t name = {                                            \
+        .count = (timer_count),                                                     \
+        .timers = rtos_budget_timer_##name,                                         \
+    }
+
+#else // CONFIG_RTOS_STATIC_ALLOC
+
+#define RTOS_STATIC_TASK(name, stack_size)                                          \
+    static rtos_static_task_t name = { .stack_bytes = (stack_size) }
+
+#define RTOS_STATIC_QUEUE(name, queue_length, queue_item_size)                      \
+    static rtos_static_queue_t name = { .length = (queue_length), .item_size = (queue_item_size) }
+
+#define RTOS_STATIC_MUTEX(name)                                                     \
+    static rtos_static_mutex_t name = { 0 }
+
+#define RTOS_STATIC_TIMERS(name, timer_count)                                       \
+    static rtos_static_timers_t name = { .count = (timer_count) }
+
+#endif // CONFIG_RTOS_STATIC_ALLOC
+
+/**
+ * @brief Создание задачи в памяти mem
+ *
+ * Статическая память - одна живая задача: повторное создание до
+ * удаления предыдущей задачи возвращает pdFAIL.
+ *
+ * @param mem Память из RTOS_STATIC_TASK
+ * @param fn Функция задачи
+ * @param name Имя задачи
+ * @param arg Аргумент
+ * @param priority Приоритет
+ * @param[out] handle Handle задачи (может быть NULL)
+ * @return pdPASS при успехе
+ */
+BaseType_t rtos_static_task_create(rtos_static_task_t *mem, TaskFunction_t fn, const char *name,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *handle);
+
+/**
+ * @brief Создание очереди в памяти mem
+ *
+ * @return Очередь, NULL если нет памяти (только heap режим)
+ */
+QueueHandle_t rtos_static_queue_create(rtos_static_queue_t *mem);
+
+/**
+ * @brief Создание мьютекса в памяти mem
+ *
+ * @return Мьютекс, NULL если нет памяти (только heap режим)
+ */
+SemaphoreHandle_t rtos_static_mutex_create(rtos_static_mutex_t *mem);
+
+/**
+ * @brief Создание таймера index группы mem (параметры как у xTimerCreate)
+ *
+ * @return Таймер, NULL если index вне группы или нет памяти
+ */
+TimerHandle_t rtos_static_timer_create(rtos_static_timers_t *mem, uint32_t index, const char *name,
+                                       TickType_t period, UBaseType_t auto_reload, void *timer_id,
+                                       TimerCallbackFunction_t callback);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTOS_STATIC_H
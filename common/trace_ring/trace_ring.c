@@ -0,0 +1,213 @@
+/**
+ * @file trace_ring.c
+ * @brief Реализация бинарной трассы горячего пути
+ */
+
+#include "trace_ring.h"
+#include "esp_log.h"
+
+static const char *TAG = "trace_ring";
+
+#ifdef CONFIG_TRACE_RING_ENABLE
+
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mbedtls/base64.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#define TRACE_RING_RECORDS      CONFIG_TRACE_RING_RECORDS
+#define TRACE_UART_CHUNK        48      // Байт дампа на строку base64 (64 символа)
+
+typedef struct {
+    trace_record_t *records;
+    uint32_t head;              // Всего записей (индекс = head % TRACE_RING_RECORDS)
+    uint32_t dumped_head;       // head на момент прошлого дампа
+    TickType_t last_sync;
+    bool synced;
+} trace_core_ring_t;
+
+static trace_core_ring_t s_rings[portNUM_PROCESSORS];
+static volatile bool s_enabled = false;
+static uint32_t s_flow = 0;       // 32 бита: атомарность без эмуляции на Xtensa
+
+static inline void ring_push(trace_core_ring_t *ring, uint32_t cycles, uint8_t event,
+                             uint16_t flow, uint32_t arg) {
+    trace_record_t *r = &ring->records[ring->head % TRACE_RING_RECORDS];
+    r->cycles = cycles;
+    r->arg = arg;
+    r->flow = flow;
+    r->event = event;
+    r->reserved = 0;
+    ring->head++;
+}
+
+void trace_ring_record(uint8_t event, uint16_t flow, uint32_t arg) {
+    // Маска прерываний: без вытеснения и переезда задачи на другое ядро
+    UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+
+    if (s_enabled) {
+        trace_core_ring_t *ring = &s_rings[esp_cpu_get_core_id()];
+        uint32_t cycles = esp_cpu_get_cycle_count();
+
+        // SYNC привязывает такты ядра к общему esp_timer; между SYNC меньше
+        // периода переполнения счётчика тактов
+        TickType_t now = xTaskGetTickCount();
+        if (!ring->synced || now - ring->last_sync >= pdMS_TO_TICKS(TRACE_RING_SYNC_MS)) {
+            ring_push(ring, cycles, TRACE_EV_SYNC, 0, (uint32_t)esp_timer_get_time());
+            ring->last_sync = now;
+            ring->synced = true;
+        }
+
+        ring_push(ring, cycles, event, flow, arg);
+    }
+
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+}
+
+esp_err_t trace_ring_init(void) {
+    if (s_enabled) {
+        return ESP_OK;
+    }
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        if (s_rings[core].records) {
+            continue;
+        }
+        // Внутренняя RAM: запись в PSRAM на горячем пути дороже самого события
+        s_rings[core].records = heap_caps_calloc(TRACE_RING_RECORDS, sizeof(trace_record_t),
+                                                 MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!s_rings[core].records) {
+            ESP_LOGE(TAG, "Failed to allocate ring for core %d", core);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    s_enabled = true;
+    ESP_LOGI(TAG, "Trace ring enabled: %d records x %d cores (%u bytes)",
+             TRACE_RING_RECORDS, portNUM_PROCESSORS,
+             (unsigned)(TRACE_RING_RECORDS * portNUM_PROCESSORS * sizeof(trace_record_t)));
+    return ESP_OK;
+}
+
+uint16_t trace_ring_flow_begin(void) {
+    if (!s_enabled) {
+        return 0;
+    }
+
+    uint16_t flow = (uint16_t)__atomic_add_fetch(&s_flow, 1, __ATOMIC_RELAXED);
+    if (flow == 0) {
+        flow = (uint16_t)__atomic_add_fetch(&s_flow, 1, __ATOMIC_RELAXED);
+    }
+    return flow;
+}
+
+size_t trace_ring_dump_size(void) {
+    return sizeof(trace_dump_header_t) +
+           portNUM_PROCESSORS * (sizeof(trace_dump_core_t) + TRACE_RING_RECORDS * sizeof(trace_record_t));
+}
+
+size_t trace_ring_dump(uint8_t *buf, size_t size) {
+    if (!buf || size < trace_ring_dump_size() || !s_rings[0].records) {
+        return 0;
+    }
+
+    // Пауза записи: начатая на другом ядре запись закончится за доли микросекунды
+    bool was_enabled = s_enabled;
+    s_enabled = false;
+    vTaskDelay(1);
+
+    trace_dump_header_t header = {
+        .magic = TRACE_RING_MAGIC,
+        .version = TRACE_RING_VERSION,
+        .cores = portNUM_PROCESSORS,
+        .record_size = sizeof(trace_record_t),
+        .cpu_mhz = esp_rom_get_cpu_ticks_per_us(),
+        .dropped = 0,
+    };
+    size_t pos = sizeof(header);
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        trace_core_ring_t *ring = &s_rings[core];
+        uint32_t count = ring->head < TRACE_RING_RECORDS ? ring->head : TRACE_RING_RECORDS;
+        uint32_t written = ring->head - ring->dumped_head;
+        if (written > TRACE_RING_RECORDS) {
+            header.dropped += written - TRACE_RING_RECORDS;
+        }
+        ring->dumped_head = ring->head;
+
+        trace_dump_core_t core_header = { .core = core, .count = count };
+        memcpy(buf + pos, &core_header, sizeof(core_header));
+        pos += sizeof(core_header);
+
+        // От старых к новым: кольцо заполнено - старейшая запись на месте head
+        uint32_t start = ring->head - count;
+        for (uint32_t i = 0; i < count; i++) {
+            memcpy(buf + pos, &ring->records[(start + i) % TRACE_RING_RECORDS], sizeof(trace_record_t));
+            pos += sizeof(trace_record_t);
+        }
+    }
+
+    memcpy(buf, &header, sizeof(header));
+    s_enabled = was_enabled;
+    return pos;
+}
+
+esp_err_t trace_ring_dump_uart(void) {
+    size_t size = trace_ring_dump_size();
+    uint8_t *buf = malloc(size);
+    if (!buf) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t len = trace_ring_dump(buf, size);
+    if (len == 0) {
+        free(buf);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Маркеры позволяют вырезать дамп из обычного лога монитора
+    printf("TRACE-BEGIN %u\n", (unsigned)len);
+    unsigned char line[TRACE_UART_CHUNK / 3 * 4 + 1];
+    for (size_t off = 0; off < len; off += TRACE_UART_CHUNK) {
+        size_t chunk = (len - off < TRACE_UART_CHUNK) ? len - off : TRACE_UART_CHUNK;
+        size_t olen = 0;
+        mbedtls_base64_encode(line, sizeof(line), &olen, buf + off, chunk);
+        printf("%.*s\n", (int)olen, line);
+    }
+    printf("TRACE-END\n");
+
+    free(buf);
+    return ESP_OK;
+}
+
+#else // CONFIG_TRACE_RING_ENABLE
+
+esp_err_t trace_ring_init(void) {
+    ESP_LOGD(TAG, "Trace ring disabled in Kconfig");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+uint16_t trace_ring_flow_begin(void) {
+    return 0;
+}
+
+size_t trace_ring_dump_size(void) {
+    return 0;
+}
+
+size_t trace_ring_dump(uint8_t *buf, size_t size) {
+    return 0;
+}
+
+esp_err_t trace_ring_dump_uart(void) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_TRACE_RING_ENABLE
@@ -0,0 +1,137 @@
+/**
+ * @file trace_ring.h
+ * @brief Бинарная трасса горячего пути: счётчик тактов + ID события в кольце на ядро
+ *
+ * Запись события - несколько десятков тактов: без форматирования, без
+ * блокировок между ядрами (у каждого ядра своё кольцо), старые записи
+ * перезаписываются. Дамп - бинарный (MQTT или UART), разбор и гистограммы
+ * задержек по этапам - tools/trace_decode.py.
+ *
+ * Выключено в Kconfig (TRACE_RING_ENABLE=n) - TRACE_EVENT() пустой макрос,
+ * остальные функции - заглушки.
+ */
+
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TRACE_RING_MAGIC        0x31525448  ///< "HTR1" (little-endian)
+#define TRACE_RING_VERSION      1
+#define TRACE_RING_SYNC_MS      1000        ///< Период SYNC записей на ядро
+
+/**
+ * @brief События трассы (номера - часть формата дампа, только добавлять)
+ */
+typedef enum {
+    TRACE_EV_SYNC = 0,          ///< arg = esp_timer_get_time() (мкс, младшие 32 бита)
+    TRACE_EV_MESH_RECV,         ///< Сообщение из mesh получено, arg = длина
+    TRACE_EV_PARSED,            ///< JSON разобран, arg = тип сообщения
+    TRACE_EV_REGISTRY,          ///< Реестр узлов обновлён
+    TRACE_EV_MQTT_ENQUEUE,      ///< Перед esp_mqtt_client_publish, arg = длина
+    TRACE_EV_MQTT_PUBLISHED,    ///< esp_mqtt_client_publish вернул, arg = msg_id
+    TRACE_EV_MQTT_ACK,          ///< MQTT_EVENT_PUBLISHED (QoS>0), arg = msg_id
+    TRACE_EV_MAX
+} trace_event_t;
+
+/**
+ * @brief Запись трассы (12 байт, формат дампа)
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t cycles;            ///< Счётчик тактов ядра (переполняется за ~18 с на 240 МГц)
+    uint32_t arg;               ///< Аргумент события
+    uint16_t flow;              ///< ID сообщения сквозь этапы (0 - без привязки)
+    uint8_t event;              ///< trace_event_t
+    uint8_t reserved;
+} trace_record_t;
+
+/*
+ * Формат дампа (little-endian):
+ *   trace_dump_header_t
+ *   для каждого ядра: trace_dump_core_t + count * trace_record_t (от старых к новым)
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             ///< TRACE_RING_MAGIC
+    uint8_t version;            ///< TRACE_RING_VERSION
+    uint8_t cores;
+    uint16_t record_size;       ///< sizeof(trace_record_t)
+    uint32_t cpu_mhz;           ///< Частота на момент дампа (декодер уточняет по SYNC)
+    uint32_t dropped;           ///< Перезаписано записей с последнего дампа (все ядра)
+} trace_dump_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t core;
+    uint8_t reserved;
+    uint16_t count;
+} trace_dump_core_t;
+
+#ifdef CONFIG_TRACE_RING_ENABLE
+
+/**
+ * @brief Запись события (только из задач, не из ISR)
+ *
+ * @param event trace_event_t
+ * @param flow ID из trace_ring_flow_begin() или 0
+ * @param arg Аргумент
+ */
+void trace_ring_record(uint8_t event, uint16_t flow, uint32_t arg);
+
+#define TRACE_EVENT(event, flow, arg)   trace_ring_record((event), (flow), (uint32_t)(arg))
+
+#else
+
+#define TRACE_EVENT(event, flow, arg)   ((void)0)
+
+#endif // CONFIG_TRACE_RING_ENABLE
+
+/**
+ * @brief Выделение колец (внутренняя RAM) и включение записи
+ *
+ * @return ESP_OK, ESP_ERR_NO_MEM, ESP_ERR_NOT_SUPPORTED если выключено в Kconfig
+ */
+esp_err_t trace_ring_init(void);
+
+/**
+ * @brief Новый ID сообщения для связки этапов
+ *
+ * @return ID (не 0), 0 если трасса выключена
+ */
+uint16_t trace_ring_flow_begin(void);
+
+/**
+ * @brief Размер буфера под полный дамп
+ *
+ * @return Байт, 0 если трасса выключена
+ */
+size_t trace_ring_dump_size(void);
+
+/**
+ * @brief Бинарный дамп колец
+ *
+ * На время копирования запись приостанавливается; кольца не очищаются.
+ *
+ * @param buf Буфер (trace_ring_dump_size() байт)
+ * @param size Размер буфера
+ * @return Записано байт, 0 при ошибке
+ */
+size_t trace_ring_dump(uint8_t *buf, size_t size);
+
+/**
+ * @brief Дамп в консоль (UART) base64 строками между TRACE-BEGIN / TRACE-END
+ *
+ * @return ESP_OK, ESP_ERR_NO_MEM, ESP_ERR_NOT_SUPPORTED
+ */
+esp_err_t trace_ring_dump_uart(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRACE_RING_H
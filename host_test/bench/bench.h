@@ -0,0 +1,43 @@
+/**
+ * @file bench.h
+ * @brief Замер нс на операцию для host бенчмарков
+ *
+ *     BENCH_RUN("parse telemetry", 100000, {
+ *         mesh_protocol_parse(json, &msg);
+ *         mesh_protocol_free_message(&msg);
+ *     });
+ *
+ * Результат - лучший из BENCH_REPEATS прогонов (меньше всего помех ОС).
+ * Строки в формате "BENCH <имя> <нс/оп>" удобно сравнивать между коммитами.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_REPEATS   5
+
+static inline int64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Не даёт компилятору выбросить результат
+static volatile uintptr_t bench_sink;
+#define BENCH_KEEP(x)   (bench_sink = (uintptr_t)(x))
+
+#define BENCH_RUN(name, iterations, ...) do {                               \
+        double best_ = 1e30;                                                \
+        for (int rep_ = 0; rep_ < BENCH_REPEATS; rep_++) {                  \
+            int64_t t0_ = bench_now_ns();                                   \
+            for (long it_ = 0; it_ < (iterations); it_++) {                 \
+                __VA_ARGS__                                                 \
+            }                                                               \
+            double ns_ = (double)(bench_now_ns() - t0_) / (iterations);     \
+            if (ns_ < best_) best_ = ns_;                                   \
+        }                                                                   \
+        printf("BENCH %-40s %10.1f ns/op\n", name, best_);                  \
+    } while (0)
@@ -0,0 +1,38 @@
+/**
+ * @file bench_adaptive_pid.c
+ * @brief Host бенчмарк common/adaptive_pid: стоимость одного шага
+ */
+
+#include "bench.h"
+#include "adaptive_pid.h"
+#include <string.h>
+
+// Биты float без нарушения strict aliasing (memcpy сворачивается в mov)
+static inline uint32_t float_bits(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+int main(void) {
+    adaptive_pid_t pid;
+    adaptive_pid_init(&pid, 6.0f, 1.0f, 0.1f, 0.05f);
+    adaptive_pid_set_safety(&pid, 5.0f, 0);     // Без интервала - считается каждый вызов
+
+    float out;
+    float values[4] = { 5.95f, 5.8f, 5.2f, 6.3f };  // DEAD, CLOSE, FAR, выше цели
+    unsigned i = 0;
+
+    BENCH_RUN("adaptive_pid_compute", 1000000, {
+        adaptive_pid_compute(&pid, values[i++ & 3], 1.0f, &out);
+        BENCH_KEEP(float_bits(out));
+    });
+
+    adaptive_pid_set_auto_tune(&pid, false, 0.0f);
+    BENCH_RUN("adaptive_pid_compute (no auto-tune)", 1000000, {
+        adaptive_pid_compute(&pid, values[i++ & 3], 1.0f, &out);
+        BENCH_KEEP(float_bits(out));
+    });
+
+    return 0;
+}
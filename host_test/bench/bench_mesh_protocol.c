@@ -0,0 +1,69 @@
+/**
+ * @file bench_mesh_protocol.c
+ * @brief Host бенчмарк common/mesh_protocol: сборка и разбор сообщений
+ */
+
+#include "bench.h"
+#include "mesh_protocol.h"
+#include "cjson_arena.h"
+
+int main(void) {
+    char json[512];
+    mesh_message_t msg;
+
+    BENCH_RUN("mesh_protocol_create_telemetry", 50000, {
+        cJSON *data = cJSON_CreateObject();
+        cJSON_AddNumberToObject(data, "ph", 6.42);
+        cJSON_AddNumberToObject(data, "ec", 1.87);
+        cJSON_AddNumberToObject(data, "temp", 22.5);
+        cJSON_AddNumberToObject(data, "rssi_to_parent", -61);
+        BENCH_KEEP(mesh_protocol_create_telemetry("ph_ec_001", "ph_ec", data, json, sizeof(json)));
+        cJSON_Delete(data);
+    });
+
+    BENCH_RUN("mesh_protocol_create_heartbeat", 50000, {
+        BENCH_KEEP(mesh_protocol_create_heartbeat("ph_ec_001", "ph_ec", 123456, 180000,
+                                                  json, sizeof(json)));
+    });
+
+    // Разбор - на типичном telemetry
+    cJSON *data = cJSON_CreateObject();
+    cJSON_AddNumberToObject(data, "ph", 6.42);
+    cJSON_AddNumberToObject(data, "ec", 1.87);
+    cJSON_AddNumberToObject(data, "temp", 22.5);
+    cJSON_AddNumberToObject(data, "rssi_to_parent", -61);
+    mesh_protocol_create_telemetry("ph_ec_001", "ph_ec", data, json, sizeof(json));
+    cJSON_Delete(data);
+
+    BENCH_RUN("mesh_protocol_parse telemetry", 50000, {
+        BENCH_KEEP(mesh_protocol_parse(json, &msg));
+        mesh_protocol_free_message(&msg);
+    });
+
+    mesh_protocol_create_heartbeat("ph_ec_001", "ph_ec", 123456, 180000, json, sizeof(json));
+    BENCH_RUN("mesh_protocol_parse heartbeat", 50000, {
+        BENCH_KEEP(mesh_protocol_parse(json, &msg));
+        mesh_protocol_free_message(&msg);
+    });
+
+    // То же через арену (как в data_router / on_mesh_data_received)
+    cjson_arena_install();
+    cjson_arena_t *arena = cjson_arena_create("bench", CJSON_ARENA_DEFAULT_SIZE);
+
+    data = cJSON_CreateObject();
+    cJSON_AddNumberToObject(data, "ph", 6.42);
+    cJSON_AddNumberToObject(data, "ec", 1.87);
+    cJSON_AddNumberToObject(data, "temp", 22.5);
+    cJSON_AddNumberToObject(data, "rssi_to_parent", -61);
+    mesh_protocol_create_telemetry("ph_ec_001", "ph_ec", data, json, sizeof(json));
+    cJSON_Delete(data);
+
+    BENCH_RUN("mesh_protocol_parse telemetry (arena)", 50000, {
+        cjson_arena_begin(arena);
+        BENCH_KEEP(mesh_protocol_parse(json, &msg));
+        mesh_protocol_free_message(&msg);
+        cjson_arena_end(arena, "telemetry");
+    });
+
+    return 0;
+}
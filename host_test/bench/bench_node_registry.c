@@ -0,0 +1,67 @@
+/**
+ * @file bench_node_registry.c
+ * @brief Host бенчмарк root_node/components/node_registry
+ *
+ * Собирается трижды с -DMAX_NODES=20/200/2000: поиск в версии таблицы
+ * линейный; публикация копирует записи, изменённые с прошлого
+ * использования версии из пула.
+ */
+
+#include "bench.h"
+#include "host_stubs.h"
+#include "node_registry.h"
+
+#define STR_(x) #x
+#define STR(x)  STR_(x)
+#define NAME(s) s " [" STR(MAX_NODES) " nodes]"
+
+int main(void) {
+    static char ids[MAX_NODES][16];
+    uint8_t mac[6] = { 0x24, 0x6f, 0x28, 0, 0, 0 };
+
+    node_registry_init();
+    for (int i = 0; i < MAX_NODES; i++) {
+        snprintf(ids[i], sizeof(ids[i]), "node_%04d", i);
+        mac[4] = (uint8_t)(i >> 8);
+        mac[5] = (uint8_t)i;
+        node_registry_update_last_seen(ids[i], mac, NULL, 0);
+    }
+
+    unsigned n = 0;
+    const node_registry_view_t *view = node_registry_acquire();
+
+    BENCH_RUN(NAME("view_find (uniform)"), 200000, {
+        BENCH_KEEP(node_registry_view_find(view, ids[n++ % MAX_NODES]));
+    });
+    BENCH_RUN(NAME("view_find (missing)"), 200000 / MAX_NODES + 1000, {
+        BENCH_KEEP(node_registry_view_find(view, "absent"));
+    });
+    node_registry_release(view);
+
+    BENCH_RUN(NAME("acquire + find + release"), 200000, {
+        const node_registry_view_t *v = node_registry_acquire();
+        BENCH_KEEP(node_registry_view_find(v, ids[n++ % MAX_NODES]));
+        node_registry_release(v);
+    });
+
+    // Контакт online узла - без публикации версии
+    BENCH_RUN(NAME("update_last_seen"), 20000000 / (MAX_NODES * 100) + 100, {
+        host_time_advance_us(1000000);
+        mac[4] = (uint8_t)((n % MAX_NODES) >> 8);
+        mac[5] = (uint8_t)(n % MAX_NODES);
+        node_registry_update_last_seen(ids[n++ % MAX_NODES], mac, NULL, 0);
+    });
+
+    // Данные узла - публикация версии из пула
+    cJSON *data = cJSON_Parse("{\"ph\":6.2,\"ec\":1.4}");
+    BENCH_RUN(NAME("update_data"), 2000000 / (MAX_NODES * 10) + 1000, {
+        node_registry_update_data(ids[n++ % MAX_NODES], data);
+    });
+    cJSON_Delete(data);
+
+    BENCH_RUN(NAME("check_timeouts"), 200000 / MAX_NODES + 100, {
+        node_registry_check_timeouts();
+    });
+
+    return 0;
+}
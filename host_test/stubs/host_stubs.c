@@ -0,0 +1,586 @@
+/**
+ * @file host_stubs.c
+ * @brief Host реализации заглушек ESP-IDF / FreeRTOS для тестов и бенчмарков
+ */
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/timers.h"
+#include "freertos/event_groups.h"
+#include "esp_pm.h"
+#include "host_stubs.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ============================================================================
+// esp_err / esp_log / esp_timer
+// ============================================================================
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:                        return "ESP_OK";
+        case ESP_FAIL:                      return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:                return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:           return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:         return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:          return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:             return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:         return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:               return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_NVS_NOT_FOUND:         return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_INVALID_HANDLE:    return "ESP_ERR_NVS_INVALID_HANDLE";
+        case ESP_ERR_NVS_INVALID_LENGTH:    return "ESP_ERR_NVS_INVALID_LENGTH";
+        default:                            return "UNKNOWN ERROR";
+    }
+}
+
+static int64_t s_time_offset_us = 0;
+
+int64_t esp_timer_get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000 + s_time_offset_us;
+}
+
+void host_time_advance_us(int64_t us) {
+    s_time_offset_us += us;
+}
+
+uint32_t esp_log_timestamp(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static int s_log_level = -1;
+
+esp_log_level_t esp_log_level_get(const char *tag) {
+    if (s_log_level < 0) {
+        const char *env = getenv("HOST_LOG_LEVEL");
+        s_log_level = env ? atoi(env) : ESP_LOG_WARN;
+    }
+    return (esp_log_level_t)s_log_level;
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    // Уровень общий для всех тегов
+    if (strcmp(tag, "*") == 0) {
+        s_log_level = level;
+    }
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+// ============================================================================
+// FreeRTOS мьютекс
+// ============================================================================
+
+struct host_semaphore {
+    int taken;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return calloc(1, sizeof(struct host_semaphore));
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    // Однопоточно: повторный захват - ошибка в тестируемом коде
+    if (sem->taken) {
+        fprintf(stderr, "xSemaphoreTake: mutex already taken (recursive lock)\n");
+        abort();
+    }
+    sem->taken = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    sem->taken = 0;
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    free(sem);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer) {
+    _Static_assert(sizeof(StaticSemaphore_t) >= sizeof(struct host_semaphore),
+                   "StaticSemaphore_t too small");
+    memset(buffer, 0, sizeof(*buffer));
+    return (SemaphoreHandle_t)buffer;
+}
+
+// ============================================================================
+// FreeRTOS задачи, очереди, таймеры: планировщика нет, создание не удаётся
+// ============================================================================
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_bytes,
+                       void *arg, UBaseType_t priority, TaskHandle_t *handle) {
+    (void)fn; (void)name; (void)stack_bytes; (void)arg; (void)priority;
+    if (handle) {
+        *handle = NULL;
+    }
+    return pdFAIL;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_bytes,
+                               void *arg, UBaseType_t priority, StackType_t *stack,
+                               StaticTask_t *tcb) {
+    (void)fn; (void)name; (void)stack_bytes; (void)arg; (void)priority; (void)stack; (void)tcb;
+    return NULL;
+}
+
+eTaskState eTaskGetState(TaskHandle_t task) {
+    (void)task;
+    return eDeleted;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    host_time_advance_us((int64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+struct host_task {
+    uint32_t notify_value;
+    bool notify_pending;
+};
+
+static struct host_task s_current_task;
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return &s_current_task;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    if (!task) {
+        return pdFAIL;
+    }
+    switch (action) {
+        case eSetBits:                  task->notify_value |= value; break;
+        case eIncrement:                task->notify_value++; break;
+        case eSetValueWithOverwrite:    task->notify_value = value; break;
+        case eSetValueWithoutOverwrite:
+            if (task->notify_pending) {
+                return pdFAIL;
+            }
+            task->notify_value = value;
+            break;
+        default:
+            break;
+    }
+    task->notify_pending = true;
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit,
+                           uint32_t *value, TickType_t ticks) {
+    struct host_task *t = &s_current_task;
+    if (!t->notify_pending) {
+        t->notify_value &= ~clear_on_entry;
+        if (ticks != portMAX_DELAY) {
+            vTaskDelay(ticks);
+        }
+        return pdFALSE;
+    }
+    if (value) {
+        *value = t->notify_value;
+    }
+    t->notify_value &= ~clear_on_exit;
+    t->notify_pending = false;
+    return pdTRUE;
+}
+
+// ============================================================================
+// FreeRTOS группы событий
+// ============================================================================
+
+struct host_event_group {
+    EventBits_t bits;
+};
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    return calloc(1, sizeof(struct host_event_group));
+}
+
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *buffer) {
+    _Static_assert(sizeof(StaticEventGroup_t) >= sizeof(struct host_event_group),
+                   "StaticEventGroup_t too small");
+    memset(buffer, 0, sizeof(*buffer));
+    return (EventGroupHandle_t)buffer;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    group->bits |= bits;
+    return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    EventBits_t old = group->bits;
+    group->bits &= ~bits;
+    return old;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+                                BaseType_t clear_on_exit, BaseType_t wait_all,
+                                TickType_t ticks) {
+    EventBits_t current = group->bits;
+    bool satisfied = wait_all ? (current & bits) == bits : (current & bits) != 0;
+    if (!satisfied) {
+        if (ticks != portMAX_DELAY) {
+            vTaskDelay(ticks);
+        }
+        return current;
+    }
+    if (clear_on_exit) {
+        group->bits &= ~bits;
+    }
+    return current;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    (void)length; (void)item_size;
+    return NULL;
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size,
+                                 uint8_t *storage, StaticQueue_t *queue) {
+    (void)length; (void)item_size; (void)storage; (void)queue;
+    return NULL;
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload,
+                           void *timer_id, TimerCallbackFunction_t callback) {
+    (void)name; (void)period; (void)auto_reload; (void)timer_id; (void)callback;
+    return NULL;
+}
+
+TimerHandle_t xTimerCreateStatic(const char *name, TickType_t period, UBaseType_t auto_reload,
+                                 void *timer_id, TimerCallbackFunction_t callback,
+                                 StaticTimer_t *buffer) {
+    (void)name; (void)period; (void)auto_reload; (void)timer_id; (void)callback; (void)buffer;
+    return NULL;
+}
+
+// ============================================================================
+// esp_pm: счётчик захватов, задержка переключения частоты сдвигом времени
+// ============================================================================
+
+struct esp_pm_lock {
+    esp_pm_lock_type_t type;
+    int count;
+};
+
+static int64_t s_pm_switch_us = 0;
+static int s_pm_held = 0;
+
+void host_pm_set_switch_us(int64_t us) {
+    s_pm_switch_us = us;
+}
+
+int host_pm_locks_held(void) {
+    return s_pm_held;
+}
+
+esp_err_t esp_pm_configure(const void *config) {
+    return config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int arg, const char *name,
+                             esp_pm_lock_handle_t *out_handle) {
+    (void)arg; (void)name;
+    if (!out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_pm_lock_handle_t lock = calloc(1, sizeof(*lock));
+    if (!lock) {
+        return ESP_ERR_NO_MEM;
+    }
+    lock->type = lock_type;
+    *out_handle = lock;
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_pm_held++ == 0) {
+        host_time_advance_us(s_pm_switch_us);
+    }
+    handle->count++;
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle) {
+    if (!handle || handle->count == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->count--;
+    s_pm_held--;
+    return ESP_OK;
+}
+
+// ============================================================================
+// heap_caps с имитацией PSRAM
+// ============================================================================
+
+#define HOST_PSRAM_MAX_BLOCKS   256
+#define HOST_INTERNAL_SIZE      (512 * 1024)    // Для отчётов: "свободно" во внутренней RAM
+
+static size_t s_psram_size = 0;
+static size_t s_psram_used = 0;             // Только растёт: free() не знает о PSRAM
+static const void *s_psram_blocks[HOST_PSRAM_MAX_BLOCKS];
+static int s_psram_block_count = 0;
+
+void host_psram_set_size(size_t bytes) {
+    s_psram_size = bytes;
+    s_psram_used = 0;
+    s_psram_block_count = 0;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+    if (!(caps & MALLOC_CAP_SPIRAM)) {
+        return malloc(size);
+    }
+    if (size > s_psram_size - s_psram_used || s_psram_block_count >= HOST_PSRAM_MAX_BLOCKS) {
+        return NULL;
+    }
+    void *ptr = malloc(size);
+    if (ptr) {
+        s_psram_used += size;
+        s_psram_blocks[s_psram_block_count++] = ptr;
+    }
+    return ptr;
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    void *ptr = heap_caps_malloc(n * size, caps);
+    if (ptr) {
+        memset(ptr, 0, n * size);
+    }
+    return ptr;
+}
+
+void heap_caps_free(void *ptr) {
+    free(ptr);
+}
+
+size_t heap_caps_get_total_size(uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? s_psram_size : HOST_INTERNAL_SIZE;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? s_psram_size - s_psram_used : HOST_INTERNAL_SIZE;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+bool esp_ptr_external_ram(const void *ptr) {
+    for (int i = 0; i < s_psram_block_count; i++) {
+        if (s_psram_blocks[i] == ptr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// NVS в памяти
+// ============================================================================
+
+#define HOST_NVS_MAX_ENTRIES    64
+#define HOST_NVS_MAX_HANDLES    16
+
+typedef struct {
+    char ns[16];
+    char key[16];
+    void *data;
+    size_t len;
+} host_nvs_entry_t;
+
+typedef struct {
+    char ns[16];
+    nvs_open_mode_t mode;
+    int open;
+} host_nvs_handle_t;
+
+static host_nvs_entry_t s_nvs[HOST_NVS_MAX_ENTRIES];
+static host_nvs_handle_t s_handles[HOST_NVS_MAX_HANDLES];
+
+static host_nvs_handle_t *get_handle(nvs_handle_t handle) {
+    if (handle == 0 || handle > HOST_NVS_MAX_HANDLES || !s_handles[handle - 1].open) {
+        return NULL;
+    }
+    return &s_handles[handle - 1];
+}
+
+static host_nvs_entry_t *find_entry(const char *ns, const char *key) {
+    for (int i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+        if (s_nvs[i].data && strcmp(s_nvs[i].ns, ns) == 0 && strcmp(s_nvs[i].key, key) == 0) {
+            return &s_nvs[i];
+        }
+    }
+    return NULL;
+}
+
+void host_nvs_reset(void) {
+    for (int i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+        free(s_nvs[i].data);
+    }
+    memset(s_nvs, 0, sizeof(s_nvs));
+}
+
+esp_err_t nvs_flash_init(void) {
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    host_nvs_reset();
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+    if (!name || !out_handle || strlen(name) >= sizeof(s_handles[0].ns)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Как в NVS: namespace без записей нельзя открыть только для чтения
+    if (open_mode == NVS_READONLY) {
+        bool exists = false;
+        for (int i = 0; i < HOST_NVS_MAX_ENTRIES && !exists; i++) {
+            exists = s_nvs[i].data && strcmp(s_nvs[i].ns, name) == 0;
+        }
+        if (!exists) {
+            return ESP_ERR_NVS_NOT_FOUND;
+        }
+    }
+
+    for (int i = 0; i < HOST_NVS_MAX_HANDLES; i++) {
+        if (!s_handles[i].open) {
+            strcpy(s_handles[i].ns, name);
+            s_handles[i].mode = open_mode;
+            s_handles[i].open = 1;
+            *out_handle = i + 1;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    host_nvs_handle_t *h = get_handle(handle);
+    if (h) {
+        h->open = 0;
+    }
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+    host_nvs_handle_t *h = get_handle(handle);
+    if (!h) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+
+    host_nvs_entry_t *e = find_entry(h->ns, key);
+    if (!e) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (!out_value) {
+        *length = e->len;
+        return ESP_OK;
+    }
+    if (*length < e->len) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out_value, e->data, e->len);
+    *length = e->len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    host_nvs_handle_t *h = get_handle(handle);
+    if (!h || h->mode != NVS_READWRITE) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (strlen(key) >= sizeof(s_nvs[0].key)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_nvs_entry_t *e = find_entry(h->ns, key);
+    for (int i = 0; i < HOST_NVS_MAX_ENTRIES && !e; i++) {
+        if (!s_nvs[i].data) {
+            e = &s_nvs[i];
+            strcpy(e->ns, h->ns);
+            strcpy(e->key, key);
+        }
+    }
+    if (!e) {
+        return ESP_ERR_NVS_NO_FREE_PAGES;
+    }
+
+    void *copy = malloc(length ? length : 1);
+    if (!copy) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(copy, value, length);
+    free(e->data);
+    e->data = copy;
+    e->len = length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+    host_nvs_handle_t *h = get_handle(handle);
+    if (!h || h->mode != NVS_READWRITE) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+
+    host_nvs_entry_t *e = find_entry(h->ns, key);
+    if (!e) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    free(e->data);
+    memset(e, 0, sizeof(*e));
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle) {
+    host_nvs_handle_t *h = get_handle(handle);
+    if (!h || h->mode != NVS_READWRITE) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+
+    for (int i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+        if (s_nvs[i].data && strcmp(s_nvs[i].ns, h->ns) == 0) {
+            free(s_nvs[i].data);
+            memset(&s_nvs[i], 0, sizeof(s_nvs[i]));
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    return get_handle(handle) ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+}
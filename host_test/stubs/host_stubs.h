@@ -0,0 +1,50 @@
+/**
+ * @file host_stubs.h
+ * @brief Управление host заглушками из тестов
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Сдвиг esp_timer_get_time() вперёд (таймауты без ожидания)
+ *
+ * @param us Микросекунды
+ */
+void host_time_advance_us(int64_t us);
+
+/**
+ * @brief Имитация переключения частоты: сдвиг времени на первом захвате esp_pm
+ *
+ * @param us Микросекунды (0 - без задержки, по умолчанию)
+ */
+void host_pm_set_switch_us(int64_t us);
+
+/**
+ * @brief Число удерживаемых захватов esp_pm (всех блокировок)
+ */
+int host_pm_locks_held(void);
+
+/**
+ * @brief Очистка NVS в памяти
+ */
+void host_nvs_reset(void);
+
+/**
+ * @brief Размер имитируемой PSRAM (0 - нет PSRAM, по умолчанию)
+ *
+ * Сбрасывает учёт занятого и адреса блоков "из PSRAM".
+ *
+ * @param bytes Байт
+ */
+void host_psram_set_size(size_t bytes);
+
+#ifdef __cplusplus
+}
+#endif
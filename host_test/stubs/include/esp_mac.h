@@ -0,0 +1,9 @@
+/**
+ * @file esp_mac.h
+ * @brief Host заглушка: макросы печати MAC
+ */
+
+#pragma once
+
+#define MAC2STR(a) (a)[0], (a)[1], (a)[2], (a)[3], (a)[4], (a)[5]
+#define MACSTR "%02x:%02x:%02x:%02x:%02x:%02x"
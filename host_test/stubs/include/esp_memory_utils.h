@@ -0,0 +1,18 @@
+/**
+ * @file esp_memory_utils.h
+ * @brief Host заглушка: принадлежность адреса PSRAM (см. esp_heap_caps.h)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool esp_ptr_external_ram(const void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
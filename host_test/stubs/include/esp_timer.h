@@ -0,0 +1,21 @@
+/**
+ * @file esp_timer.h
+ * @brief Host заглушка: esp_timer_get_time() - монотонные часы + сдвиг
+ *
+ * Тесты двигают время вперёд host_time_advance_us() (host_stubs.h) - так
+ * проверяются таймауты и интервалы без реального ожидания.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,18 @@
+/**
+ * @file queue.h
+ * @brief Host заглушка: очереди FreeRTOS (не создаются)
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_queue *QueueHandle_t;
+
+typedef struct {
+    void *dummy[4];
+} StaticQueue_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size,
+                                 uint8_t *storage, StaticQueue_t *queue);
@@ -0,0 +1,47 @@
+/**
+ * @file task.h
+ * @brief Host заглушка: задачи FreeRTOS (планировщика нет - создание не удаётся)
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef uint8_t StackType_t;
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+typedef struct {
+    void *dummy[4];
+} StaticTask_t;
+
+typedef enum {
+    eRunning = 0,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid
+} eTaskState;
+
+typedef enum {
+    eNoAction = 0,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite
+} eNotifyAction;
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_bytes,
+                       void *arg, UBaseType_t priority, TaskHandle_t *handle);
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_bytes,
+                               void *arg, UBaseType_t priority, StackType_t *stack,
+                               StaticTask_t *tcb);
+eTaskState eTaskGetState(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+
+// Уведомления: текущая задача - единственная задача теста
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit,
+                           uint32_t *value, TickType_t ticks);
@@ -0,0 +1,20 @@
+/**
+ * @file nvs_flash.h
+ * @brief Host заглушка: инициализация/стирание NVS в памяти
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "nvs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
+
+#ifdef __cplusplus
+}
+#endif
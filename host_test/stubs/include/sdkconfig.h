@@ -0,0 +1,26 @@
+/**
+ * @file sdkconfig.h
+ * @brief Host заглушка: Kconfig опции компонентов, собираемых на ПК
+ */
+
+#pragma once
+
+#define CONFIG_CJSON_ARENA_ENABLE       1
+#define CONFIG_CJSON_ARENA_SIZE         4096
+#define CONFIG_MEM_POLICY_COLD_PSRAM    1  // PSRAM - host_psram_set_size()
+#define CONFIG_RTOS_STATIC_ALLOC        1
+#define CONFIG_EVENT_BUS_MAX_SUBSCRIBERS 16
+#define CONFIG_PM_ENABLE                1
+#define CONFIG_PM_POLICY_ENABLE         1
+#define CONFIG_PM_POLICY_MAX_FREQ_MHZ   160
+#define CONFIG_PM_POLICY_MIN_FREQ_MHZ   40
+#define CONFIG_PM_POLICY_ACTIVE_MA      90
+#define CONFIG_PM_POLICY_IDLE_MA        30
+#define CONFIG_DOSING_NODE_PH_EC        1
+#define CONFIG_DOSING_HAS_PH            1
+#define CONFIG_DOSING_HAS_EC            1
+#define CONFIG_DOSING_PUMP_PH_UP_GPIO   4
+#define CONFIG_DOSING_PUMP_PH_DOWN_GPIO 5
+#define CONFIG_DOSING_PUMP_EC_A_GPIO    6
+#define CONFIG_DOSING_PUMP_EC_B_GPIO    7
+#define CONFIG_DOSING_PUMP_EC_C_GPIO    15
@@ -0,0 +1,68 @@
+/**
+ * @file host_test.h
+ * @brief Минимальный раннер host тестов (по мотивам Unity)
+ *
+ * Каждый test_*.c - отдельный исполняемый файл с main():
+ *
+ *     static void test_parse(void) { TEST_ASSERT_TRUE(...); }
+ *     int main(void) { RUN_TEST(test_parse); return TEST_REPORT(); }
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static int s_test_failures = 0;
+static int s_test_count = 0;
+static int s_test_current_failed = 0;
+
+#define TEST_FAIL_MSG(fmt, ...) do {                                                    \
+        fprintf(stderr, "  FAIL %s:%d: " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__);  \
+        s_test_current_failed = 1;                                                      \
+        return;                                                                         \
+    } while (0)
+
+#define TEST_ASSERT_TRUE(cond) do {                                         \
+        if (!(cond)) TEST_FAIL_MSG("expected true: %s", #cond);             \
+    } while (0)
+
+#define TEST_ASSERT_FALSE(cond) do {                                        \
+        if (cond) TEST_FAIL_MSG("expected false: %s", #cond);               \
+    } while (0)
+
+#define TEST_ASSERT_NULL(ptr)       TEST_ASSERT_TRUE((ptr) == NULL)
+#define TEST_ASSERT_NOT_NULL(ptr)   TEST_ASSERT_TRUE((ptr) != NULL)
+
+#define TEST_ASSERT_EQUAL_INT(expected, actual) do {                        \
+        long long e_ = (long long)(expected), a_ = (long long)(actual);     \
+        if (e_ != a_) TEST_FAIL_MSG("%s: expected %lld, got %lld", #actual, e_, a_); \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL_STRING(expected, actual) do {                     \
+        const char *e_ = (expected), *a_ = (actual);                        \
+        if (!a_ || strcmp(e_, a_) != 0)                                     \
+            TEST_FAIL_MSG("%s: expected \"%s\", got \"%s\"", #actual, e_, a_ ? a_ : "(null)"); \
+    } while (0)
+
+#define TEST_ASSERT_FLOAT_WITHIN(delta, expected, actual) do {              \
+        double e_ = (expected), a_ = (actual);                              \
+        if (!(fabs(e_ - a_) <= (delta)))                                    \
+            TEST_FAIL_MSG("%s: expected %g +- %g, got %g", #actual, e_, (double)(delta), a_); \
+    } while (0)
+
+#define RUN_TEST(fn) do {                                                   \
+        s_test_current_failed = 0;                                          \
+        s_test_count++;                                                     \
+        fn();                                                               \
+        if (s_test_current_failed) {                                        \
+            s_test_failures++;                                              \
+            fprintf(stderr, "[FAIL] %s\n", #fn);                            \
+        } else {                                                            \
+            printf("[ OK ] %s\n", #fn);                                     \
+        }                                                                   \
+    } while (0)
+
+#define TEST_REPORT() (printf("%d tests, %d failures\n", s_test_count, s_test_failures), \
+                       s_test_failures ? 1 : 0)
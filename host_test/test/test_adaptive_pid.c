@@ -0,0 +1,304 @@
+/**
+ * @file test_adaptive_pid.c
+ * @brief Host тесты common/adaptive_pid: зоны, safety интервал, ограничения,
+ *        идентификация объекта, предиктор Смита
+ */
+
+#include "host_test.h"
+#include "host_stubs.h"
+#include "adaptive_pid.h"
+#include <math.h>
+
+// Объект для идентификации: доза u сдвигает значение на K·u с задержкой
+// dead_s и смешиванием tau_s (первый порядок)
+#define PLANT_K         0.1f
+#define PLANT_TAU_S     40.0f
+#define PLANT_DEAD_S    20.0f
+#define PLANT_DT_S      10.0f
+#define PLANT_MAX_DOSES 128
+
+typedef struct {
+    float y0;
+    float tau_s;
+    float dead_s;
+    float t_s;
+    int doses;
+    float dose_t[PLANT_MAX_DOSES];
+    float dose_ml[PLANT_MAX_DOSES];
+} plant_t;
+
+#define PLANT_INIT(y) { .y0 = (y), .tau_s = PLANT_TAU_S, .dead_s = PLANT_DEAD_S }
+
+static float plant_value(const plant_t *p) {
+    float y = p->y0;
+    for (int i = 0; i < p->doses; i++) {
+        float age = p->t_s - p->dose_t[i] - p->dead_s;
+        if (age > 0.0f) {
+            y += PLANT_K * p->dose_ml[i] * (1.0f - expf(-age / p->tau_s));
+        }
+    }
+    return y;
+}
+
+// Шаги контура по PLANT_DT_S; возвращает максимум значения
+static float plant_run(plant_t *p, adaptive_pid_t *pid, int steps) {
+    float y_max = plant_value(p);
+    for (int i = 0; i < steps; i++) {
+        float y = plant_value(p);
+        if (y > y_max) {
+            y_max = y;
+        }
+        float out = 0.0f;
+        adaptive_pid_compute(pid, y, PLANT_DT_S, &out);
+        if (out > 0.0f && p->doses < PLANT_MAX_DOSES) {
+            p->dose_t[p->doses] = p->t_s;
+            p->dose_ml[p->doses] = out;
+            p->doses++;
+        }
+        p->t_s += PLANT_DT_S;
+        host_time_advance_us((int64_t)(PLANT_DT_S * 1000000.0f));
+    }
+    return y_max;
+}
+
+// Агрессивные начальные коэффициенты: доза 5 мл на ошибку 0.25
+static void init_plant_pid(adaptive_pid_t *pid, float setpoint) {
+    host_time_advance_us(600000000LL);
+    adaptive_pid_init(pid, setpoint, 20.0f, 0.0f, 0.0f);
+}
+
+static void init_pid(adaptive_pid_t *pid) {
+    adaptive_pid_init(pid, 6.0f, 1.0f, 0.1f, 0.0f);
+    adaptive_pid_set_auto_tune(pid, false, 0.0f);
+}
+
+static void test_dead_zone_no_output(void) {
+    adaptive_pid_t pid;
+    init_pid(&pid);
+
+    float out = -1.0f;
+    TEST_ASSERT_EQUAL_INT(ESP_OK, adaptive_pid_compute(&pid, 5.95f, 1.0f, &out));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, out);
+    TEST_ASSERT_EQUAL_INT(ZONE_DEAD, adaptive_pid_get_zone(&pid));
+}
+
+static void test_close_zone_output(void) {
+    adaptive_pid_t pid;
+    init_pid(&pid);
+
+    // error = 0.2: P = 0.2, I = 0.1 * 0.2 * 1 = 0.02
+    float out = 0.0f;
+    TEST_ASSERT_EQUAL_INT(ESP_OK, adaptive_pid_compute(&pid, 5.8f, 1.0f, &out));
+    TEST_ASSERT_EQUAL_INT(ZONE_CLOSE, adaptive_pid_get_zone(&pid));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.22, out);
+    TEST_ASSERT_EQUAL_INT(1, adaptive_pid_get_stats(&pid)->corrections_count);
+}
+
+static void test_far_zone_clamped_to_max_dose(void) {
+    adaptive_pid_t pid;
+    init_pid(&pid);
+    adaptive_pid_set_safety(&pid, 2.0f, 0);
+
+    float out = 0.0f;
+    TEST_ASSERT_EQUAL_INT(ESP_OK, adaptive_pid_compute(&pid, 2.0f, 1.0f, &out));
+    TEST_ASSERT_EQUAL_INT(ZONE_FAR, adaptive_pid_get_zone(&pid));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 2.0, out);
+}
+
+static void test_safety_interval(void) {
+    adaptive_pid_t pid;
+    init_pid(&pid);
+    adaptive_pid_set_safety(&pid, 5.0f, 60000);
+
+    float out = 0.0f;
+    adaptive_pid_compute(&pid, 5.8f, 1.0f, &out);
+    TEST_ASSERT_TRUE(out > 0.0f);
+
+    // Сразу после дозы - пропуск
+    adaptive_pid_compute(&pid, 5.8f, 1.0f, &out);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, out);
+
+    host_time_advance_us(60000LL * 1000);
+    adaptive_pid_compute(&pid, 5.8f, 1.0f, &out);
+    TEST_ASSERT_TRUE(out > 0.0f);
+}
+
+static void test_emergency_stop(void) {
+    adaptive_pid_t pid;
+    init_pid(&pid);
+
+    float out = 1.0f;
+    adaptive_pid_emergency_stop(&pid);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, adaptive_pid_compute(&pid, 3.0f, 1.0f, &out));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, out);
+
+    adaptive_pid_resume(&pid);
+    adaptive_pid_compute(&pid, 3.0f, 1.0f, &out);
+    TEST_ASSERT_TRUE(out > 0.0f);
+}
+
+static void test_invalid_args(void) {
+    adaptive_pid_t pid;
+    init_pid(&pid);
+
+    float out;
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, adaptive_pid_compute(&pid, 5.0f, 0.0f, &out));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, adaptive_pid_compute(&pid, 5.0f, 11.0f, &out));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, adaptive_pid_compute(NULL, 5.0f, 1.0f, &out));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, adaptive_pid_set_target(&pid, 15.0f));
+}
+
+static void test_set_target_changes_setpoint(void) {
+    adaptive_pid_t pid;
+    init_pid(&pid);
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, adaptive_pid_set_target(&pid, 6.5f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 6.5, pid.setpoint);
+
+    // Ошибка 0.5 - дальняя зона (close_zone = 0.3)
+    float out = 0.0f;
+    adaptive_pid_compute(&pid, 6.0f, 1.0f, &out);
+    TEST_ASSERT_EQUAL_INT(ZONE_FAR, adaptive_pid_get_zone(&pid));
+    TEST_ASSERT_TRUE(out > 0.0f);
+}
+
+static void test_identifies_plant(void) {
+    plant_t plant = PLANT_INIT(5.0f);
+    adaptive_pid_t pid;
+    init_plant_pid(&pid, 5.6f);
+
+    // Несколько подъёмов цели - дозы с откликом
+    plant_run(&plant, &pid, 60);
+    adaptive_pid_set_setpoint(&pid, 6.2f);
+    plant_run(&plant, &pid, 60);
+
+    const pid_model_t *m = adaptive_pid_get_model(&pid);
+    TEST_ASSERT_TRUE(m->ready);
+    TEST_ASSERT_TRUE(m->doses >= 2);
+    TEST_ASSERT_FLOAT_WITHIN(PLANT_K * 0.2f, PLANT_K, m->gain);
+    TEST_ASSERT_FLOAT_WITHIN(PLANT_DT_S, PLANT_DEAD_S, m->dead_time_s);
+    TEST_ASSERT_FLOAT_WITHIN(PLANT_TAU_S * 0.5f, PLANT_TAU_S, m->time_constant_s);
+
+    // Коэффициенты выведены из модели: один шаг не перекрывает ошибку
+    TEST_ASSERT_TRUE(pid.coeffs_close.kp > 0.0f);
+    TEST_ASSERT_TRUE(pid.coeffs_close.kp * m->gain <= 1.0f);
+    TEST_ASSERT_TRUE(pid.coeffs_far.kp > pid.coeffs_close.kp);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, pid.coeffs_close.kd);
+}
+
+static void test_model_tuning_reduces_overshoot(void) {
+    // Фиксированные агрессивные коэффициенты
+    plant_t fixed_plant = PLANT_INIT(5.0f);
+    adaptive_pid_t fixed;
+    init_plant_pid(&fixed, 5.6f);
+    adaptive_pid_set_auto_tune(&fixed, false, 0.0f);
+    adaptive_pid_set_identification(&fixed, false, 1.5f);
+    float fixed_over = plant_run(&fixed_plant, &fixed, 60) - 5.6f;
+
+    // Те же коэффициенты, модель идентифицирована на предыдущих шагах цели
+    plant_t plant = PLANT_INIT(4.0f);
+    adaptive_pid_t pid;
+    init_plant_pid(&pid, 4.6f);
+    plant_run(&plant, &pid, 60);
+    adaptive_pid_set_setpoint(&pid, 5.2f);
+    plant_run(&plant, &pid, 60);
+    TEST_ASSERT_TRUE(adaptive_pid_get_model(&pid)->ready);
+
+    float y_start = plant_value(&plant);
+    adaptive_pid_set_setpoint(&pid, y_start + 0.6f);
+    float tuned_over = plant_run(&plant, &pid, 60) - (y_start + 0.6f);
+
+    TEST_ASSERT_TRUE(fixed_over > pid.zones.dead_zone);
+    TEST_ASSERT_TRUE(tuned_over < fixed_over);
+    TEST_ASSERT_TRUE(tuned_over <= pid.zones.dead_zone);
+    // И цель достигнута (мёртвая зона)
+    TEST_ASSERT_TRUE(plant_value(&plant) >= y_start + 0.6f - pid.zones.dead_zone);
+}
+
+// Задержка 90 с при дозах раз в 20 с: без предиктора 4-5 доз уходят до
+// первой реакции датчика
+static float run_dead_time_step(bool smith, int *doses, float *final) {
+    plant_t plant = { .y0 = 5.0f, .tau_s = 20.0f, .dead_s = 90.0f };
+    adaptive_pid_t pid;
+    init_plant_pid(&pid, 6.0f);
+    adaptive_pid_set_auto_tune(&pid, false, 0.0f);
+    adaptive_pid_set_identification(&pid, false, 1.5f);
+    adaptive_pid_set_zone_coeffs(&pid, ZONE_FAR, 4.0f, 0.0f, 0.0f);
+    adaptive_pid_set_zone_coeffs(&pid, ZONE_CLOSE, 4.0f, 0.0f, 0.0f);
+    adaptive_pid_set_safety(&pid, 5.0f, 20000);
+    if (smith) {
+        adaptive_pid_set_smith_predictor(&pid, true, PLANT_K, 20.0f, 90.0f);
+    }
+
+    float over = plant_run(&plant, &pid, 60) - 6.0f;
+    *doses = plant.doses;
+    *final = plant_value(&plant);
+    return over;
+}
+
+static void test_smith_predictor_dead_time(void) {
+    int plain_doses, smith_doses;
+    float plain_final, smith_final;
+    float plain_over = run_dead_time_step(false, &plain_doses, &plain_final);
+    float smith_over = run_dead_time_step(true, &smith_doses, &smith_final);
+
+    TEST_ASSERT_TRUE(plain_over > 0.5f);
+    TEST_ASSERT_TRUE(smith_over <= 0.1f);
+    TEST_ASSERT_TRUE(smith_doses <= plain_doses);
+    // Цель достигнута (мёртвая зона 0.1)
+    TEST_ASSERT_TRUE(smith_final >= 5.9f);
+}
+
+static void test_smith_without_model(void) {
+    // Усиление 0 и модели нет - поправки нет, выход как без предиктора
+    adaptive_pid_t pid;
+    init_pid(&pid);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, adaptive_pid_set_smith_predictor(&pid, true, 0.0f, 0.0f, 0.0f));
+
+    float out = 0.0f;
+    adaptive_pid_compute(&pid, 5.8f, 1.0f, &out);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.22, out);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, pid.smith.correction);
+
+    // Заданная модель, смешивание мгновенное: доза в поправке, пока идёт задержка
+    init_pid(&pid);
+    adaptive_pid_set_safety(&pid, 5.0f, 0);
+    adaptive_pid_set_smith_predictor(&pid, true, 0.5f, 0.0f, 5.0f);
+    adaptive_pid_compute(&pid, 5.8f, 1.0f, &out);
+    host_time_advance_us(1000000);
+    adaptive_pid_compute(&pid, 5.8f, 1.0f, &out);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.11, pid.smith.correction);
+
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, adaptive_pid_set_smith_predictor(&pid, true, -1.0f, 0.0f, 0.0f));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, adaptive_pid_set_smith_predictor(&pid, true, 0.1f, 0.0f, 601.0f));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, adaptive_pid_set_smith_predictor(NULL, true, 0.1f, 0.0f, 0.0f));
+}
+
+static void test_identification_api(void) {
+    adaptive_pid_t pid;
+    init_pid(&pid);
+
+    TEST_ASSERT_FALSE(adaptive_pid_get_model(&pid)->ready);
+    TEST_ASSERT_NULL(adaptive_pid_get_model(NULL));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, adaptive_pid_set_identification(&pid, true, 0.1f));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, adaptive_pid_set_identification(NULL, true, 1.5f));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, adaptive_pid_set_identification(&pid, true, 2.0f));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, adaptive_pid_reset_model(&pid));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, adaptive_pid_reset_model(NULL));
+}
+
+int main(void) {
+    RUN_TEST(test_dead_zone_no_output);
+    RUN_TEST(test_close_zone_output);
+    RUN_TEST(test_far_zone_clamped_to_max_dose);
+    RUN_TEST(test_safety_interval);
+    RUN_TEST(test_emergency_stop);
+    RUN_TEST(test_invalid_args);
+    RUN_TEST(test_set_target_changes_setpoint);
+    RUN_TEST(test_identifies_plant);
+    RUN_TEST(test_model_tuning_reduces_overshoot);
+    RUN_TEST(test_identification_api);
+    RUN_TEST(test_smith_predictor_dead_time);
+    RUN_TEST(test_smith_without_model);
+    return TEST_REPORT();
+}
@@ -0,0 +1,198 @@
+/**
+ * @file test_cjson_arena.c
+ * @brief Host тесты common/cjson_arena: выделение, сброс, переполнение, статистика
+ */
+
+#include "host_test.h"
+#include "host_stubs.h"
+#include "cjson_arena.h"
+
+#include <stdlib.h>
+
+static cjson_arena_t *s_arena;          // 4096 байт (CJSON_ARENA_DEFAULT_SIZE)
+static cjson_arena_t *s_small;          // 256 байт
+
+static cjson_arena_stats_t *find_stats(cjson_arena_stats_t *stats, int n, const char *label) {
+    for (int i = 0; i < n; i++) {
+        if (strcmp(stats[i].label, label) == 0) {
+            return &stats[i];
+        }
+    }
+    return NULL;
+}
+
+static void test_allocations_reset_per_message(void) {
+    cjson_arena_begin(s_arena);
+    cJSON *first = cJSON_Parse("{\"type\":\"telemetry\",\"data\":{\"ph\":6.5}}");
+    TEST_ASSERT_NOT_NULL(first);
+    cJSON_Delete(first);                // Для арены - пустой
+    cjson_arena_end(s_arena, "telemetry");
+
+    // После сброса следующее сообщение получает ту же память
+    cjson_arena_begin(s_arena);
+    cJSON *second = cJSON_Parse("{\"type\":\"telemetry\",\"data\":{\"ph\":6.6}}");
+    TEST_ASSERT_TRUE(second == first);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 6.6,
+        cJSON_GetObjectItem(cJSON_GetObjectItem(second, "data"), "ph")->valuedouble);
+    char *str = cJSON_PrintUnformatted(second);
+    TEST_ASSERT_NOT_NULL(str);
+    cJSON_free(str);
+    cJSON_Delete(second);
+    cjson_arena_end(s_arena, "telemetry");
+}
+
+static void test_outside_scope_uses_heap(void) {
+    cjson_arena_begin(s_arena);
+    cJSON *scoped = cJSON_CreateObject();
+    cjson_arena_end(s_arena, "other");
+
+    cJSON *heap = cJSON_CreateObject();
+    TEST_ASSERT_NOT_NULL(heap);
+    TEST_ASSERT_TRUE(heap != scoped);
+    cJSON_AddStringToObject(heap, "node_id", "ph_ec_001");
+    cJSON_Delete(heap);                 // Уходит в free(), не в арену
+}
+
+static void test_overflow_falls_back_to_heap(void) {
+    cjson_arena_begin(s_small);
+    cJSON *arr = cJSON_CreateArray();
+    for (int i = 0; i < 64; i++) {
+        cJSON_AddItemToArray(arr, cJSON_CreateNumber(i));
+    }
+    TEST_ASSERT_EQUAL_INT(64, cJSON_GetArraySize(arr));
+    TEST_ASSERT_EQUAL_INT(63, cJSON_GetArrayItem(arr, 63)->valueint);
+    cJSON_Delete(arr);                  // Элементы из heap освобождаются
+    cjson_arena_end(s_small, "big");
+
+    cjson_arena_begin(s_small);
+    cJSON_Delete(cJSON_CreateObject());
+    cjson_arena_end(s_small, "tiny");
+
+    cjson_arena_stats_t stats[CJSON_ARENA_MAX_LABELS];
+    int n = cjson_arena_get_stats(s_small, stats);
+    cjson_arena_stats_t *big = find_stats(stats, n, "big");
+    cjson_arena_stats_t *tiny = find_stats(stats, n, "tiny");
+    TEST_ASSERT_NOT_NULL(big);
+    TEST_ASSERT_NOT_NULL(tiny);
+    TEST_ASSERT_EQUAL_INT(1, big->overflows);
+    TEST_ASSERT_TRUE(big->peak_bytes > 256);        // Потребность, а не занятое в арене
+    TEST_ASSERT_EQUAL_INT(0, tiny->overflows);
+    TEST_ASSERT_TRUE(tiny->peak_bytes > 0 && tiny->peak_bytes <= 256);
+}
+
+static void test_peak_per_label(void) {
+    for (int i = 0; i < 3; i++) {
+        cjson_arena_begin(s_arena);
+        cJSON_Delete(cJSON_Parse("{\"type\":\"heartbeat\",\"uptime\":1}"));
+        cjson_arena_end(s_arena, "heartbeat");
+    }
+    cjson_arena_begin(s_arena);
+    cJSON_Delete(cJSON_Parse("{\"type\":\"heartbeat\",\"uptime\":1,\"heap_free\":180000,\"rssi\":-60}"));
+    cjson_arena_end(s_arena, "heartbeat");
+
+    cjson_arena_stats_t stats[CJSON_ARENA_MAX_LABELS];
+    int n = cjson_arena_get_stats(s_arena, stats);
+    cjson_arena_stats_t *hb = find_stats(stats, n, "heartbeat");
+    cjson_arena_stats_t *tel = find_stats(stats, n, "telemetry");
+    TEST_ASSERT_NOT_NULL(hb);
+    TEST_ASSERT_NOT_NULL(tel);
+    TEST_ASSERT_EQUAL_INT(4, hb->messages);
+    TEST_ASSERT_EQUAL_INT(2, tel->messages);
+    TEST_ASSERT_TRUE(hb->peak_bytes > 0);
+    TEST_ASSERT_EQUAL_INT(0, hb->overflows);
+}
+
+static void test_suspend_allocates_from_heap(void) {
+    cjson_arena_begin(s_arena);
+    cJSON *msg = cJSON_Parse("{\"data\":{\"ph\":6.1}}");
+
+    void *token = cjson_arena_suspend();
+    cJSON *copy = cJSON_Duplicate(cJSON_GetObjectItem(msg, "data"), true);
+    cjson_arena_resume(token);
+
+    cJSON_Delete(msg);
+    cjson_arena_end(s_arena, "suspend");
+
+    // Переиспользование арены не портит копию
+    cjson_arena_begin(s_arena);
+    cJSON_Delete(cJSON_Parse("{\"data\":{\"ph\":9.9,\"ec\":9.9}}"));
+    cjson_arena_end(s_arena, "suspend");
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 6.1, cJSON_GetObjectItem(copy, "ph")->valuedouble);
+    cJSON_Delete(copy);
+}
+
+static void test_nested_scope_resets_once(void) {
+    cjson_arena_begin(s_arena);
+    cJSON *outer = cJSON_CreateString("outer");
+
+    cjson_arena_begin(s_arena);
+    cJSON *inner = cJSON_CreateString("inner");
+    cjson_arena_end(s_arena, "inner");             // Вложенная - без сброса
+
+    TEST_ASSERT_EQUAL_STRING("outer", outer->valuestring);
+    TEST_ASSERT_EQUAL_STRING("inner", inner->valuestring);
+    cjson_arena_end(s_arena, "nested");
+
+    cjson_arena_stats_t stats[CJSON_ARENA_MAX_LABELS];
+    int n = cjson_arena_get_stats(s_arena, stats);
+    TEST_ASSERT_NULL(find_stats(stats, n, "inner"));
+    TEST_ASSERT_NOT_NULL(find_stats(stats, n, "nested"));
+}
+
+static void test_null_arena_is_noop(void) {
+    cjson_arena_begin(NULL);
+    cJSON *obj = cJSON_CreateObject();
+    cjson_arena_end(NULL, "none");
+    TEST_ASSERT_NOT_NULL(obj);
+    cJSON_Delete(obj);
+}
+
+static void test_stats_json(void) {
+    cJSON *compact = cJSON_CreateObject();
+    cjson_arena_add_to_json(compact, false);
+    cJSON *rows = cJSON_GetObjectItem(compact, "arena");
+    TEST_ASSERT_TRUE(cJSON_IsArray(rows));
+    TEST_ASSERT_EQUAL_INT(2, cJSON_GetArraySize(rows));
+    cJSON *small = cJSON_GetArrayItem(rows, 1);
+    TEST_ASSERT_EQUAL_STRING("small", cJSON_GetArrayItem(small, 0)->valuestring);
+    TEST_ASSERT_EQUAL_INT(256, cJSON_GetArrayItem(small, 1)->valueint);
+    TEST_ASSERT_EQUAL_INT(1, cJSON_GetArrayItem(small, 3)->valueint);
+    cJSON_Delete(compact);
+
+    cJSON *detailed = cJSON_CreateObject();
+    cjson_arena_add_to_json(detailed, true);
+    cJSON *main_arena = cJSON_GetObjectItem(cJSON_GetObjectItem(detailed, "arena"), "main");
+    TEST_ASSERT_NOT_NULL(main_arena);
+    TEST_ASSERT_EQUAL_INT(CJSON_ARENA_DEFAULT_SIZE, cJSON_GetObjectItem(main_arena, "size")->valueint);
+    cJSON *hb = cJSON_GetObjectItem(cJSON_GetObjectItem(main_arena, "types"), "heartbeat");
+    TEST_ASSERT_TRUE(cJSON_IsArray(hb));
+    TEST_ASSERT_EQUAL_INT(4, cJSON_GetArrayItem(hb, 0)->valueint);
+    cJSON_Delete(detailed);
+}
+
+int main(void) {
+    cJSON *before = cJSON_CreateObject();           // Создан до установки хуков
+
+    if (cjson_arena_install() != ESP_OK) {
+        fprintf(stderr, "install failed\n");
+        return 1;
+    }
+    s_arena = cjson_arena_create("main", CJSON_ARENA_DEFAULT_SIZE);
+    s_small = cjson_arena_create("small", 256);
+    if (!s_arena || !s_small) {
+        fprintf(stderr, "arena create failed\n");
+        return 1;
+    }
+    cJSON_Delete(before);
+
+    RUN_TEST(test_allocations_reset_per_message);
+    RUN_TEST(test_outside_scope_uses_heap);
+    RUN_TEST(test_overflow_falls_back_to_heap);
+    RUN_TEST(test_peak_per_label);
+    RUN_TEST(test_suspend_allocates_from_heap);
+    RUN_TEST(test_nested_scope_resets_once);
+    RUN_TEST(test_null_arena_is_noop);
+    RUN_TEST(test_stats_json);
+    return TEST_REPORT();
+}
@@ -0,0 +1,308 @@
+/**
+ * @file test_dosing_engine.c
+ * @brief Host тесты common/dosing_engine (узел pH+EC): направления, доли насосов, safety,
+ *        релейная автонастройка
+ */
+
+#include "host_test.h"
+#include "host_stubs.h"
+#include "dosing_engine.h"
+#include "esp_timer.h"
+#include <math.h>
+
+// Бак для автонастройки: доза pH сдвигает значение на TANK_K·доза
+// с задержкой и смешиванием; PH_DOWN - в обратную сторону
+#define TANK_K          0.1f
+#define TANK_TAU_S      40.0f
+#define TANK_DEAD_S     20.0f
+#define TANK_MAX_DOSES  256
+
+static struct {
+    bool enabled;
+    float y0;
+    int doses;
+    int64_t dose_us[TANK_MAX_DOSES];
+    float delta[TANK_MAX_DOSES];
+} s_tank;
+
+// Подмена pump_controller: запоминаем дозы по насосам
+static float s_dosed_ml[PUMP_MAX];
+static int s_runs;
+
+esp_err_t pump_controller_run_dose(pump_id_t pump, float dose_ml) {
+    s_dosed_ml[pump] += dose_ml;
+    s_runs++;
+    if (s_tank.enabled && s_tank.doses < TANK_MAX_DOSES) {
+        s_tank.dose_us[s_tank.doses] = esp_timer_get_time();
+        s_tank.delta[s_tank.doses] = (pump == PUMP_PH_DOWN ? -TANK_K : TANK_K) * dose_ml;
+        s_tank.doses++;
+    }
+    return ESP_OK;
+}
+
+const char* pump_controller_name(pump_id_t pump) {
+    return "fake";
+}
+
+static float tank_value(void) {
+    float y = s_tank.y0;
+    int64_t now = esp_timer_get_time();
+    for (int i = 0; i < s_tank.doses; i++) {
+        float age = (now - s_tank.dose_us[i]) / 1000000.0f - TANK_DEAD_S;
+        if (age > 0.0f) {
+            y += s_tank.delta[i] * (1.0f - expf(-age / TANK_TAU_S));
+        }
+    }
+    return y;
+}
+
+static void reset_engine(void) {
+    // Время не с нуля: last_dose_time_us == 0 означает "доз не было"
+    host_time_advance_us(120000000);
+    memset(s_dosed_ml, 0, sizeof(s_dosed_ml));
+    memset(&s_tank, 0, sizeof(s_tank));
+    s_runs = 0;
+    dosing_engine_autotune_stop(DOSING_LOOP_PH);
+    dosing_engine_autotune_stop(DOSING_LOOP_EC);
+    dosing_engine_autotune_poll(DOSING_LOOP_PH, NULL);
+    dosing_engine_autotune_poll(DOSING_LOOP_EC, NULL);
+
+    pump_pid_t pid[PUMP_MAX] = { 0 };
+    for (int i = 0; i < PUMP_MAX; i++) {
+        pid[i].kp = 1.0f;
+    }
+    const float targets[DOSING_LOOP_COUNT] = { [DOSING_LOOP_PH] = 6.0f, [DOSING_LOOP_EC] = 2.0f };
+    TEST_ASSERT_EQUAL_INT(ESP_OK, dosing_engine_init(targets, pid));
+
+    // Без автоподстройки - дозы считаются точно
+    adaptive_pid_set_auto_tune(dosing_engine_get_pid(DOSING_LOOP_PH, DOSING_RAISE), false, 0.0f);
+    adaptive_pid_set_auto_tune(dosing_engine_get_pid(DOSING_LOOP_PH, DOSING_LOWER), false, 0.0f);
+    adaptive_pid_set_auto_tune(dosing_engine_get_pid(DOSING_LOOP_EC, DOSING_RAISE), false, 0.0f);
+}
+
+static void test_ph_raise(void) {
+    reset_engine();
+
+    dosing_result_t r;
+    TEST_ASSERT_EQUAL_INT(ESP_OK, dosing_engine_control(DOSING_LOOP_PH, 5.8f, 1.0f, &r));
+    TEST_ASSERT_EQUAL_INT(DOSING_RAISE, r.dir);
+    TEST_ASSERT_EQUAL_INT(ZONE_CLOSE, r.zone);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.2, r.dose_ml);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.2, s_dosed_ml[PUMP_PH_UP]);
+    TEST_ASSERT_EQUAL_INT(1, s_runs);
+}
+
+static void test_ph_lower_mirrored(void) {
+    reset_engine();
+
+    // Ошибка понижения считается как (значение - цель), доза положительная
+    dosing_result_t r;
+    dosing_engine_control(DOSING_LOOP_PH, 6.2f, 1.0f, &r);
+    TEST_ASSERT_EQUAL_INT(DOSING_LOWER, r.dir);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.2, r.dose_ml);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.2, s_dosed_ml[PUMP_PH_DOWN]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, s_dosed_ml[PUMP_PH_UP]);
+}
+
+static void test_dead_zone(void) {
+    reset_engine();
+
+    dosing_result_t r;
+    dosing_engine_control(DOSING_LOOP_PH, 6.05f, 1.0f, &r);
+    TEST_ASSERT_EQUAL_INT(DOSING_NONE, r.dir);
+    TEST_ASSERT_EQUAL_INT(ZONE_DEAD, r.zone);
+    TEST_ASSERT_EQUAL_INT(0, s_runs);
+}
+
+static void test_ec_split_and_gap(void) {
+    reset_engine();
+
+    int64_t t0 = esp_timer_get_time();
+    dosing_result_t r;
+    dosing_engine_control(DOSING_LOOP_EC, 1.7f, 1.0f, &r);
+    int64_t t1 = esp_timer_get_time();
+
+    TEST_ASSERT_EQUAL_INT(DOSING_RAISE, r.dir);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.3, r.dose_ml);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.15, s_dosed_ml[PUMP_EC_A]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.12, s_dosed_ml[PUMP_EC_B]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.03, s_dosed_ml[PUMP_EC_C]);
+    TEST_ASSERT_EQUAL_INT(3, s_runs);
+    // Две паузы по 100 мс между насосами
+    TEST_ASSERT_TRUE(t1 - t0 >= 200000);
+}
+
+static void test_ec_no_lowering(void) {
+    reset_engine();
+
+    dosing_result_t r;
+    dosing_engine_control(DOSING_LOOP_EC, 3.0f, 1.0f, &r);
+    TEST_ASSERT_EQUAL_INT(DOSING_NONE, r.dir);
+    TEST_ASSERT_EQUAL_INT(0, s_runs);
+    TEST_ASSERT_NULL(dosing_engine_get_pid(DOSING_LOOP_EC, DOSING_LOWER));
+}
+
+static void test_safety_interval(void) {
+    reset_engine();
+
+    dosing_engine_control(DOSING_LOOP_PH, 5.8f, 1.0f, NULL);
+    TEST_ASSERT_EQUAL_INT(1, s_runs);
+
+    // Сразу после дозы - пропуск
+    dosing_result_t r;
+    dosing_engine_control(DOSING_LOOP_PH, 5.8f, 1.0f, &r);
+    TEST_ASSERT_EQUAL_INT(DOSING_NONE, r.dir);
+    TEST_ASSERT_EQUAL_INT(1, s_runs);
+
+    host_time_advance_us(60000000);
+    dosing_engine_control(DOSING_LOOP_PH, 5.8f, 1.0f, &r);
+    TEST_ASSERT_EQUAL_INT(DOSING_RAISE, r.dir);
+    TEST_ASSERT_EQUAL_INT(2, s_runs);
+}
+
+static void test_set_target(void) {
+    reset_engine();
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, dosing_engine_set_target(DOSING_LOOP_PH, 6.5f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 6.5, dosing_engine_get_target(DOSING_LOOP_PH));
+
+    // 6.3 теперь ниже цели - повышение, а не понижение
+    dosing_result_t r;
+    dosing_engine_control(DOSING_LOOP_PH, 6.3f, 1.0f, &r);
+    TEST_ASSERT_EQUAL_INT(DOSING_RAISE, r.dir);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.2, s_dosed_ml[PUMP_PH_UP]);
+}
+
+static void test_invalid_args(void) {
+    reset_engine();
+
+    dosing_result_t r;
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, dosing_engine_control(DOSING_LOOP_COUNT, 1.0f, 1.0f, &r));
+    TEST_ASSERT_EQUAL_INT(DOSING_NONE, r.dir);
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, dosing_engine_set_target(DOSING_LOOP_COUNT, 1.0f));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, dosing_engine_init(NULL, NULL));
+    TEST_ASSERT_NULL(dosing_engine_get_pid(DOSING_LOOP_COUNT, DOSING_RAISE));
+    TEST_ASSERT_EQUAL_STRING("ph", dosing_engine_loop_name(DOSING_LOOP_PH));
+    TEST_ASSERT_EQUAL_STRING("ec", dosing_engine_loop_name(DOSING_LOOP_EC));
+    TEST_ASSERT_EQUAL_STRING("unknown", dosing_engine_loop_name(DOSING_LOOP_COUNT));
+}
+
+static void test_autotune_relay(void) {
+    reset_engine();
+    s_tank.enabled = true;
+    s_tank.y0 = 5.9f;
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, dosing_engine_autotune_start(DOSING_LOOP_PH, 0.0f, 0, NULL));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, dosing_engine_autotune_start(DOSING_LOOP_PH, 0.0f, 0, NULL));
+
+    // Ход эксперимента - по колебаниям
+    int progress = 0;
+    dosing_autotune_t at;
+    for (int i = 0; i < 2000; i++) {
+        dosing_engine_control(DOSING_LOOP_PH, tank_value(), 10.0f, NULL);
+        if (dosing_engine_autotune_poll(DOSING_LOOP_PH, &at) && at.state == DOSING_AUTOTUNE_RUNNING) {
+            progress++;
+        }
+        if (at.state != DOSING_AUTOTUNE_RUNNING) {
+            break;
+        }
+        host_time_advance_us(10000000);
+    }
+
+    TEST_ASSERT_EQUAL_INT(DOSING_AUTOTUNE_DONE, at.state);
+    TEST_ASSERT_EQUAL_INT(3, progress);
+    TEST_ASSERT_EQUAL_INT(4, at.cycles);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.5, at.dose_ml);
+    TEST_ASSERT_TRUE(at.amplitude > 0.05f && at.amplitude < 0.5f);
+    TEST_ASSERT_TRUE(at.pu_s >= 120.0f);
+    TEST_ASSERT_TRUE(at.ku > 0.0f);
+    TEST_ASSERT_TRUE(at.close.kp < at.far.kp);
+    TEST_ASSERT_TRUE(at.close.ki > 0.0f);
+
+    // Коэффициенты применены к обоим направлениям
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, at.close.kp, dosing_engine_get_pid(DOSING_LOOP_PH, DOSING_RAISE)->coeffs_close.kp);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, at.far.kp, dosing_engine_get_pid(DOSING_LOOP_PH, DOSING_LOWER)->coeffs_far.kp);
+
+    // Для NVS - pump_pid насосов контура pH, EC не тронут
+    pump_pid_t pid[PUMP_MAX] = { 0 };
+    TEST_ASSERT_EQUAL_INT(ESP_OK, dosing_engine_autotune_apply(DOSING_LOOP_PH, pid));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, at.close.kp, pid[PUMP_PH_UP].kp);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, at.close.ki, pid[PUMP_PH_DOWN].ki);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, pid[PUMP_EC_A].kp);
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, dosing_engine_autotune_apply(DOSING_LOOP_EC, pid));
+
+    // Результат сообщается один раз
+    TEST_ASSERT_FALSE(dosing_engine_autotune_poll(DOSING_LOOP_PH, &at));
+}
+
+static void test_autotune_aborts_out_of_bounds(void) {
+    reset_engine();
+    s_tank.enabled = true;
+    s_tank.y0 = 6.0f;
+
+    dosing_engine_autotune_start(DOSING_LOOP_PH, 0.5f, 2, NULL);
+    dosing_engine_control(DOSING_LOOP_PH, 6.0f, 10.0f, NULL);
+    // Дальняя зона pH - 1.0
+    dosing_engine_control(DOSING_LOOP_PH, 7.2f, 10.0f, NULL);
+
+    dosing_autotune_t at;
+    TEST_ASSERT_TRUE(dosing_engine_autotune_poll(DOSING_LOOP_PH, &at));
+    TEST_ASSERT_EQUAL_INT(DOSING_AUTOTUNE_FAILED, at.state);
+    TEST_ASSERT_EQUAL_STRING("out of bounds", at.error);
+
+    // Дальше - снова PID
+    s_runs = 0;
+    host_time_advance_us(120000000);
+    dosing_result_t r;
+    dosing_engine_control(DOSING_LOOP_PH, 5.8f, 1.0f, &r);
+    TEST_ASSERT_EQUAL_INT(DOSING_RAISE, r.dir);
+}
+
+static void test_autotune_args_and_stop(void) {
+    reset_engine();
+
+    pump_calibration_t cal[PUMP_MAX] = { 0 };
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, dosing_engine_autotune_start(DOSING_LOOP_PH, 0.0f, 0, cal));
+    for (int i = 0; i < PUMP_MAX; i++) {
+        cal[i].is_calibrated = true;
+    }
+    // Доза не больше половины максимальной (5 мл), колебаний 2..8
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, dosing_engine_autotune_start(DOSING_LOOP_PH, 3.0f, 0, cal));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, dosing_engine_autotune_start(DOSING_LOOP_PH, 0.5f, 9, cal));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, dosing_engine_autotune_start(DOSING_LOOP_COUNT, 0.5f, 0, cal));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, dosing_engine_autotune_start(DOSING_LOOP_EC, 0.0f, 0, cal));
+
+    dosing_autotune_t at;
+    dosing_engine_autotune_poll(DOSING_LOOP_EC, &at);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 1.0, at.dose_ml);
+
+    // EC выше цели: одностороннее реле - пауза, не понижение
+    dosing_result_t r;
+    dosing_engine_control(DOSING_LOOP_EC, 2.3f, 10.0f, &r);
+    TEST_ASSERT_EQUAL_INT(DOSING_NONE, r.dir);
+    TEST_ASSERT_EQUAL_INT(0, s_runs);
+    dosing_engine_control(DOSING_LOOP_EC, 1.8f, 10.0f, &r);
+    TEST_ASSERT_EQUAL_INT(DOSING_RAISE, r.dir);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.5, s_dosed_ml[PUMP_EC_A]);
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, dosing_engine_autotune_stop(DOSING_LOOP_EC));
+    TEST_ASSERT_TRUE(dosing_engine_autotune_poll(DOSING_LOOP_EC, &at));
+    TEST_ASSERT_EQUAL_INT(DOSING_AUTOTUNE_FAILED, at.state);
+    TEST_ASSERT_EQUAL_STRING("stopped", at.error);
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, dosing_engine_autotune_stop(DOSING_LOOP_EC));
+}
+
+int main(void) {
+    RUN_TEST(test_ph_raise);
+    RUN_TEST(test_ph_lower_mirrored);
+    RUN_TEST(test_dead_zone);
+    RUN_TEST(test_ec_split_and_gap);
+    RUN_TEST(test_ec_no_lowering);
+    RUN_TEST(test_safety_interval);
+    RUN_TEST(test_set_target);
+    RUN_TEST(test_invalid_args);
+    RUN_TEST(test_autotune_relay);
+    RUN_TEST(test_autotune_aborts_out_of_bounds);
+    RUN_TEST(test_autotune_args_and_stop);
+    return TEST_REPORT();
+}
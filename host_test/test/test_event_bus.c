@@ -0,0 +1,168 @@
+/**
+ * @file test_event_bus.c
+ * @brief Host тесты common/event_bus: рассылка без копий, фильтр типов, задачи, состояние mesh
+ */
+
+#include "host_test.h"
+#include "host_stubs.h"
+#include "event_bus.h"
+#include "sdkconfig.h"
+
+typedef struct {
+    int calls;
+    const event_bus_event_t *last;
+    event_bus_id_t last_id;
+} recorder_t;
+
+static void record(const event_bus_event_t *event, void *ctx) {
+    recorder_t *r = (recorder_t *)ctx;
+    r->calls++;
+    r->last = event;
+    r->last_id = event->id;
+}
+
+static void test_fan_out_without_copy(void) {
+    recorder_t a = {0}, b = {0};
+    TEST_ASSERT_EQUAL_INT(ESP_OK, event_bus_subscribe(EVENT_BUS_BIT(EVENT_BUS_MESH_RX),
+                                                      EVENT_BUS_MSG_ALL, record, &a));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, event_bus_subscribe(EVENT_BUS_BIT(EVENT_BUS_MESH_RX),
+                                                      EVENT_BUS_MSG_ALL, record, &b));
+
+    static const uint8_t frame[] = "{\"type\":\"command\"}";
+    event_bus_event_t event = {
+        .id = EVENT_BUS_MESH_RX,
+        .rx = { .data = frame, .len = sizeof(frame) - 1 },
+    };
+    TEST_ASSERT_EQUAL_INT(2, event_bus_publish(&event));
+    TEST_ASSERT_EQUAL_INT(1, a.calls);
+    TEST_ASSERT_EQUAL_INT(1, b.calls);
+    // Оба подписчика видят одно и то же событие и тот же буфер
+    TEST_ASSERT_TRUE(a.last == &event && b.last == &event);
+    TEST_ASSERT_TRUE(a.last->rx.data == frame);
+
+    // Событие без подписчиков никуда не доставляется
+    TEST_ASSERT_EQUAL_INT(0, event_bus_publish_config_changed("test"));
+
+    event_bus_unsubscribe(record, &a);
+    event_bus_unsubscribe(record, &b);
+    TEST_ASSERT_EQUAL_INT(0, event_bus_publish(&event));
+}
+
+static void test_message_type_filter(void) {
+    recorder_t commands = {0}, all = {0};
+    TEST_ASSERT_EQUAL_INT(ESP_OK, event_bus_subscribe(EVENT_BUS_BIT(EVENT_BUS_MESSAGE),
+                                                      EVENT_BUS_MSG_BIT(MESH_MSG_COMMAND),
+                                                      record, &commands));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, event_bus_subscribe(EVENT_BUS_BIT(EVENT_BUS_MESSAGE),
+                                                      EVENT_BUS_MSG_ALL, record, &all));
+
+    mesh_message_t msg = { .type = MESH_MSG_CONFIG };
+    TEST_ASSERT_EQUAL_INT(1, event_bus_publish_message(&msg));
+    msg.type = MESH_MSG_COMMAND;
+    TEST_ASSERT_EQUAL_INT(2, event_bus_publish_message(&msg));
+    TEST_ASSERT_EQUAL_INT(1, commands.calls);
+    TEST_ASSERT_EQUAL_INT(2, all.calls);
+    TEST_ASSERT_TRUE(commands.last->message.msg == &msg);
+
+    // Пустое сообщение не публикуется
+    TEST_ASSERT_EQUAL_INT(0, event_bus_publish_message(NULL));
+
+    event_bus_unsubscribe(record, &commands);
+    event_bus_unsubscribe(record, &all);
+}
+
+static void test_task_notification_bits(void) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    TEST_ASSERT_EQUAL_INT(ESP_OK, event_bus_subscribe_task(
+        EVENT_BUS_BIT(EVENT_BUS_CONFIG_CHANGED) | EVENT_BUS_BIT(EVENT_BUS_EMERGENCY),
+        EVENT_BUS_MSG_ALL, self));
+
+    TEST_ASSERT_EQUAL_INT(0, event_bus_task_wait(0));
+
+    TEST_ASSERT_EQUAL_INT(1, event_bus_publish_config_changed("mesh"));
+    TEST_ASSERT_EQUAL_INT(1, event_bus_publish_emergency(true, "test"));
+    // Несколько событий до пробуждения - одно пробуждение со всеми битами
+    TEST_ASSERT_EQUAL_INT(EVENT_BUS_BIT(EVENT_BUS_CONFIG_CHANGED) | EVENT_BUS_BIT(EVENT_BUS_EMERGENCY),
+                          event_bus_task_wait(0));
+    TEST_ASSERT_EQUAL_INT(0, event_bus_task_wait(0));
+
+    event_bus_unsubscribe_task(self);
+    TEST_ASSERT_EQUAL_INT(0, event_bus_publish_config_changed("mesh"));
+    TEST_ASSERT_EQUAL_INT(0, event_bus_task_wait(0));
+}
+
+static void test_mesh_state(void) {
+    recorder_t r = {0};
+    TEST_ASSERT_EQUAL_INT(ESP_OK, event_bus_subscribe(
+        EVENT_BUS_BIT(EVENT_BUS_MESH_UP) | EVENT_BUS_BIT(EVENT_BUS_MESH_DOWN),
+        EVENT_BUS_MSG_ALL, record, &r));
+
+    TEST_ASSERT_FALSE(event_bus_mesh_is_up());
+    TEST_ASSERT_FALSE(event_bus_wait_mesh_up(pdMS_TO_TICKS(100)));
+
+    event_bus_event_t up = { .id = EVENT_BUS_MESH_UP, .mesh = { .layer = 2 } };
+    event_bus_publish(&up);
+    TEST_ASSERT_TRUE(event_bus_mesh_is_up());
+    TEST_ASSERT_TRUE(event_bus_wait_mesh_up(0));
+    TEST_ASSERT_EQUAL_INT(EVENT_BUS_MESH_UP, r.last_id);
+
+    // Состояние - уровень, а не событие: повторное ожидание тоже успешно
+    TEST_ASSERT_TRUE(event_bus_wait_mesh_up(portMAX_DELAY));
+
+    event_bus_event_t down = { .id = EVENT_BUS_MESH_DOWN };
+    event_bus_publish(&down);
+    TEST_ASSERT_FALSE(event_bus_mesh_is_up());
+    TEST_ASSERT_EQUAL_INT(2, r.calls);
+
+    event_bus_unsubscribe(record, &r);
+}
+
+static void test_slots_reused_and_exhausted(void) {
+    static recorder_t recs[CONFIG_EVENT_BUS_MAX_SUBSCRIBERS + 1];
+    for (int i = 0; i < CONFIG_EVENT_BUS_MAX_SUBSCRIBERS; i++) {
+        TEST_ASSERT_EQUAL_INT(ESP_OK, event_bus_subscribe(EVENT_BUS_BIT(EVENT_BUS_EMERGENCY),
+                                                          EVENT_BUS_MSG_ALL, record, &recs[i]));
+    }
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_NO_MEM,
+        event_bus_subscribe(EVENT_BUS_BIT(EVENT_BUS_EMERGENCY), EVENT_BUS_MSG_ALL,
+                            record, &recs[CONFIG_EVENT_BUS_MAX_SUBSCRIBERS]));
+
+    // Освобождённый слот занимает следующая подписка
+    event_bus_unsubscribe(record, &recs[3]);
+    TEST_ASSERT_EQUAL_INT(ESP_OK,
+        event_bus_subscribe(EVENT_BUS_BIT(EVENT_BUS_EMERGENCY), EVENT_BUS_MSG_ALL,
+                            record, &recs[CONFIG_EVENT_BUS_MAX_SUBSCRIBERS]));
+    TEST_ASSERT_EQUAL_INT(CONFIG_EVENT_BUS_MAX_SUBSCRIBERS, event_bus_publish_emergency(false, "test"));
+    TEST_ASSERT_EQUAL_INT(0, recs[3].calls);
+    TEST_ASSERT_EQUAL_INT(1, recs[CONFIG_EVENT_BUS_MAX_SUBSCRIBERS].calls);
+
+    for (int i = 0; i <= CONFIG_EVENT_BUS_MAX_SUBSCRIBERS; i++) {
+        event_bus_unsubscribe(record, &recs[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(0, event_bus_publish_emergency(false, "test"));
+}
+
+static void test_invalid_args(void) {
+    recorder_t r = {0};
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, event_bus_subscribe(0, EVENT_BUS_MSG_ALL, record, &r));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG,
+        event_bus_subscribe(EVENT_BUS_BIT(EVENT_BUS_EVENT_COUNT), EVENT_BUS_MSG_ALL, record, &r));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG,
+        event_bus_subscribe(EVENT_BUS_BIT(EVENT_BUS_MESH_UP), EVENT_BUS_MSG_ALL, NULL, &r));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG,
+        event_bus_subscribe_task(EVENT_BUS_BIT(EVENT_BUS_MESH_UP), EVENT_BUS_MSG_ALL, NULL));
+
+    event_bus_event_t bad = { .id = EVENT_BUS_EVENT_COUNT };
+    TEST_ASSERT_EQUAL_INT(0, event_bus_publish(&bad));
+    TEST_ASSERT_EQUAL_INT(0, event_bus_publish(NULL));
+}
+
+int main(void) {
+    RUN_TEST(test_fan_out_without_copy);
+    RUN_TEST(test_message_type_filter);
+    RUN_TEST(test_task_notification_bits);
+    RUN_TEST(test_mesh_state);
+    RUN_TEST(test_slots_reused_and_exhausted);
+    RUN_TEST(test_invalid_args);
+    return TEST_REPORT();
+}
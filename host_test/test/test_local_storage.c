@@ -0,0 +1,73 @@
+/**
+ * @file test_local_storage.c
+ * @brief Host тесты кольцевого буфера local_storage (node_ph / node_ec)
+ */
+
+#include "host_test.h"
+#include "local_storage.h"
+
+static void test_add_and_count(void) {
+    local_storage_init();
+    for (int i = 0; i < 10; i++) {
+        local_storage_add(6.0f + i * 0.01f, 1.5f, 22.0f);
+    }
+
+    int total, synced, unsynced;
+    local_storage_get_stats(&total, &synced, &unsynced);
+    TEST_ASSERT_EQUAL_INT(10, total);
+    TEST_ASSERT_EQUAL_INT(0, synced);
+    TEST_ASSERT_EQUAL_INT(10, local_storage_get_unsynced_count());
+}
+
+static void test_sync_and_clear(void) {
+    local_storage_init();
+    local_storage_add(6.1f, 1.4f, 21.0f);
+    local_storage_add(6.2f, 1.5f, 21.5f);
+
+    storage_entry_t entry;
+    TEST_ASSERT_TRUE(local_storage_get_next_unsynced(&entry));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 6.1, entry.ph);
+
+    local_storage_mark_synced(entry.timestamp);
+    TEST_ASSERT_EQUAL_INT(1, local_storage_get_unsynced_count());
+
+    TEST_ASSERT_EQUAL_INT(1, local_storage_clear_synced());
+    int total;
+    local_storage_get_stats(&total, NULL, NULL);
+    TEST_ASSERT_EQUAL_INT(1, total);
+
+    TEST_ASSERT_TRUE(local_storage_get_next_unsynced(&entry));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 6.2, entry.ph);
+}
+
+static void test_wrap_keeps_capacity(void) {
+    local_storage_init();
+    for (int i = 0; i < BUFFER_SIZE + 25; i++) {
+        local_storage_add((float)i, 0.0f, 0.0f);
+    }
+
+    int total;
+    local_storage_get_stats(&total, NULL, NULL);
+    TEST_ASSERT_EQUAL_INT(BUFFER_SIZE, total);
+
+    // Самые старые записи затёрты: в слоте 0 - запись BUFFER_SIZE
+    storage_entry_t entry;
+    TEST_ASSERT_TRUE(local_storage_get_next_unsynced(&entry));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, (double)BUFFER_SIZE, entry.ph);
+}
+
+static void test_empty(void) {
+    local_storage_init();
+    storage_entry_t entry;
+    TEST_ASSERT_FALSE(local_storage_get_next_unsynced(&entry));
+    TEST_ASSERT_FALSE(local_storage_get_next_unsynced(NULL));
+    TEST_ASSERT_EQUAL_INT(0, local_storage_clear_synced());
+}
+
+int main(void) {
+    RUN_TEST(test_add_and_count);
+    RUN_TEST(test_sync_and_clear);
+    RUN_TEST(test_wrap_keeps_capacity);
+    RUN_TEST(test_empty);
+    return TEST_REPORT();
+}
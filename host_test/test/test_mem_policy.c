@@ -0,0 +1,86 @@
+/**
+ * @file test_mem_policy.c
+ * @brief Host тесты common/mem_policy: HOT/COLD размещение, откат без PSRAM, учёт владельцев
+ */
+
+#include "host_test.h"
+#include "host_stubs.h"
+#include "mem_policy.h"
+#include "esp_memory_utils.h"
+
+#include <stdlib.h>
+
+static void test_no_psram_cold_is_internal(void) {
+    host_psram_set_size(0);
+    TEST_ASSERT_FALSE(mem_policy_psram_available());
+
+    void *cold = mem_policy_malloc(MEM_COLD, 1024);
+    TEST_ASSERT_NOT_NULL(cold);
+    TEST_ASSERT_FALSE(esp_ptr_external_ram(cold));
+    free(cold);
+}
+
+static void test_cold_goes_to_psram(void) {
+    host_psram_set_size(64 * 1024);
+    TEST_ASSERT_TRUE(mem_policy_psram_available());
+
+    void *cold = mem_policy_malloc(MEM_COLD, 4096);
+    void *hot = mem_policy_malloc(MEM_HOT, 4096);
+    TEST_ASSERT_NOT_NULL(cold);
+    TEST_ASSERT_NOT_NULL(hot);
+    TEST_ASSERT_TRUE(esp_ptr_external_ram(cold));
+    TEST_ASSERT_FALSE(esp_ptr_external_ram(hot));
+    free(cold);
+    free(hot);
+}
+
+static void test_psram_full_falls_back(void) {
+    host_psram_set_size(1024);
+
+    void *cold = mem_policy_malloc(MEM_COLD, 2048);
+    TEST_ASSERT_NOT_NULL(cold);
+    TEST_ASSERT_FALSE(esp_ptr_external_ram(cold));
+    free(cold);
+}
+
+static void test_calloc_zeroed(void) {
+    host_psram_set_size(64 * 1024);
+
+    unsigned char *buf = mem_policy_calloc("zeroed", MEM_COLD, 512);
+    TEST_ASSERT_NOT_NULL(buf);
+    for (int i = 0; i < 512; i++) {
+        if (buf[i] != 0) {
+            TEST_FAIL_MSG("byte %d not zero", i);
+        }
+    }
+    free(buf);
+}
+
+static void test_owner_accounting_and_report(void) {
+    host_psram_set_size(64 * 1024);
+    static char table[256];
+
+    void *a = mem_policy_calloc("history", MEM_COLD, 1000);
+    void *b = mem_policy_calloc("history", MEM_COLD, 1000);
+    void *c = mem_policy_calloc(NULL, MEM_HOT, 100);       // Без учёта
+    mem_policy_track_static("table", table, sizeof(table));
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_NOT_NULL(c);
+
+    // Отчёт - только в лог; проверяется, что не падает на смешанных владельцах
+    mem_policy_report();
+
+    free(a);
+    free(b);
+    free(c);
+}
+
+int main(void) {
+    RUN_TEST(test_no_psram_cold_is_internal);
+    RUN_TEST(test_cold_goes_to_psram);
+    RUN_TEST(test_psram_full_falls_back);
+    RUN_TEST(test_calloc_zeroed);
+    RUN_TEST(test_owner_accounting_and_report);
+    return TEST_REPORT();
+}
@@ -0,0 +1,195 @@
+/**
+ * @file test_mesh_protocol.c
+ * @brief Host тесты common/mesh_protocol: создание и разбор сообщений
+ */
+
+#include "host_test.h"
+#include "mesh_protocol.h"
+
+static void test_telemetry_round_trip(void) {
+    cJSON *data = cJSON_CreateObject();
+    cJSON_AddNumberToObject(data, "ph", 6.5);
+    cJSON_AddNumberToObject(data, "ec", 1.8);
+    cJSON_AddNumberToObject(data, "rssi_to_parent", -61);
+
+    char json[512];
+    TEST_ASSERT_TRUE(mesh_protocol_create_telemetry("ph_001", "ph", data, json, sizeof(json)));
+    cJSON_Delete(data);
+
+    mesh_message_t msg;
+    TEST_ASSERT_TRUE(mesh_protocol_parse(json, &msg));
+    TEST_ASSERT_EQUAL_INT(MESH_MSG_TELEMETRY, msg.type);
+    TEST_ASSERT_EQUAL_STRING("ph_001", msg.node_id);
+    TEST_ASSERT_EQUAL_STRING("ph", msg.node_type);
+    TEST_ASSERT_TRUE(msg.has_seq);
+    TEST_ASSERT_EQUAL_INT(-61, msg.rssi);
+    TEST_ASSERT_NOT_NULL(msg.data);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 6.5, cJSON_GetObjectItem(msg.data, "ph")->valuedouble);
+    mesh_protocol_free_message(&msg);
+    TEST_ASSERT_NULL(msg.data);
+}
+
+static void test_seq_increments(void) {
+    char json[256];
+    mesh_message_t a, b;
+
+    TEST_ASSERT_TRUE(mesh_protocol_create_heartbeat("n1", "ec", 10, 1000, json, sizeof(json)));
+    TEST_ASSERT_TRUE(mesh_protocol_parse(json, &a));
+    TEST_ASSERT_TRUE(mesh_protocol_create_heartbeat("n1", "ec", 11, 1000, json, sizeof(json)));
+    TEST_ASSERT_TRUE(mesh_protocol_parse(json, &b));
+
+    TEST_ASSERT_EQUAL_INT(MESH_MSG_HEARTBEAT, a.type);
+    TEST_ASSERT_EQUAL_INT(a.seq + 1, b.seq);
+    mesh_protocol_free_message(&a);
+    mesh_protocol_free_message(&b);
+}
+
+static void test_heartbeat_root_rssi(void) {
+    const char *json = "{\"type\":\"heartbeat\",\"node_id\":\"c1\",\"rssi_to_parent\":-72,\"uptime\":5}";
+    mesh_message_t msg;
+
+    TEST_ASSERT_TRUE(mesh_protocol_parse(json, &msg));
+    TEST_ASSERT_EQUAL_INT(-72, msg.rssi);
+    TEST_ASSERT_FALSE(msg.has_seq);     // Старые прошивки без seq
+    TEST_ASSERT_NULL(msg.data);
+    mesh_protocol_free_message(&msg);
+}
+
+static void test_command_data_in_root(void) {
+    cJSON *params = cJSON_CreateObject();
+    cJSON_AddNumberToObject(params, "pump", 1);
+    cJSON_AddNumberToObject(params, "duration_ms", 2500);
+
+    char json[256];
+    TEST_ASSERT_TRUE(mesh_protocol_create_command("ph_001", "run_pump", params, json, sizeof(json)));
+    cJSON_Delete(params);
+
+    // Без "data" команда получает в data весь корень
+    mesh_message_t msg;
+    TEST_ASSERT_TRUE(mesh_protocol_parse(json, &msg));
+    TEST_ASSERT_EQUAL_INT(MESH_MSG_COMMAND, msg.type);
+    TEST_ASSERT_NOT_NULL(msg.data);
+    TEST_ASSERT_EQUAL_STRING("run_pump", cJSON_GetObjectItem(msg.data, "command")->valuestring);
+    cJSON *p = cJSON_GetObjectItem(msg.data, "params");
+    TEST_ASSERT_EQUAL_INT(2500, cJSON_GetObjectItem(p, "duration_ms")->valueint);
+    mesh_protocol_free_message(&msg);
+}
+
+static void test_rate_hint(void) {
+    char json[128];
+    TEST_ASSERT_TRUE(mesh_protocol_create_rate_hint(MESH_RATE_REDUCE, 30, json, sizeof(json)));
+
+    mesh_message_t msg;
+    TEST_ASSERT_TRUE(mesh_protocol_parse(json, &msg));
+    TEST_ASSERT_EQUAL_INT(MESH_MSG_RATE_HINT, msg.type);
+
+    mesh_rate_level_t level;
+    TEST_ASSERT_TRUE(mesh_protocol_rate_level_from_str(cJSON_GetObjectItem(msg.data, "level")->valuestring, &level));
+    TEST_ASSERT_EQUAL_INT(MESH_RATE_REDUCE, level);
+    TEST_ASSERT_EQUAL_INT(30, cJSON_GetObjectItem(msg.data, "ttl")->valueint);
+    mesh_protocol_free_message(&msg);
+
+    TEST_ASSERT_FALSE(mesh_protocol_rate_level_from_str("fast", &level));
+}
+
+static void test_time_sync(void) {
+    char json[MESH_TIME_SYNC_MAX_LEN];
+    const uint64_t t = 1734000000123456ULL;
+    TEST_ASSERT_TRUE(mesh_protocol_create_time_sync(t, true, json, sizeof(json)));
+
+    uint64_t parsed = 0;
+    bool sntp = false;
+    TEST_ASSERT_TRUE(mesh_protocol_parse_time_sync((const uint8_t *)json, strlen(json), &parsed, &sntp));
+    TEST_ASSERT_TRUE(parsed == t);
+    TEST_ASSERT_TRUE(sntp);
+
+    // Полный разбор тоже узнаёт тип
+    mesh_message_t msg;
+    TEST_ASSERT_TRUE(mesh_protocol_parse(json, &msg));
+    TEST_ASSERT_EQUAL_INT(MESH_MSG_TIME_SYNC, msg.type);
+    mesh_protocol_free_message(&msg);
+
+    TEST_ASSERT_TRUE(mesh_protocol_create_time_sync(42, false, json, sizeof(json)));
+    TEST_ASSERT_TRUE(mesh_protocol_parse_time_sync((const uint8_t *)json, strlen(json), &parsed, &sntp));
+    TEST_ASSERT_TRUE(parsed == 42 && !sntp);
+
+    const char *other = "{\"type\":\"rate_hint\",\"level\":\"hold\",\"ttl\":60}";
+    TEST_ASSERT_FALSE(mesh_protocol_parse_time_sync((const uint8_t *)other, strlen(other), &parsed, NULL));
+    TEST_ASSERT_FALSE(mesh_protocol_create_time_sync(t, true, json, 16));
+}
+
+static void test_timestamp_us(void) {
+    // Поле ts_us в исходящих сообщениях
+    char json[256];
+    TEST_ASSERT_TRUE(mesh_protocol_create_heartbeat("ph_001", "ph", 10, 20000, json, sizeof(json)));
+    mesh_message_t msg;
+    TEST_ASSERT_TRUE(mesh_protocol_parse(json, &msg));
+    TEST_ASSERT_TRUE(msg.timestamp_us > 0);
+    mesh_protocol_free_message(&msg);
+
+    // Точность микросекунд для значений эпохи (double без потерь до 2^53)
+    mesh_protocol_set_time_offset_us(1734000000000000LL);
+    uint64_t before = mesh_protocol_get_timestamp_us();
+    TEST_ASSERT_TRUE(mesh_protocol_create_heartbeat("ph_001", "ph", 10, 20000, json, sizeof(json)));
+    TEST_ASSERT_TRUE(mesh_protocol_parse(json, &msg));
+    TEST_ASSERT_TRUE(msg.timestamp_us >= before && msg.timestamp_us - before < 1000000);
+    mesh_protocol_free_message(&msg);
+
+    // Коррекция назад меньше секунды - время не убывает
+    uint64_t t1 = mesh_protocol_get_timestamp_us();
+    mesh_protocol_set_time_offset_us(1734000000000000LL - 500000);
+    TEST_ASSERT_TRUE(mesh_protocol_get_timestamp_us() >= t1);
+
+    // Без ts_us (старые прошивки) - 0
+    TEST_ASSERT_TRUE(mesh_protocol_parse("{\"type\":\"heartbeat\",\"node_id\":\"x\"}", &msg));
+    TEST_ASSERT_TRUE(msg.timestamp_us == 0);
+    mesh_protocol_free_message(&msg);
+
+    mesh_protocol_set_time_offset_us(0);
+}
+
+static void test_buffer_too_small(void) {
+    char json[16];
+    TEST_ASSERT_FALSE(mesh_protocol_create_heartbeat("node_with_long_id", "climate", 1, 2, json, sizeof(json)));
+    TEST_ASSERT_FALSE(mesh_protocol_create_rate_hint(MESH_RATE_HOLD, 600, json, 8));
+}
+
+static void test_invalid_input(void) {
+    mesh_message_t msg;
+    TEST_ASSERT_FALSE(mesh_protocol_parse("{not json", &msg));
+    TEST_ASSERT_FALSE(mesh_protocol_parse("{\"node_id\":\"x\"}", &msg));   // Нет type
+    TEST_ASSERT_FALSE(mesh_protocol_parse("{\"type\":5}", &msg));
+    TEST_ASSERT_FALSE(mesh_protocol_parse(NULL, &msg));
+
+    TEST_ASSERT_TRUE(mesh_protocol_parse("{\"type\":\"bogus\"}", &msg));
+    TEST_ASSERT_EQUAL_INT(MESH_MSG_UNKNOWN, msg.type);
+    mesh_protocol_free_message(&msg);
+
+    TEST_ASSERT_TRUE(mesh_protocol_parse("{\"type\":\"config_response\",\"node_id\":\"a\"}", &msg));
+    TEST_ASSERT_EQUAL_INT(MESH_MSG_RESPONSE, msg.type);
+    mesh_protocol_free_message(&msg);
+}
+
+static void test_is_for_node(void) {
+    mesh_message_t msg = { .type = MESH_MSG_COMMAND };
+    strcpy(msg.node_id, "ec_002");
+    TEST_ASSERT_TRUE(mesh_protocol_is_for_node(&msg, "ec_002"));
+    TEST_ASSERT_FALSE(mesh_protocol_is_for_node(&msg, "ec_003"));
+
+    strcpy(msg.node_id, MESH_NODE_ID_GROUP);
+    TEST_ASSERT_TRUE(mesh_protocol_is_for_node(&msg, "ec_003"));
+}
+
+int main(void) {
+    RUN_TEST(test_telemetry_round_trip);
+    RUN_TEST(test_seq_increments);
+    RUN_TEST(test_heartbeat_root_rssi);
+    RUN_TEST(test_command_data_in_root);
+    RUN_TEST(test_rate_hint);
+    RUN_TEST(test_time_sync);
+    RUN_TEST(test_timestamp_us);
+    RUN_TEST(test_buffer_too_small);
+    RUN_TEST(test_invalid_input);
+    RUN_TEST(test_is_for_node);
+    return TEST_REPORT();
+}
@@ -0,0 +1,92 @@
+/**
+ * @file test_node_config.c
+ * @brief Host тесты common/node_config: JSON экспорт/импорт и NVS (в памяти)
+ */
+
+#include "host_test.h"
+#include "host_stubs.h"
+#include "node_config.h"
+
+static void test_export_import_round_trip(void) {
+    ph_ec_node_config_t src, dst;
+    TEST_ASSERT_EQUAL_INT(ESP_OK, node_config_reset_to_default(&src, "ph_ec"));
+    strcpy(src.base.node_id, "ph_ec_001");
+    src.ph_target = 6.2f;
+    src.pump_pid[3].kp = 2.5f;
+    src.pump_pid[3].enabled = false;
+
+    cJSON *json = node_config_export_to_json(&src, "ph_ec");
+    TEST_ASSERT_NOT_NULL(json);
+
+    node_config_reset_to_default(&dst, "ph_ec");
+    TEST_ASSERT_EQUAL_INT(ESP_OK, node_config_update_from_json(&dst, json, "ph_ec"));
+    cJSON_Delete(json);
+
+    TEST_ASSERT_EQUAL_STRING("ph_ec_001", dst.base.node_id);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 6.2, dst.ph_target);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 2.5, dst.pump_pid[3].kp);
+    TEST_ASSERT_FALSE(dst.pump_pid[3].enabled);
+    TEST_ASSERT_EQUAL_INT(src.max_pump_time_ms, dst.max_pump_time_ms);
+    TEST_ASSERT_EQUAL_INT(2, dst.base.config_version);  // Импорт увеличивает версию
+}
+
+static void test_partial_update(void) {
+    climate_node_config_t cfg;
+    node_config_reset_to_default(&cfg, "climate");
+    float humidity = cfg.humidity_target;
+
+    cJSON *json = cJSON_Parse("{\"temp_target\":23.5,\"co2_max\":900,\"unknown\":1}");
+    TEST_ASSERT_EQUAL_INT(ESP_OK, node_config_update_from_json(&cfg, json, "climate"));
+    cJSON_Delete(json);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 23.5, cfg.temp_target);
+    TEST_ASSERT_EQUAL_INT(900, cfg.co2_max);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, humidity, cfg.humidity_target);   // Не было в JSON
+}
+
+static void test_wrong_types_ignored(void) {
+    ph_ec_node_config_t cfg;
+    node_config_reset_to_default(&cfg, "ph_ec");
+
+    cJSON *json = cJSON_Parse("{\"ph_target\":\"7.0\",\"autonomous_enabled\":1}");
+    node_config_update_from_json(&cfg, json, "ph_ec");
+    cJSON_Delete(json);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 6.8, cfg.ph_target);
+    TEST_ASSERT_TRUE(cfg.autonomous_enabled);
+}
+
+static void test_unknown_type(void) {
+    ph_ec_node_config_t cfg;
+    TEST_ASSERT_NULL(node_config_export_to_json(&cfg, "toaster"));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, node_config_update_from_json(&cfg, NULL, "ph_ec"));
+}
+
+static void test_nvs_save_load(void) {
+    host_nvs_reset();
+    TEST_ASSERT_EQUAL_INT(ESP_OK, node_config_init());
+
+    water_node_config_t cfg, loaded;
+    TEST_ASSERT_TRUE(node_config_load(&loaded, sizeof(loaded), "water_cfg") != ESP_OK);
+
+    node_config_reset_to_default(&cfg, "water");
+    cfg.active_zones = 0x5;
+    TEST_ASSERT_EQUAL_INT(ESP_OK, node_config_save(&cfg, sizeof(cfg), "water_cfg"));
+
+    memset(&loaded, 0, sizeof(loaded));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, node_config_load(&loaded, sizeof(loaded), "water_cfg"));
+    TEST_ASSERT_EQUAL_INT(0x5, loaded.active_zones);
+    TEST_ASSERT_TRUE(memcmp(&cfg, &loaded, sizeof(cfg)) == 0);
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, node_config_erase_all());
+    TEST_ASSERT_TRUE(node_config_load(&loaded, sizeof(loaded), "water_cfg") != ESP_OK);
+}
+
+int main(void) {
+    RUN_TEST(test_export_import_round_trip);
+    RUN_TEST(test_partial_update);
+    RUN_TEST(test_wrong_types_ignored);
+    RUN_TEST(test_unknown_type);
+    RUN_TEST(test_nvs_save_load);
+    return TEST_REPORT();
+}
@@ -0,0 +1,256 @@
+/**
+ * @file test_node_registry.c
+ * @brief Host тесты root_node/components/node_registry
+ *
+ * Реестр хранит состояние в static переменных и не имеет deinit -
+ * тесты идут по порядку и опираются на состояние предыдущих.
+ */
+
+#include "host_test.h"
+#include "host_stubs.h"
+#include "node_registry.h"
+#include <stdio.h>
+
+static int s_events[5];
+
+static void on_event(node_registry_event_t event, const node_info_t *node, void *ctx) {
+    (void)node;
+    (void)ctx;
+    s_events[event]++;
+}
+
+static void make_mac(uint8_t mac[6], int idx) {
+    mac[0] = 0x24; mac[1] = 0x6f; mac[2] = 0x28;
+    mac[3] = 0; mac[4] = (uint8_t)(idx >> 8); mac[5] = (uint8_t)idx;
+}
+
+static void test_add_and_find(void) {
+    TEST_ASSERT_EQUAL_INT(ESP_OK, node_registry_init());
+    TEST_ASSERT_EQUAL_INT(ESP_OK, node_registry_register_event_cb(on_event, NULL));
+
+    uint8_t mac[6];
+    make_mac(mac, 1);
+    node_registry_update_last_seen("ph_001", mac, NULL, 0);
+    TEST_ASSERT_EQUAL_INT(1, node_registry_get_count());
+    TEST_ASSERT_EQUAL_INT(1, s_events[NODE_REGISTRY_EVENT_ONLINE]);
+
+    const node_registry_view_t *view = node_registry_acquire();
+    TEST_ASSERT_NOT_NULL(view);
+    const node_info_t *node = node_registry_view_find(view, "ph_001");
+    TEST_ASSERT_NOT_NULL(node);
+    TEST_ASSERT_TRUE(node->online);
+    TEST_ASSERT_TRUE(memcmp(node->mac_addr, mac, 6) == 0);
+    TEST_ASSERT_NULL(node_registry_view_find(view, "ph_002"));
+    node_registry_release(view);
+}
+
+static void test_type_and_data(void) {
+    node_registry_update_type("ph_001", "ph");
+    node_registry_update_type("ph_001", "ph");  // Без изменений - без события
+    TEST_ASSERT_EQUAL_INT(1, s_events[NODE_REGISTRY_EVENT_INFO]);
+    TEST_ASSERT_TRUE(node_registry_has_type("ph"));
+    TEST_ASSERT_FALSE(node_registry_has_type("climate"));
+
+    cJSON *data = cJSON_Parse("{\"ph\":6.4,\"zone\":\"A\"}");
+    node_registry_update_data("ph_001", data);
+    cJSON_Delete(data);     // Реестр хранит копию
+    TEST_ASSERT_EQUAL_INT(1, s_events[NODE_REGISTRY_EVENT_DATA]);
+
+    const node_registry_view_t *view = node_registry_acquire();
+    const node_info_t *node = node_registry_view_find(view, "ph_001");
+    TEST_ASSERT_NOT_NULL(node);
+    TEST_ASSERT_NOT_NULL(node->last_data);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 6.4, cJSON_GetObjectItem(node->last_data, "ph")->valuedouble);
+    TEST_ASSERT_EQUAL_STRING("ph", node->node_type);
+    node_registry_release(view);
+
+    // Неизвестный узел не добавляется данными
+    data = cJSON_Parse("{\"ph\":7.0}");
+    node_registry_update_data("ghost", data);
+    cJSON_Delete(data);
+    TEST_ASSERT_EQUAL_INT(1, node_registry_get_count());
+}
+
+static void test_view_is_immutable(void) {
+    const node_registry_view_t *old = node_registry_acquire();
+    uint32_t version = old->version;
+
+    uint8_t mac[6];
+    make_mac(mac, 2);
+    node_registry_update_last_seen("ec_001", mac, NULL, 0);
+
+    // Удерживаемая версия не видит нового узла
+    TEST_ASSERT_NULL(node_registry_view_find(old, "ec_001"));
+    const node_registry_view_t *cur = node_registry_acquire();
+    TEST_ASSERT_TRUE(cur->version > version);
+    TEST_ASSERT_NOT_NULL(node_registry_view_find(cur, "ec_001"));
+    node_registry_release(cur);
+    node_registry_release(old);
+}
+
+static void test_bootstrap_timeout(void) {
+    uint8_t mac[6];
+    make_mac(mac, 1);
+
+    // ph_001 на связи каждые 10 с, ec_001 молчит
+    for (int i = 0; i < 10; i++) {
+        host_time_advance_us(10 * 1000000LL);
+        node_registry_update_last_seen("ph_001", mac, NULL, 0);
+        node_registry_check_timeouts();
+    }
+
+    TEST_ASSERT_EQUAL_INT(1, s_events[NODE_REGISTRY_EVENT_OFFLINE]);
+    TEST_ASSERT_EQUAL_INT(1, node_registry_get_count());
+
+    const node_registry_view_t *view = node_registry_acquire();
+    TEST_ASSERT_FALSE(node_registry_view_find(view, "ec_001")->online);
+    TEST_ASSERT_TRUE(node_registry_view_find(view, "ph_001")->online);
+    node_registry_release(view);
+}
+
+static void test_phi_timeout(void) {
+    // Регулярный интервал 10 с: через 35 с тишины phi превышает порог
+    host_time_advance_us(35 * 1000000LL);
+    node_registry_check_timeouts();
+    TEST_ASSERT_EQUAL_INT(2, s_events[NODE_REGISTRY_EVENT_OFFLINE]);
+    TEST_ASSERT_EQUAL_INT(0, node_registry_get_count());
+
+    // Возврат в online генерирует событие
+    uint8_t mac[6];
+    make_mac(mac, 1);
+    node_registry_update_last_seen("ph_001", mac, NULL, 0);
+    TEST_ASSERT_EQUAL_INT(3, s_events[NODE_REGISTRY_EVENT_ONLINE]);
+}
+
+static void test_parse_failures(void) {
+    uint8_t mac[6];
+    make_mac(mac, 1);
+    node_registry_record_parse_failure(mac);
+    make_mac(mac, 999);
+    node_registry_record_parse_failure(mac);
+
+    TEST_ASSERT_EQUAL_INT(1, (int)node_registry_get_unknown_parse_failures());
+
+    // Счётчик попадает в версию с проверкой таймаутов
+    node_registry_check_timeouts();
+    const node_registry_view_t *view = node_registry_acquire();
+    TEST_ASSERT_EQUAL_INT(1, (int)node_registry_view_find(view, "ph_001")->traffic.parse_failures);
+    node_registry_release(view);
+}
+
+static void test_last_seen_without_version(void) {
+    uint8_t mac[6];
+    make_mac(mac, 1);
+    const node_registry_view_t *view = node_registry_acquire();
+    uint32_t version = view->version;
+    uint64_t seen_ms = node_registry_view_find(view, "ph_001")->last_seen_ms;
+    node_registry_release(view);
+
+    // Контакт online узла - без новой версии
+    host_time_advance_us(10 * 1000000LL);
+    node_registry_update_last_seen("ph_001", mac, NULL, 0);
+    view = node_registry_acquire();
+    TEST_ASSERT_EQUAL_INT(version, view->version);
+    node_registry_release(view);
+
+    // Данные публикуют версию вместе с накопленным временем контакта
+    cJSON *data = cJSON_Parse("{\"ph\":6.1}");
+    node_registry_update_data("ph_001", data);
+    cJSON_Delete(data);
+    view = node_registry_acquire();
+    TEST_ASSERT_TRUE(view->version > version);
+    TEST_ASSERT_TRUE(node_registry_view_find(view, "ph_001")->last_seen_ms >= seen_ms + 10000);
+    node_registry_release(view);
+}
+
+static void test_version_pool_exhausted(void) {
+    // Читатели держат все версии: публикация откладывается
+    const node_registry_view_t *held[NODE_REGISTRY_VERSIONS];
+    held[0] = node_registry_acquire();
+    for (int i = 1; i < NODE_REGISTRY_VERSIONS; i++) {
+        cJSON *data = cJSON_CreateNumber(i);
+        node_registry_update_data("ph_001", data);
+        cJSON_Delete(data);
+        held[i] = node_registry_acquire();
+        TEST_ASSERT_TRUE(held[i] != held[i - 1]);
+    }
+
+    cJSON *data = cJSON_Parse("{\"ph\":5.5}");
+    node_registry_update_data("ph_001", data);
+    cJSON_Delete(data);
+    const node_registry_view_t *view = node_registry_acquire();
+    TEST_ASSERT_TRUE(view == held[NODE_REGISTRY_VERSIONS - 1]);
+    node_registry_release(view);
+
+    for (int i = 0; i < NODE_REGISTRY_VERSIONS; i++) {
+        node_registry_release(held[i]);
+    }
+
+    // Отложенные данные публикуются проверкой таймаутов
+    node_registry_check_timeouts();
+    view = node_registry_acquire();
+    const node_info_t *node = node_registry_view_find(view, "ph_001");
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 5.5, cJSON_GetObjectItem(node->last_data, "ph")->valuedouble);
+    node_registry_release(view);
+}
+
+static void test_remove(void) {
+    uint8_t mac[6];
+    make_mac(mac, 3);
+    node_registry_update_last_seen("tmp_001", mac, NULL, 0);
+    make_mac(mac, 4);
+    node_registry_update_last_seen("tmp_002", mac, NULL, 0);
+
+    const node_registry_view_t *old = node_registry_acquire();
+    const node_info_t *tmp2 = node_registry_view_find(old, "tmp_002");
+    uint32_t serial = tmp2->serial;
+    int slot = (int)(tmp2 - old->nodes);
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, node_registry_remove("tmp_001"));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_NOT_FOUND, node_registry_remove("tmp_001"));
+    TEST_ASSERT_EQUAL_INT(1, s_events[NODE_REGISTRY_EVENT_REMOVED]);
+
+    // Удерживаемая версия не меняется, в новой запись сдвинута с тем же serial
+    TEST_ASSERT_NOT_NULL(node_registry_view_find(old, "tmp_001"));
+    const node_registry_view_t *cur = node_registry_acquire();
+    TEST_ASSERT_NULL(node_registry_view_find(cur, "tmp_001"));
+    TEST_ASSERT_EQUAL_INT(old->count - 1, cur->count);
+    tmp2 = node_registry_view_find(cur, "tmp_002");
+    TEST_ASSERT_NOT_NULL(tmp2);
+    TEST_ASSERT_EQUAL_INT(slot - 1, (int)(tmp2 - cur->nodes));
+    TEST_ASSERT_EQUAL_INT(serial, tmp2->serial);
+    node_registry_release(cur);
+    node_registry_release(old);
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, node_registry_remove("tmp_002"));
+}
+
+static void test_registry_full(void) {
+    char id[16];
+    uint8_t mac[6];
+    for (int i = 0; i < MAX_NODES + 3; i++) {
+        snprintf(id, sizeof(id), "node_%03d", i);
+        make_mac(mac, 100 + i);
+        node_registry_update_last_seen(id, mac, NULL, 0);
+    }
+
+    const node_registry_view_t *view = node_registry_acquire();
+    TEST_ASSERT_EQUAL_INT(MAX_NODES, view->count);
+    snprintf(id, sizeof(id), "node_%03d", MAX_NODES);
+    TEST_ASSERT_NULL(node_registry_view_find(view, id));
+    node_registry_release(view);
+}
+
+int main(void) {
+    RUN_TEST(test_add_and_find);
+    RUN_TEST(test_type_and_data);
+    RUN_TEST(test_view_is_immutable);
+    RUN_TEST(test_bootstrap_timeout);
+    RUN_TEST(test_phi_timeout);
+    RUN_TEST(test_parse_failures);
+    RUN_TEST(test_last_seen_without_version);
+    RUN_TEST(test_version_pool_exhausted);
+    RUN_TEST(test_remove);
+    RUN_TEST(test_registry_full);
+    return TEST_REPORT();
+}
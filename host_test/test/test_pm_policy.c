@@ -0,0 +1,160 @@
+/**
+ * @file test_pm_policy.c
+ * @brief Host тесты common/pm_policy: счётные блокировки, задержка захвата, занятость, оценка тока
+ */
+
+#include "host_test.h"
+#include "host_stubs.h"
+#include "pm_policy.h"
+#include "sdkconfig.h"
+
+static void test_init_and_nested_locks(void) {
+    TEST_ASSERT_EQUAL_INT(ESP_OK, pm_policy_init());
+    TEST_ASSERT_EQUAL_INT(ESP_OK, pm_policy_init());
+
+    pm_policy_site_stats_t before, after;
+    pm_policy_get_site_stats(PM_SITE_I2C, &before);
+
+    pm_policy_acquire(PM_SITE_I2C);
+    pm_policy_acquire(PM_SITE_I2C);
+    TEST_ASSERT_EQUAL_INT(2, host_pm_locks_held());
+    pm_policy_release(PM_SITE_I2C);
+    pm_policy_release(PM_SITE_I2C);
+    TEST_ASSERT_EQUAL_INT(0, host_pm_locks_held());
+
+    pm_policy_get_site_stats(PM_SITE_I2C, &after);
+    TEST_ASSERT_EQUAL_INT(before.acquires + 2, after.acquires);
+
+    pm_policy_status_t status;
+    pm_policy_get_status(&status);
+    TEST_ASSERT_TRUE(status.active);
+    TEST_ASSERT_EQUAL_INT(CONFIG_PM_POLICY_MAX_FREQ_MHZ, status.max_freq_mhz);
+    TEST_ASSERT_EQUAL_INT(CONFIG_PM_POLICY_MIN_FREQ_MHZ, status.min_freq_mhz);
+}
+
+static void test_acquire_latency(void) {
+    host_pm_set_switch_us(250);
+    pm_policy_acquire(PM_SITE_MESH_TX);
+    // Частота уже поднята - второй захват без переключения
+    pm_policy_acquire(PM_SITE_I2C);
+    pm_policy_release(PM_SITE_I2C);
+    pm_policy_release(PM_SITE_MESH_TX);
+    host_pm_set_switch_us(0);
+
+    pm_policy_site_stats_t tx;
+    pm_policy_get_site_stats(PM_SITE_MESH_TX, &tx);
+    TEST_ASSERT_EQUAL_INT(1, tx.acquires);
+    TEST_ASSERT_TRUE(tx.acquire_us_max >= 250);
+    TEST_ASSERT_TRUE(tx.acquire_us_total >= 250);
+
+    pm_policy_site_stats_t i2c;
+    pm_policy_get_site_stats(PM_SITE_I2C, &i2c);
+    TEST_ASSERT_TRUE(i2c.acquire_us_max < 250);
+}
+
+static void test_overlap_counted_once(void) {
+    pm_policy_status_t s0, s1;
+    pm_policy_site_stats_t pump0, pump1, i2c0, i2c1;
+    pm_policy_get_status(&s0);
+    pm_policy_get_site_stats(PM_SITE_PUMP, &pump0);
+    pm_policy_get_site_stats(PM_SITE_I2C, &i2c0);
+
+    pm_policy_acquire(PM_SITE_PUMP);
+    host_time_advance_us(1000000);
+    pm_policy_acquire(PM_SITE_I2C);
+    host_time_advance_us(500000);
+    pm_policy_release(PM_SITE_I2C);
+    pm_policy_release(PM_SITE_PUMP);
+
+    pm_policy_get_status(&s1);
+    pm_policy_get_site_stats(PM_SITE_PUMP, &pump1);
+    pm_policy_get_site_stats(PM_SITE_I2C, &i2c1);
+
+    TEST_ASSERT_FLOAT_WITHIN(5000, 1500000, (double)(s1.busy_us - s0.busy_us));
+    TEST_ASSERT_FLOAT_WITHIN(5000, 1500000, (double)(pump1.hold_us_total - pump0.hold_us_total));
+    TEST_ASSERT_FLOAT_WITHIN(5000, 500000, (double)(i2c1.hold_us_total - i2c0.hold_us_total));
+}
+
+static void test_open_hold_counts_as_busy(void) {
+    pm_policy_status_t s0, s1;
+    pm_policy_get_status(&s0);
+
+    pm_policy_acquire(PM_SITE_PUMP);
+    host_time_advance_us(2000000);
+    pm_policy_get_status(&s1);
+    pm_policy_release(PM_SITE_PUMP);
+
+    TEST_ASSERT_FLOAT_WITHIN(5000, 2000000, (double)(s1.busy_us - s0.busy_us));
+}
+
+static void test_current_estimate(void) {
+    host_time_advance_us(100000000);
+
+    pm_policy_status_t status;
+    pm_policy_get_status(&status);
+    TEST_ASSERT_TRUE(status.window_us > status.busy_us);
+
+    double busy = (double)status.busy_us / status.window_us;
+    double expected_ua = 1000.0 * (CONFIG_PM_POLICY_ACTIVE_MA * busy +
+                                   CONFIG_PM_POLICY_IDLE_MA * (1.0 - busy));
+    TEST_ASSERT_FLOAT_WITHIN(2, expected_ua, status.avg_current_ua);
+    TEST_ASSERT_TRUE(status.avg_current_ua > CONFIG_PM_POLICY_IDLE_MA * 1000);
+    TEST_ASSERT_TRUE(status.avg_current_ua < CONFIG_PM_POLICY_ACTIVE_MA * 1000);
+}
+
+static void test_unbalanced_release_ignored(void) {
+    pm_policy_status_t s0, s1;
+    pm_policy_get_status(&s0);
+
+    pm_policy_release(PM_SITE_MESH_TX);
+    TEST_ASSERT_EQUAL_INT(0, host_pm_locks_held());
+
+    // Счётчики не ушли в минус: следующий захват/освобождение - как обычно
+    pm_policy_acquire(PM_SITE_MESH_TX);
+    TEST_ASSERT_EQUAL_INT(1, host_pm_locks_held());
+    pm_policy_release(PM_SITE_MESH_TX);
+    TEST_ASSERT_EQUAL_INT(0, host_pm_locks_held());
+
+    pm_policy_get_status(&s1);
+    TEST_ASSERT_TRUE(s1.busy_us - s0.busy_us < 5000);
+
+    pm_policy_acquire(PM_SITE_COUNT);
+    pm_policy_release(PM_SITE_COUNT);
+    TEST_ASSERT_EQUAL_INT(0, host_pm_locks_held());
+    TEST_ASSERT_EQUAL_STRING("unknown", pm_policy_site_to_str(PM_SITE_COUNT));
+}
+
+static void test_json_summary(void) {
+    cJSON *obj = cJSON_CreateObject();
+    pm_policy_add_to_json(obj);
+
+    cJSON *pm = cJSON_GetObjectItem(obj, "pm");
+    TEST_ASSERT_NOT_NULL(pm);
+
+    cJSON *f = cJSON_GetObjectItem(pm, "f");
+    TEST_ASSERT_EQUAL_INT(2, cJSON_GetArraySize(f));
+    TEST_ASSERT_EQUAL_INT(CONFIG_PM_POLICY_MIN_FREQ_MHZ, cJSON_GetArrayItem(f, 0)->valueint);
+    TEST_ASSERT_EQUAL_INT(CONFIG_PM_POLICY_MAX_FREQ_MHZ, cJSON_GetArrayItem(f, 1)->valueint);
+    TEST_ASSERT_NOT_NULL(cJSON_GetObjectItem(pm, "busy"));
+    TEST_ASSERT_NOT_NULL(cJSON_GetObjectItem(pm, "ua"));
+
+    cJSON *locks = cJSON_GetObjectItem(pm, "locks");
+    TEST_ASSERT_EQUAL_INT(PM_SITE_COUNT, cJSON_GetArraySize(locks));
+    cJSON *row = cJSON_GetArrayItem(locks, PM_SITE_MESH_TX);
+    TEST_ASSERT_EQUAL_INT(5, cJSON_GetArraySize(row));
+    TEST_ASSERT_EQUAL_STRING("mesh_tx", cJSON_GetArrayItem(row, 0)->valuestring);
+    TEST_ASSERT_TRUE(cJSON_GetArrayItem(row, 3)->valueint >= 250);
+
+    cJSON_Delete(obj);
+}
+
+int main(void) {
+    RUN_TEST(test_init_and_nested_locks);
+    RUN_TEST(test_acquire_latency);
+    RUN_TEST(test_overlap_counted_once);
+    RUN_TEST(test_open_hold_counts_as_busy);
+    RUN_TEST(test_current_estimate);
+    RUN_TEST(test_unbalanced_release_ignored);
+    RUN_TEST(test_json_summary);
+    return TEST_REPORT();
+}
@@ -5,6 +5,7 @@
 
 #include "ccs811_driver.h"
 #include "esp_log.h"
+#include "pm_policy.h"
 #include "esp_random.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -39,7 +40,9 @@ esp_err_t ccs811_init(i2c_port_t i2c_port) {
     i2c_master_write_byte(cmd, CCS811_REG_APP_START, true);
     i2c_master_stop(cmd);
     
+    pm_policy_acquire(PM_SITE_I2C);
     esp_err_t ret = i2c_master_cmd_begin(s_i2c_port, cmd, pdMS_TO_TICKS(1000));
+    pm_policy_release(PM_SITE_I2C);
     i2c_cmd_link_delete(cmd);
     
     if (ret != ESP_OK) {
@@ -58,7 +61,9 @@ esp_err_t ccs811_init(i2c_port_t i2c_port) {
     i2c_master_write(cmd, mode_data, 2, true);
     i2c_master_stop(cmd);
     
+    pm_policy_acquire(PM_SITE_I2C);
     ret = i2c_master_cmd_begin(s_i2c_port, cmd, pdMS_TO_TICKS(1000));
+    pm_policy_release(PM_SITE_I2C);
     i2c_cmd_link_delete(cmd);
     
     if (ret != ESP_OK) {
@@ -110,7 +115,9 @@ esp_err_t ccs811_read(uint16_t *co2, uint16_t *tvoc) {
     i2c_master_read(cmd, data, 8, I2C_MASTER_LAST_NACK);
     i2c_master_stop(cmd);
     
+    pm_policy_acquire(PM_SITE_I2C);
     esp_err_t ret = i2c_master_cmd_begin(s_i2c_port, cmd, pdMS_TO_TICKS(1000));
+    pm_policy_release(PM_SITE_I2C);
     i2c_cmd_link_delete(cmd);
     
     if (ret != ESP_OK) {
@@ -152,7 +159,9 @@ esp_err_t ccs811_set_environment(float temperature, float humidity) {
     i2c_master_write(cmd, data, 5, true);
     i2c_master_stop(cmd);
     
+    pm_policy_acquire(PM_SITE_I2C);
     esp_err_t ret = i2c_master_cmd_begin(s_i2c_port, cmd, pdMS_TO_TICKS(1000));
+    pm_policy_release(PM_SITE_I2C);
     i2c_cmd_link_delete(cmd);
 
     ESP_LOGD(TAG, "Environment set: %.1f°C, %.0f%%", temperature, humidity);
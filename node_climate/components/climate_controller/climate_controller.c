@@ -9,7 +9,11 @@
 #include "lux_sensor.h"
 #include "mesh_manager.h"
 #include "mesh_protocol.h"
+#include "rate_hint.h"
+#include "instrumentation.h"
+#include "pm_policy.h"
 #include "node_config.h"
+#include "event_bus.h"
 
 #include "esp_log.h"
 #include "esp_wifi.h"
@@ -17,6 +21,7 @@
 // #include "esp_task_wdt.h"  // Закомментировано для совместимости с ESP-IDF v5.5
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "rtos_static.h"
 #include <string.h>
 #include <stdbool.h>
 #include <time.h>
@@ -26,8 +31,18 @@ static const char *TAG = "climate_ctrl";
 static climate_node_config_t *s_config = NULL;
 static TaskHandle_t s_main_task = NULL;
 static TaskHandle_t s_heartbeat_task = NULL;
+RTOS_STATIC_TASK(climate_main, 8192);
+RTOS_STATIC_TASK(climate_heartbeat, 6144);
 static bool s_discovery_sent = false;
 static uint32_t s_boot_time = 0;
+static volatile TickType_t s_last_telemetry_tick = 0;  // Последняя успешная telemetry
+
+// Heartbeat пропускается, если telemetry уже подтвердила связь за этот интервал
+// (ROOT считает живостью любое сообщение). Раз в HEARTBEAT_MAX_SKIPPED + 1
+// интервалов heartbeat уходит всегда - с heap/uptime для backend.
+#define HEARTBEAT_INTERVAL_MS       5000
+#define HEARTBEAT_MAX_SKIPPED       2       // Heartbeat не реже 15 с: backend (таймаут 20 с) видит узел и без сырой telemetry
+#define TELEMETRY_INTERVAL_MS       5000
 
 // Forward declarations
 static void climate_main_task(void *arg);
@@ -65,12 +80,12 @@ esp_err_t climate_controller_start(void) {
 
     // Запуск главной задачи (telemetry каждые 30 сек)
     // Stack увеличен в 2 раза для безопасности: 4096 → 8192
-    BaseType_t ret = xTaskCreate(climate_main_task,
-                                  "climate_main",
-                                  8192,
-                                  NULL,
-                                  5,
-                                  &s_main_task);
+    BaseType_t ret = rtos_static_task_create(&climate_main,
+                                             climate_main_task,
+                                             "climate_main",
+                                             NULL,
+                                             5,
+                                             &s_main_task);
     
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create main task");
@@ -79,12 +94,12 @@ esp_err_t climate_controller_start(void) {
 
     // Запуск задачи heartbeat (каждые 60 сек)
     // Stack увеличен в 2 раза для безопасности: 3072 → 6144
-    ret = xTaskCreate(heartbeat_task,
-                      "heartbeat",
-                      6144,
-                      NULL,
-                      4,
-                      &s_heartbeat_task);
+    ret = rtos_static_task_create(&climate_heartbeat,
+                                  heartbeat_task,
+                                  "heartbeat",
+                                  NULL,
+                                  4,
+                                  &s_heartbeat_task);
     
     if (ret != pdPASS) {
         ESP_LOGW(TAG, "Failed to create heartbeat task");
@@ -119,21 +134,18 @@ static void climate_main_task(void *arg) {
     uint16_t co2, lux;
 
     // Отправка discovery сообщения при старте
-    // Ожидаем подключения к mesh (до 30 секунд)
-    int wait_count = 0;
-    while (!mesh_manager_is_connected() && wait_count < 30) {
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        wait_count++;
-    }
-    
+    // Ожидаем подключения к mesh (до 30 секунд, пробуждение по MESH_UP)
     // Дополнительная задержка после подключения для стабилизации mesh
-    if (mesh_manager_is_connected()) {
+    if (event_bus_wait_mesh_up(pdMS_TO_TICKS(30000))) {
         ESP_LOGI(TAG, "Mesh connected, waiting 3 seconds for stabilization...");
         vTaskDelay(pdMS_TO_TICKS(3000));
         send_discovery();
         s_discovery_sent = true;
     }
 
+    TickType_t last_sent = 0;
+    bool sent_once = false;
+
     while (1) {
         // Сброс watchdog (закомментировано для ESP-IDF v5.5)
         // esp_task_wdt_reset();
@@ -149,16 +161,25 @@ static void climate_main_task(void *arg) {
 
         // ⚠️ MOCK MODE: Всегда отправляем телеметрию (даже с моковыми данными)
         if (ret == ESP_OK) {
-            // Отправка телеметрии на ROOT
-            send_telemetry(temp, humidity, co2, lux);
+            // Отправка телеметрии на ROOT - реже по подсказке ROOT, в HOLD не отправляем
+            // (после снятия HOLD сразу уходит последнее показание)
+            TickType_t now = xTaskGetTickCount();
+            if (rate_hint_is_hold()) {
+                ESP_LOGD(TAG, "Telemetry held by ROOT rate hint");
+            } else if (!sent_once ||
+                       now - last_sent >= pdMS_TO_TICKS(rate_hint_scale_interval_ms(TELEMETRY_INTERVAL_MS))) {
+                send_telemetry(temp, humidity, co2, lux);
+                last_sent = now;
+                sent_once = true;
+            }
 
             // Проверка пороговых значений и отправка events
             check_sensor_thresholds(temp, humidity, co2);
         }
         // Убрана проверка "else" которая пропускала телеметрию - теперь всегда отправляется!
 
-        // Интервал telemetry - 5 секунд (DEBUG режим!)
-        vTaskDelay(pdMS_TO_TICKS(5000));
+        // Интервал чтения датчиков - 5 секунд (DEBUG режим!)
+        vTaskDelay(pdMS_TO_TICKS(TELEMETRY_INTERVAL_MS));
     }
 }
 
@@ -169,12 +190,26 @@ static void heartbeat_task(void *arg) {
     // Начальная задержка
     vTaskDelay(pdMS_TO_TICKS(5000));
 
+    int skipped = 0;
+
     while (1) {
         if (mesh_manager_is_connected()) {
-            send_heartbeat();
+            bool telemetry_recent = s_last_telemetry_tick != 0 &&
+                (xTaskGetTickCount() - s_last_telemetry_tick) < pdMS_TO_TICKS(HEARTBEAT_INTERVAL_MS);
+
+            // При подсказке ROOT reduce/hold heartbeat тоже реже - раз в 15 с
+            bool throttled = rate_hint_get_level() != MESH_RATE_NORMAL;
+
+            if ((telemetry_recent || throttled) && skipped < HEARTBEAT_MAX_SKIPPED) {
+                skipped++;
+                ESP_LOGD(TAG, "Heartbeat skipped (telemetry recent)");
+            } else {
+                send_heartbeat();
+                skipped = 0;
+            }
         }
         
-        vTaskDelay(pdMS_TO_TICKS(5000));  // Каждые 5 секунд (DEBUG)
+        vTaskDelay(pdMS_TO_TICKS(HEARTBEAT_INTERVAL_MS));  // Каждые 5 секунд (DEBUG)
     }
 }
 
@@ -311,6 +346,7 @@ static void send_heartbeat(void) {
     cJSON_AddStringToObject(root, "type", "heartbeat");
     cJSON_AddStringToObject(root, "node_id", s_config->base.node_id);
     cJSON_AddStringToObject(root, "node_type", "climate");
+    cJSON_AddNumberToObject(root, "seq", mesh_protocol_next_seq());
     
     char mac_str[18];
     snprintf(mac_str, sizeof(mac_str), "%02X:%02X:%02X:%02X:%02X:%02X",
@@ -321,6 +357,8 @@ static void send_heartbeat(void) {
     cJSON_AddNumberToObject(root, "uptime", uptime);
     cJSON_AddNumberToObject(root, "heap_free", heap_free);
     cJSON_AddNumberToObject(root, "rssi_to_parent", rssi);
+    instrumentation_add_to_json(root);
+    pm_policy_add_to_json(root);
     
     char *heartbeat_msg = cJSON_PrintUnformatted(root);
     esp_err_t err = ESP_FAIL;
@@ -364,6 +402,7 @@ static void send_telemetry(float temp, float humidity, uint16_t co2, uint16_t lu
         esp_err_t err = mesh_manager_send_to_root((uint8_t *)json_buf, strlen(json_buf));
         
         if (err == ESP_OK) {
+            s_last_telemetry_tick = xTaskGetTickCount();
             ESP_LOGI(TAG, "📊 Telemetry: %.1f°C, %.0f%%, %dppm, %dlux, RSSI=%d", 
                      temp, humidity, co2, lux, rssi);
         } else {
@@ -5,6 +5,7 @@
 
 #include "lux_sensor.h"
 #include "esp_log.h"
+#include "pm_policy.h"
 #include "esp_random.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -37,7 +38,9 @@ esp_err_t lux_sensor_init(i2c_port_t i2c_port) {
     i2c_master_write(cmd, control_data, 2, true);
     i2c_master_stop(cmd);
     
+    pm_policy_acquire(PM_SITE_I2C);
     esp_err_t ret = i2c_master_cmd_begin(s_i2c_port, cmd, pdMS_TO_TICKS(1000));
+    pm_policy_release(PM_SITE_I2C);
     i2c_cmd_link_delete(cmd);
     
     if (ret != ESP_OK) {
@@ -56,7 +59,9 @@ esp_err_t lux_sensor_init(i2c_port_t i2c_port) {
     i2c_master_write(cmd, timing_data, 2, true);
     i2c_master_stop(cmd);
     
+    pm_policy_acquire(PM_SITE_I2C);
     ret = i2c_master_cmd_begin(s_i2c_port, cmd, pdMS_TO_TICKS(1000));
+    pm_policy_release(PM_SITE_I2C);
     i2c_cmd_link_delete(cmd);
     
     if (ret != ESP_OK) {
@@ -100,7 +105,9 @@ esp_err_t lux_sensor_read(uint16_t *lux) {
     i2c_master_read_byte(cmd, &data_low, I2C_MASTER_NACK);
     i2c_master_stop(cmd);
     
+    pm_policy_acquire(PM_SITE_I2C);
     esp_err_t ret = i2c_master_cmd_begin(s_i2c_port, cmd, pdMS_TO_TICKS(1000));
+    pm_policy_release(PM_SITE_I2C);
     i2c_cmd_link_delete(cmd);
     
     if (ret != ESP_OK) {
@@ -118,7 +125,9 @@ esp_err_t lux_sensor_read(uint16_t *lux) {
     i2c_master_read_byte(cmd, &data_high, I2C_MASTER_NACK);
     i2c_master_stop(cmd);
     
+    pm_policy_acquire(PM_SITE_I2C);
     ret = i2c_master_cmd_begin(s_i2c_port, cmd, pdMS_TO_TICKS(1000));
+    pm_policy_release(PM_SITE_I2C);
     i2c_cmd_link_delete(cmd);
     
     if (ret != ESP_OK) {
@@ -5,6 +5,7 @@
 
 #include "sht3x_driver.h"
 #include "esp_log.h"
+#include "pm_policy.h"
 #include "esp_random.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -74,7 +75,9 @@ esp_err_t sht3x_read(float *temperature, float *humidity) {
     i2c_master_write(cmd_handle, cmd, 2, true);
     i2c_master_stop(cmd_handle);
     
+    pm_policy_acquire(PM_SITE_I2C);
     esp_err_t ret = i2c_master_cmd_begin(s_i2c_port, cmd_handle, pdMS_TO_TICKS(1000));
+    pm_policy_release(PM_SITE_I2C);
     i2c_cmd_link_delete(cmd_handle);
     
     if (ret != ESP_OK) {
@@ -93,7 +96,9 @@ esp_err_t sht3x_read(float *temperature, float *humidity) {
     i2c_master_read(cmd_handle, data, 6, I2C_MASTER_LAST_NACK);
     i2c_master_stop(cmd_handle);
     
+    pm_policy_acquire(PM_SITE_I2C);
     ret = i2c_master_cmd_begin(s_i2c_port, cmd_handle, pdMS_TO_TICKS(1000));
+    pm_policy_release(PM_SITE_I2C);
     i2c_cmd_link_delete(cmd_handle);
     
     if (ret != ESP_OK) {
@@ -127,7 +132,9 @@ esp_err_t sht3x_soft_reset(void) {
     i2c_master_write(cmd_handle, cmd, 2, true);
     i2c_master_stop(cmd_handle);
     
+    pm_policy_acquire(PM_SITE_I2C);
     esp_err_t ret = i2c_master_cmd_begin(s_i2c_port, cmd_handle, pdMS_TO_TICKS(1000));
+    pm_policy_release(PM_SITE_I2C);
     i2c_cmd_link_delete(cmd_handle);
 
     return ret;
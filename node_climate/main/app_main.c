@@ -16,6 +16,11 @@
 // Common компоненты
 #include "mesh_manager.h"
 #include "mesh_protocol.h"
+#include "rate_hint.h"
+#include "event_bus.h"
+#include "mesh_time.h"
+#include "instrumentation.h"
+#include "pm_policy.h"
 #include "node_config.h"
 #include "mesh_config.h"  // Централизованная конфигурация
 
@@ -46,13 +51,20 @@ static void on_mesh_data_received(const uint8_t *src, const uint8_t *data, size_
         return;
     }
 
+    // Подсказка темпа рассылается всем узлам - до проверки адресата
+    if (rate_hint_handle_message(&msg)) {
+        mesh_protocol_free_message(&msg);
+        return;
+    }
+
     // Проверка что сообщение для нас
-    if (strcmp(msg.node_id, g_config.base.node_id) != 0) {
+    if (!mesh_protocol_is_for_node(&msg, g_config.base.node_id)) {
         mesh_protocol_free_message(&msg);
         return;
     }
 
     ESP_LOGI(TAG, "Message from ROOT: type=%d", msg.type);
+    event_bus_publish_message(&msg);
 
     // Обработка по типу сообщения
     switch (msg.type) {
@@ -95,6 +107,7 @@ void app_main(void) {
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    pm_policy_init();          // DFS и light sleep (если включено в Kconfig)
 
     // === Шаг 2: Загрузка конфигурации ===
     ESP_LOGI(TAG, "[Step 2/7] Loading configuration...");
@@ -178,6 +191,7 @@ void app_main(void) {
         .router_bssid = NULL
     };
     ESP_ERROR_CHECK(mesh_manager_init(&mesh_config));
+    mesh_time_init(false);     // Часы ROOT по маякам (если включено в Kconfig)
     mesh_manager_register_recv_cb(on_mesh_data_received);
     ESP_ERROR_CHECK(mesh_manager_start());
     ESP_LOGI(TAG, "Mesh started");
@@ -189,6 +203,7 @@ void app_main(void) {
     // === Шаг 7: Запуск главной задачи ===
     ESP_LOGI(TAG, "[Step 7/7] Starting Climate Controller...");
     ESP_ERROR_CHECK(climate_controller_start());
+    instrumentation_start();   // CPU/стек задач в heartbeat (если включено в Kconfig)
 
     ESP_LOGI(TAG, "========================================");
     ESP_LOGI(TAG, "=== NODE Climate Running ===");
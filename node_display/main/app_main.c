@@ -10,6 +10,7 @@
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_wifi.h"
+#include "esp_attr.h"
 #include "nvs_flash.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -17,6 +18,13 @@
 
 #include "../../common/mesh_manager/mesh_manager.h"
 #include "../../common/mesh_protocol/mesh_protocol.h"
+#include "../../common/rate_hint/rate_hint.h"
+#include "../../common/instrumentation/instrumentation.h"
+#include "../../common/mem_policy/mem_policy.h"
+#include "../../common/pm_policy/pm_policy.h"
+#include "../../common/rtos_static/rtos_static.h"
+#include "../../common/event_bus/event_bus.h"
+#include "../../common/mesh_time/mesh_time.h"
 #include "../../common/node_config/node_config.h"
 #include "../../common/mesh_config/mesh_config.h"
 
@@ -67,9 +75,14 @@ typedef struct {
 } cached_node_t;
 
 #define MAX_CACHED_NODES 10
-static cached_node_t s_nodes_cache[MAX_CACHED_NODES];
+// ~5.6 KB, обновляется раз в 5 сек - в PSRAM, внутренняя RAM остаётся Wi-Fi/mesh и DMA LCD
+EXT_RAM_BSS_ATTR static cached_node_t s_nodes_cache[MAX_CACHED_NODES];
 static int s_cache_count = 0;
 static SemaphoreHandle_t s_cache_mutex;
+RTOS_STATIC_MUTEX(cache_mutex);
+RTOS_STATIC_TASK(request, 4096);
+RTOS_STATIC_TASK(heartbeat, 4096);
+RTOS_STATIC_TASK(display, 6144);
 
 // ════════════════════════════════════════════════════════
 // ПРОТОТИПЫ ФУНКЦИЙ
@@ -131,8 +144,15 @@ static void on_mesh_data_received(const uint8_t *src, const uint8_t *data, size_
         return;
     }
     
+    // Подсказка темпа рассылается всем узлам - до проверки адресата
+    if (rate_hint_handle_message(&msg)) {
+        mesh_protocol_free_message(&msg);
+        free(data_copy);
+        return;
+    }
+
     // Проверка адресата
-    if (strcmp(msg.node_id, s_config.base.node_id) != 0) {
+    if (!mesh_protocol_is_for_node(&msg, s_config.base.node_id)) {
         ESP_LOGD(TAG, "Message not for us (for %s)", msg.node_id);
         free(data_copy);
         mesh_protocol_free_message(&msg);
@@ -140,6 +160,7 @@ static void on_mesh_data_received(const uint8_t *src, const uint8_t *data, size_
     }
     
     ESP_LOGI(TAG, "✅ Message parsed: type=%d, node_id=%s", msg.type, msg.node_id);
+    event_bus_publish_message(&msg);
     
     switch (msg.type) {
         case MESH_MSG_RESPONSE: {
@@ -277,6 +298,7 @@ static void send_heartbeat(void) {
     cJSON_AddStringToObject(root, "type", "heartbeat");
     cJSON_AddStringToObject(root, "node_id", s_config.base.node_id);
     cJSON_AddStringToObject(root, "node_type", "display");
+    cJSON_AddNumberToObject(root, "seq", mesh_protocol_next_seq());
     
     char mac_str[18];
     snprintf(mac_str, sizeof(mac_str), "%02X:%02X:%02X:%02X:%02X:%02X",
@@ -287,6 +309,8 @@ static void send_heartbeat(void) {
     cJSON_AddNumberToObject(root, "uptime", uptime);
     cJSON_AddNumberToObject(root, "heap_free", heap_free);
     cJSON_AddNumberToObject(root, "rssi_to_parent", rssi);
+    instrumentation_add_to_json(root);
+    pm_policy_add_to_json(root);
     
     char *heartbeat_msg = cJSON_PrintUnformatted(root);
     esp_err_t err = ESP_FAIL;
@@ -312,17 +336,20 @@ static void send_heartbeat(void) {
 static void request_task(void *arg) {
     ESP_LOGI(TAG, "Request task running (every 5 sec)");
     
-    // Ожидание подключения к mesh
-    vTaskDelay(pdMS_TO_TICKS(10000));
-    
     while (1) {
-        if (mesh_manager_is_connected()) {
-            send_request_all_nodes();
-        } else {
+        if (!event_bus_mesh_is_up()) {
+            // Задача спит до MESH_UP вместо опроса раз в интервал
             ESP_LOGW(TAG, "⚠️ Mesh offline - waiting for connection");
+            event_bus_wait_mesh_up(portMAX_DELAY);
+            continue;
+        } else if (rate_hint_is_hold()) {
+            // ROOT перегружен: ответ all_nodes_data самый тяжёлый трафик, показываем кэш
+            ESP_LOGD(TAG, "Request skipped (ROOT rate hint: hold)");
+        } else {
+            send_request_all_nodes();
         }
         
-        vTaskDelay(pdMS_TO_TICKS(s_config.request_interval_ms));
+        vTaskDelay(pdMS_TO_TICKS(rate_hint_scale_interval_ms(s_config.request_interval_ms)));
     }
 }
 
@@ -365,6 +392,10 @@ static void display_task(void *arg) {
         ESP_LOGI(TAG, "║      🌿 HYDRO MESH DASHBOARD (Display)           ║");
         ESP_LOGI(TAG, "╠═══════════════════════════════════════════════════╣");
         ESP_LOGI(TAG, "║  Cached nodes: %d                                 ║", s_cache_count);
+        if (rate_hint_get_level() != MESH_RATE_NORMAL) {
+            ESP_LOGI(TAG, "║  ⏸ ROOT rate hint: %s (data may be stale)", 
+                     mesh_protocol_rate_level_to_str(rate_hint_get_level()));
+        }
         ESP_LOGI(TAG, "╠═══════════════════════════════════════════════════╣");
         
         if (s_cache_count == 0) {
@@ -411,6 +442,7 @@ void app_main(void) {
     // === Шаг 1: NVS ===
     ESP_LOGI(TAG, "[Step 1/6] Initializing NVS...");
     ESP_ERROR_CHECK(nvs_flash_init());
+    pm_policy_init();          // DFS и light sleep (если включено в Kconfig)
 
     // === Шаг 2: Загрузка конфигурации ===
     ESP_LOGI(TAG, "[Step 2/6] Loading configuration...");
@@ -428,12 +460,13 @@ void app_main(void) {
     
     // === Шаг 3: Создание мьютекса кэша ===
     ESP_LOGI(TAG, "[Step 3/6] Initializing cache...");
-    s_cache_mutex = xSemaphoreCreateMutex();
+    s_cache_mutex = rtos_static_mutex_create(&cache_mutex);
     if (!s_cache_mutex) {
         ESP_LOGE(TAG, "Failed to create cache mutex");
         return;
     }
     ESP_LOGI(TAG, "Cache mutex created");
+    mem_policy_track_static("nodes_cache", s_nodes_cache, sizeof(s_nodes_cache));
     
     // === Шаг 4: TODO - LCD init ===
     ESP_LOGI(TAG, "[Step 4/6] Initializing LCD... (TODO)");
@@ -462,6 +495,7 @@ void app_main(void) {
         .router_bssid = NULL
     };
     ESP_ERROR_CHECK(mesh_manager_init(&mesh_config));
+    mesh_time_init(false);     // Часы ROOT по маякам (если включено в Kconfig)
     mesh_manager_register_recv_cb(on_mesh_data_received);
     ESP_ERROR_CHECK(mesh_manager_start());
     ESP_LOGI(TAG, "Mesh started");
@@ -469,15 +503,21 @@ void app_main(void) {
     // === Шаг 7: Запуск задач ===
     ESP_LOGI(TAG, "[Step 7/7] Starting tasks...");
     
-    xTaskCreate(request_task, "request", 4096, NULL, 5, NULL);
+    rtos_static_task_create(&request, request_task, "request", NULL, 5, NULL);
     ESP_LOGI(TAG, "  - Request task started");
     
-    xTaskCreate(heartbeat_task, "heartbeat", 4096, NULL, 4, NULL);
+    rtos_static_task_create(&heartbeat, heartbeat_task, "heartbeat", NULL, 4, NULL);
     ESP_LOGI(TAG, "  - Heartbeat task started");
     
-    xTaskCreate(display_task, "display", 6144, NULL, 6, NULL);
+    rtos_static_task_create(&display, display_task, "display", NULL, 6, NULL);
     ESP_LOGI(TAG, "  - Display task started (console dashboard)");
     
+    if (instrumentation_start() == ESP_OK) {
+        ESP_LOGI(TAG, "  - Instrumentation task started");
+    }
+    
+    mem_policy_report();
+    
     ESP_LOGI(TAG, "========================================");
     ESP_LOGI(TAG, "=== NODE Display Running ===");
     ESP_LOGI(TAG, "Node ID: %s", s_config.base.node_id);
@@ -6,16 +6,22 @@
 #include "ec_manager.h"
 #include "ec_sensor.h"
 #include "pump_controller.h"
-#include "pid_controller.h"
-#include "adaptive_pid.h"
+#include "dosing_engine.h"
 #include "mesh_manager.h"
 #include "mesh_protocol.h"
+#include "rate_hint.h"
+#include "instrumentation.h"
+#include "local_storage.h"
+#include "cjson_arena.h"
+#include "pm_policy.h"
+#include "event_bus.h"
 
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_wifi.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "rtos_static.h"
 #include "cJSON.h"
 #include <string.h>
 #include <time.h>
@@ -27,13 +33,16 @@ static const char *TAG = "ec_mgr";
 static ec_node_config_t *s_config = NULL;
 static TaskHandle_t s_main_task = NULL;
 static TaskHandle_t s_heartbeat_task = NULL;
+RTOS_STATIC_TASK(ec_main, 6144);
+RTOS_STATIC_TASK(ec_heartbeat, 3072);
 static bool s_discovery_sent = false;
 static uint32_t s_boot_time = 0;
 static bool s_emergency_mode = false;
 static bool s_autonomous_mode = false;
 
-// Адаптивный PID контроллер (один для всех насосов EC)
-static adaptive_pid_t s_pid_ec;
+// Арены cJSON задач (NULL - выключено в Kconfig)
+static cjson_arena_t *s_main_arena = NULL;
+static cjson_arena_t *s_heartbeat_arena = NULL;
 
 // Текущее значение
 static float s_current_ec = 2.0f;
@@ -44,9 +53,12 @@ static void heartbeat_task(void *arg);
 static void send_discovery(void);
 static void send_telemetry(void);
 static void send_heartbeat(void);
+static cJSON *take_held_summary(void);
+static void send_event(mesh_event_level_t level, const char *message, float value);
 static int8_t get_rssi_to_parent(void);
 static void read_sensor(void);
 static void control_ec(void);
+static void report_autotune(void);
 static void check_emergency_conditions(void);
 
 esp_err_t ec_manager_init(ec_node_config_t *config) {
@@ -61,20 +73,11 @@ esp_err_t ec_manager_init(ec_node_config_t *config) {
     s_emergency_mode = false;
     s_autonomous_mode = false;
     
-    // Инициализация адаптивного PID контроллера для EC
-    adaptive_pid_init(&s_pid_ec, s_config->ec_target,
-                     s_config->pump_pid[PUMP_EC_A].kp, 
-                     s_config->pump_pid[PUMP_EC_A].ki, 
-                     s_config->pump_pid[PUMP_EC_A].kd);
+    // Буфер показаний на время HOLD от ROOT
+    local_storage_init();
     
-    // Настройка зон для EC (dead=0.2, close=0.5, far=1.5)
-    adaptive_pid_set_zones(&s_pid_ec, 0.2f, 0.5f, 1.5f);
-    
-    // Safety: макс 10 мл за раз, минимум 60 сек между дозами
-    adaptive_pid_set_safety(&s_pid_ec, 10.0f, 60000);
-    
-    // Лимиты выхода
-    adaptive_pid_set_output_limits(&s_pid_ec, 0.0f, 10.0f);
+    // Контур EC (A/B/C): зоны, safety и доли насосов - в таблице dosing_engine
+    dosing_engine_init(&s_config->ec_target, s_config->pump_pid);
     
     ESP_LOGI(TAG, "EC Manager initialized");
     ESP_LOGI(TAG, "Node ID: %s, EC target: %.2f", 
@@ -89,15 +92,21 @@ esp_err_t ec_manager_start(void) {
         return ESP_OK;
     }
     
+    // Арены создаются один раз - буферы не освобождаются
+    if (s_main_arena == NULL) {
+        s_main_arena = cjson_arena_create("main", CJSON_ARENA_DEFAULT_SIZE);
+        s_heartbeat_arena = cjson_arena_create("heartbeat", CJSON_ARENA_DEFAULT_SIZE);
+    }
+    
     // Запуск главной задачи
-    BaseType_t ret = xTaskCreate(main_task, "EC_main", 6144, NULL, 5, &s_main_task);
+    BaseType_t ret = rtos_static_task_create(&ec_main, main_task, "EC_main", NULL, 5, &s_main_task);
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create main task");
         return ESP_FAIL;
     }
     
     // Запуск heartbeat задачи
-    ret = xTaskCreate(heartbeat_task, "heartbeat", 3072, NULL, 4, &s_heartbeat_task);
+    ret = rtos_static_task_create(&ec_heartbeat, heartbeat_task, "heartbeat", NULL, 4, &s_heartbeat_task);
     if (ret != pdPASS) {
         ESP_LOGW(TAG, "Failed to create heartbeat task");
     }
@@ -108,6 +117,7 @@ esp_err_t ec_manager_start(void) {
 
 esp_err_t ec_manager_stop(void) {
     if (s_main_task != NULL) {
+        event_bus_unsubscribe_task(s_main_task);
         vTaskDelete(s_main_task);
         s_main_task = NULL;
     }
@@ -129,15 +139,21 @@ esp_err_t ec_manager_get_value(float *EC) {
 }
 
 esp_err_t ec_manager_set_emergency(bool enable) {
+    bool changed = (enable != s_emergency_mode);
     s_emergency_mode = enable;
     
     if (enable) {
         ESP_LOGW(TAG, "EMERGENCY MODE ACTIVATED");
         pump_controller_emergency_stop();
+        dosing_engine_autotune_stop(DOSING_LOOP_EC);
     } else {
         ESP_LOGI(TAG, "Emergency mode deactivated");
     }
     
+    if (changed) {
+        event_bus_publish_emergency(enable, TAG);
+    }
+    
     return ESP_OK;
 }
 
@@ -145,17 +161,25 @@ esp_err_t ec_manager_set_emergency(bool enable) {
 static void main_task(void *arg) {
     ESP_LOGI(TAG, "Main task started");
     
-    // Ждём подключения к mesh
-    vTaskDelay(pdMS_TO_TICKS(3000));
-    
-    // Отправка discovery при старте
-    send_discovery();
-    s_discovery_sent = true;
+    // Discovery - при старте и после каждого переподключения к mesh:
+    // задача просыпается по MESH_UP, а не ждёт фиксированную паузу
+    event_bus_subscribe_task(EVENT_BUS_BIT(EVENT_BUS_MESH_UP), EVENT_BUS_MSG_ALL,
+                             xTaskGetCurrentTaskHandle());
+    bool discovery_pending = true;
     
     TickType_t last_telemetry = 0;
     TickType_t last_control = 0;
+    bool was_hold = false;
     
     while (1) {
+        if (discovery_pending && event_bus_mesh_is_up()) {
+            cjson_arena_begin(s_main_arena);
+            send_discovery();
+            cjson_arena_end(s_main_arena, "discovery");
+            s_discovery_sent = true;
+            discovery_pending = false;
+        }
+        
         TickType_t now = xTaskGetTickCount();
         
         // Чтение датчика каждые 10 секунд
@@ -170,13 +194,25 @@ static void main_task(void *arg) {
             last_control = now;
         }
         
-        // Отправка telemetry каждые 30 секунд
-        if (now - last_telemetry >= pdMS_TO_TICKS(30000)) {
-            send_telemetry();
+        // Отправка telemetry каждые 30 секунд (реже по подсказке ROOT).
+        // В HOLD показания копятся локально, сводка уходит сразу после снятия
+        bool hold = rate_hint_is_hold();
+        if (now - last_telemetry >= pdMS_TO_TICKS(rate_hint_scale_interval_ms(30000)) ||
+            (was_hold && !hold)) {
+            if (hold) {
+                local_storage_add(0.0f, s_current_ec, 0.0f);
+            } else {
+                cjson_arena_begin(s_main_arena);
+                send_telemetry();
+                cjson_arena_end(s_main_arena, "telemetry");
+            }
             last_telemetry = now;
         }
+        was_hold = hold;
         
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        if (event_bus_task_wait(pdMS_TO_TICKS(1000)) & EVENT_BUS_BIT(EVENT_BUS_MESH_UP)) {
+            discovery_pending = true;
+        }
     }
 }
 
@@ -186,7 +222,9 @@ static void heartbeat_task(void *arg) {
     
     while (1) {
         vTaskDelay(pdMS_TO_TICKS(60000)); // Каждую минуту
+        cjson_arena_begin(s_heartbeat_arena);
         send_heartbeat();
+        cjson_arena_end(s_heartbeat_arena, "heartbeat");
     }
 }
 
@@ -240,7 +278,7 @@ static void send_discovery(void) {
     if (json_str) {
         mesh_manager_send_to_root((uint8_t *)json_str, strlen(json_str));
         ESP_LOGI(TAG, "Discovery sent: %s", json_str);
-        free(json_str);
+        cJSON_free(json_str);
     }
     
     cJSON_Delete(root);
@@ -263,6 +301,7 @@ static void send_telemetry(void) {
     cJSON_AddStringToObject(root, "type", "telemetry");
     cJSON_AddStringToObject(root, "node_id", s_config->base.node_id);
     cJSON_AddStringToObject(root, "node_type", "ec");  // ВАЖНО: тип узла для backend
+    cJSON_AddNumberToObject(root, "seq", mesh_protocol_next_seq());
     
     cJSON *data = cJSON_CreateObject();
     if (!data) {
@@ -279,18 +318,62 @@ static void send_telemetry(void) {
     cJSON_AddNumberToObject(data, "rssi_to_parent", get_rssi_to_parent());
     cJSON_AddBoolToObject(data, "emergency", s_emergency_mode);
     cJSON_AddBoolToObject(data, "autonomous", s_autonomous_mode);
+    
+    cJSON *held = take_held_summary();
+    if (held) {
+        cJSON_AddItemToObject(data, "held", held);
+    }
     cJSON_AddItemToObject(root, "data", data);
     
     char *json_str = cJSON_PrintUnformatted(root);
     if (json_str) {
         mesh_manager_send_to_root((uint8_t *)json_str, strlen(json_str));
         ESP_LOGD(TAG, "Telemetry sent");
-        free(json_str);
+        cJSON_free(json_str);
     }
     
     cJSON_Delete(root);
 }
 
+// Сводка показаний, накопленных в local_storage за время HOLD.
+// Одно поле в очередной telemetry вместо пачки сообщений после перегрузки
+static cJSON *take_held_summary(void) {
+    storage_entry_t entry;
+    int count = 0;
+    float min = 0.0f, max = 0.0f, sum = 0.0f;
+    uint64_t first_ts = 0;
+
+    for (int i = 0; i < BUFFER_SIZE && local_storage_get_next_unsynced(&entry); i++) {
+        if (count == 0) {
+            min = max = entry.ec;
+            first_ts = entry.timestamp;
+        }
+        min = fminf(min, entry.ec);
+        max = fmaxf(max, entry.ec);
+        sum += entry.ec;
+        count++;
+        local_storage_mark_synced(entry.timestamp);
+    }
+
+    if (count == 0) {
+        return NULL;
+    }
+    local_storage_clear_synced();
+
+    cJSON *held = cJSON_CreateObject();
+    if (held == NULL) {
+        return NULL;
+    }
+    cJSON_AddNumberToObject(held, "count", count);
+    cJSON_AddNumberToObject(held, "ec_min", min);
+    cJSON_AddNumberToObject(held, "ec_max", max);
+    cJSON_AddNumberToObject(held, "ec_mean", sum / count);
+    cJSON_AddNumberToObject(held, "duration_s", (double)((uint64_t)time(NULL) - first_ts));
+
+    ESP_LOGI(TAG, "Held samples flushed: %d", count);
+    return held;
+}
+
 // Отправка heartbeat
 static void send_heartbeat(void) {
     if (!mesh_manager_is_connected()) {
@@ -305,14 +388,18 @@ static void send_heartbeat(void) {
     cJSON_AddStringToObject(root, "type", "heartbeat");
     cJSON_AddStringToObject(root, "node_id", s_config->base.node_id);
     cJSON_AddStringToObject(root, "node_type", "ec");  // ВАЖНО: тип узла для backend
+    cJSON_AddNumberToObject(root, "seq", mesh_protocol_next_seq());
     cJSON_AddNumberToObject(root, "uptime", (uint32_t)time(NULL) - s_boot_time);
     cJSON_AddNumberToObject(root, "heap_free", esp_get_free_heap_size());
     cJSON_AddBoolToObject(root, "autonomous", s_autonomous_mode);
+    instrumentation_add_to_json(root);
+    cjson_arena_add_to_json(root, false);
+    pm_policy_add_to_json(root);
     
     char *json_str = cJSON_PrintUnformatted(root);
     if (json_str) {
         mesh_manager_send_to_root((uint8_t *)json_str, strlen(json_str));
-        free(json_str);
+        cJSON_free(json_str);
     }
     
     cJSON_Delete(root);
@@ -331,44 +418,54 @@ static void read_sensor(void) {
     }
 }
 
-// Управление EC (распределение по 3 насосам)
+// Управление EC: A 50% / B 40% / C 10% последовательно (dosing_engine)
 static void control_ec(void) {
-    float output = 0.0f;
-    esp_err_t err;
+    // Вызов и выше цели: во время автонастройки дозами управляет реле
+    dosing_result_t result;
+    dosing_engine_control(DOSING_LOOP_EC, s_current_ec, 10.0f, &result);
     
-    // Если EC < target - нужно повысить
-    if (s_current_ec < s_config->ec_target) {
-        err = adaptive_pid_compute(&s_pid_ec, s_current_ec, 10.0f, &output);
-        
-        if (err == ESP_OK && output > 0.0f) {
-            // Распределение по 3 насосам: A = 50%, B = 40%, C = 10%
-            float dose_a = output * 0.5f;
-            float dose_b = output * 0.4f;
-            float dose_c = output * 0.1f;
-            
-            pid_zone_t zone = adaptive_pid_get_zone(&s_pid_ec);
-            ESP_LOGI(TAG, "EC: %.2f ml [%s zone] (A:%.2f B:%.2f C:%.2f) current=%.2f target=%.2f", 
-                     output, adaptive_pid_zone_to_str(zone), dose_a, dose_b, dose_c, 
-                     s_current_ec, s_config->ec_target);
-            
-            // Запуск всех 3 насосов последовательно
-            pump_controller_run_dose(PUMP_EC_A, dose_a);
-            vTaskDelay(pdMS_TO_TICKS(100)); // Небольшая задержка между насосами
-            pump_controller_run_dose(PUMP_EC_B, dose_b);
-            vTaskDelay(pdMS_TO_TICKS(100));
-            pump_controller_run_dose(PUMP_EC_C, dose_c);
-            
-            // Отправка события при коррекции в FAR зоне
-            if (zone == ZONE_FAR) {
-                send_event(MESH_EVENT_WARNING, "EC far from target, aggressive correction", s_current_ec);
-            }
-        }
+    // Отправка события при коррекции в FAR зоне
+    if (result.dir != DOSING_NONE && result.zone == ZONE_FAR) {
+        send_event(MESH_EVENT_WARNING, "EC far from target, aggressive correction", s_current_ec);
     }
     // Если EC > target - только логирование (EC не понижается насосами)
-    else {
+    if (result.dir == DOSING_NONE && s_current_ec > s_config->ec_target) {
         ESP_LOGD(TAG, "EC above target (%.2f > %.2f), waiting for dilution", 
                  s_current_ec, s_config->ec_target);
     }
+    
+    report_autotune();
+}
+
+// Ход автонастройки: событие на каждое колебание, результат - в NVS
+static void report_autotune(void) {
+    dosing_autotune_t at;
+    if (!dosing_engine_autotune_poll(DOSING_LOOP_EC, &at)) {
+        return;
+    }
+    
+    char msg[96];
+    switch (at.state) {
+        case DOSING_AUTOTUNE_RUNNING:
+            snprintf(msg, sizeof(msg), "EC autotune: cycle %d/%d", at.cycles, at.cycles_needed);
+            send_event(MESH_EVENT_INFO, msg, s_current_ec);
+            break;
+        case DOSING_AUTOTUNE_DONE:
+            dosing_engine_autotune_apply(DOSING_LOOP_EC, s_config->pump_pid);
+            if (node_config_save(s_config, sizeof(ec_node_config_t), "ec_ns") != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to save autotune result to NVS");
+            }
+            snprintf(msg, sizeof(msg), "EC autotune done: Ku=%.2f Pu=%.0fs Kp=%.3f Ki=%.4f",
+                     at.ku, at.pu_s, at.close.kp, at.close.ki);
+            send_event(MESH_EVENT_INFO, msg, s_current_ec);
+            break;
+        case DOSING_AUTOTUNE_FAILED:
+            snprintf(msg, sizeof(msg), "EC autotune failed: %s", at.error);
+            send_event(MESH_EVENT_WARNING, msg, s_current_ec);
+            break;
+        default:
+            break;
+    }
 }
 
 // Отправка event сообщения
@@ -385,6 +482,7 @@ static void send_event(mesh_event_level_t level, const char *message, float valu
     cJSON_AddStringToObject(root, "type", "event");
     cJSON_AddStringToObject(root, "node_id", s_config->base.node_id);
     cJSON_AddStringToObject(root, "node_type", "ec");
+    cJSON_AddNumberToObject(root, "seq", mesh_protocol_next_seq());
     cJSON_AddStringToObject(root, "level", mesh_protocol_event_level_to_str(level));
     cJSON_AddStringToObject(root, "message", message);
     cJSON_AddNumberToObject(root, "timestamp", (uint32_t)time(NULL));
@@ -400,7 +498,7 @@ static void send_event(mesh_event_level_t level, const char *message, float valu
     if (json_str) {
         mesh_manager_send_to_root((uint8_t *)json_str, strlen(json_str));
         ESP_LOGI(TAG, "Event sent: %s - %s", mesh_protocol_event_level_to_str(level), message);
-        free(json_str);
+        cJSON_free(json_str);
     }
     
     cJSON_Delete(root);
@@ -457,7 +555,7 @@ void ec_manager_handle_command(const char *command, cJSON *params) {
             }
             
             s_config->ec_target = new_target;
-            adaptive_pid_set_setpoint(&s_pid_ec, s_config->ec_target);
+            dosing_engine_set_target(DOSING_LOOP_EC, s_config->ec_target);
             
             // ВАЖНО: Сохранение в NVS!
             esp_err_t err = node_config_save(s_config, sizeof(ec_node_config_t), "ec_ns");
@@ -488,6 +586,34 @@ void ec_manager_handle_command(const char *command, cJSON *params) {
             }
         }
     }
+    else if (strcmp(command, "autotune") == 0) {
+        // Релейная автонастройка: {"dose_ml": 1.0, "cycles": 4} или {"action": "stop"}.
+        // EC без насоса понижения: колебания дают потребление растениями
+        cJSON *action = cJSON_GetObjectItem(params, "action");
+        if (cJSON_IsString(action) && strcmp(action->valuestring, "stop") == 0) {
+            dosing_engine_autotune_stop(DOSING_LOOP_EC);
+            return;
+        }
+        if (s_emergency_mode) {
+            ESP_LOGW(TAG, "Autotune blocked: EMERGENCY mode active");
+            return;
+        }
+        
+        cJSON *dose = cJSON_GetObjectItem(params, "dose_ml");
+        cJSON *cycles = cJSON_GetObjectItem(params, "cycles");
+        esp_err_t err = dosing_engine_autotune_start(DOSING_LOOP_EC,
+                                                     cJSON_IsNumber(dose) ? (float)dose->valuedouble : 0.0f,
+                                                     cJSON_IsNumber(cycles) ? (uint8_t)cycles->valueint : 0,
+                                                     s_config->pump_calibration);
+        if (err == ESP_OK) {
+            send_event(MESH_EVENT_INFO, "EC autotune started", s_current_ec);
+        } else {
+            ESP_LOGW(TAG, "Autotune not started: %s", esp_err_to_name(err));
+            send_event(MESH_EVENT_WARNING, err == ESP_ERR_INVALID_STATE ?
+                       "EC autotune rejected: running or pumps not calibrated" :
+                       "EC autotune rejected: invalid params", s_current_ec);
+        }
+    }
     else if (strcmp(command, "reset_stats") == 0) {
         pump_controller_reset_stats(PUMP_EC_A);
         pump_controller_reset_stats(PUMP_EC_B);
@@ -646,7 +772,7 @@ void ec_manager_handle_command(const char *command, cJSON *params) {
             } else {
                 ESP_LOGE(TAG, "Failed to send config: %s", esp_err_to_name(err));
             }
-            free(json_str);
+            cJSON_free(json_str);
         } else {
             ESP_LOGE(TAG, "Failed to serialize config JSON");
         }
@@ -670,7 +796,7 @@ void ec_manager_handle_config_update(cJSON *config_json) {
         float new_target = (float)ec_target->valuedouble;
         if (new_target >= 0.5f && new_target <= 5.0f) {
             s_config->ec_target = new_target;
-            adaptive_pid_set_setpoint(&s_pid_ec, s_config->ec_target);
+            dosing_engine_set_target(DOSING_LOOP_EC, s_config->ec_target);
             config_changed = true;
             ESP_LOGI(TAG, "EC target updated: %.2f", s_config->ec_target);
         }
@@ -715,8 +841,7 @@ void ec_manager_handle_config_update(cJSON *config_json) {
             s_config->pump_pid[2].kd = (float)kd->valuedouble;
             
             // Переинициализация PID
-            pid_init(&s_pid_ec, s_config->pump_pid[0].kp, 
-                     s_config->pump_pid[0].ki, s_config->pump_pid[0].kd);
+            dosing_engine_init(&s_config->ec_target, s_config->pump_pid);
             
             config_changed = true;
             ESP_LOGI(TAG, "PID params updated: Kp=%.2f Ki=%.2f Kd=%.2f", 
@@ -726,6 +851,7 @@ void ec_manager_handle_config_update(cJSON *config_json) {
     
     // ВАЖНО: Сохранение в NVS
     if (config_changed) {
+        event_bus_publish_config_changed("mesh");
         esp_err_t err = node_config_save(s_config, sizeof(ec_node_config_t), "ec_ns");
         if (err == ESP_OK) {
             ESP_LOGI(TAG, "Configuration saved to NVS");
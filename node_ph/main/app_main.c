@@ -19,6 +19,13 @@
 // Common компоненты
 #include "mesh_manager.h"
 #include "mesh_protocol.h"
+#include "rate_hint.h"
+#include "event_bus.h"
+#include "mesh_time.h"
+#include "instrumentation.h"
+#include "dlog.h"
+#include "cjson_arena.h"
+#include "pm_policy.h"
 #include "node_config.h"
 #include "mesh_config.h"
 
@@ -41,10 +48,14 @@ static const char *TAG = "ph_node";
 // Конфигурация узла
 static ph_node_config_t s_node_config;
 
+// Арена cJSON задачи приёма mesh (NULL - выключено в Kconfig)
+static cjson_arena_t *s_rx_arena = NULL;
+
 // Forward declarations
 static esp_err_t i2c_master_init(void);
 static void init_default_config(void);
 static void on_mesh_data_received(const uint8_t *src, const uint8_t *data, size_t len);
+static mesh_msg_type_t process_mesh_data(const uint8_t *data, size_t len);
 
 void app_main(void)
 {
@@ -61,6 +72,7 @@ void app_main(void)
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    pm_policy_init();          // DFS и light sleep (если включено в Kconfig)
     
     // [Step 2/8] Загрузка конфигурации
     ESP_LOGI(TAG, "[Step 2/8] Loading config...");
@@ -107,8 +119,11 @@ void app_main(void)
     
     ESP_ERROR_CHECK(mesh_manager_init(&mesh_config));
     ESP_LOGI(TAG, "  Mesh ID: %s", mesh_config.mesh_id);
+    mesh_time_init(false);     // Часы ROOT по маякам (если включено в Kconfig)
     
     // Регистрация callback для команд от ROOT
+    cjson_arena_install();     // cJSON сообщений - из арен задач (если включено в Kconfig)
+    s_rx_arena = cjson_arena_create("mesh_rx", CJSON_ARENA_DEFAULT_SIZE);
     mesh_manager_register_recv_cb(on_mesh_data_received);
     
     // [Step 7/8] pH Manager init
@@ -119,6 +134,8 @@ void app_main(void)
     ESP_LOGI(TAG, "[Step 8/8] Starting...");
     ESP_ERROR_CHECK(mesh_manager_start());
     ESP_ERROR_CHECK(ph_manager_start());
+    instrumentation_start();   // CPU/стек задач в heartbeat (если включено в Kconfig)
+    dlog_init();               // Отложенный вывод логов насосов (если включён в Kconfig)
     
     ESP_LOGI(TAG, "╔════════════════════════════════════════╗");
     ESP_LOGI(TAG, "║  NODE pH Running! ✓                    ║");
@@ -208,11 +225,18 @@ static void init_default_config(void) {
  * @brief Callback при получении данных от ROOT
  */
 static void on_mesh_data_received(const uint8_t *src, const uint8_t *data, size_t len) {
+    // Все выделения cJSON сообщения - из арены, освобождаются одним сбросом
+    cjson_arena_begin(s_rx_arena);
+    mesh_msg_type_t type = process_mesh_data(data, len);
+    cjson_arena_end(s_rx_arena, mesh_protocol_msg_type_to_str(type));
+}
+
+static mesh_msg_type_t process_mesh_data(const uint8_t *data, size_t len) {
     // Создаём NULL-terminated копию
     char *data_copy = malloc(len + 1);
     if (data_copy == NULL) {
         ESP_LOGE(TAG, "Failed to allocate memory for data copy");
-        return;
+        return MESH_MSG_UNKNOWN;
     }
     memcpy(data_copy, data, len);
     data_copy[len] = '\0';
@@ -226,21 +250,29 @@ static void on_mesh_data_received(const uint8_t *src, const uint8_t *data, size_
     if (!mesh_protocol_parse(data_copy, &msg)) {
         ESP_LOGE(TAG, "Failed to parse mesh message");
         free(data_copy);
-        return;
+        return MESH_MSG_UNKNOWN;
     }
     
     ESP_LOGI(TAG, "JSON parsed successfully");
     ESP_LOGI(TAG, "Message type: %d", msg.type);
     ESP_LOGI(TAG, "Node ID: %s", msg.node_id);
 
+    // Подсказка темпа рассылается всем узлам - до проверки адресата
+    if (rate_hint_handle_message(&msg)) {
+        mesh_protocol_free_message(&msg);
+        free(data_copy);
+        return msg.type;
+    }
+
     // Проверка что сообщение для нас
-    if (strcmp(msg.node_id, s_node_config.base.node_id) != 0) {
+    if (!mesh_protocol_is_for_node(&msg, s_node_config.base.node_id)) {
         mesh_protocol_free_message(&msg);
         free(data_copy);
-        return;
+        return msg.type;
     }
 
     ESP_LOGI(TAG, "Message from ROOT: type=%d", msg.type);
+    event_bus_publish_message(&msg);
 
     // Обработка по типу сообщения
     switch (msg.type) {
@@ -251,7 +283,7 @@ static void on_mesh_data_received(const uint8_t *src, const uint8_t *data, size_
             if (msg.data) {
                 char *data_str = cJSON_PrintUnformatted(msg.data);
                 ESP_LOGI(TAG, "msg.data content: %s", data_str ? data_str : "NULL");
-                if (data_str) free(data_str);
+                if (data_str) cJSON_free(data_str);
             }
             
             cJSON *cmd = cJSON_GetObjectItem(msg.data, "command");
@@ -282,5 +314,6 @@ static void on_mesh_data_received(const uint8_t *src, const uint8_t *data, size_
 
     mesh_protocol_free_message(&msg);
     free(data_copy);
+    return msg.type;
 }
 
@@ -1,60 +0,0 @@
-/**
- * @file adaptive_pid.c
- * @brief Реализация адаптивного PID (ЗАГЛУШКА)
- * 
- * TODO: Портировать реальную реализацию из hydro1.0/components/adaptive_pid/
- */
-
-#include "adaptive_pid.h"
-#include "esp_log.h"
-
-static const char *TAG = "adaptive_pid";
-
-static ph_ec_node_config_t *s_config = NULL;
-
-esp_err_t adaptive_pid_init(ph_ec_node_config_t *config) {
-    if (!config) {
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    s_config = config;
-
-    ESP_LOGI(TAG, "Adaptive PID initialized (STUB - TODO: port from hydro1.0)");
-    ESP_LOGI(TAG, "pH target: %.2f, EC target: %.2f", 
-             s_config->ph_target, s_config->ec_target);
-    
-    // TODO: Инициализация PID регуляторов
-    // TODO: Загрузка параметров из конфигурации
-    
-    return ESP_OK;
-}
-
-esp_err_t adaptive_pid_update(float ph, float ec) {
-    if (!s_config) {
-        return ESP_FAIL;
-    }
-
-    ESP_LOGD(TAG, "PID update: pH=%.2f (target=%.2f), EC=%.2f (target=%.2f)",
-             ph, s_config->ph_target, ec, s_config->ec_target);
-
-    // TODO: Расчет PID для pH
-    // float ph_error = s_config->ph_target - ph;
-    // float ph_output = pid_calculate(ph_error, ...);
-    
-    // TODO: Расчет PID для EC
-    // float ec_error = s_config->ec_target - ec;
-    // float ec_output = pid_calculate(ec_error, ...);
-    
-    // TODO: Управление насосами через pump_manager
-    // if (ph_output > 0) pump_manager_run(PUMP_PH_UP, duration);
-    // if (ph_output < 0) pump_manager_run(PUMP_PH_DOWN, duration);
-    
-    return ESP_OK;
-}
-
-void adaptive_pid_reset(void) {
-    ESP_LOGI(TAG, "PID reset");
-    
-    // TODO: Сброс интеграторов
-}
-
@@ -1,103 +0,0 @@
-/**
- * @file oled_display.c
- * @brief Реализация OLED дисплея
- * 
- * Простая реализация для SSD1306 128x64
- * TODO: Интегрировать драйвер SSD1306 (можно взять из библиотек ESP-IDF)
- */
-
-#include "oled_display.h"
-#include "esp_log.h"
-#include "driver/i2c.h"
-#include <string.h>
-#include <stdio.h>
-
-static const char *TAG = "oled_display";
-
-#define SSD1306_I2C_ADDR    0x3C
-#define OLED_WIDTH          128
-#define OLED_HEIGHT         64
-
-static int s_i2c_port = -1;
-
-// TODO: Интегрировать полный драйвер SSD1306
-// Сейчас заглушки для структуры кода
-
-esp_err_t oled_display_init(int i2c_port, int sda_gpio, int scl_gpio) {
-    s_i2c_port = i2c_port;
-
-    // Инициализация I2C
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = sda_gpio,
-        .scl_io_num = scl_gpio,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = 400000,
-    };
-    
-    ESP_ERROR_CHECK(i2c_param_config(i2c_port, &conf));
-    ESP_ERROR_CHECK(i2c_driver_install(i2c_port, I2C_MODE_MASTER, 0, 0, 0));
-
-    ESP_LOGI(TAG, "OLED Display initialized (I2C port %d, SDA=%d, SCL=%d)", 
-             i2c_port, sda_gpio, scl_gpio);
-    
-    // TODO: Инициализация SSD1306
-    // - Отправка команд инициализации
-    // - Очистка экрана
-    // - Установка параметров
-    
-    return ESP_OK;
-}
-
-void oled_display_update_main(float ph, float ec, float temp, connection_state_t state) {
-    // TODO: Реальная отрисовка на SSD1306
-    // Сейчас только логирование
-    
-    const char *state_str;
-    switch (state) {
-        case CONN_STATE_ONLINE:     state_str = "ONLINE"; break;
-        case CONN_STATE_DEGRADED:   state_str = "DEGRADED"; break;
-        case CONN_STATE_AUTONOMOUS: state_str = "AUTONOMOUS"; break;
-        case CONN_STATE_EMERGENCY:  state_str = "EMERGENCY"; break;
-        default:                    state_str = "UNKNOWN"; break;
-    }
-    
-    ESP_LOGI(TAG, "Display update: pH=%.2f, EC=%.2f, T=%.1f°C, State=%s",
-             ph, ec, temp, state_str);
-    
-    // TODO: Отрисовка на OLED:
-    // Line 1: "pH/EC Zone 1"
-    // Line 2: "pH: 6.5  EC: 1.8"
-    // Line 3: "● ONLINE" или "⚡ AUTONOMOUS"
-    // Line 4: "24.5°C"
-}
-
-void oled_display_show_pump_stats(uint32_t ph_up_ml, uint32_t ph_down_ml, uint32_t ec_ml) {
-    ESP_LOGI(TAG, "Pump stats: pH↑%d  pH↓%d  EC→%d ml/hour", 
-             ph_up_ml, ph_down_ml, ec_ml);
-    
-    // TODO: Отрисовка статистики насосов
-}
-
-void oled_display_show_emergency(const char *message, float value) {
-    ESP_LOGE(TAG, "EMERGENCY: %s (value: %.2f)", message, value);
-    
-    // TODO: Крупное отображение аварии
-    // - Мигающий текст
-    // - Крупный шрифт
-    // - Значение параметра
-}
-
-void oled_display_show_message(const char *message) {
-    ESP_LOGI(TAG, "Message: %s", message);
-    
-    // TODO: Показать сообщение на 3 секунды
-}
-
-void oled_display_clear(void) {
-    ESP_LOGD(TAG, "Display cleared");
-    
-    // TODO: Очистка дисплея
-}
-
@@ -7,15 +7,17 @@
 #include "ph_sensor.h"
 #include "ec_sensor.h"
 #include "pump_controller.h"
-#include "pid_controller.h"
+#include "dosing_engine.h"
 #include "mesh_manager.h"
 #include "mesh_protocol.h"
+#include "event_bus.h"
 
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_wifi.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "rtos_static.h"
 #include <string.h>
 #include <time.h>
 
@@ -25,16 +27,13 @@ static const char *TAG = "ph_ec_mgr";
 static ph_ec_node_config_t *s_config = NULL;
 static TaskHandle_t s_main_task = NULL;
 static TaskHandle_t s_heartbeat_task = NULL;
+RTOS_STATIC_TASK(ph_ec_main, 6144);
+RTOS_STATIC_TASK(ph_ec_heartbeat, 3072);
 static bool s_discovery_sent = false;
 static uint32_t s_boot_time = 0;
 static bool s_emergency_mode = false;
 static bool s_autonomous_mode = false;
 
-// PID контроллеры
-static pid_controller_t s_pid_ph_up;
-static pid_controller_t s_pid_ph_down;
-static pid_controller_t s_pid_ec;
-
 // Текущие значения
 static float s_current_ph = 7.0f;
 static float s_current_ec = 2.0f;
@@ -49,6 +48,9 @@ static int8_t get_rssi_to_parent(void);
 static void read_sensors(void);
 static void control_ph_ec(void);
 static void check_emergency_conditions(void);
+static void init_dosing(void);
+static void report_autotune(dosing_loop_t loop);
+static void send_event(mesh_event_level_t level, const char *message);
 
 esp_err_t ph_ec_manager_init(ph_ec_node_config_t *config) {
     if (config == NULL) {
@@ -62,24 +64,8 @@ esp_err_t ph_ec_manager_init(ph_ec_node_config_t *config) {
     s_emergency_mode = false;
     s_autonomous_mode = false;
     
-    // Инициализация PID контроллеров с параметрами из конфигурации
-    pid_init(&s_pid_ph_up, s_config->pump_pid[PUMP_PH_UP].kp, 
-             s_config->pump_pid[PUMP_PH_UP].ki, 
-             s_config->pump_pid[PUMP_PH_UP].kd);
-    pid_set_setpoint(&s_pid_ph_up, s_config->ph_target);
-    pid_set_output_limits(&s_pid_ph_up, 0.0f, 5.0f); // Макс 5 мл за раз
-    
-    pid_init(&s_pid_ph_down, s_config->pump_pid[PUMP_PH_DOWN].kp,
-             s_config->pump_pid[PUMP_PH_DOWN].ki,
-             s_config->pump_pid[PUMP_PH_DOWN].kd);
-    pid_set_setpoint(&s_pid_ph_down, s_config->ph_target);
-    pid_set_output_limits(&s_pid_ph_down, 0.0f, 5.0f);
-    
-    pid_init(&s_pid_ec, s_config->pump_pid[PUMP_EC_A].kp,
-             s_config->pump_pid[PUMP_EC_A].ki,
-             s_config->pump_pid[PUMP_EC_A].kd);
-    pid_set_setpoint(&s_pid_ec, s_config->ec_target);
-    pid_set_output_limits(&s_pid_ec, 0.0f, 10.0f);
+    // Контуры pH и EC с коэффициентами из конфигурации
+    init_dosing();
     
     ESP_LOGI(TAG, "pH/EC Manager initialized");
     ESP_LOGI(TAG, "Node ID: %s, pH target: %.2f, EC target: %.2f", 
@@ -95,14 +81,14 @@ esp_err_t ph_ec_manager_start(void) {
     }
     
     // Запуск главной задачи
-    BaseType_t ret = xTaskCreate(main_task, "ph_ec_main", 6144, NULL, 5, &s_main_task);
+    BaseType_t ret = rtos_static_task_create(&ph_ec_main, main_task, "ph_ec_main", NULL, 5, &s_main_task);
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create main task");
         return ESP_FAIL;
     }
     
     // Запуск heartbeat задачи
-    ret = xTaskCreate(heartbeat_task, "heartbeat", 3072, NULL, 4, &s_heartbeat_task);
+    ret = rtos_static_task_create(&ph_ec_heartbeat, heartbeat_task, "heartbeat", NULL, 4, &s_heartbeat_task);
     if (ret != pdPASS) {
         ESP_LOGW(TAG, "Failed to create heartbeat task");
     }
@@ -135,15 +121,22 @@ esp_err_t ph_ec_manager_get_values(float *ph, float *ec) {
 }
 
 esp_err_t ph_ec_manager_set_emergency(bool enable) {
+    bool changed = (enable != s_emergency_mode);
     s_emergency_mode = enable;
     
     if (enable) {
         ESP_LOGW(TAG, "EMERGENCY MODE ACTIVATED");
         pump_controller_emergency_stop();
+        dosing_engine_autotune_stop(DOSING_LOOP_PH);
+        dosing_engine_autotune_stop(DOSING_LOOP_EC);
     } else {
         ESP_LOGI(TAG, "Emergency mode deactivated");
     }
     
+    if (changed) {
+        event_bus_publish_emergency(enable, TAG);
+    }
+    
     return ESP_OK;
 }
 
@@ -151,15 +144,9 @@ esp_err_t ph_ec_manager_set_emergency(bool enable) {
 static void main_task(void *arg) {
     ESP_LOGI(TAG, "Main task running");
     
-    // Ожидание подключения к mesh
-    int wait_count = 0;
-    while (!mesh_manager_is_connected() && wait_count < 30) {
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        wait_count++;
-    }
-    
+    // Ожидание подключения к mesh (до 30 секунд, пробуждение по MESH_UP)
     // Дополнительная задержка после подключения для стабилизации mesh
-    if (mesh_manager_is_connected()) {
+    if (event_bus_wait_mesh_up(pdMS_TO_TICKS(30000))) {
         ESP_LOGI(TAG, "Mesh connected, waiting 3 seconds for stabilization...");
         vTaskDelay(pdMS_TO_TICKS(3000));
         send_discovery();
@@ -287,40 +274,77 @@ static void check_emergency_conditions(void) {
     }
 }
 
-// Управление pH/EC через PID
+// Контуры dosing_engine из конфигурации (также после смены PID)
+static void init_dosing(void) {
+    const float targets[DOSING_LOOP_COUNT] = {
+        [DOSING_LOOP_PH] = s_config->ph_target,
+        [DOSING_LOOP_EC] = s_config->ec_target,
+    };
+    dosing_engine_init(targets, s_config->pump_pid);
+}
+
+// Управление pH/EC: зоны, safety интервал и насосы - в таблице dosing_engine
 static void control_ph_ec(void) {
     float dt = 1.0f; // Цикл 1 секунда
     
-    // Управление pH
-    if (s_current_ph < s_config->ph_target - 0.1f) {
-        // pH низкий - нужен pH UP
-        float dose = pid_compute(&s_pid_ph_up, s_current_ph, dt);
-        if (dose > 0.1f) {
-            pump_controller_run_dose(PUMP_PH_UP, dose);
-            ESP_LOGI(TAG, "pH UP: %.2f ml (current=%.2f, target=%.2f)", 
-                     dose, s_current_ph, s_config->ph_target);
-        }
-    } else if (s_current_ph > s_config->ph_target + 0.1f) {
-        // pH высокий - нужен pH DOWN
-        float dose = pid_compute(&s_pid_ph_down, s_current_ph, dt);
-        if (dose > 0.1f) {
-            pump_controller_run_dose(PUMP_PH_DOWN, dose);
-            ESP_LOGI(TAG, "pH DOWN: %.2f ml (current=%.2f, target=%.2f)",
-                     dose, s_current_ph, s_config->ph_target);
-        }
+    // pH: PH_UP ниже цели, PH_DOWN выше
+    dosing_engine_control(DOSING_LOOP_PH, s_current_ph, dt, NULL);
+    
+    // EC: A/B/C ниже цели, выше - ждём разбавления
+    dosing_engine_control(DOSING_LOOP_EC, s_current_ec, dt, NULL);
+    
+    report_autotune(DOSING_LOOP_PH);
+    report_autotune(DOSING_LOOP_EC);
+}
+
+// Ход автонастройки контура: событие на каждое колебание, результат - в NVS
+static void report_autotune(dosing_loop_t loop) {
+    dosing_autotune_t at;
+    if (!dosing_engine_autotune_poll(loop, &at)) {
+        return;
     }
     
-    // Управление EC
-    if (s_current_ec < s_config->ec_target - 0.1f) {
-        // EC низкая - нужны удобрения
-        float dose = pid_compute(&s_pid_ec, s_current_ec, dt);
-        if (dose > 0.1f) {
-            // Распределяем между A, B, C (упрощённо - только A)
-            pump_controller_run_dose(PUMP_EC_A, dose);
-            ESP_LOGI(TAG, "EC A: %.2f ml (current=%.2f, target=%.2f)",
-                     dose, s_current_ec, s_config->ec_target);
-        }
+    const char *name = dosing_engine_loop_name(loop);
+    char msg[96];
+    switch (at.state) {
+        case DOSING_AUTOTUNE_RUNNING:
+            snprintf(msg, sizeof(msg), "%s autotune: cycle %d/%d", name, at.cycles, at.cycles_needed);
+            send_event(MESH_EVENT_INFO, msg);
+            break;
+        case DOSING_AUTOTUNE_DONE:
+            dosing_engine_autotune_apply(loop, s_config->pump_pid);
+            node_config_save(s_config, sizeof(ph_ec_node_config_t), "ph_ec_ns");
+            snprintf(msg, sizeof(msg), "%s autotune done: Ku=%.2f Pu=%.0fs Kp=%.3f Ki=%.4f",
+                     name, at.ku, at.pu_s, at.close.kp, at.close.ki);
+            send_event(MESH_EVENT_INFO, msg);
+            break;
+        case DOSING_AUTOTUNE_FAILED:
+            snprintf(msg, sizeof(msg), "%s autotune failed: %s", name, at.error);
+            send_event(MESH_EVENT_WARNING, msg);
+            break;
+        default:
+            break;
+    }
+}
+
+// Отправка event сообщения
+static void send_event(mesh_event_level_t level, const char *message) {
+    if (!mesh_manager_is_connected()) {
+        return;
+    }
+    
+    cJSON *data = cJSON_CreateObject();
+    cJSON_AddNumberToObject(data, "ph", s_current_ph);
+    cJSON_AddNumberToObject(data, "ec", s_current_ec);
+    
+    char json_buf[512];
+    if (mesh_protocol_create_event(s_config->base.node_id, level, message, data,
+                                    json_buf, sizeof(json_buf))) {
+        mesh_manager_send_to_root((uint8_t *)json_buf, strlen(json_buf));
+        ESP_LOGI(TAG, "Event sent: %s - %s", mesh_protocol_event_level_to_str(level), message);
     }
+    
+    cJSON_Delete(data);
 }
 
 // Получение RSSI к родительскому узлу
@@ -471,8 +495,7 @@ void ph_ec_manager_handle_command(const char *command, cJSON *params) {
         cJSON *value = cJSON_GetObjectItem(params, "value");
         if (value && cJSON_IsNumber(value)) {
             s_config->ph_target = (float)value->valuedouble;
-            pid_set_setpoint(&s_pid_ph_up, s_config->ph_target);
-            pid_set_setpoint(&s_pid_ph_down, s_config->ph_target);
+            dosing_engine_set_target(DOSING_LOOP_PH, s_config->ph_target);
             node_config_save(s_config, sizeof(ph_ec_node_config_t), "ph_ec_ns");
             ESP_LOGI(TAG, "pH target updated: %.2f", s_config->ph_target);
         }
@@ -480,10 +503,41 @@ void ph_ec_manager_handle_command(const char *command, cJSON *params) {
         cJSON *value = cJSON_GetObjectItem(params, "value");
         if (value && cJSON_IsNumber(value)) {
             s_config->ec_target = (float)value->valuedouble;
-            pid_set_setpoint(&s_pid_ec, s_config->ec_target);
+            dosing_engine_set_target(DOSING_LOOP_EC, s_config->ec_target);
             node_config_save(s_config, sizeof(ph_ec_node_config_t), "ph_ec_ns");
             ESP_LOGI(TAG, "EC target updated: %.2f", s_config->ec_target);
         }
+    } else if (strcmp(command, "autotune") == 0) {
+        // {"loop": "ph"|"ec", "dose_ml": 0.5, "cycles": 4} или {"loop": "ph", "action": "stop"}
+        cJSON *loop_json = cJSON_GetObjectItem(params, "loop");
+        if (!cJSON_IsString(loop_json)) {
+            ESP_LOGW(TAG, "Autotune: loop not specified");
+            return;
+        }
+        dosing_loop_t loop = strcmp(loop_json->valuestring, "ec") == 0 ? DOSING_LOOP_EC : DOSING_LOOP_PH;
+        
+        cJSON *action = cJSON_GetObjectItem(params, "action");
+        if (cJSON_IsString(action) && strcmp(action->valuestring, "stop") == 0) {
+            dosing_engine_autotune_stop(loop);
+            return;
+        }
+        if (s_emergency_mode) {
+            ESP_LOGW(TAG, "Autotune blocked: EMERGENCY mode active");
+            return;
+        }
+        
+        // Калибровки насосов в конфигурации узла pH+EC нет - без проверки
+        cJSON *dose = cJSON_GetObjectItem(params, "dose_ml");
+        cJSON *cycles = cJSON_GetObjectItem(params, "cycles");
+        esp_err_t err = dosing_engine_autotune_start(loop,
+                                                     cJSON_IsNumber(dose) ? (float)dose->valuedouble : 0.0f,
+                                                     cJSON_IsNumber(cycles) ? (uint8_t)cycles->valueint : 0,
+                                                     NULL);
+        if (err == ESP_OK) {
+            send_event(MESH_EVENT_INFO, loop == DOSING_LOOP_EC ? "ec autotune started" : "ph autotune started");
+        } else {
+            ESP_LOGW(TAG, "Autotune not started: %s", esp_err_to_name(err));
+        }
     }
 }
 
@@ -492,7 +546,9 @@ void ph_ec_manager_handle_config_update(cJSON *config_json) {
     ESP_LOGI(TAG, "Config update received");
     
     node_config_update_from_json(s_config, config_json, "ph_ec");
+    init_dosing();  // Цели и PID могли измениться
     node_config_save(s_config, sizeof(ph_ec_node_config_t), "ph_ec_ns");
+    event_bus_publish_config_changed("mesh");
     
     ESP_LOGI(TAG, "Config updated and saved");
 }
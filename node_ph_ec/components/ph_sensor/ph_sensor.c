@@ -5,6 +5,7 @@
 
 #include "ph_sensor.h"
 #include "esp_log.h"
+#include "pm_policy.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
@@ -33,7 +34,9 @@ esp_err_t ph_sensor_init(i2c_port_t i2c_port) {
     i2c_master_write_byte(cmd, (PH_SENSOR_ADDR << 1) | I2C_MASTER_WRITE, true);
     i2c_master_stop(cmd);
     
+    pm_policy_acquire(PM_SITE_I2C);
     esp_err_t ret = i2c_master_cmd_begin(s_i2c_port, cmd, pdMS_TO_TICKS(100));
+    pm_policy_release(PM_SITE_I2C);
     i2c_cmd_link_delete(cmd);
     
     if (ret != ESP_OK) {
@@ -146,7 +149,9 @@ static esp_err_t ph_read_register(uint8_t reg, uint8_t *data, size_t len) {
     i2c_master_read_byte(cmd, data + len - 1, I2C_MASTER_NACK);
     i2c_master_stop(cmd);
     
+    pm_policy_acquire(PM_SITE_I2C);
     esp_err_t ret = i2c_master_cmd_begin(s_i2c_port, cmd, pdMS_TO_TICKS(100));
+    pm_policy_release(PM_SITE_I2C);
     i2c_cmd_link_delete(cmd);
     
     return ret;
@@ -161,7 +166,9 @@ static esp_err_t ph_write_register(uint8_t reg, uint8_t *data, size_t len) {
     i2c_master_write(cmd, data, len, true);
     i2c_master_stop(cmd);
     
+    pm_policy_acquire(PM_SITE_I2C);
     esp_err_t ret = i2c_master_cmd_begin(s_i2c_port, cmd, pdMS_TO_TICKS(100));
+    pm_policy_release(PM_SITE_I2C);
     i2c_cmd_link_delete(cmd);
     
     return ret;
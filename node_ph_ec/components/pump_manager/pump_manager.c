@@ -1,48 +0,0 @@
-/**
- * @file pump_manager.c
- * @brief Реализация менеджера насосов (ЗАГЛУШКА)
- * 
- * TODO: Портировать реальную реализацию из hydro1.0/components/pump_manager/
- */
-
-#include "pump_manager.h"
-#include "esp_log.h"
-
-static const char *TAG = "pump_manager";
-
-esp_err_t pump_manager_init(void) {
-    ESP_LOGI(TAG, "Pump Manager initialized (STUB - TODO: port from hydro1.0)");
-    
-    // TODO: Инициализация GPIO для 5 насосов
-    // TODO: Инициализация safety таймеров
-    // TODO: Загрузка статистики из NVS
-    
-    return ESP_OK;
-}
-
-esp_err_t pump_manager_run(pump_id_t pump_id, uint32_t duration_ms) {
-    ESP_LOGI(TAG, "Pump %d running for %d ms", pump_id, duration_ms);
-    
-    // TODO: Проверка safety
-    // TODO: Проверка cooldown
-    // TODO: Проверка дневного лимита
-    // TODO: Включение GPIO
-    // TODO: Таймер выключения
-    // TODO: Обновление статистики
-    
-    return ESP_OK;
-}
-
-void pump_manager_emergency_stop(void) {
-    ESP_LOGW(TAG, "EMERGENCY STOP - all pumps OFF");
-    
-    // TODO: Немедленное выключение всех GPIO насосов
-}
-
-void pump_manager_get_stats(pump_id_t pump_id, uint32_t *ml_hour, uint32_t *ml_day) {
-    // TODO: Реальная статистика из счетчиков
-    
-    if (ml_hour) *ml_hour = 0;
-    if (ml_day) *ml_day = 0;
-}
-
@@ -19,8 +19,12 @@
 // Common компоненты
 #include "mesh_manager.h"
 #include "mesh_protocol.h"
+#include "event_bus.h"
+#include "mesh_time.h"
 #include "node_config.h"
 #include "mesh_config.h"  // Централизованная конфигурация
+#include "dlog.h"
+#include "pm_policy.h"
 
 // Компоненты pH/EC
 #include "ph_sensor.h"
@@ -62,6 +66,7 @@ void app_main(void)
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    pm_policy_init();          // DFS и light sleep (если включено в Kconfig)
     
     // [Step 2/9] Загрузка конфигурации
     ESP_LOGI(TAG, "[Step 2/9] Loading config...");
@@ -97,6 +102,7 @@ void app_main(void)
     // [Step 5/9] Pumps init
     ESP_LOGI(TAG, "[Step 5/9] Pumps init (5x PWM)...");
     ESP_ERROR_CHECK(pump_controller_init());
+    dlog_init();  // Отложенный вывод логов насосов (если включён в Kconfig)
     ESP_LOGI(TAG, "  - 5 pumps ready (GPIO 4,5,6,7,15)");
     
     // [Step 6/9] Mesh NODE mode init
@@ -116,6 +122,7 @@ void app_main(void)
     
     ESP_ERROR_CHECK(mesh_manager_init(&mesh_config));
     ESP_LOGI(TAG, "  Mesh ID: %s", mesh_config.mesh_id);
+    mesh_time_init(false);     // Часы ROOT по маякам (если включено в Kconfig)
     
     // Регистрация callback для команд от ROOT
     mesh_manager_register_recv_cb(on_mesh_data_received);
@@ -233,13 +240,14 @@ static void on_mesh_data_received(const uint8_t *src, const uint8_t *data, size_
     }
 
     // Проверка что сообщение для нас
-    if (strcmp(msg.node_id, s_node_config.base.node_id) != 0) {
+    if (!mesh_protocol_is_for_node(&msg, s_node_config.base.node_id)) {
         mesh_protocol_free_message(&msg);
         free(data_copy);
         return;
     }
 
     ESP_LOGI(TAG, "Message from ROOT: type=%d", msg.type);
+    event_bus_publish_message(&msg);
 
     // Обработка по типу сообщения
     switch (msg.type) {
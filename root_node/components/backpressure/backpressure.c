@@ -0,0 +1,121 @@
+/**
+ * @file backpressure.c
+ * @brief Реализация сигнала перегрузки ROOT
+ */
+
+#include "backpressure.h"
+#include "mesh_manager.h"
+#include "mqtt_client_manager.h"
+#include "node_registry.h"
+#include "esp_log.h"
+#include "esp_mesh.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "rtos_static.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+static const char *TAG = "backpressure";
+
+#define REDUCE_PENDING      CONFIG_ROOT_BACKPRESSURE_REDUCE_PENDING
+#define HOLD_PENDING        CONFIG_ROOT_BACKPRESSURE_HOLD_PENDING
+#define REDUCE_OUTBOX       (CONFIG_ROOT_BACKPRESSURE_REDUCE_OUTBOX_KB * 1024)
+#define HOLD_OUTBOX         (CONFIG_ROOT_BACKPRESSURE_HOLD_OUTBOX_KB * 1024)
+
+static volatile mesh_rate_level_t s_level = MESH_RATE_NORMAL;
+RTOS_STATIC_TASK(backpressure, 3072);
+
+// Уровень, которого требуют очереди прямо сейчас (без гистерезиса)
+static mesh_rate_level_t evaluate_target(int *pending_out, int *outbox_out) {
+    mesh_rx_pending_t pending = {0};
+    if (esp_mesh_get_rx_pending(&pending) != ESP_OK) {
+        pending.toSelf = 0;
+    }
+    int outbox = mqtt_client_manager_get_outbox_size();
+
+    *pending_out = pending.toSelf;
+    *outbox_out = outbox;
+
+    if (pending.toSelf >= HOLD_PENDING || outbox >= HOLD_OUTBOX) {
+        return MESH_RATE_HOLD;
+    }
+    if (pending.toSelf >= REDUCE_PENDING || outbox >= REDUCE_OUTBOX ||
+        !mqtt_client_manager_is_connected()) {
+        return MESH_RATE_REDUCE;
+    }
+    return MESH_RATE_NORMAL;
+}
+
+static void broadcast_level(mesh_rate_level_t level) {
+    if (!mesh_manager_is_connected() || mesh_manager_get_total_nodes() <= 1) {
+        return;
+    }
+
+    char msg[64];
+    if (!mesh_protocol_create_rate_hint(level, BACKPRESSURE_TTL_S, msg, sizeof(msg))) {
+        return;
+    }
+
+    esp_err_t err = mesh_manager_broadcast((const uint8_t *)msg, strlen(msg));
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Rate hint broadcast failed: %s", esp_err_to_name(err));
+    }
+}
+
+static void backpressure_task(void *arg) {
+    int calm_evals = 0;
+    TickType_t last_broadcast = 0;
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(BACKPRESSURE_EVAL_MS));
+
+        int pending, outbox;
+        mesh_rate_level_t target = evaluate_target(&pending, &outbox);
+        mesh_rate_level_t level = s_level;
+
+        if (target > level) {
+            level = target;
+            calm_evals = 0;
+        } else if (target < level) {
+            if (++calm_evals >= BACKPRESSURE_RELEASE_EVALS) {
+                level = (mesh_rate_level_t)(level - 1);
+                calm_evals = 0;
+            }
+        } else {
+            calm_evals = 0;
+        }
+
+        TickType_t now = xTaskGetTickCount();
+        if (level != s_level) {
+            ESP_LOGW(TAG, "Rate hint %s -> %s (mesh rx pending: %d, outbox: %d B, mqtt: %s)",
+                     mesh_protocol_rate_level_to_str(s_level),
+                     mesh_protocol_rate_level_to_str(level), pending, outbox,
+                     mqtt_client_manager_is_connected() ? "up" : "down");
+            s_level = level;
+            broadcast_level(level);
+            // Узлы переходят на другие интервалы - старая статистика phi неверна
+            node_registry_reset_arrivals();
+            last_broadcast = now;
+        } else if (level != MESH_RATE_NORMAL &&
+                   now - last_broadcast >= pdMS_TO_TICKS(BACKPRESSURE_REFRESH_S * 1000)) {
+            broadcast_level(level);
+            last_broadcast = now;
+        }
+    }
+}
+
+esp_err_t backpressure_init(void) {
+    if (rtos_static_task_create(&backpressure, backpressure_task, "backpressure", NULL, 4, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create backpressure task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Backpressure started (reduce: %d pending / %d KB, hold: %d pending / %d KB)",
+             REDUCE_PENDING, REDUCE_OUTBOX / 1024, HOLD_PENDING, HOLD_OUTBOX / 1024);
+    return ESP_OK;
+}
+
+mesh_rate_level_t backpressure_get_level(void) {
+    return s_level;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file backpressure.h
+ * @brief Сигнал перегрузки ROOT → NODE (rate hint)
+ *
+ * Раз в секунду оценивает заполненность очередей ROOT и рассылает узлам
+ * подсказку темпа (см. common/rate_hint):
+ *
+ * - NORMAL - очереди свободны, MQTT подключён
+ * - REDUCE - MQTT offline, либо mesh RX очередь / MQTT outbox заполняются
+ * - HOLD   - mesh RX очередь или outbox почти переполнены
+ *
+ * MQTT offline сам по себе даёт только REDUCE: telemetry по-прежнему нужна
+ * ROOT локально (rule_engine, climate fallback, local API).
+ *
+ * Повышение уровня - сразу, понижение - на одну ступень после
+ * BACKPRESSURE_RELEASE_EVALS спокойных оценок подряд. Пока уровень не
+ * NORMAL, подсказка переотправляется каждые BACKPRESSURE_REFRESH_S секунд
+ * с TTL BACKPRESSURE_TTL_S, чтобы узлы, пропустившие рассылку или
+ * подключившиеся позже, её получили.
+ */
+
+#ifndef BACKPRESSURE_H
+#define BACKPRESSURE_H
+
+#include "esp_err.h"
+#include "mesh_protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BACKPRESSURE_EVAL_MS            1000
+#define BACKPRESSURE_RELEASE_EVALS      10      ///< Спокойных оценок до понижения уровня
+#define BACKPRESSURE_REFRESH_S          20
+#define BACKPRESSURE_TTL_S              60
+
+/**
+ * @brief Запуск задачи оценки перегрузки
+ *
+ * @return ESP_OK при успехе
+ */
+esp_err_t backpressure_init(void);
+
+/**
+ * @brief Текущий разосланный уровень
+ */
+mesh_rate_level_t backpressure_get_level(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BACKPRESSURE_H
@@ -1,30 +1,291 @@
 /**
  * @file climate_logic.c
  * @brief Реализация резервной климатической логики
+ *
+ * Конечный автомат, управляемый событиями:
+ * - события реестра (online/offline/данные Climate узла) приходят через
+ *   node_registry_register_event_cb() и обрабатываются сразу;
+ * - таймерные шаги fallback (окна/вентилятор) - через one-shot esp_timer.
+ * Задача блокируется только на очереди событий и ни на чём больше.
  */
 
 #include "climate_logic.h"
 #include "node_registry.h"
-#include "mesh_manager.h"
-#include "mesh_protocol.h"
+#include "rule_engine.h"
+#include "instrumentation.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "rtos_static.h"
 #include <string.h>
+#include <math.h>
 
 static const char *TAG = "climate_logic";
 
-static TaskHandle_t s_climate_task = NULL;
-static bool s_fallback_active = false;
-
-// Простые таймеры для fallback логики
+// Простые таймеры для fallback логики (Climate node offline)
 #define WINDOW_OPEN_INTERVAL_MS    3600000  // 1 час
 #define WINDOW_OPEN_DURATION_MS    300000   // 5 минут
 #define FAN_CHECK_INTERVAL_MS      600000   // 10 минут
+#define FAN_RUN_DURATION_MS        120000   // 2 минуты
+
+// Пороги по последним значениям Climate узла (Climate node online)
+#define TEMP_WINDOWS_OPEN_C        28.0f    // Открыть окна выше
+#define TEMP_WINDOWS_CLOSE_C       25.0f    // Закрыть окна ниже (гистерезис)
+#define HUMIDITY_FAN_ON_PCT        85.0f
+#define HUMIDITY_FAN_OFF_PCT       75.0f
+#define CO2_FAN_ON_PPM             1200.0f
+#define CO2_FAN_OFF_PPM            900.0f
+
+#define CLIMATE_EVENT_QUEUE_LEN    16
+#define CLIMATE_RELAY_TARGET       "type:relay"     // Все online Relay узлы
 
-// Forward declaration
+/**
+ * @brief Режим автомата
+ */
+typedef enum {
+    CLIMATE_MODE_SENSOR = 0,    ///< Climate node online - решения по его последним значениям
+    CLIMATE_MODE_FALLBACK       ///< Climate node offline - таймерная логика
+} climate_mode_t;
+
+/**
+ * @brief События автомата
+ */
+typedef enum {
+    CLIMATE_EVT_PRESENCE = 0,   ///< Изменился состав/статус узлов - перепроверить Climate
+    CLIMATE_EVT_DATA,           ///< Новые значения от Climate узла
+    CLIMATE_EVT_WINDOW_TIMER,   ///< Таймер окон (fallback)
+    CLIMATE_EVT_FAN_TIMER,      ///< Таймер вентилятора (fallback)
+    CLIMATE_EVT_STOP            ///< Остановка задачи
+} climate_evt_type_t;
+
+typedef struct {
+    climate_evt_type_t type;
+    float temperature;          ///< Только для CLIMATE_EVT_DATA (NAN если нет)
+    float humidity;
+    float co2;
+} climate_evt_t;
+
+static TaskHandle_t s_climate_task = NULL;
+static QueueHandle_t s_event_queue = NULL;
+// Stack увеличен в 2 раза для безопасности: 4096 → 8192
+RTOS_STATIC_TASK(climate_fallback, 8192);
+RTOS_STATIC_QUEUE(climate_evt, CLIMATE_EVENT_QUEUE_LEN, sizeof(climate_evt_t));
+static esp_timer_handle_t s_window_timer = NULL;
+static esp_timer_handle_t s_fan_timer = NULL;
+static bool s_listener_registered = false;
+
+static volatile bool s_fallback_active = false;
+static climate_mode_t s_mode = CLIMATE_MODE_SENSOR;
+static bool s_windows_open = false;
+static bool s_fan_on = false;
+
+// Forward declarations
 static void climate_fallback_task(void *arg);
-static void send_command_to_relay(const char *command);
+static esp_err_t send_command_to_relay(const char *command);
+
+// ============================================================================
+// ИСТОЧНИКИ СОБЫТИЙ
+// ============================================================================
+
+static void post_event(const climate_evt_t *evt) {
+    if (s_event_queue && xQueueSend(s_event_queue, evt, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Event queue full, event %d dropped", evt->type);
+    }
+}
+
+static float json_number_or_nan(const cJSON *obj, const char *key) {
+    const cJSON *item = cJSON_GetObjectItem(obj, key);
+    return (item && cJSON_IsNumber(item)) ? (float)item->valuedouble : NAN;
+}
+
+// Вызывается в контексте mesh_recv/root_monitor - только копирование в очередь
+static void registry_event_cb(node_registry_event_t event, const node_info_t *node, void *ctx) {
+    climate_evt_t evt = { .type = CLIMATE_EVT_PRESENCE, .temperature = NAN, .humidity = NAN, .co2 = NAN };
+
+    if (event == NODE_REGISTRY_EVENT_DATA) {
+        if (strcmp(node->node_type, "climate") != 0 || !node->last_data) {
+            return;
+        }
+        evt.type = CLIMATE_EVT_DATA;
+        evt.temperature = json_number_or_nan(node->last_data, "temperature");
+        evt.humidity = json_number_or_nan(node->last_data, "humidity");
+        evt.co2 = json_number_or_nan(node->last_data, "co2");
+    }
+
+    post_event(&evt);
+}
+
+static void window_timer_cb(void *arg) {
+    climate_evt_t evt = { .type = CLIMATE_EVT_WINDOW_TIMER };
+    post_event(&evt);
+}
+
+static void fan_timer_cb(void *arg) {
+    climate_evt_t evt = { .type = CLIMATE_EVT_FAN_TIMER };
+    post_event(&evt);
+}
+
+// ============================================================================
+// ДЕЙСТВИЯ
+// ============================================================================
+
+// Состояние меняется только после отправки: иначе следующий тик решит,
+// что реле уже переключено, и команду не повторит
+static void set_windows(bool open) {
+    if (s_windows_open == open) {
+        return;
+    }
+    if (send_command_to_relay(open ? "open_windows" : "close_windows") == ESP_OK) {
+        s_windows_open = open;
+    }
+}
+
+static void set_fan(bool on) {
+    if (s_fan_on == on) {
+        return;
+    }
+    if (send_command_to_relay(on ? "start_fan" : "stop_fan") == ESP_OK) {
+        s_fan_on = on;
+    }
+}
+
+static void restart_timer(esp_timer_handle_t timer, uint32_t timeout_ms) {
+    esp_timer_stop(timer);  // ESP_ERR_INVALID_STATE если не запущен - не важно
+    esp_timer_start_once(timer, (uint64_t)timeout_ms * 1000);
+}
+
+// Решение по последним значениям Climate узла (с гистерезисом)
+static void apply_sensor_values(float temperature, float humidity, float co2) {
+    if (!isnan(temperature)) {
+        if (temperature > TEMP_WINDOWS_OPEN_C) {
+            set_windows(true);
+        } else if (temperature < TEMP_WINDOWS_CLOSE_C) {
+            set_windows(false);
+        }
+    }
+
+    bool want_fan_on = (!isnan(humidity) && humidity > HUMIDITY_FAN_ON_PCT) ||
+                       (!isnan(co2) && co2 > CO2_FAN_ON_PPM);
+    bool allow_fan_off = (isnan(humidity) || humidity < HUMIDITY_FAN_OFF_PCT) &&
+                         (isnan(co2) || co2 < CO2_FAN_OFF_PPM);
+
+    if (want_fan_on) {
+        set_fan(true);
+    } else if (allow_fan_off) {
+        set_fan(false);
+    }
+}
+
+// Последние известные значения Climate узла из реестра (при входе в SENSOR режим)
+static void apply_registry_values(void) {
+    float temp = NAN, humidity = NAN, co2 = NAN;
+    bool found = false;
+
+    const node_registry_view_t *view = node_registry_acquire();
+    for (int i = 0; view && i < view->count && !found; i++) {
+        const node_info_t *node = &view->nodes[i];
+        if (node->online && strcmp(node->node_type, "climate") == 0 && node->last_data) {
+            temp = json_number_or_nan(node->last_data, "temperature");
+            humidity = json_number_or_nan(node->last_data, "humidity");
+            co2 = json_number_or_nan(node->last_data, "co2");
+            found = true;
+        }
+    }
+    node_registry_release(view);
+
+    // Реле управляются уже без удержания версии реестра
+    if (found) {
+        apply_sensor_values(temp, humidity, co2);
+        return;
+    }
+
+    // Данных ещё нет - безопасное состояние
+    set_windows(false);
+    set_fan(false);
+}
+
+static void enter_fallback(void) {
+    ESP_LOGW(TAG, "Climate node OFFLINE - activating fallback logic");
+    s_mode = CLIMATE_MODE_FALLBACK;
+    s_fallback_active = true;
+
+    // Окна/вентилятор в исходное положение, дальше - по расписанию
+    set_windows(false);
+    set_fan(false);
+    restart_timer(s_window_timer, WINDOW_OPEN_INTERVAL_MS);
+    restart_timer(s_fan_timer, FAN_CHECK_INTERVAL_MS);
+}
+
+static void enter_sensor_mode(void) {
+    ESP_LOGI(TAG, "Climate node ONLINE - deactivating fallback logic");
+    s_mode = CLIMATE_MODE_SENSOR;
+    s_fallback_active = false;
+
+    esp_timer_stop(s_window_timer);
+    esp_timer_stop(s_fan_timer);
+    apply_registry_values();
+}
+
+// ============================================================================
+// КОНЕЧНЫЙ АВТОМАТ
+// ============================================================================
+
+static void handle_event(const climate_evt_t *evt) {
+    switch (evt->type) {
+        case CLIMATE_EVT_PRESENCE: {
+            bool climate_online = node_registry_has_type("climate");
+            if (climate_online && s_mode == CLIMATE_MODE_FALLBACK) {
+                enter_sensor_mode();
+            } else if (!climate_online && s_mode == CLIMATE_MODE_SENSOR) {
+                enter_fallback();
+            }
+            break;
+        }
+
+        case CLIMATE_EVT_DATA:
+            if (s_mode == CLIMATE_MODE_FALLBACK) {
+                // Данные пришли раньше события ONLINE/INFO - сначала сменить режим
+                enter_sensor_mode();
+            }
+            apply_sensor_values(evt->temperature, evt->humidity, evt->co2);
+            break;
+
+        case CLIMATE_EVT_WINDOW_TIMER:
+            if (s_mode != CLIMATE_MODE_FALLBACK) {
+                break;
+            }
+            if (!s_windows_open) {
+                ESP_LOGI(TAG, "Fallback: Opening windows");
+                set_windows(true);
+                restart_timer(s_window_timer, WINDOW_OPEN_DURATION_MS);
+            } else {
+                ESP_LOGI(TAG, "Fallback: Closing windows");
+                set_windows(false);
+                restart_timer(s_window_timer, WINDOW_OPEN_INTERVAL_MS - WINDOW_OPEN_DURATION_MS);
+            }
+            break;
+
+        case CLIMATE_EVT_FAN_TIMER:
+            if (s_mode != CLIMATE_MODE_FALLBACK) {
+                break;
+            }
+            if (!s_fan_on) {
+                ESP_LOGI(TAG, "Fallback: Starting fan");
+                set_fan(true);
+                restart_timer(s_fan_timer, FAN_RUN_DURATION_MS);
+            } else {
+                ESP_LOGI(TAG, "Fallback: Stopping fan");
+                set_fan(false);
+                restart_timer(s_fan_timer, FAN_CHECK_INTERVAL_MS - FAN_RUN_DURATION_MS);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
 
 esp_err_t climate_logic_init(void) {
     ESP_LOGI(TAG, "Climate fallback logic initialized");
@@ -37,28 +298,64 @@ esp_err_t climate_logic_start(void) {
         return ESP_OK;
     }
 
-    // Stack увеличен в 2 раза для безопасности: 4096 → 8192
-    BaseType_t ret = xTaskCreate(climate_fallback_task, 
-                                  "climate_fallback", 
-                                  8192, 
-                                  NULL, 
-                                  5, 
-                                  &s_climate_task);
-    
+    if (s_event_queue == NULL) {
+        s_event_queue = rtos_static_queue_create(&climate_evt);
+        if (s_event_queue == NULL) {
+            ESP_LOGE(TAG, "Failed to create event queue");
+            return ESP_ERR_NO_MEM;
+        }
+        instrumentation_register_queue("climate_evt", s_event_queue);
+    }
+
+    if (s_window_timer == NULL) {
+        const esp_timer_create_args_t window_args = {
+            .callback = window_timer_cb,
+            .name = "climate_win",
+        };
+        const esp_timer_create_args_t fan_args = {
+            .callback = fan_timer_cb,
+            .name = "climate_fan",
+        };
+        if (esp_timer_create(&window_args, &s_window_timer) != ESP_OK ||
+            esp_timer_create(&fan_args, &s_fan_timer) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create timers");
+            return ESP_FAIL;
+        }
+    }
+
+    BaseType_t ret = rtos_static_task_create(&climate_fallback,
+                                             climate_fallback_task,
+                                             "climate_fallback",
+                                             NULL,
+                                             5,
+                                             &s_climate_task);
+
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create climate task");
         return ESP_FAIL;
     }
 
+    if (!s_listener_registered) {
+        node_registry_register_event_cb(registry_event_cb, NULL);
+        s_listener_registered = true;
+    }
+
+    // Начальная оценка наличия Climate узла
+    climate_evt_t evt = { .type = CLIMATE_EVT_PRESENCE };
+    post_event(&evt);
+
     ESP_LOGI(TAG, "Climate fallback task started");
     return ESP_OK;
 }
 
 esp_err_t climate_logic_stop(void) {
     if (s_climate_task != NULL) {
-        vTaskDelete(s_climate_task);
-        s_climate_task = NULL;
-        s_fallback_active = false;
+        // Задача сама остановит таймеры и удалится
+        climate_evt_t evt = { .type = CLIMATE_EVT_STOP };
+        xQueueSend(s_event_queue, &evt, portMAX_DELAY);
+        while (s_climate_task != NULL) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
         ESP_LOGI(TAG, "Climate fallback task stopped");
     }
     return ESP_OK;
@@ -70,97 +367,40 @@ bool climate_logic_is_fallback_active(void) {
 
 // Задача резервной климатической логики
 static void climate_fallback_task(void *arg) {
-    uint64_t last_window_open = 0;
-    uint64_t last_fan_check = 0;
-    bool windows_are_open = false;
+    climate_evt_t evt;
 
     ESP_LOGI(TAG, "Climate fallback task running");
 
-    while (1) {
-        // Проверка наличия Climate узла
-        bool climate_online = node_registry_has_type("climate");
-
-        if (!climate_online) {
-            if (!s_fallback_active) {
-                ESP_LOGW(TAG, "Climate node OFFLINE - activating fallback logic");
-                s_fallback_active = true;
-            }
-
-            uint64_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
-
-            // Логика проветривания (каждый час на 5 минут)
-            if (now - last_window_open > WINDOW_OPEN_INTERVAL_MS) {
-                if (!windows_are_open) {
-                    ESP_LOGI(TAG, "Fallback: Opening windows");
-                    send_command_to_relay("open_windows");
-                    windows_are_open = true;
-                    last_window_open = now;
-                }
-            }
-
-            // Закрытие окон через 5 минут
-            if (windows_are_open && (now - last_window_open > WINDOW_OPEN_DURATION_MS)) {
-                ESP_LOGI(TAG, "Fallback: Closing windows");
-                send_command_to_relay("close_windows");
-                windows_are_open = false;
-            }
+    // Исходное состояние: SENSOR; первое CLIMATE_EVT_PRESENCE решит, нужен ли fallback
+    s_mode = CLIMATE_MODE_SENSOR;
+    s_fallback_active = false;
 
-            // Периодическая проверка вентиляции
-            if (now - last_fan_check > FAN_CHECK_INTERVAL_MS) {
-                ESP_LOGI(TAG, "Fallback: Starting fan");
-                send_command_to_relay("start_fan");
-                
-                // Остановка вентилятора через 2 минуты
-                vTaskDelay(pdMS_TO_TICKS(120000));
-                send_command_to_relay("stop_fan");
-                
-                last_fan_check = now;
-            }
+    while (1) {
+        if (xQueueReceive(s_event_queue, &evt, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
 
-        } else {
-            // Climate узел онлайн - деактивация fallback
-            if (s_fallback_active) {
-                ESP_LOGI(TAG, "Climate node ONLINE - deactivating fallback logic");
-                s_fallback_active = false;
-                
-                // Сброс состояния
-                if (windows_are_open) {
-                    send_command_to_relay("close_windows");
-                    windows_are_open = false;
-                }
-            }
+        if (evt.type == CLIMATE_EVT_STOP) {
+            break;
         }
 
-        // Проверка каждые 60 секунд
-        vTaskDelay(pdMS_TO_TICKS(60000));
+        handle_event(&evt);
     }
-}
 
-// Отправка команды на Relay узел
-static void send_command_to_relay(const char *command) {
-    node_info_t *relay = node_registry_get("relay_001");
-    
-    if (!relay || !relay->online) {
-        ESP_LOGW(TAG, "Relay node offline, cannot send command: %s", command);
-        return;
-    }
+    esp_timer_stop(s_window_timer);
+    esp_timer_stop(s_fan_timer);
+    s_fallback_active = false;
+    s_climate_task = NULL;
+    vTaskDelete(NULL);
+}
 
-    // Создание JSON команды
-    cJSON *params = cJSON_CreateObject();
-    
-    char json_buf[256];
-    if (mesh_protocol_create_command("relay_001", command, params, 
-                                      json_buf, sizeof(json_buf))) {
-        esp_err_t err = mesh_manager_send(relay->mac_addr, 
-                                         (uint8_t *)json_buf, strlen(json_buf));
-        
-        if (err == ESP_OK) {
-            ESP_LOGI(TAG, "Sent command to relay: %s", command);
-        } else {
-            ESP_LOGE(TAG, "Failed to send command: %s", esp_err_to_name(err));
-        }
+// Отправка команды всем Relay узлам (адресация по типу, без фиксированного ID)
+static esp_err_t send_command_to_relay(const char *command) {
+    esp_err_t err = rule_engine_send_command(CLIMATE_RELAY_TARGET, command, NULL);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Sent command to relay: %s", command);
+    } else {
+        ESP_LOGW(TAG, "Relay node offline, cannot send command: %s (will retry)", command);
     }
-    
-    cJSON_Delete(params);
+    return err;
 }
-
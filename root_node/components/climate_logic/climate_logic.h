@@ -2,9 +2,12 @@
  * @file climate_logic.h
  * @brief Резервная логика управления климатом
  * 
- * Активируется когда Climate node offline > 30 сек.
- * Использует простую таймерную логику для управления
- * форточками и вентиляцией через Relay node.
+ * Конечный автомат на событиях реестра и esp_timer:
+ * - Climate node online: решения по его последним значениям
+ *   (температура → окна, влажность/CO2 → вентилятор);
+ * - Climate node offline: простая таймерная логика для управления
+ *   форточками и вентиляцией через Relay node.
+ * Переключение режимов - сразу по событию online/offline из реестра.
  */
 
 #ifndef CLIMATE_LOGIC_H
@@ -25,7 +28,7 @@ extern "C" {
 esp_err_t climate_logic_init(void);
 
 /**
- * @brief Запуск резервной логики (фоновая задача)
+ * @brief Запуск резервной логики (фоновая задача + подписка на реестр)
  * 
  * @return ESP_OK при успехе
  */
@@ -8,9 +8,18 @@
 #include "mesh_protocol.h"
 #include "node_registry.h"
 #include "mqtt_client_manager.h"
+#include "mqtt_metrics.h"
+#include "rule_engine.h"
+#include "telemetry_rollup.h"
+#include "trace_ring.h"
+#include "dlog.h"
+#include "cjson_arena.h"
+#include "mem_policy.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_mac.h"
 #include <string.h>
+#include <stdlib.h>
 
 static const char *TAG = "data_router";
 
@@ -18,8 +27,40 @@ static const char *TAG = "data_router";
 #define MQTT_TOPIC_TELEMETRY    "hydro/telemetry"
 #define MQTT_TOPIC_EVENT        "hydro/event"
 #define MQTT_TOPIC_HEARTBEAT    "hydro/heartbeat"
+#define MQTT_TOPIC_COMMAND      "hydro/command"
+#define MQTT_TOPIC_CONFIG       "hydro/config"
+#define MQTT_TOPIC_OTA          "hydro/ota"
+#define MQTT_TOPIC_TRACE_DUMP   "hydro/trace/dump"
+#define MQTT_TOPIC_TRACE_DATA   "hydro/trace/data"
+
+#define RESPONSE_BUF_SIZE       2048    // Ответ Display (all_nodes_data)
+#define MESH_LATENCY_MAX_US     60000000LL  // Больше - часы узла не синхронизированы
+
+static void build_mqtt_routes(void);
+static mesh_msg_type_t route_mesh_message(const uint8_t *src_addr, const uint8_t *data, size_t len);
+
+// Арены cJSON: задача приёма mesh и задача MQTT (NULL - выключено в Kconfig)
+static cjson_arena_t *s_mesh_arena = NULL;
+static cjson_arena_t *s_mqtt_arena = NULL;
+
+// Адресаты групповой команды: растёт с MAX_NODES, поэтому не на стеке.
+// Маршруты MQTT вызываются только из задачи MQTT клиента - буфер один
+static uint8_t s_group_macs[MAX_NODES][6];
+
+// Публикация с отметками трассы вокруг esp_mqtt_client_publish
+static esp_err_t publish_traced(const char *topic, const char *data, size_t len, uint16_t flow) {
+    TRACE_EVENT(TRACE_EV_MQTT_ENQUEUE, flow, len);
+    esp_err_t err = mqtt_client_manager_publish(topic, data);
+    if (err == ESP_OK) {
+        TRACE_EVENT(TRACE_EV_MQTT_PUBLISHED, flow, 0);     // QoS 0: msg_id всегда 0
+    }
+    return err;
+}
 
 esp_err_t data_router_init(void) {
+    build_mqtt_routes();
+    s_mesh_arena = cjson_arena_create("mesh_rx", CJSON_ARENA_DEFAULT_SIZE);
+    s_mqtt_arena = cjson_arena_create("mqtt_rx", CJSON_ARENA_DEFAULT_SIZE);
     ESP_LOGI(TAG, "Data Router initialized");
     
     // Регистрация callbacks
@@ -30,76 +71,113 @@ esp_err_t data_router_init(void) {
 }
 
 void data_router_handle_mesh_data(const uint8_t *src_addr, const uint8_t *data, size_t len) {
-    ESP_LOGI(TAG, "📥 Mesh data received: %d bytes from "MACSTR, len, MAC2STR(src_addr));
+    // Только задача mesh_recv: s_mesh_arena - её арена
+    data_router_route_mesh_data(s_mesh_arena, src_addr, data, len);
+}
+
+void data_router_route_mesh_data(cjson_arena_t *arena, const uint8_t *src_addr,
+                                 const uint8_t *data, size_t len) {
+    // Все выделения cJSON сообщения (разбор, правила, ответы) - из арены,
+    // освобождаются одним сбросом; копия данных в реестре - из heap
+    cjson_arena_begin(arena);
+    mesh_msg_type_t type = route_mesh_message(src_addr, data, len);
+    cjson_arena_end(arena, mesh_protocol_msg_type_to_str(type));
+}
+
+static mesh_msg_type_t route_mesh_message(const uint8_t *src_addr, const uint8_t *data, size_t len) {
+    int64_t recv_us = esp_timer_get_time();  // Для гистограммы mesh recv → publish
+    uint64_t recv_ts_us = mesh_protocol_get_timestamp_us();  // Часы mesh: задержка узел → ROOT
+    uint16_t flow = trace_ring_flow_begin();
+    TRACE_EVENT(TRACE_EV_MESH_RECV, flow, len);
+    // Горячий путь: DLOG (форматирование в задаче с приоритетом IDLE), по
+    // одной строке INFO на сообщение, подробности - DEBUG
+    DLOG_D(TAG, "📥 Mesh data: %d bytes from "MACSTR, (int)len, MAC2STR(src_addr));
     
     // ВАЖНО: Создаём NULL-terminated копию для безопасного парсинга и публикации
     char *data_copy = malloc(len + 1);
     if (data_copy == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate memory for data copy");
-        return;
+        DLOG_E(TAG, "Failed to allocate memory for data copy");
+        return MESH_MSG_UNKNOWN;
     }
     memcpy(data_copy, data, len);
     data_copy[len] = '\0';  // ← Добавляем '\0' для strlen()
     
-    // DEBUG: Показать первые 100 символов JSON
-    char preview[101] = {0};
-    size_t preview_len = (len > 100) ? 100 : len;
-    memcpy(preview, data_copy, preview_len);
-    ESP_LOGI(TAG, "   Data: %s%s", preview, (len > 100) ? "..." : "");
-
     // Парсинг JSON (используем data_copy с '\0')
     mesh_message_t msg;
     if (!mesh_protocol_parse(data_copy, &msg)) {
-        ESP_LOGE(TAG, "❌ Failed to parse mesh message!");
-        ESP_LOGE(TAG, "   Raw data: %s", data_copy);
+        // Без содержимого: счётчик ошибок разбора узла - в node_registry
+        DLOG_W(TAG, "❌ Failed to parse mesh message (%d bytes from "MACSTR")", (int)len, MAC2STR(src_addr));
+        node_registry_record_parse_failure(src_addr);
         free(data_copy);
-        return;
+        return MESH_MSG_UNKNOWN;
     }
     
-    ESP_LOGI(TAG, "✅ Message parsed: type=%d, node_id=%s", msg.type, msg.node_id);
+    TRACE_EVENT(TRACE_EV_PARSED, flow, msg.type);
+
+    // Собственная рассылка rate_hint / time_sync (ROOT есть в своей таблице маршрутизации)
+    if (msg.type == MESH_MSG_RATE_HINT || msg.type == MESH_MSG_TIME_SYNC) {
+        mesh_protocol_free_message(&msg);
+        free(data_copy);
+        return msg.type;
+    }
 
-    // Обновление реестра узлов (отметка последнего контакта)
-    node_registry_update_last_seen(msg.node_id, src_addr);
+    // Обновление реестра узлов (отметка последнего контакта и статистика трафика)
+    node_registry_update_last_seen(msg.node_id, src_addr, &msg, len);
+    node_registry_update_type(msg.node_id, msg.node_type);
+    TRACE_EVENT(TRACE_EV_REGISTRY, flow, 0);
+
+    // Односторонняя задержка: узел ещё не синхронизирован - его ts_us от загрузки, не учитывается
+    if (msg.timestamp_us > 0 && msg.timestamp_us <= recv_ts_us &&
+        recv_ts_us - msg.timestamp_us < MESH_LATENCY_MAX_US) {
+        mqtt_metrics_record_mesh_latency((int64_t)(recv_ts_us - msg.timestamp_us));
+    }
 
     // Маршрутизация в зависимости от типа сообщения
     switch (msg.type) {
         case MESH_MSG_TELEMETRY:
-            ESP_LOGI(TAG, "📊 Telemetry from %s → MQTT", msg.node_id);
+            DLOG_I(TAG, "📊 Telemetry from %s (%d bytes)", msg.node_id, (int)len);
             
             // Обновление данных в реестре
             node_registry_update_data(msg.node_id, msg.data);
-            
-            // Отправка в MQTT с node_id в топике (для backend!)
-            if (mqtt_client_manager_is_connected()) {
+
+            // Локальные правила автоматизации (только затронутые метрики)
+            rule_engine_on_telemetry(msg.node_id, msg.data);
+
+            // Минутные агрегаты; сырой поток может быть отключён для узла
+            if (!telemetry_rollup_add(msg.node_id, msg.node_type, msg.data)) {
+                DLOG_D(TAG, "   Raw telemetry of %s covered by rollup, not published", msg.node_id);
+            } else if (mqtt_client_manager_is_connected()) {
                 char topic[64];
                 snprintf(topic, sizeof(topic), "%s/%s", MQTT_TOPIC_TELEMETRY, msg.node_id);
                 
                 // ИСПРАВЛЕНИЕ: используем data_copy с '\0' для правильного strlen()
-                esp_err_t err = mqtt_client_manager_publish(topic, data_copy);
+                esp_err_t err = publish_traced(topic, data_copy, len, flow);
                 if (err == ESP_OK) {
-                    ESP_LOGI(TAG, "   ✓ Telemetry published to %s", topic);
+                    DLOG_D(TAG, "   ✓ Telemetry published to %s", topic);
+                    mqtt_metrics_record_route_latency(esp_timer_get_time() - recv_us);
                 } else {
-                    ESP_LOGW(TAG, "   ✗ Failed to publish telemetry: %s", esp_err_to_name(err));
+                    DLOG_W(TAG, "   ✗ Failed to publish telemetry: %s", esp_err_to_name(err));
                 }
             } else {
-                ESP_LOGW(TAG, "MQTT offline, telemetry dropped");
+                DLOG_W(TAG, "MQTT offline, telemetry dropped");
                 // TODO: буферизация для отправки позже
             }
             break;
 
         case MESH_MSG_EVENT:
-            ESP_LOGI(TAG, "🔔 Event from %s → MQTT", msg.node_id);
+            DLOG_I(TAG, "🔔 Event from %s (%d bytes)", msg.node_id, (int)len);
             
             if (mqtt_client_manager_is_connected()) {
                 char topic[64];
                 snprintf(topic, sizeof(topic), "%s/%s", MQTT_TOPIC_EVENT, msg.node_id);
                 
                 // ИСПРАВЛЕНИЕ: используем data_copy с '\0' для правильного strlen()
-                esp_err_t err = mqtt_client_manager_publish(topic, data_copy);
+                esp_err_t err = publish_traced(topic, data_copy, len, flow);
                 if (err == ESP_OK) {
-                    ESP_LOGI(TAG, "   ✓ Event published to %s", topic);
+                    DLOG_D(TAG, "   ✓ Event published to %s", topic);
+                    mqtt_metrics_record_route_latency(esp_timer_get_time() - recv_us);
                 } else {
-                    ESP_LOGW(TAG, "   ✗ Failed to publish event: %s", esp_err_to_name(err));
+                    DLOG_W(TAG, "   ✗ Failed to publish event: %s", esp_err_to_name(err));
                 }
 
                 // Проверка критичности события
@@ -107,7 +185,7 @@ void data_router_handle_mesh_data(const uint8_t *src_addr, const uint8_t *data,
                 if (level && cJSON_IsString(level)) {
                     const char *level_str = level->valuestring;
                     if (strcmp(level_str, "critical") == 0 || strcmp(level_str, "emergency") == 0) {
-                        ESP_LOGW(TAG, "⚠️ CRITICAL event from %s!", msg.node_id);
+                        DLOG_W(TAG, "⚠️ CRITICAL event from %s!", msg.node_id);
                         // TODO: дополнительные действия (SMS, Telegram)
                     }
                 }
@@ -115,7 +193,7 @@ void data_router_handle_mesh_data(const uint8_t *src_addr, const uint8_t *data,
             break;
 
         case MESH_MSG_HEARTBEAT:
-            ESP_LOGI(TAG, "💓 Heartbeat from %s → MQTT", msg.node_id);
+            DLOG_I(TAG, "💓 Heartbeat from %s (%d bytes)", msg.node_id, (int)len);
             
             // Heartbeat обновляет только реестр (уже сделано выше)
             // Отправка в MQTT с node_id в топике (для backend!)
@@ -124,19 +202,20 @@ void data_router_handle_mesh_data(const uint8_t *src_addr, const uint8_t *data,
                 snprintf(topic, sizeof(topic), "%s/%s", MQTT_TOPIC_HEARTBEAT, msg.node_id);
                 
                 // ИСПРАВЛЕНИЕ: используем data_copy с '\0' для правильного strlen()
-                esp_err_t err = mqtt_client_manager_publish(topic, data_copy);
+                esp_err_t err = publish_traced(topic, data_copy, len, flow);
                 if (err == ESP_OK) {
-                    ESP_LOGI(TAG, "   ✓ Heartbeat published to %s (len=%d)", topic, len);
+                    DLOG_D(TAG, "   ✓ Heartbeat published to %s", topic);
+                    mqtt_metrics_record_route_latency(esp_timer_get_time() - recv_us);
                 } else {
-                    ESP_LOGW(TAG, "   ✗ Failed to publish heartbeat: %s", esp_err_to_name(err));
+                    DLOG_W(TAG, "   ✗ Failed to publish heartbeat: %s", esp_err_to_name(err));
                 }
             } else {
-                ESP_LOGW(TAG, "   ✗ MQTT offline, heartbeat dropped");
+                DLOG_W(TAG, "   ✗ MQTT offline, heartbeat dropped");
             }
             break;
 
         case MESH_MSG_REQUEST:
-            ESP_LOGI(TAG, "Request from %s (Display)", msg.node_id);
+            DLOG_I(TAG, "Request from %s (Display)", msg.node_id);
             
             // Запрос от Display узла - собрать данные всех узлов
             cJSON *request_type = cJSON_GetObjectItem(msg.data, "request");
@@ -147,24 +226,25 @@ void data_router_handle_mesh_data(const uint8_t *src_addr, const uint8_t *data,
                     // Экспорт всех узлов в JSON
                     cJSON *nodes_data = node_registry_export_all_to_json();
                     
-                    if (nodes_data) {
+                    // Буфер ответа - раз в несколько секунд, не на стеке mesh_recv, а в PSRAM
+                    char *response_buf = mem_policy_malloc(MEM_COLD, RESPONSE_BUF_SIZE);
+                    if (nodes_data && response_buf) {
                         // Создание response сообщения
-                        char response_buf[2048];
                         if (mesh_protocol_create_response(msg.node_id, nodes_data,
-                                                          response_buf, sizeof(response_buf))) {
+                                                          response_buf, RESPONSE_BUF_SIZE)) {
                             // Отправка обратно Display узлу
                             mesh_manager_send(src_addr, (uint8_t *)response_buf, strlen(response_buf));
-                            ESP_LOGI(TAG, "Sent response to Display");
+                            DLOG_D(TAG, "Sent response to Display");
                         }
-                        
-                        cJSON_Delete(nodes_data);
                     }
+                    free(response_buf);
+                    cJSON_Delete(nodes_data);
                 }
             }
             break;
 
         case MESH_MSG_RESPONSE:
-            ESP_LOGI(TAG, "📋 Response from %s → MQTT", msg.node_id);
+            DLOG_I(TAG, "📋 Response from %s (%d bytes)", msg.node_id, (int)len);
             
             // Это может быть config_response от pH/EC ноды
             // Публикуем в MQTT для backend
@@ -172,61 +252,191 @@ void data_router_handle_mesh_data(const uint8_t *src_addr, const uint8_t *data,
                 char topic[64];
                 snprintf(topic, sizeof(topic), "hydro/config_response/%s", msg.node_id);
                 
-                esp_err_t err = mqtt_client_manager_publish(topic, data_copy);
+                esp_err_t err = publish_traced(topic, data_copy, len, flow);
                 if (err == ESP_OK) {
-                    ESP_LOGI(TAG, "   ✓ Config response published to %s", topic);
+                    DLOG_D(TAG, "   ✓ Config response published to %s", topic);
+                    mqtt_metrics_record_route_latency(esp_timer_get_time() - recv_us);
                 } else {
-                    ESP_LOGW(TAG, "   ✗ Failed to publish config response: %s", esp_err_to_name(err));
+                    DLOG_W(TAG, "   ✗ Failed to publish config response: %s", esp_err_to_name(err));
                 }
             } else {
-                ESP_LOGW(TAG, "MQTT offline, config response dropped");
+                DLOG_W(TAG, "MQTT offline, config response dropped");
             }
             break;
 
         default:
-            ESP_LOGW(TAG, "Unknown message type: %d", msg.type);
+            DLOG_W(TAG, "Unknown message type: %d", msg.type);
             break;
     }
 
     mesh_protocol_free_message(&msg);
     free(data_copy);
+    return msg.type;
+}
+
+// ============================================================================
+// MQTT → mesh
+// ============================================================================
+
+static void route_rules(const char *topic, const topic_params_t *params, const char *data, int data_len) {
+    rule_engine_handle_mqtt(data);
+}
+
+static void route_rollup(const char *topic, const topic_params_t *params, const char *data, int data_len) {
+    telemetry_rollup_handle_mqtt(data);
+}
+
+// hydro/trace/dump: пустой payload - дамп в hydro/trace/data, "uart" - в консоль
+static void route_trace_dump(const char *topic, const topic_params_t *params, const char *data, int data_len) {
+    if (data_len >= 4 && strncmp(data, "uart", 4) == 0) {
+        esp_err_t err = trace_ring_dump_uart();
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Trace dump to UART failed: %s", esp_err_to_name(err));
+        }
+        return;
+    }
+
+    size_t size = trace_ring_dump_size();
+    if (size == 0) {
+        ESP_LOGW(TAG, "Trace ring disabled in Kconfig");
+        return;
+    }
+
+    uint8_t *buf = mem_policy_malloc(MEM_COLD, size);
+    if (!buf) {
+        ESP_LOGE(TAG, "No memory for trace dump (%u bytes)", (unsigned)size);
+        return;
+    }
+
+    size_t len = trace_ring_dump(buf, size);
+    if (len > 0) {
+        mqtt_client_manager_publish_binary(MQTT_TOPIC_TRACE_DATA, buf, len);
+    }
+    free(buf);
+}
+
+// hydro/command/{node_id}, hydro/config/{node_id}, hydro/ota/{node_id}
+static void route_to_node(const char *topic, const topic_params_t *params, const char *data, int data_len) {
+    const char *node_id = params->values[0];
+
+    // Поиск узла в реестре (MAC копируется из согласованной версии)
+    uint8_t mac[6];
+    bool online = false;
+    const node_registry_view_t *view = node_registry_acquire();
+    const node_info_t *node = node_registry_view_find(view, node_id);
+    if (node && node->online) {
+        memcpy(mac, node->mac_addr, sizeof(mac));
+        online = true;
+    }
+    node_registry_release(view);
+
+    if (!online) {
+        ESP_LOGW(TAG, "Node %s offline or not found, message dropped", node_id);
+        return;
+    }
+
+    ESP_LOGI(TAG, "Forwarding %s to %s", topic, node_id);
+
+    // Отправка через mesh
+    esp_err_t err = mesh_manager_send(mac, (const uint8_t *)data, data_len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to send to node: %s", esp_err_to_name(err));
+    }
+}
+
+/*
+ * Групповая команда: адресаты берутся из одной версии реестра, сообщение
+ * уходит одной multicast передачей. node_id заменяется на
+ * MESH_NODE_ID_GROUP - узлы принимают его как адресованное им.
+ */
+static void route_to_group(bool by_zone, const char *value, const char *data) {
+    uint8_t (*macs)[6] = s_group_macs;
+    int count = 0;
+
+    const node_registry_view_t *view = node_registry_acquire();
+    for (int i = 0; view && i < view->count; i++) {
+        const node_info_t *node = &view->nodes[i];
+        const char *key = by_zone ? node->zone : node->node_type;
+        if (node->online && strcmp(key, value) == 0) {
+            memcpy(macs[count++], node->mac_addr, 6);
+        }
+    }
+    node_registry_release(view);
+
+    if (count == 0) {
+        ESP_LOGW(TAG, "No online nodes in %s %s, message dropped", by_zone ? "zone" : "type", value);
+        return;
+    }
+
+    cjson_arena_begin(s_mqtt_arena);
+    cJSON *root = cJSON_Parse(data);
+    if (!root || !cJSON_IsObject(root)) {
+        ESP_LOGW(TAG, "Group message is not a JSON object, dropped");
+        cJSON_Delete(root);
+        cjson_arena_end(s_mqtt_arena, "group");
+        return;
+    }
+    cJSON_DeleteItemFromObject(root, "node_id");
+    cJSON_AddStringToObject(root, "node_id", MESH_NODE_ID_GROUP);
+
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (!json) {
+        ESP_LOGE(TAG, "No memory for group message");
+        cjson_arena_end(s_mqtt_arena, "group");
+        return;
+    }
+
+    esp_err_t err = mesh_manager_multicast((const uint8_t (*)[6])macs, count, (const uint8_t *)json, strlen(json));
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Group %s %s: sent to %d nodes", by_zone ? "zone" : "type", value, count);
+    } else {
+        ESP_LOGE(TAG, "Failed to send group message: %s", esp_err_to_name(err));
+    }
+    cJSON_free(json);
+    cjson_arena_end(s_mqtt_arena, "group");
+}
+
+// hydro/command/zone/{zone}, hydro/ota/zone/{zone}
+static void route_to_zone(const char *topic, const topic_params_t *params, const char *data, int data_len) {
+    route_to_group(true, params->values[0], data);
+}
+
+// hydro/command/type/{type}, hydro/ota/type/{type}
+static void route_to_type(const char *topic, const topic_params_t *params, const char *data, int data_len) {
+    route_to_group(false, params->values[0], data);
+}
+
+static topic_trie_t s_mqtt_routes;
+
+static void build_mqtt_routes(void) {
+    topic_trie_init(&s_mqtt_routes);
+
+    topic_trie_add(&s_mqtt_routes, RULE_ENGINE_MQTT_TOPIC_SET, route_rules);
+    topic_trie_add(&s_mqtt_routes, ROLLUP_MQTT_TOPIC_SET, route_rollup);
+    topic_trie_add(&s_mqtt_routes, MQTT_TOPIC_TRACE_DUMP, route_trace_dump);
+
+    topic_trie_add(&s_mqtt_routes, MQTT_TOPIC_COMMAND "/+", route_to_node);
+    topic_trie_add(&s_mqtt_routes, MQTT_TOPIC_COMMAND "/zone/+", route_to_zone);
+    topic_trie_add(&s_mqtt_routes, MQTT_TOPIC_COMMAND "/type/+", route_to_type);
+    topic_trie_add(&s_mqtt_routes, MQTT_TOPIC_CONFIG "/+", route_to_node);
+    topic_trie_add(&s_mqtt_routes, MQTT_TOPIC_OTA "/+", route_to_node);
+    topic_trie_add(&s_mqtt_routes, MQTT_TOPIC_OTA "/zone/+", route_to_zone);
+    topic_trie_add(&s_mqtt_routes, MQTT_TOPIC_OTA "/type/+", route_to_type);
+}
+
+esp_err_t data_router_register_mqtt_route(const char *pattern, topic_handler_t handler) {
+    return topic_trie_add(&s_mqtt_routes, pattern, handler);
 }
 
 void data_router_handle_mqtt_data(const char *topic, const char *data, int data_len) {
     ESP_LOGI(TAG, "MQTT data received: %s (%d bytes)", topic, data_len);
 
-    // Парсинг топика: hydro/command/{node_id} или hydro/config/{node_id}
-    char node_id[32] = {0};
-    bool is_command = (strstr(topic, "/command/") != NULL);
-    bool is_config = (strstr(topic, "/config/") != NULL);
-
-    if (is_command || is_config) {
-        // Извлечение node_id из топика
-        const char *slash = strrchr(topic, '/');
-        if (slash && strlen(slash + 1) > 0) {
-            strncpy(node_id, slash + 1, sizeof(node_id) - 1);
-
-            // Поиск узла в реестре
-            node_info_t *node = node_registry_get(node_id);
-            if (node && node->online) {
-                ESP_LOGI(TAG, "Forwarding %s to %s", 
-                         is_command ? "command" : "config", node_id);
-
-                // Отправка через mesh
-                esp_err_t err = mesh_manager_send(node->mac_addr, 
-                                                  (const uint8_t *)data, data_len);
-                
-                if (err != ESP_OK) {
-                    ESP_LOGE(TAG, "Failed to send to node: %s", esp_err_to_name(err));
-                }
-            } else {
-                ESP_LOGW(TAG, "Node %s offline or not found, message dropped", node_id);
-            }
-        } else {
-            ESP_LOGW(TAG, "Invalid topic format: %s", topic);
-        }
+    topic_params_t params;
+    topic_handler_t handler = topic_trie_match(&s_mqtt_routes, topic, &params);
+    if (handler) {
+        handler(topic, &params, data, data_len);
     } else {
         ESP_LOGW(TAG, "Unknown MQTT topic: %s", topic);
     }
 }
-
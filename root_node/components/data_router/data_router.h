@@ -10,6 +10,9 @@
 #define DATA_ROUTER_H
 
 #include "esp_err.h"
+#include "topic_trie.h"
+#include "cjson_arena.h"
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -34,10 +37,46 @@ esp_err_t data_router_init(void);
  */
 void data_router_handle_mesh_data(const uint8_t *src_addr, const uint8_t *data, size_t len);
 
+/**
+ * @brief Обработка mesh сообщения в арене вызывающей задачи
+ * 
+ * То же, что data_router_handle_mesh_data(), для задач кроме приёма
+ * mesh (load_generator): арена mesh_rx принадлежит задаче mesh_recv,
+ * вызывающая задача передаёт свою.
+ * 
+ * @param arena Арена вызывающей задачи (NULL - выделения из heap)
+ * @param src_addr MAC адрес отправителя
+ * @param data Данные (JSON строка)
+ * @param len Длина данных
+ */
+void data_router_route_mesh_data(cjson_arena_t *arena, const uint8_t *src_addr,
+                                 const uint8_t *data, size_t len);
+
+/**
+ * @brief Регистрация обработчика MQTT топика
+ * 
+ * Встроенные маршруты (правила, rollup, команды/config/OTA узлам,
+ * зонам и типам) добавляются в data_router_init(). Компоненты, от
+ * которых data_router не зависит (load_generator), добавляют свои
+ * после data_router_init() из одной задачи (app_main). Топик должен
+ * попадать под подписки mqtt_client_manager.
+ * 
+ * @param pattern Шаблон топика ('+' - уровень, '#' - остаток)
+ * @param handler Обработчик (вызывается в задаче MQTT клиента)
+ * @return ESP_OK при успехе (см. topic_trie_add)
+ */
+esp_err_t data_router_register_mqtt_route(const char *pattern, topic_handler_t handler);
+
 /**
  * @brief Обработка команд от MQTT
  * 
- * Вызывается из mqtt_client_manager callback
+ * Вызывается из mqtt_client_manager callback. Топик сопоставляется с
+ * деревом маршрутов за один проход по уровням:
+ * - hydro/command/{node_id}, hydro/config/{node_id}, hydro/ota/{node_id} - узлу
+ * - hydro/command/zone/{zone}, hydro/ota/zone/{zone} - online узлам зоны
+ * - hydro/command/type/{type}, hydro/ota/type/{type} - online узлам типа
+ * 
+ * Групповые сообщения уходят одной multicast передачей.
  * 
  * @param topic MQTT топик
  * @param data Данные (JSON строка)
@@ -0,0 +1,159 @@
+/**
+ * @file topic_trie.c
+ * @brief Реализация дерева MQTT топиков
+ */
+
+#include "topic_trie.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "topic_trie";
+
+// Длина текущего уровня топика (до '/' или конца строки)
+static size_t segment_len(const char *s) {
+    const char *slash = strchr(s, '/');
+    return slash ? (size_t)(slash - s) : strlen(s);
+}
+
+static bool segment_equals(const char *segment, const char *s, size_t len) {
+    return strlen(segment) == len && strncmp(segment, s, len) == 0;
+}
+
+static int find_child(const topic_trie_t *trie, int parent, const char *s, size_t len) {
+    for (int i = trie->nodes[parent].first_child; i >= 0; i = trie->nodes[i].next_sibling) {
+        if (segment_equals(trie->nodes[i].segment, s, len)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void topic_trie_init(topic_trie_t *trie) {
+    memset(trie, 0, sizeof(*trie));
+    trie->nodes[0].first_child = -1;
+    trie->nodes[0].next_sibling = -1;
+    trie->count = 1;
+}
+
+esp_err_t topic_trie_add(topic_trie_t *trie, const char *pattern, topic_handler_t handler) {
+    if (!trie || !pattern || !handler || pattern[0] == '\0') {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int node = 0;
+    int params = 0;
+    const char *s = pattern;
+
+    while (1) {
+        size_t len = segment_len(s);
+        bool last = (s[len] == '\0');
+
+        if (len == 0 || len >= TOPIC_TRIE_SEGMENT_LEN) {
+            ESP_LOGE(TAG, "Bad level in pattern %s", pattern);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (len == 1 && s[0] == '#' && !last) {
+            ESP_LOGE(TAG, "'#' must be the last level: %s", pattern);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (len == 1 && s[0] == '+' && ++params > TOPIC_TRIE_MAX_PARAMS) {
+            ESP_LOGE(TAG, "Too many '+' levels: %s", pattern);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        int child = find_child(trie, node, s, len);
+        if (child < 0) {
+            if (trie->count >= TOPIC_TRIE_MAX_NODES) {
+                ESP_LOGE(TAG, "Trie full, cannot add %s", pattern);
+                return ESP_ERR_NO_MEM;
+            }
+
+            child = trie->count++;
+            topic_trie_node_t *n = &trie->nodes[child];
+            memcpy(n->segment, s, len);
+            n->segment[len] = '\0';
+            n->first_child = -1;
+            n->handler = NULL;
+
+            // Новый уровень - в начало списка: порядок братьев не важен.
+            // Узел заполнен до связывания - параллельный поиск его не увидит недостроенным
+            n->next_sibling = trie->nodes[node].first_child;
+            __atomic_store_n(&trie->nodes[node].first_child, (int8_t)child, __ATOMIC_RELEASE);
+        }
+        node = child;
+
+        if (last) {
+            break;
+        }
+        s += len + 1;
+    }
+
+    if (trie->nodes[node].handler) {
+        ESP_LOGE(TAG, "Duplicate pattern %s", pattern);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    __atomic_store_n(&trie->nodes[node].handler, handler, __ATOMIC_RELEASE);
+    return ESP_OK;
+}
+
+/*
+ * s - остаток топика начиная с текущего уровня, NULL - уровни кончились.
+ * Глубина рекурсии не больше числа уровней шаблона.
+ */
+static topic_handler_t match_node(const topic_trie_t *trie, int node, const char *s,
+                                  topic_params_t *params) {
+    int plus = -1;
+    int hash = -1;
+    for (int i = trie->nodes[node].first_child; i >= 0; i = trie->nodes[i].next_sibling) {
+        const char *seg = trie->nodes[i].segment;
+        if (strcmp(seg, "+") == 0) {
+            plus = i;
+        } else if (strcmp(seg, "#") == 0) {
+            hash = i;
+        }
+    }
+
+    if (s == NULL) {
+        // "a/#" совпадает и с "a" (как в MQTT)
+        if (trie->nodes[node].handler) {
+            return trie->nodes[node].handler;
+        }
+        return (hash >= 0) ? trie->nodes[hash].handler : NULL;
+    }
+
+    size_t len = segment_len(s);
+    const char *next = (s[len] == '/') ? s + len + 1 : NULL;
+
+    int literal = find_child(trie, node, s, len);
+    if (literal >= 0 && literal != plus && literal != hash) {
+        topic_handler_t h = match_node(trie, literal, next, params);
+        if (h) {
+            return h;
+        }
+    }
+
+    if (plus >= 0 && len > 0 && len < TOPIC_TRIE_PARAM_LEN &&
+        params->count < TOPIC_TRIE_MAX_PARAMS) {
+        int slot = params->count++;
+        memcpy(params->values[slot], s, len);
+        params->values[slot][len] = '\0';
+
+        topic_handler_t h = match_node(trie, plus, next, params);
+        if (h) {
+            return h;
+        }
+        params->count--;
+    }
+
+    return (hash >= 0) ? trie->nodes[hash].handler : NULL;
+}
+
+topic_handler_t topic_trie_match(const topic_trie_t *trie, const char *topic, topic_params_t *params) {
+    if (!trie || !topic || !params) {
+        return NULL;
+    }
+
+    params->count = 0;
+    return match_node(trie, 0, topic, params);
+}
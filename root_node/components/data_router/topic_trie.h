@@ -0,0 +1,100 @@
+/**
+ * @file topic_trie.h
+ * @brief Префиксное дерево MQTT топиков для маршрутизации входящих сообщений
+ *
+ * Шаблоны строятся один раз при инициализации; сопоставление топика -
+ * один проход по уровням без выделения памяти. Поддерживаются
+ * MQTT-шаблоны '+' (один уровень, значение попадает в параметры) и
+ * '#' (остаток топика, только последним уровнем). При совпадении
+ * нескольких шаблонов точный уровень важнее '+', '+' важнее '#'.
+ */
+
+#ifndef TOPIC_TRIE_H
+#define TOPIC_TRIE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TOPIC_TRIE_MAX_NODES    32      ///< Узлов дерева (уровней всех шаблонов)
+#define TOPIC_TRIE_SEGMENT_LEN  16      ///< Макс. длина уровня шаблона + '\0'
+#define TOPIC_TRIE_MAX_PARAMS   2       ///< Макс. '+' в одном шаблоне
+#define TOPIC_TRIE_PARAM_LEN    32      ///< Макс. длина значения '+' + '\0'
+
+/**
+ * @brief Значения уровней '+' совпавшего шаблона (слева направо)
+ */
+typedef struct {
+    int count;
+    char values[TOPIC_TRIE_MAX_PARAMS][TOPIC_TRIE_PARAM_LEN];
+} topic_params_t;
+
+/**
+ * @brief Обработчик топика
+ *
+ * @param topic Полный топик
+ * @param params Значения '+'
+ * @param data Данные (null-terminated)
+ * @param data_len Длина данных
+ */
+typedef void (*topic_handler_t)(const char *topic, const topic_params_t *params,
+                                const char *data, int data_len);
+
+/**
+ * @brief Узел дерева (один уровень шаблона)
+ */
+typedef struct {
+    char segment[TOPIC_TRIE_SEGMENT_LEN];   ///< Уровень ("command", "+", "#")
+    int8_t first_child;                     ///< Индекс первого потомка (-1 - нет)
+    int8_t next_sibling;                    ///< Индекс следующего брата (-1 - нет)
+    topic_handler_t handler;                ///< Обработчик, если здесь кончается шаблон
+} topic_trie_node_t;
+
+/**
+ * @brief Дерево топиков (узел 0 - корень)
+ */
+typedef struct {
+    topic_trie_node_t nodes[TOPIC_TRIE_MAX_NODES];
+    int count;
+} topic_trie_t;
+
+/**
+ * @brief Инициализация пустого дерева
+ *
+ * @param trie Дерево
+ */
+void topic_trie_init(topic_trie_t *trie);
+
+/**
+ * @brief Добавление шаблона
+ *
+ * Добавлять шаблоны может только одна задача; параллельное
+ * topic_trie_match() допустимо - новый шаблон становится виден целиком.
+ *
+ * @param trie Дерево
+ * @param pattern Шаблон ("hydro/command/zone/+")
+ * @param handler Обработчик
+ * @return ESP_OK, ESP_ERR_INVALID_ARG (некорректный шаблон),
+ *         ESP_ERR_INVALID_STATE (шаблон уже есть), ESP_ERR_NO_MEM (нет узлов)
+ */
+esp_err_t topic_trie_add(topic_trie_t *trie, const char *pattern, topic_handler_t handler);
+
+/**
+ * @brief Поиск обработчика для топика
+ *
+ * @param trie Дерево
+ * @param topic Топик
+ * @param params Значения '+' совпавшего шаблона
+ * @return Обработчик или NULL, если ни один шаблон не подошёл
+ */
+topic_handler_t topic_trie_match(const topic_trie_t *trie, const char *topic, topic_params_t *params);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TOPIC_TRIE_H
@@ -0,0 +1,451 @@
+/**
+ * @file load_generator.c
+ * @brief Реализация синтетического генератора нагрузки
+ */
+
+#include "load_generator.h"
+#include "data_router.h"
+#include "node_registry.h"
+#include "telemetry_rollup.h"
+#include "mqtt_client_manager.h"
+#include "mqtt_metrics.h"
+#include "cjson_arena.h"
+#include "cJSON.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *TAG = "load_generator";
+
+#define LOADGEN_NODE_PREFIX     "loadgen_"
+#define LOADGEN_NODE_TYPE       "loadgen"   // НЕ "climate" - иначе отключится climate fallback
+
+typedef enum {
+    LOADGEN_KIND_TELEMETRY = 0,
+    LOADGEN_KIND_HEARTBEAT,
+    LOADGEN_KIND_EVENT,
+    LOADGEN_KIND_REQUEST,
+    LOADGEN_KIND_MAX
+} loadgen_kind_t;
+
+typedef struct {
+    uint32_t *samples;          // Выборка задержек (мкс)
+    uint32_t sample_count;      // Заполнено элементов
+    uint32_t seen;              // Всего измерений (для reservoir sampling)
+    uint32_t max_us;
+} latency_samples_t;
+
+// Своя арена: mesh_rx занята задачей mesh_recv (создаётся один раз -
+// арены не удаляются, задача прогона новая на каждый запуск)
+static cjson_arena_t *s_arena = NULL;
+
+static void virtual_node_id(uint16_t index, char *out, size_t out_len) {
+    snprintf(out, out_len, LOADGEN_NODE_PREFIX "%03u", (unsigned)index);
+}
+
+static void virtual_node_mac(uint16_t index, uint8_t mac[6]) {
+    // Локально администрируемый MAC (бит 0x02) - не пересекается с реальными узлами
+    mac[0] = 0x02;
+    mac[1] = 0x4C;  // 'L'
+    mac[2] = 0x47;  // 'G'
+    mac[3] = 0x00;
+    mac[4] = (uint8_t)(index >> 8);
+    mac[5] = (uint8_t)(index & 0xFF);
+}
+
+static int build_message(loadgen_kind_t kind, const char *node_id, uint32_t seq,
+                         char *buf, size_t buf_len) {
+    uint32_t uptime_s = (uint32_t)(esp_timer_get_time() / 1000000);
+
+    switch (kind) {
+        case LOADGEN_KIND_TELEMETRY:
+            return snprintf(buf, buf_len,
+                "{\"type\":\"telemetry\",\"node_id\":\"%s\",\"node_type\":\"" LOADGEN_NODE_TYPE "\","
+                "\"timestamp\":%lu,\"data\":{\"ph\":%.2f,\"ec\":%.2f,\"temp\":%.1f,\"seq\":%lu}}",
+                node_id, (unsigned long)uptime_s,
+                6.0 + (seq % 100) / 100.0, 1.5 + (seq % 50) / 100.0, 20.0 + (seq % 80) / 10.0,
+                (unsigned long)seq);
+
+        case LOADGEN_KIND_HEARTBEAT:
+            return snprintf(buf, buf_len,
+                "{\"type\":\"heartbeat\",\"node_id\":\"%s\",\"node_type\":\"" LOADGEN_NODE_TYPE "\","
+                "\"timestamp\":%lu,\"uptime\":%lu,\"heap_free\":%lu}",
+                node_id, (unsigned long)uptime_s, (unsigned long)uptime_s,
+                (unsigned long)esp_get_free_heap_size());
+
+        case LOADGEN_KIND_EVENT:
+            return snprintf(buf, buf_len,
+                "{\"type\":\"event\",\"node_id\":\"%s\",\"timestamp\":%lu,"
+                "\"level\":\"info\",\"message\":\"loadgen event %lu\"}",
+                node_id, (unsigned long)uptime_s, (unsigned long)seq);
+
+        case LOADGEN_KIND_REQUEST:
+            // node_id добавлен, чтобы запрос не создавал в реестре узел с пустым ID
+            return snprintf(buf, buf_len,
+                "{\"type\":\"request\",\"node_id\":\"%s\",\"from\":\"%s\",\"request\":\"all_nodes_data\"}",
+                node_id, node_id);
+
+        default:
+            return -1;
+    }
+}
+
+static void samples_add(latency_samples_t *s, uint32_t value_us) {
+    if (value_us > s->max_us) {
+        s->max_us = value_us;
+    }
+
+    s->seen++;
+    if (s->sample_count < LOADGEN_MAX_SAMPLES) {
+        s->samples[s->sample_count++] = value_us;
+    } else {
+        // Reservoir sampling: каждое измерение попадает в выборку с вероятностью N/seen
+        uint32_t j = esp_random() % s->seen;
+        if (j < LOADGEN_MAX_SAMPLES) {
+            s->samples[j] = value_us;
+        }
+    }
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentile(const uint32_t *sorted, uint32_t count, uint32_t pct) {
+    if (count == 0) {
+        return 0;
+    }
+    uint32_t idx = (count * pct) / 100;
+    if (idx >= count) {
+        idx = count - 1;
+    }
+    return sorted[idx];
+}
+
+static uint32_t published_node_traffic(const mqtt_metrics_snapshot_t *snap) {
+    return snap->published[MQTT_TOPIC_CLASS_TELEMETRY] +
+           snap->published[MQTT_TOPIC_CLASS_HEARTBEAT] +
+           snap->published[MQTT_TOPIC_CLASS_EVENT];
+}
+
+static uint32_t failed_node_traffic(const mqtt_metrics_snapshot_t *snap) {
+    return snap->failed[MQTT_TOPIC_CLASS_TELEMETRY] +
+           snap->failed[MQTT_TOPIC_CLASS_HEARTBEAT] +
+           snap->failed[MQTT_TOPIC_CLASS_EVENT];
+}
+
+void load_generator_default_config(load_generator_config_t *config) {
+    if (!config) {
+        return;
+    }
+
+    memset(config, 0, sizeof(*config));
+#ifdef CONFIG_ROOT_LOADGEN_ENABLE
+    config->num_nodes = CONFIG_ROOT_LOADGEN_NODES;
+    config->telemetry_interval_ms = CONFIG_ROOT_LOADGEN_TELEMETRY_INTERVAL_MS;
+    config->heartbeat_interval_ms = CONFIG_ROOT_LOADGEN_HEARTBEAT_INTERVAL_MS;
+    config->event_interval_ms = CONFIG_ROOT_LOADGEN_EVENT_INTERVAL_MS;
+    config->request_interval_ms = CONFIG_ROOT_LOADGEN_REQUEST_INTERVAL_MS;
+    config->duration_ms = CONFIG_ROOT_LOADGEN_DURATION_S * 1000;
+#else
+    config->num_nodes = 20;
+    config->telemetry_interval_ms = 1000;
+    config->heartbeat_interval_ms = 5000;
+    config->event_interval_ms = 30000;
+    config->request_interval_ms = 0;
+    config->duration_ms = 60000;
+#endif
+}
+
+esp_err_t load_generator_run(const load_generator_config_t *config, load_generator_report_t *report) {
+    if (!config || !report || config->num_nodes == 0 || config->duration_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(report, 0, sizeof(*report));
+
+    const uint32_t intervals[LOADGEN_KIND_MAX] = {
+        config->telemetry_interval_ms,
+        config->heartbeat_interval_ms,
+        config->event_interval_ms,
+        config->request_interval_ms,
+    };
+
+    // Расписание: следующий момент отправки (мс от старта) для каждого узла и типа
+    uint32_t *next_due = calloc((size_t)config->num_nodes * LOADGEN_KIND_MAX, sizeof(uint32_t));
+    latency_samples_t lat = {0};
+    lat.samples = malloc(LOADGEN_MAX_SAMPLES * sizeof(uint32_t));
+
+    if (!next_due || !lat.samples) {
+        ESP_LOGE(TAG, "Failed to allocate benchmark buffers");
+        free(next_due);
+        free(lat.samples);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Равномерный разнос фаз, чтобы узлы не отправляли всё в один тик
+    for (uint16_t n = 0; n < config->num_nodes; n++) {
+        for (int k = 0; k < LOADGEN_KIND_MAX; k++) {
+            next_due[n * LOADGEN_KIND_MAX + k] =
+                intervals[k] ? (uint32_t)(((uint64_t)intervals[k] * n) / config->num_nodes) : UINT32_MAX;
+        }
+    }
+
+    ESP_LOGI(TAG, "Load run: %u nodes, telemetry=%lu ms, heartbeat=%lu ms, event=%lu ms, request=%lu ms, %lu ms",
+             config->num_nodes,
+             (unsigned long)config->telemetry_interval_ms, (unsigned long)config->heartbeat_interval_ms,
+             (unsigned long)config->event_interval_ms, (unsigned long)config->request_interval_ms,
+             (unsigned long)config->duration_ms);
+
+    mqtt_metrics_snapshot_t before;
+    mqtt_metrics_get_snapshot(&before);
+
+    // Минимум ведёт аллокатор (все задачи, любой момент), а не выборка раз за цикл
+    report->heap_start = esp_get_free_heap_size();
+    uint32_t min_before = esp_get_minimum_free_heap_size();
+
+    uint32_t *sent_by_kind[LOADGEN_KIND_MAX] = {
+        &report->sent_telemetry, &report->sent_heartbeat, &report->sent_event, &report->sent_request
+    };
+
+    char node_id[32];
+    uint8_t mac[6];
+    char msg[320];
+    uint32_t seq = 0;
+    int64_t start_us = esp_timer_get_time();
+    uint32_t now_ms = 0;
+
+    while (now_ms < config->duration_ms) {
+        now_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+
+        for (uint16_t n = 0; n < config->num_nodes; n++) {
+            for (int k = 0; k < LOADGEN_KIND_MAX; k++) {
+                uint32_t *due = &next_due[n * LOADGEN_KIND_MAX + k];
+
+                // Догоняем расписание (при насыщении отставание растёт)
+                while (*due <= now_ms && *due < config->duration_ms) {
+                    uint32_t lag = now_ms - *due;
+                    if (lag > report->max_schedule_lag_ms) {
+                        report->max_schedule_lag_ms = lag;
+                    }
+
+                    virtual_node_id(n, node_id, sizeof(node_id));
+                    virtual_node_mac(n, mac);
+                    int len = build_message((loadgen_kind_t)k, node_id, seq++, msg, sizeof(msg));
+
+                    if (len > 0 && len < (int)sizeof(msg)) {
+                        int64_t t0 = esp_timer_get_time();
+                        data_router_route_mesh_data(s_arena, mac, (const uint8_t *)msg, (size_t)len);
+                        samples_add(&lat, (uint32_t)(esp_timer_get_time() - t0));
+                        (*sent_by_kind[k])++;
+                    }
+
+                    *due += intervals[k];
+                }
+            }
+        }
+
+        vTaskDelay(1);  // Отдаём CPU mesh_recv/MQTT задачам, минимальный шаг расписания
+    }
+
+    report->elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+
+    // Даём MQTT клиенту отправить хвост
+    vTaskDelay(pdMS_TO_TICKS(500));
+
+    mqtt_metrics_snapshot_t after;
+    mqtt_metrics_get_snapshot(&after);
+
+    uint32_t to_publish = report->sent_telemetry + report->sent_heartbeat + report->sent_event;
+    report->published = published_node_traffic(&after) - published_node_traffic(&before);
+    report->publish_failures = failed_node_traffic(&after) - failed_node_traffic(&before);
+    report->dropped = (to_publish > report->published) ? (to_publish - report->published) : 0;
+    report->heap_end = esp_get_free_heap_size();
+    report->heap_low_water = esp_get_minimum_free_heap_size();
+    report->heap_min_drop = min_before - report->heap_low_water;
+
+    const node_registry_view_t *view = node_registry_acquire();
+    for (uint16_t n = 0; n < config->num_nodes; n++) {
+        virtual_node_id(n, node_id, sizeof(node_id));
+        if (node_registry_view_find(view, node_id) != NULL) {
+            report->registered_nodes++;
+        }
+    }
+    node_registry_release(view);
+
+    // Виртуальные узлы не остаются в /api/nodes, метриках и rollup после прогона
+    for (uint16_t n = 0; n < config->num_nodes; n++) {
+        virtual_node_id(n, node_id, sizeof(node_id));
+        node_registry_remove(node_id);
+        telemetry_rollup_remove(node_id);
+    }
+
+    uint32_t total_sent = to_publish + report->sent_request;
+    report->throughput_msg_s = report->elapsed_ms ? (total_sent * 1000.0f) / report->elapsed_ms : 0.0f;
+
+    qsort(lat.samples, lat.sample_count, sizeof(uint32_t), cmp_u32);
+    report->latency_p50_us = percentile(lat.samples, lat.sample_count, 50);
+    report->latency_p90_us = percentile(lat.samples, lat.sample_count, 90);
+    report->latency_p99_us = percentile(lat.samples, lat.sample_count, 99);
+    report->latency_max_us = lat.max_us;
+
+    free(next_due);
+    free(lat.samples);
+
+    return ESP_OK;
+}
+
+static void log_report(const load_generator_config_t *config, const load_generator_report_t *r) {
+    ESP_LOGI(TAG, "========================================");
+    ESP_LOGI(TAG, "=== LOAD GENERATOR REPORT ===");
+    ESP_LOGI(TAG, "Nodes: %u (registered: %u)", config->num_nodes, r->registered_nodes);
+    ESP_LOGI(TAG, "Sent: telemetry=%lu heartbeat=%lu event=%lu request=%lu",
+             (unsigned long)r->sent_telemetry, (unsigned long)r->sent_heartbeat,
+             (unsigned long)r->sent_event, (unsigned long)r->sent_request);
+    ESP_LOGI(TAG, "Published: %lu, dropped: %lu, publish failures: %lu",
+             (unsigned long)r->published, (unsigned long)r->dropped, (unsigned long)r->publish_failures);
+    ESP_LOGI(TAG, "Throughput: %.1f msg/s over %lu ms (max schedule lag %lu ms)",
+             r->throughput_msg_s, (unsigned long)r->elapsed_ms, (unsigned long)r->max_schedule_lag_ms);
+    ESP_LOGI(TAG, "Latency us: p50=%lu p90=%lu p99=%lu max=%lu",
+             (unsigned long)r->latency_p50_us, (unsigned long)r->latency_p90_us,
+             (unsigned long)r->latency_p99_us, (unsigned long)r->latency_max_us);
+    ESP_LOGI(TAG, "Heap: start=%lu low=%lu (min dropped by %lu) end=%lu",
+             (unsigned long)r->heap_start, (unsigned long)r->heap_low_water,
+             (unsigned long)r->heap_min_drop, (unsigned long)r->heap_end);
+    ESP_LOGI(TAG, "========================================");
+}
+
+static void publish_report(const load_generator_config_t *config, const load_generator_report_t *r) {
+    if (!mqtt_client_manager_is_connected()) {
+        return;
+    }
+
+    char buf[704];
+    int len = snprintf(buf, sizeof(buf),
+        "{\"type\":\"loadgen_report\",\"nodes\":%u,\"registered_nodes\":%u,"
+        "\"telemetry_interval_ms\":%lu,\"heartbeat_interval_ms\":%lu,"
+        "\"event_interval_ms\":%lu,\"request_interval_ms\":%lu,"
+        "\"sent\":{\"telemetry\":%lu,\"heartbeat\":%lu,\"event\":%lu,\"request\":%lu},"
+        "\"published\":%lu,\"dropped\":%lu,\"publish_failures\":%lu,"
+        "\"elapsed_ms\":%lu,\"throughput_msg_s\":%.1f,\"max_schedule_lag_ms\":%lu,"
+        "\"latency_us\":{\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,\"max\":%lu},"
+        "\"heap\":{\"start\":%lu,\"low_water\":%lu,\"min_drop\":%lu,\"end\":%lu}}",
+        config->num_nodes, r->registered_nodes,
+        (unsigned long)config->telemetry_interval_ms, (unsigned long)config->heartbeat_interval_ms,
+        (unsigned long)config->event_interval_ms, (unsigned long)config->request_interval_ms,
+        (unsigned long)r->sent_telemetry, (unsigned long)r->sent_heartbeat,
+        (unsigned long)r->sent_event, (unsigned long)r->sent_request,
+        (unsigned long)r->published, (unsigned long)r->dropped, (unsigned long)r->publish_failures,
+        (unsigned long)r->elapsed_ms, r->throughput_msg_s, (unsigned long)r->max_schedule_lag_ms,
+        (unsigned long)r->latency_p50_us, (unsigned long)r->latency_p90_us,
+        (unsigned long)r->latency_p99_us, (unsigned long)r->latency_max_us,
+        (unsigned long)r->heap_start, (unsigned long)r->heap_low_water,
+        (unsigned long)r->heap_min_drop, (unsigned long)r->heap_end);
+
+    if (len > 0 && len < (int)sizeof(buf)) {
+        mqtt_client_manager_publish(LOADGEN_MQTT_TOPIC, buf);
+    }
+}
+
+static volatile bool s_running = false;
+
+/*
+ * arg == NULL - прогон по Kconfig после CONFIG_ROOT_LOADGEN_START_DELAY_S,
+ * иначе - параметры из hydro/bench/loadgen (освобождаются задачей).
+ */
+static void load_generator_task(void *arg) {
+    load_generator_config_t config;
+    load_generator_report_t report;
+
+    if (arg) {
+        config = *(load_generator_config_t *)arg;
+        free(arg);
+    } else {
+#ifdef CONFIG_ROOT_LOADGEN_ENABLE
+        ESP_LOGW(TAG, "Load generator armed: run starts in %d s", CONFIG_ROOT_LOADGEN_START_DELAY_S);
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_ROOT_LOADGEN_START_DELAY_S * 1000));
+#endif
+        load_generator_default_config(&config);
+    }
+
+    if (load_generator_run(&config, &report) == ESP_OK) {
+        log_report(&config, &report);
+        publish_report(&config, &report);
+    } else {
+        ESP_LOGE(TAG, "Load run failed");
+    }
+
+    s_running = false;
+    vTaskDelete(NULL);
+}
+
+static esp_err_t spawn_run(load_generator_config_t *config) {
+    if (s_running) {
+        ESP_LOGW(TAG, "Load run already in progress");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_running = true;
+    BaseType_t ret = xTaskCreate(load_generator_task, "loadgen", 8192, config, 4, NULL);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create load generator task");
+        s_running = false;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static uint32_t json_u32(const cJSON *obj, const char *key, uint32_t def) {
+    const cJSON *item = cJSON_GetObjectItem(obj, key);
+    return (item && cJSON_IsNumber(item) && item->valuedouble >= 0) ? (uint32_t)item->valuedouble : def;
+}
+
+// hydro/bench/loadgen: {"nodes":20,"telemetry_interval_ms":500,...,"duration_s":30}
+static void bench_route(const char *topic, const topic_params_t *params, const char *data, int data_len) {
+    load_generator_config_t *config = malloc(sizeof(load_generator_config_t));
+    if (!config) {
+        ESP_LOGE(TAG, "No memory for bench request");
+        return;
+    }
+    load_generator_default_config(config);
+
+    cJSON *root = cJSON_Parse(data);
+    if (root) {
+        config->num_nodes = (uint16_t)json_u32(root, "nodes", config->num_nodes);
+        config->telemetry_interval_ms = json_u32(root, "telemetry_interval_ms", config->telemetry_interval_ms);
+        config->heartbeat_interval_ms = json_u32(root, "heartbeat_interval_ms", config->heartbeat_interval_ms);
+        config->event_interval_ms = json_u32(root, "event_interval_ms", config->event_interval_ms);
+        config->request_interval_ms = json_u32(root, "request_interval_ms", config->request_interval_ms);
+        config->duration_ms = json_u32(root, "duration_s", config->duration_ms / 1000) * 1000;
+        cJSON_Delete(root);
+    }
+
+    ESP_LOGW(TAG, "Bench run requested over MQTT: %u nodes, %lu s",
+             config->num_nodes, (unsigned long)(config->duration_ms / 1000));
+    if (spawn_run(config) != ESP_OK) {
+        free(config);
+    }
+}
+
+esp_err_t load_generator_start(void) {
+#ifdef CONFIG_ROOT_LOADGEN_ENABLE
+    s_arena = cjson_arena_create("loadgen", CJSON_ARENA_DEFAULT_SIZE);
+
+    // Повторные прогоны без перепрошивки - по MQTT
+    if (data_router_register_mqtt_route(LOADGEN_MQTT_TOPIC_RUN, bench_route) != ESP_OK) {
+        ESP_LOGW(TAG, "Bench topic %s not registered", LOADGEN_MQTT_TOPIC_RUN);
+    }
+    return spawn_run(NULL);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
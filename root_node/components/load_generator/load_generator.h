@@ -0,0 +1,98 @@
+/**
+ * @file load_generator.h
+ * @brief Синтетический генератор нагрузки для тракта данных ROOT
+ *
+ * Эмулирует N виртуальных узлов, которые отправляют telemetry, heartbeat,
+ * event и запросы Display напрямую в data_router_handle_mesh_data().
+ * Измеряет пропускную способность, перцентили задержки обработки,
+ * минимум свободной памяти и количество потерянных сообщений.
+ *
+ * Используется как воспроизводимый тест ёмкости связки
+ * data_router + node_registry + mqtt_client_manager.
+ */
+
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOADGEN_MAX_SAMPLES     2048                    ///< Размер выборки задержек (reservoir sampling)
+#define LOADGEN_MQTT_TOPIC      "hydro/metrics/root/loadgen"
+#define LOADGEN_MQTT_TOPIC_RUN  "hydro/bench/loadgen"          ///< Запуск прогона по MQTT (JSON параметры)
+
+/**
+ * @brief Параметры прогона
+ */
+typedef struct {
+    uint16_t num_nodes;                 ///< Количество виртуальных узлов
+    uint32_t telemetry_interval_ms;     ///< Интервал telemetry на узел (0 = выкл)
+    uint32_t heartbeat_interval_ms;     ///< Интервал heartbeat на узел (0 = выкл)
+    uint32_t event_interval_ms;         ///< Интервал event на узел (0 = выкл)
+    uint32_t request_interval_ms;       ///< Интервал запросов Display на узел (0 = выкл)
+    uint32_t duration_ms;               ///< Длительность прогона
+} load_generator_config_t;
+
+/**
+ * @brief Результаты прогона
+ */
+typedef struct {
+    uint32_t sent_telemetry;            ///< Отправлено telemetry
+    uint32_t sent_heartbeat;            ///< Отправлено heartbeat
+    uint32_t sent_event;                ///< Отправлено event
+    uint32_t sent_request;              ///< Отправлено запросов Display
+    uint32_t published;                 ///< Опубликовано в MQTT (telemetry + heartbeat + event)
+    uint32_t dropped;                   ///< Не дошло до MQTT (отправлено - опубликовано)
+    uint32_t publish_failures;          ///< Ошибки публикации (из mqtt_metrics)
+    uint16_t registered_nodes;          ///< Виртуальных узлов в реестре после прогона
+    uint32_t elapsed_ms;                ///< Фактическая длительность
+    float throughput_msg_s;             ///< Обработано сообщений в секунду
+    uint32_t latency_p50_us;            ///< Медиана времени обработки
+    uint32_t latency_p90_us;            ///< 90-й перцентиль
+    uint32_t latency_p99_us;            ///< 99-й перцентиль
+    uint32_t latency_max_us;            ///< Максимум
+    uint32_t max_schedule_lag_ms;       ///< Макс. отставание от расписания (признак насыщения)
+    uint32_t heap_start;                ///< Свободная память до прогона
+    uint32_t heap_low_water;            ///< Минимум свободной памяти с загрузки (после прогона)
+    uint32_t heap_min_drop;             ///< На сколько прогон опустил этот минимум (0 - не опустил)
+    uint32_t heap_end;                  ///< Свободная память после прогона
+} load_generator_report_t;
+
+/**
+ * @brief Заполнение параметров из Kconfig (CONFIG_ROOT_LOADGEN_*)
+ *
+ * @param config Структура для заполнения
+ */
+void load_generator_default_config(load_generator_config_t *config);
+
+/**
+ * @brief Синхронный прогон нагрузки (блокирует вызывающую задачу)
+ *
+ * @param config Параметры прогона
+ * @param report Результаты
+ * @return ESP_OK при успехе
+ */
+esp_err_t load_generator_run(const load_generator_config_t *config, load_generator_report_t *report);
+
+/**
+ * @brief Запуск фоновой задачи: задержка CONFIG_ROOT_LOADGEN_START_DELAY_S,
+ *        прогон с параметрами из Kconfig, лог и публикация отчёта
+ *
+ * Также регистрирует LOADGEN_MQTT_TOPIC_RUN в data_router: повторный
+ * прогон с параметрами из JSON (nodes, *_interval_ms, duration_s;
+ * отсутствующие - из Kconfig). Вызывать после data_router_init().
+ *
+ * @return ESP_OK при успехе, ESP_ERR_NOT_SUPPORTED если генератор выключен в Kconfig
+ */
+esp_err_t load_generator_start(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOAD_GENERATOR_H
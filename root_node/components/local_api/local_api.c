@@ -0,0 +1,634 @@
+/**
+ * @file local_api.c
+ * @brief Реализация локального HTTP + WebSocket API
+ */
+
+#include "local_api.h"
+#include "node_history.h"
+#include "node_registry.h"
+#include "mesh_protocol.h"
+#include "mesh_manager.h"
+#include "mqtt_metrics.h"
+#include "rule_engine.h"
+#include "instrumentation.h"
+#include "mem_policy.h"
+#include "cjson_arena.h"
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_mac.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+static const char *TAG = "local_api";
+
+#ifndef CONFIG_ROOT_HTTP_API_PORT
+#define CONFIG_ROOT_HTTP_API_PORT           80
+#endif
+#ifndef CONFIG_ROOT_HTTP_API_WS_MAX_CLIENTS
+#define CONFIG_ROOT_HTTP_API_WS_MAX_CLIENTS 4
+#endif
+
+#define LOCAL_API_HISTORY_PREFIX    "/api/nodes/"
+#define LOCAL_API_HISTORY_SUFFIX    "/history"
+#define LOCAL_API_TOPOLOGY_MAX      64
+#define LOCAL_API_WS_RX_MAX         128
+
+static httpd_handle_t s_server = NULL;
+static int s_ws_fds[CONFIG_ROOT_HTTP_API_WS_MAX_CLIENTS];
+static int s_ws_count = 0;
+static portMUX_TYPE s_ws_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Отправка WebSocket кадра из задачи httpd (httpd_queue_work)
+typedef struct {
+    int fd;             ///< -1 - всем клиентам
+    char *payload;      ///< Освобождается после отправки
+} ws_send_job_t;
+
+// ============================================================================
+// ВСПОМОГАТЕЛЬНЫЕ
+// ============================================================================
+
+static esp_err_t send_json(httpd_req_t *req, cJSON *json) {
+    if (!json) {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON build failed");
+    }
+
+    char *str = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+    if (!str) {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+    esp_err_t err = httpd_resp_sendstr(req, str);
+    free(str);
+    return err;
+}
+
+static cJSON* node_to_json(const node_info_t *node, uint64_t now_ms) {
+    cJSON *obj = cJSON_CreateObject();
+    if (!obj) {
+        return NULL;
+    }
+
+    char mac_str[18];
+    snprintf(mac_str, sizeof(mac_str), MACSTR, MAC2STR(node->mac_addr));
+
+    cJSON_AddStringToObject(obj, "node_id", node->node_id);
+    cJSON_AddStringToObject(obj, "node_type", node->node_type);
+    cJSON_AddStringToObject(obj, "zone", node->zone);
+    cJSON_AddStringToObject(obj, "mac_addr", mac_str);
+    cJSON_AddBoolToObject(obj, "online", node->online);
+    cJSON_AddNumberToObject(obj, "last_seen_ms_ago", (double)(now_ms - node->last_seen_ms));
+    cJSON_AddNumberToObject(obj, "phi", node->online ? node_registry_compute_phi(node, now_ms) : -1);
+    if (node->last_data) {
+        cJSON_AddItemToObject(obj, "data", cJSON_Duplicate(node->last_data, true));
+    }
+    return obj;
+}
+
+static char* build_snapshot(void) {
+    cJSON *root = cJSON_CreateObject();
+    if (!root) {
+        return NULL;
+    }
+    cJSON_AddStringToObject(root, "type", "snapshot");
+    cJSON_AddNumberToObject(root, "uptime_ms", (double)(esp_timer_get_time() / 1000));
+
+    cJSON *nodes = node_registry_export_all_to_json();
+    cJSON_AddItemToObject(root, "nodes", nodes ? nodes : cJSON_CreateArray());
+
+    char *str = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return str;
+}
+
+// ============================================================================
+// WEBSOCKET
+// ============================================================================
+
+static void ws_add_client(int fd) {
+    bool known = false;
+    bool added = false;
+
+    portENTER_CRITICAL(&s_ws_lock);
+    for (int i = 0; i < s_ws_count; i++) {
+        known |= (s_ws_fds[i] == fd);
+    }
+    if (!known && s_ws_count < CONFIG_ROOT_HTTP_API_WS_MAX_CLIENTS) {
+        s_ws_fds[s_ws_count++] = fd;
+        added = true;
+    }
+    portEXIT_CRITICAL(&s_ws_lock);
+
+    if (added) {
+        ESP_LOGI(TAG, "WebSocket client connected (fd=%d)", fd);
+    } else if (!known) {
+        ESP_LOGW(TAG, "WebSocket client limit reached, fd=%d gets no deltas", fd);
+    }
+}
+
+static void ws_remove_client(int fd) {
+    portENTER_CRITICAL(&s_ws_lock);
+    for (int i = 0; i < s_ws_count; i++) {
+        if (s_ws_fds[i] == fd) {
+            s_ws_fds[i] = s_ws_fds[--s_ws_count];
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_ws_lock);
+}
+
+int local_api_get_ws_client_count(void) {
+    portENTER_CRITICAL(&s_ws_lock);
+    int count = s_ws_count;
+    portEXIT_CRITICAL(&s_ws_lock);
+    return count;
+}
+
+// Выполняется в задаче httpd
+static void ws_send_work(void *arg) {
+    ws_send_job_t *job = (ws_send_job_t *)arg;
+
+    int fds[CONFIG_ROOT_HTTP_API_WS_MAX_CLIENTS];
+    int count = 0;
+    if (job->fd >= 0) {
+        fds[count++] = job->fd;
+    } else {
+        portENTER_CRITICAL(&s_ws_lock);
+        memcpy(fds, s_ws_fds, sizeof(int) * s_ws_count);
+        count = s_ws_count;
+        portEXIT_CRITICAL(&s_ws_lock);
+    }
+
+    httpd_ws_frame_t frame = {
+        .final = true,
+        .type = HTTPD_WS_TYPE_TEXT,
+        .payload = (uint8_t *)job->payload,
+        .len = strlen(job->payload),
+    };
+
+    for (int i = 0; i < count; i++) {
+        // Закрытые сокеты убираем лениво - при следующей отправке
+        if (httpd_ws_get_fd_info(s_server, fds[i]) != HTTPD_WS_CLIENT_WEBSOCKET ||
+            httpd_ws_send_frame_async(s_server, fds[i], &frame) != ESP_OK) {
+            ESP_LOGI(TAG, "WebSocket client gone (fd=%d)", fds[i]);
+            ws_remove_client(fds[i]);
+        }
+    }
+
+    cJSON_free(job->payload);
+    free(job);
+}
+
+static void ws_queue_send(int fd, char *payload) {
+    if (!payload) {
+        return;
+    }
+
+    ws_send_job_t *job = malloc(sizeof(ws_send_job_t));
+    if (job) {
+        job->fd = fd;
+        job->payload = payload;
+        if (httpd_queue_work(s_server, ws_send_work, job) == ESP_OK) {
+            return;
+        }
+        free(job);
+    }
+    cJSON_free(payload);
+}
+
+static esp_err_t ws_handler(httpd_req_t *req) {
+    int fd = httpd_req_to_sockfd(req);
+
+    if (req->method == HTTP_GET) {
+        // Handshake завершён - сразу полный снимок, дальше только дельты
+        ws_add_client(fd);
+        ws_queue_send(fd, build_snapshot());
+        return ESP_OK;
+    }
+
+    httpd_ws_frame_t frame = { .type = HTTPD_WS_TYPE_TEXT };
+    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (frame.len == 0 || frame.len > LOCAL_API_WS_RX_MAX) {
+        return ESP_OK;
+    }
+
+    uint8_t buf[LOCAL_API_WS_RX_MAX + 1] = {0};
+    frame.payload = buf;
+    err = httpd_ws_recv_frame(req, &frame, frame.len);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Единственная команда клиента - запросить снимок заново
+    if (strcmp((const char *)buf, "snapshot") == 0) {
+        ws_queue_send(fd, build_snapshot());
+    }
+    return ESP_OK;
+}
+
+// Контекст mesh_recv / root_monitor: только сериализация дельты и постановка в очередь httpd.
+// На mesh_recv открыта арена data_router: строка уходит в задачу httpd и
+// переживает cjson_arena_end(), поэтому дельта собирается в heap
+static void registry_event_cb(node_registry_event_t event, const node_info_t *node, void *ctx) {
+    static const char *event_names[] = { "online", "offline", "data", "info", "removed" };
+
+    if (event == NODE_REGISTRY_EVENT_DATA) {
+        node_history_record(node);
+    } else if (event == NODE_REGISTRY_EVENT_REMOVED) {
+        node_history_remove(node->node_id);
+    }
+
+    if (!s_server || local_api_get_ws_client_count() == 0) {
+        return;
+    }
+
+    void *arena = cjson_arena_suspend();
+    cJSON *root = cJSON_CreateObject();
+    if (root) {
+        cJSON_AddStringToObject(root, "type", "delta");
+        cJSON_AddStringToObject(root, "event", event_names[event]);
+        cJSON_AddItemToObject(root, "node", node_to_json(node, esp_timer_get_time() / 1000));
+        ws_queue_send(-1, cJSON_PrintUnformatted(root));
+        cJSON_Delete(root);
+    }
+    cjson_arena_resume(arena);
+}
+
+// ============================================================================
+// REST
+// ============================================================================
+
+static esp_err_t nodes_handler(httpd_req_t *req) {
+    cJSON *root = cJSON_CreateObject();
+    if (root) {
+        // Экспорт содержит только online узлы одной версии реестра
+        cJSON *nodes = node_registry_export_all_to_json();
+        cJSON_AddNumberToObject(root, "online", nodes ? cJSON_GetArraySize(nodes) : 0);
+        cJSON_AddItemToObject(root, "nodes", nodes ? nodes : cJSON_CreateArray());
+    }
+    return send_json(req, root);
+}
+
+static esp_err_t history_handler(httpd_req_t *req) {
+    // /api/nodes/{node_id}/history
+    const char *id_start = req->uri + strlen(LOCAL_API_HISTORY_PREFIX);
+    const char *id_end = strstr(id_start, LOCAL_API_HISTORY_SUFFIX);
+    size_t id_len = id_end ? (size_t)(id_end - id_start) : 0;
+
+    if (id_len == 0 || id_len >= 32 || strcmp(id_end, LOCAL_API_HISTORY_SUFFIX) != 0) {
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Use /api/nodes/{node_id}/history");
+    }
+
+    char node_id[32] = {0};
+    memcpy(node_id, id_start, id_len);
+
+    cJSON *history = node_history_to_json(node_id);
+    if (!history) {
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No history for node");
+    }
+    return send_json(req, history);
+}
+
+static esp_err_t topology_handler(httpd_req_t *req) {
+    mesh_node_info_t *routes = mem_policy_malloc(MEM_COLD, sizeof(mesh_node_info_t) * LOCAL_API_TOPOLOGY_MAX);
+    if (!routes) {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+    }
+
+    int route_count = 0;
+    mesh_manager_get_routing_table_with_rssi(routes, LOCAL_API_TOPOLOGY_MAX, &route_count);
+    const node_registry_view_t *view = node_registry_acquire();
+
+    cJSON *root = cJSON_CreateObject();
+    if (root) {
+        uint8_t root_mac[6] = {0};
+        char mac_str[18];
+        mesh_manager_get_mac(root_mac);
+        snprintf(mac_str, sizeof(mac_str), MACSTR, MAC2STR(root_mac));
+
+        cJSON_AddStringToObject(root, "root_mac", mac_str);
+        cJSON_AddNumberToObject(root, "total_nodes", mesh_manager_get_total_nodes());
+
+        cJSON *arr = cJSON_AddArrayToObject(root, "nodes");
+        for (int i = 0; i < route_count; i++) {
+            cJSON *obj = cJSON_CreateObject();
+            snprintf(mac_str, sizeof(mac_str), MACSTR, MAC2STR(routes[i].mac));
+            cJSON_AddStringToObject(obj, "mac", mac_str);
+            cJSON_AddNumberToObject(obj, "layer", routes[i].layer);
+            cJSON_AddNumberToObject(obj, "rssi", routes[i].rssi);
+
+            for (int n = 0; view && n < view->count; n++) {
+                const node_info_t *node = &view->nodes[n];
+                if (node->online && memcmp(node->mac_addr, routes[i].mac, 6) == 0) {
+                    cJSON_AddStringToObject(obj, "node_id", node->node_id);
+                    cJSON_AddStringToObject(obj, "node_type", node->node_type);
+                    break;
+                }
+            }
+            cJSON_AddItemToArray(arr, obj);
+        }
+    }
+
+    node_registry_release(view);
+    free(routes);
+    return send_json(req, root);
+}
+
+static esp_err_t rules_handler(httpd_req_t *req) {
+    return send_json(req, rule_engine_export_json());
+}
+
+// ============================================================================
+// PROMETHEUS
+// ============================================================================
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+    bool oom;
+} text_buf_t;
+
+static void tb_printf(text_buf_t *tb, const char *fmt, ...) {
+    if (tb->oom) {
+        return;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(tb->buf + tb->len, tb->cap - tb->len, fmt, args);
+        va_end(args);
+
+        if (n < 0) {
+            return;
+        }
+        if ((size_t)n < tb->cap - tb->len) {
+            tb->len += n;
+            return;
+        }
+
+        size_t new_cap = tb->cap * 2 + n;
+        char *new_buf = realloc(tb->buf, new_cap);
+        if (!new_buf) {
+            tb->oom = true;
+            return;
+        }
+        tb->buf = new_buf;
+        tb->cap = new_cap;
+    }
+}
+
+static void prom_histogram(text_buf_t *tb, const char *name, const char *help, const mqtt_latency_hist_t *hist) {
+    const uint32_t *bounds = mqtt_metrics_hist_bounds_us();
+    uint32_t cumulative = 0;
+
+    tb_printf(tb, "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+    for (int i = 0; i < MQTT_METRICS_HIST_BUCKETS - 1; i++) {
+        cumulative += hist->buckets[i];
+        tb_printf(tb, "%s_bucket{le=\"%g\"} %lu\n", name, bounds[i] / 1e6, (unsigned long)cumulative);
+    }
+    tb_printf(tb, "%s_bucket{le=\"+Inf\"} %lu\n", name, (unsigned long)hist->count);
+    tb_printf(tb, "%s_sum %.6f\n%s_count %lu\n", name, hist->sum_us / 1e6, name, (unsigned long)hist->count);
+}
+
+static esp_err_t metrics_handler(httpd_req_t *req) {
+    text_buf_t tb = { .cap = 4096 };
+    tb.buf = mem_policy_malloc(MEM_COLD, tb.cap);
+    if (!tb.buf) {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+    }
+
+    uint64_t now_ms = esp_timer_get_time() / 1000;
+
+    // Система
+    tb_printf(&tb, "# TYPE hydro_root_uptime_seconds gauge\nhydro_root_uptime_seconds %.3f\n", now_ms / 1000.0);
+    tb_printf(&tb, "# TYPE hydro_root_heap_free_bytes gauge\nhydro_root_heap_free_bytes %lu\n",
+              (unsigned long)esp_get_free_heap_size());
+    tb_printf(&tb, "# TYPE hydro_root_heap_min_free_bytes gauge\nhydro_root_heap_min_free_bytes %lu\n",
+              (unsigned long)esp_get_minimum_free_heap_size());
+    tb_printf(&tb, "# TYPE hydro_mesh_total_nodes gauge\nhydro_mesh_total_nodes %d\n",
+              mesh_manager_get_total_nodes());
+    tb_printf(&tb, "# TYPE hydro_rules_loaded gauge\nhydro_rules_loaded %d\n", rule_engine_get_rule_count());
+    tb_printf(&tb, "# TYPE hydro_local_api_ws_clients gauge\nhydro_local_api_ws_clients %d\n",
+              local_api_get_ws_client_count());
+
+    // Задачи, heap, очереди (есть, только если включено в Kconfig)
+    instrumentation_snapshot_t *sys = malloc(sizeof(instrumentation_snapshot_t));
+    if (sys && instrumentation_get_snapshot(sys)) {
+        tb_printf(&tb, "# TYPE hydro_root_heap_largest_free_block_bytes gauge\n"
+                       "hydro_root_heap_largest_free_block_bytes %lu\n",
+                  (unsigned long)sys->heap.largest_free_block);
+        tb_printf(&tb, "# TYPE hydro_root_heap_fragmentation_ratio gauge\n"
+                       "hydro_root_heap_fragmentation_ratio %.2f\n",
+                  sys->heap.fragmentation_pct / 100.0f);
+        tb_printf(&tb, "# TYPE hydro_root_task_cpu_ratio gauge\n");
+        for (int i = 0; i < sys->task_count; i++) {
+            tb_printf(&tb, "hydro_root_task_cpu_ratio{task=\"%s\"} %.3f\n",
+                      sys->tasks[i].name, sys->tasks[i].cpu_permille / 1000.0f);
+        }
+        tb_printf(&tb, "# TYPE hydro_root_task_stack_free_min_bytes gauge\n");
+        for (int i = 0; i < sys->task_count; i++) {
+            tb_printf(&tb, "hydro_root_task_stack_free_min_bytes{task=\"%s\"} %lu\n",
+                      sys->tasks[i].name, (unsigned long)sys->tasks[i].stack_free_min);
+        }
+        tb_printf(&tb, "# TYPE hydro_root_task_priority gauge\n");
+        for (int i = 0; i < sys->task_count; i++) {
+            tb_printf(&tb, "hydro_root_task_priority{task=\"%s\"} %u\n",
+                      sys->tasks[i].name, sys->tasks[i].priority);
+        }
+        tb_printf(&tb, "# TYPE hydro_root_queue_waiting gauge\n");
+        for (int i = 0; i < sys->queue_count; i++) {
+            tb_printf(&tb, "hydro_root_queue_waiting{queue=\"%s\"} %u\n",
+                      sys->queues[i].name, sys->queues[i].waiting);
+        }
+        tb_printf(&tb, "# TYPE hydro_root_queue_max_waiting gauge\n");
+        for (int i = 0; i < sys->queue_count; i++) {
+            tb_printf(&tb, "hydro_root_queue_max_waiting{queue=\"%s\"} %u\n",
+                      sys->queues[i].name, sys->queues[i].max_waiting);
+        }
+        tb_printf(&tb, "# TYPE hydro_root_queue_length gauge\n");
+        for (int i = 0; i < sys->queue_count; i++) {
+            tb_printf(&tb, "hydro_root_queue_length{queue=\"%s\"} %u\n",
+                      sys->queues[i].name, sys->queues[i].length);
+        }
+    }
+    free(sys);
+
+    // MQTT мост
+    mqtt_metrics_snapshot_t snap;
+    mqtt_metrics_get_snapshot(&snap);
+
+    tb_printf(&tb, "# TYPE hydro_mqtt_published_total counter\n");
+    for (int i = 0; i < MQTT_TOPIC_CLASS_MAX; i++) {
+        tb_printf(&tb, "hydro_mqtt_published_total{class=\"%s\"} %lu\n",
+                  mqtt_metrics_topic_class_to_str(i), (unsigned long)snap.published[i]);
+    }
+    tb_printf(&tb, "# TYPE hydro_mqtt_failed_total counter\n");
+    for (int i = 0; i < MQTT_TOPIC_CLASS_MAX; i++) {
+        tb_printf(&tb, "hydro_mqtt_failed_total{class=\"%s\"} %lu\n",
+                  mqtt_metrics_topic_class_to_str(i), (unsigned long)snap.failed[i]);
+    }
+    tb_printf(&tb, "# TYPE hydro_mqtt_bytes_out_total counter\nhydro_mqtt_bytes_out_total %llu\n",
+              (unsigned long long)snap.bytes_out);
+    tb_printf(&tb, "# TYPE hydro_mqtt_reconnects_total counter\nhydro_mqtt_reconnects_total %lu\n",
+              (unsigned long)snap.reconnects);
+    tb_printf(&tb, "# TYPE hydro_mqtt_connected gauge\nhydro_mqtt_connected %d\n", snap.connected ? 1 : 0);
+
+    prom_histogram(&tb, "hydro_route_latency_seconds", "Mesh receive to MQTT publish", &snap.route_latency);
+    prom_histogram(&tb, "hydro_mqtt_ack_latency_seconds", "MQTT publish to broker ack (QoS>0)", &snap.ack_latency);
+    prom_histogram(&tb, "hydro_mesh_latency_seconds", "Node send to ROOT receive (synced clocks)", &snap.mesh_latency);
+
+    // Узлы (одна версия реестра на весь вывод)
+    const node_registry_view_t *view = node_registry_acquire();
+    int online = 0;
+    for (int i = 0; view && i < view->count; i++) {
+        online += view->nodes[i].online ? 1 : 0;
+    }
+    tb_printf(&tb, "# TYPE hydro_nodes_online gauge\nhydro_nodes_online %d\n", online);
+    tb_printf(&tb, "# TYPE hydro_node_last_seen_seconds gauge\n");
+    for (int i = 0; view && i < view->count; i++) {
+        const node_info_t *node = &view->nodes[i];
+        if (node->online) {
+            tb_printf(&tb, "hydro_node_last_seen_seconds{node_id=\"%s\",node_type=\"%s\"} %.3f\n",
+                      node->node_id, node->node_type, (now_ms - node->last_seen_ms) / 1000.0);
+        }
+    }
+    tb_printf(&tb, "# TYPE hydro_node_phi gauge\n");
+    for (int i = 0; view && i < view->count; i++) {
+        const node_info_t *node = &view->nodes[i];
+        if (node->online) {
+            tb_printf(&tb, "hydro_node_phi{node_id=\"%s\",node_type=\"%s\"} %.2f\n",
+                      node->node_id, node->node_type, node_registry_compute_phi(node, now_ms));
+        }
+    }
+
+    // Трафик узлов (и offline: болтливый узел мог только что пропасть)
+    tb_printf(&tb, "# TYPE hydro_node_rx_messages_total counter\n");
+    for (int i = 0; view && i < view->count; i++) {
+        const node_info_t *node = &view->nodes[i];
+        for (int type = 0; type < NODE_TRAFFIC_MSG_TYPES; type++) {
+            if (node->traffic.msgs[type]) {
+                tb_printf(&tb, "hydro_node_rx_messages_total{node_id=\"%s\",msg_type=\"%s\"} %lu\n",
+                          node->node_id, mesh_protocol_msg_type_to_str(type),
+                          (unsigned long)node->traffic.msgs[type]);
+            }
+        }
+    }
+    tb_printf(&tb, "# TYPE hydro_node_rx_rate_per_minute gauge\n");
+    for (int i = 0; view && i < view->count; i++) {
+        const node_info_t *node = &view->nodes[i];
+        for (int type = 0; type < NODE_TRAFFIC_MSG_TYPES; type++) {
+            if (node->traffic.msgs[type]) {
+                tb_printf(&tb, "hydro_node_rx_rate_per_minute{node_id=\"%s\",msg_type=\"%s\"} %lu\n",
+                          node->node_id, mesh_protocol_msg_type_to_str(type),
+                          (unsigned long)node_registry_traffic_rate(node, type, now_ms));
+            }
+        }
+    }
+    tb_printf(&tb, "# TYPE hydro_node_rx_bytes_total counter\n");
+    for (int i = 0; view && i < view->count; i++) {
+        tb_printf(&tb, "hydro_node_rx_bytes_total{node_id=\"%s\"} %llu\n",
+                  view->nodes[i].node_id, (unsigned long long)view->nodes[i].traffic.bytes);
+    }
+    tb_printf(&tb, "# TYPE hydro_node_seq_gaps_total counter\n");
+    for (int i = 0; view && i < view->count; i++) {
+        tb_printf(&tb, "hydro_node_seq_gaps_total{node_id=\"%s\"} %lu\n",
+                  view->nodes[i].node_id, (unsigned long)view->nodes[i].traffic.seq_gaps);
+    }
+    tb_printf(&tb, "# TYPE hydro_node_seq_resets_total counter\n");
+    for (int i = 0; view && i < view->count; i++) {
+        tb_printf(&tb, "hydro_node_seq_resets_total{node_id=\"%s\"} %lu\n",
+                  view->nodes[i].node_id, (unsigned long)view->nodes[i].traffic.seq_resets);
+    }
+    tb_printf(&tb, "# TYPE hydro_node_parse_failures_total counter\n");
+    for (int i = 0; view && i < view->count; i++) {
+        tb_printf(&tb, "hydro_node_parse_failures_total{node_id=\"%s\"} %lu\n",
+                  view->nodes[i].node_id, (unsigned long)view->nodes[i].traffic.parse_failures);
+    }
+    tb_printf(&tb, "hydro_node_parse_failures_total{node_id=\"\"} %lu\n",
+              (unsigned long)node_registry_get_unknown_parse_failures());
+    tb_printf(&tb, "# TYPE hydro_node_jitter_seconds gauge\n");
+    for (int i = 0; view && i < view->count; i++) {
+        tb_printf(&tb, "hydro_node_jitter_seconds{node_id=\"%s\"} %.3f\n",
+                  view->nodes[i].node_id, view->nodes[i].traffic.jitter_ms / 1000.0f);
+    }
+    tb_printf(&tb, "# TYPE hydro_node_rssi_dbm gauge\n");
+    for (int i = 0; view && i < view->count; i++) {
+        if (view->nodes[i].traffic.last_rssi != 0) {
+            tb_printf(&tb, "hydro_node_rssi_dbm{node_id=\"%s\"} %d\n",
+                      view->nodes[i].node_id, view->nodes[i].traffic.last_rssi);
+        }
+    }
+    node_registry_release(view);
+
+    esp_err_t err;
+    if (tb.oom) {
+        err = httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+    } else {
+        httpd_resp_set_type(req, "text/plain; version=0.0.4");
+        err = httpd_resp_send(req, tb.buf, tb.len);
+    }
+    free(tb.buf);
+    return err;
+}
+
+// ============================================================================
+// ЗАПУСК
+// ============================================================================
+
+esp_err_t local_api_start(void) {
+    if (s_server) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = node_history_init();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = CONFIG_ROOT_HTTP_API_PORT;
+    config.uri_match_fn = httpd_uri_match_wildcard;
+    config.stack_size = 8192;           // cJSON снимки реестра
+    config.lru_purge_enable = true;     // Забытые дашборды не держат сокеты
+
+    err = httpd_start(&s_server, &config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start HTTP server: %s", esp_err_to_name(err));
+        s_server = NULL;
+        return err;
+    }
+
+    const httpd_uri_t handlers[] = {
+        { .uri = "/api/nodes",   .method = HTTP_GET, .handler = nodes_handler },
+        { .uri = "/api/nodes/*", .method = HTTP_GET, .handler = history_handler },
+        { .uri = "/api/topology", .method = HTTP_GET, .handler = topology_handler },
+        { .uri = "/api/rules",   .method = HTTP_GET, .handler = rules_handler },
+        { .uri = "/metrics",     .method = HTTP_GET, .handler = metrics_handler },
+        { .uri = "/ws",          .method = HTTP_GET, .handler = ws_handler, .is_websocket = true },
+    };
+    for (size_t i = 0; i < sizeof(handlers) / sizeof(handlers[0]); i++) {
+        httpd_register_uri_handler(s_server, &handlers[i]);
+    }
+
+    err = node_registry_register_event_cb(registry_event_cb, NULL);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Registry events unavailable, WebSocket deltas and history disabled");
+    }
+
+    ESP_LOGI(TAG, "Local API started on port %d (REST, /metrics, /ws)", CONFIG_ROOT_HTTP_API_PORT);
+    return ESP_OK;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file local_api.h
+ * @brief Локальный HTTP + WebSocket API ROOT узла
+ *
+ * Даёт LAN дашбордам и Prometheus данные напрямую с ROOT, без цепочки
+ * mesh → ROOT → MQTT → backend → frontend:
+ *
+ * - GET /api/nodes                    - снимок реестра узлов
+ * - GET /api/nodes/{node_id}/history  - последние telemetry узла
+ * - GET /api/topology                 - таблица маршрутизации mesh с RSSI
+ * - GET /api/rules                    - правила rule_engine и их состояние
+ * - GET /metrics                      - метрики в текстовом формате Prometheus
+ * - WS  /ws                           - снимок при подключении, затем дельты реестра
+ */
+
+#ifndef LOCAL_API_H
+#define LOCAL_API_H
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Запуск HTTP сервера и подписка на события реестра
+ *
+ * Вызывать после получения IP адреса.
+ *
+ * @return ESP_OK при успехе
+ */
+esp_err_t local_api_start(void);
+
+/**
+ * @brief Количество подключённых WebSocket клиентов
+ */
+int local_api_get_ws_client_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOCAL_API_H
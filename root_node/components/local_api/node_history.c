@@ -0,0 +1,200 @@
+/**
+ * @file node_history.c
+ * @brief Реализация истории telemetry узлов
+ */
+
+#include "node_history.h"
+#include "mem_policy.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "rtos_static.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+static const char *TAG = "node_history";
+
+typedef struct {
+    uint64_t t_ms;                              ///< Время приёма (мс от старта)
+    float values[NODE_HISTORY_MAX_FIELDS];      ///< NAN - поля не было
+} history_sample_t;
+
+typedef struct {
+    char node_id[32];
+    char fields[NODE_HISTORY_MAX_FIELDS][NODE_HISTORY_FIELD_LEN];
+    uint8_t field_count;
+    uint8_t count;
+    uint8_t next;
+    history_sample_t samples[NODE_HISTORY_DEPTH];
+} node_history_t;
+
+static node_history_t *s_history[MAX_NODES];
+static SemaphoreHandle_t s_mutex = NULL;
+RTOS_STATIC_MUTEX(node_history);
+
+esp_err_t node_history_init(void) {
+    if (s_mutex) {
+        return ESP_OK;
+    }
+
+    s_mutex = rtos_static_mutex_create(&node_history);
+    if (!s_mutex) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Node history initialized (%d samples x %d fields per node)",
+             NODE_HISTORY_DEPTH, NODE_HISTORY_MAX_FIELDS);
+    return ESP_OK;
+}
+
+// Вызывается под мьютексом
+static node_history_t* find_or_create(const char *node_id) {
+    int free_slot = -1;
+    for (int i = 0; i < MAX_NODES; i++) {
+        if (s_history[i] && strcmp(s_history[i]->node_id, node_id) == 0) {
+            return s_history[i];
+        }
+        if (!s_history[i] && free_slot < 0) {
+            free_slot = i;
+        }
+    }
+
+    if (free_slot < 0) {
+        return NULL;
+    }
+
+    // Кольца истории читаются только HTTP запросами - в PSRAM
+    node_history_t *h = mem_policy_calloc("node_history", MEM_COLD, sizeof(node_history_t));
+    if (!h) {
+        ESP_LOGW(TAG, "No memory for history of %s", node_id);
+        return NULL;
+    }
+    strncpy(h->node_id, node_id, sizeof(h->node_id) - 1);
+    s_history[free_slot] = h;
+    return h;
+}
+
+static int field_index(node_history_t *h, const char *name) {
+    for (int i = 0; i < h->field_count; i++) {
+        if (strcmp(h->fields[i], name) == 0) {
+            return i;
+        }
+    }
+    if (h->field_count >= NODE_HISTORY_MAX_FIELDS || strlen(name) >= NODE_HISTORY_FIELD_LEN) {
+        return -1;
+    }
+    strcpy(h->fields[h->field_count], name);
+    return h->field_count++;
+}
+
+void node_history_record(const node_info_t *node) {
+    if (!s_mutex || !node || !node->last_data) {
+        return;
+    }
+
+    history_sample_t sample = { .t_ms = esp_timer_get_time() / 1000 };
+    for (int i = 0; i < NODE_HISTORY_MAX_FIELDS; i++) {
+        sample.values[i] = NAN;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    node_history_t *h = find_or_create(node->node_id);
+    if (h) {
+        const cJSON *item;
+        bool any = false;
+        cJSON_ArrayForEach(item, node->last_data) {
+            if (!item->string || !cJSON_IsNumber(item)) {
+                continue;
+            }
+            int idx = field_index(h, item->string);
+            if (idx >= 0) {
+                sample.values[idx] = (float)item->valuedouble;
+                any = true;
+            }
+        }
+
+        if (any) {
+            h->samples[h->next] = sample;
+            h->next = (h->next + 1) % NODE_HISTORY_DEPTH;
+            if (h->count < NODE_HISTORY_DEPTH) {
+                h->count++;
+            }
+        }
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+void node_history_remove(const char *node_id) {
+    if (!s_mutex || !node_id) {
+        return;
+    }
+
+    node_history_t *h = NULL;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    for (int i = 0; i < MAX_NODES; i++) {
+        if (s_history[i] && strcmp(s_history[i]->node_id, node_id) == 0) {
+            h = s_history[i];
+            s_history[i] = NULL;
+            break;
+        }
+    }
+    xSemaphoreGive(s_mutex);
+    free(h);
+}
+
+cJSON* node_history_to_json(const char *node_id) {
+    if (!s_mutex || !node_id) {
+        return NULL;
+    }
+
+    // Копия под мьютексом, JSON - без него (mesh_recv не ждёт HTTP)
+    node_history_t *copy = mem_policy_malloc(MEM_COLD, sizeof(node_history_t));
+    if (!copy) {
+        return NULL;
+    }
+
+    bool found = false;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    for (int i = 0; i < MAX_NODES; i++) {
+        if (s_history[i] && strcmp(s_history[i]->node_id, node_id) == 0) {
+            memcpy(copy, s_history[i], sizeof(node_history_t));
+            found = true;
+            break;
+        }
+    }
+    xSemaphoreGive(s_mutex);
+
+    if (!found) {
+        free(copy);
+        return NULL;
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    if (root) {
+        cJSON_AddStringToObject(root, "node_id", copy->node_id);
+
+        cJSON *fields = cJSON_AddArrayToObject(root, "fields");
+        for (int f = 0; f < copy->field_count; f++) {
+            cJSON_AddItemToArray(fields, cJSON_CreateString(copy->fields[f]));
+        }
+
+        cJSON *samples = cJSON_AddArrayToObject(root, "samples");
+        int start = (copy->next + NODE_HISTORY_DEPTH - copy->count) % NODE_HISTORY_DEPTH;
+        for (int n = 0; n < copy->count; n++) {
+            const history_sample_t *s = &copy->samples[(start + n) % NODE_HISTORY_DEPTH];
+            cJSON *obj = cJSON_CreateObject();
+            cJSON_AddNumberToObject(obj, "t_ms", (double)s->t_ms);
+            cJSON *values = cJSON_AddArrayToObject(obj, "v");
+            for (int f = 0; f < copy->field_count; f++) {
+                cJSON_AddItemToArray(values, isnan(s->values[f]) ? cJSON_CreateNull()
+                                                                 : cJSON_CreateNumber(s->values[f]));
+            }
+            cJSON_AddItemToArray(samples, obj);
+        }
+    }
+
+    free(copy);
+    return root;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file node_history.h
+ * @brief Короткая история telemetry каждого узла (для локального API)
+ *
+ * Хранит последние NODE_HISTORY_DEPTH числовых снимков data каждого узла
+ * в кольцевом буфере. Память под узел выделяется при первой telemetry.
+ */
+
+#ifndef NODE_HISTORY_H
+#define NODE_HISTORY_H
+
+#include "esp_err.h"
+#include "cJSON.h"
+#include "node_registry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NODE_HISTORY_DEPTH          32      ///< Снимков на узел
+#define NODE_HISTORY_MAX_FIELDS     8       ///< Числовых полей на узел
+#define NODE_HISTORY_FIELD_LEN      16      ///< Макс. длина имени поля
+
+/**
+ * @brief Инициализация хранилища
+ *
+ * @return ESP_OK при успехе
+ */
+esp_err_t node_history_init(void);
+
+/**
+ * @brief Добавить снимок из события реестра (NODE_REGISTRY_EVENT_DATA)
+ *
+ * @param node Узел с обновлёнными last_data
+ */
+void node_history_record(const node_info_t *node);
+
+/**
+ * @brief Удалить историю узла (NODE_REGISTRY_EVENT_REMOVED)
+ *
+ * @param node_id ID узла
+ */
+void node_history_remove(const char *node_id);
+
+/**
+ * @brief История узла в JSON
+ *
+ * Формат: {"node_id":..,"fields":["temperature",...],
+ *          "samples":[{"t_ms":123,"v":[24.1,...]},...]} (от старых к новым)
+ *
+ * @param node_id ID узла
+ * @return cJSON объект (освободить через cJSON_Delete) или NULL если истории нет
+ */
+cJSON* node_history_to_json(const char *node_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NODE_HISTORY_H
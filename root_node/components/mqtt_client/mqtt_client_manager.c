@@ -4,14 +4,20 @@
  */
 
 #include "mqtt_client_manager.h"
+#include "mqtt_metrics.h"
 #include "mqtt_client.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_system.h"
 #include "esp_mac.h"
 #include "mesh_config.h"
+#include "instrumentation.h"
+#include "cjson_arena.h"
+#include "pm_policy.h"
+#include "trace_ring.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 // Внешнее объявление для spi_flash функции
 extern uint32_t spi_flash_get_chip_size(void);
@@ -24,6 +30,12 @@ static const char *TAG = "mqtt_manager";
 #define MQTT_TOPIC_HEARTBEAT    "hydro/heartbeat"
 #define MQTT_TOPIC_COMMAND      "hydro/command/#"
 #define MQTT_TOPIC_CONFIG       "hydro/config/#"
+#define MQTT_TOPIC_RULES        "hydro/rules/set"
+#define MQTT_TOPIC_ROLLUP_SET   "hydro/rollup/set"
+#define MQTT_TOPIC_OTA          "hydro/ota/#"
+#define MQTT_TOPIC_BENCH        "hydro/bench/#"
+#define MQTT_TOPIC_TRACE        "hydro/trace/dump"
+#define MQTT_BUFFER_SIZE        4096    // Набор правил rule_engine должен помещаться целиком
 
 // MQTT конфигурация берётся из mesh_config.h
 // MQTT_BROKER_URI уже определён в mesh_config.h: "mqtt://192.168.0.167:1883"
@@ -31,6 +43,18 @@ static const char *TAG = "mqtt_manager";
 #define MQTT_USERNAME           NULL
 #define MQTT_PASSWORD           NULL
 
+// Входящие топики (команды и настройки ROOT), QoS 1
+static const esp_mqtt_topic_t s_subscriptions[] = {
+    { .filter = MQTT_TOPIC_COMMAND,    .qos = 1 },
+    { .filter = MQTT_TOPIC_CONFIG,     .qos = 1 },
+    { .filter = MQTT_TOPIC_RULES,      .qos = 1 },
+    { .filter = MQTT_TOPIC_ROLLUP_SET, .qos = 1 },
+    { .filter = MQTT_TOPIC_OTA,        .qos = 1 },
+    { .filter = MQTT_TOPIC_BENCH,      .qos = 1 },
+    { .filter = MQTT_TOPIC_TRACE,      .qos = 1 },
+};
+#define MQTT_SUBSCRIPTION_COUNT (int)(sizeof(s_subscriptions) / sizeof(s_subscriptions[0]))
+
 static esp_mqtt_client_handle_t s_mqtt_client = NULL;
 static mqtt_recv_callback_t s_recv_cb = NULL;
 static bool s_is_connected = false;
@@ -54,6 +78,9 @@ esp_err_t mqtt_client_manager_init(void) {
             .reconnect_timeout_ms = 10000,
             .timeout_ms = 10000,
         },
+        .buffer = {
+            .size = MQTT_BUFFER_SIZE,
+        },
     };
 
     s_mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
@@ -62,6 +89,8 @@ esp_err_t mqtt_client_manager_init(void) {
         return ESP_FAIL;
     }
 
+    mqtt_metrics_init();
+
     // Регистрация обработчика событий
     ESP_ERROR_CHECK(esp_mqtt_client_register_event(s_mqtt_client, ESP_EVENT_ANY_ID,
                                                     mqtt_event_handler, NULL));
@@ -101,14 +130,17 @@ esp_err_t mqtt_client_manager_publish(const char *topic, const char *data) {
         return ESP_ERR_INVALID_ARG;
     }
 
+    // ВАЖНО: strlen() для null-terminated строк (JSON payload)
+    int data_len = strlen(data);
+
     if (!s_is_connected) {
         ESP_LOGW(TAG, "MQTT not connected, cannot publish to %s", topic);
+        mqtt_metrics_record_publish(topic, -1, 0, data_len, false);
         return ESP_FAIL;
     }
 
-    // ВАЖНО: strlen() для null-terminated строк (JSON payload)
-    int data_len = strlen(data);
     int msg_id = esp_mqtt_client_publish(s_mqtt_client, topic, data, data_len, 0, 0);
+    mqtt_metrics_record_publish(topic, msg_id, 0, data_len, msg_id >= 0);
     
     if (msg_id < 0) {
         ESP_LOGE(TAG, "Failed to publish to %s", topic);
@@ -119,6 +151,30 @@ esp_err_t mqtt_client_manager_publish(const char *topic, const char *data) {
     return ESP_OK;
 }
 
+esp_err_t mqtt_client_manager_publish_binary(const char *topic, const uint8_t *data, size_t len) {
+    if (!s_mqtt_client || !topic || !data) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!s_is_connected) {
+        ESP_LOGW(TAG, "MQTT not connected, cannot publish to %s", topic);
+        mqtt_metrics_record_publish(topic, -1, 0, len, false);
+        return ESP_FAIL;
+    }
+
+    // QoS 0: большой payload не копируется в outbox
+    int msg_id = esp_mqtt_client_publish(s_mqtt_client, topic, (const char *)data, (int)len, 0, 0);
+    mqtt_metrics_record_publish(topic, msg_id, 0, len, msg_id >= 0);
+
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Failed to publish to %s", topic);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "MQTT Published binary: %s (len=%u)", topic, (unsigned)len);
+    return ESP_OK;
+}
+
 void mqtt_client_manager_register_recv_cb(mqtt_recv_callback_t cb) {
     s_recv_cb = cb;
 }
@@ -127,6 +183,15 @@ bool mqtt_client_manager_is_connected(void) {
     return s_is_connected;
 }
 
+int mqtt_client_manager_get_outbox_size(void) {
+    if (!s_mqtt_client) {
+        return 0;
+    }
+
+    int size = esp_mqtt_client_get_outbox_size(s_mqtt_client);
+    return (size > 0) ? size : 0;
+}
+
 esp_err_t mqtt_client_manager_reconnect(void) {
     if (!s_mqtt_client) {
         return ESP_FAIL;
@@ -145,13 +210,15 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
         case MQTT_EVENT_CONNECTED:
             ESP_LOGI(TAG, "MQTT connected to broker");
             s_is_connected = true;
-
-            // Подписка на топики команд
-            esp_mqtt_client_subscribe(s_mqtt_client, MQTT_TOPIC_COMMAND, 1);
-            ESP_LOGI(TAG, "Subscribed to %s", MQTT_TOPIC_COMMAND);
-
-            esp_mqtt_client_subscribe(s_mqtt_client, MQTT_TOPIC_CONFIG, 1);
-            ESP_LOGI(TAG, "Subscribed to %s", MQTT_TOPIC_CONFIG);
+            mqtt_metrics_on_connected();
+
+            // Все входящие топики одним SUBSCRIBE, разбор - деревом в data_router
+            if (esp_mqtt_client_subscribe_multiple(s_mqtt_client, s_subscriptions,
+                                                   MQTT_SUBSCRIPTION_COUNT) < 0) {
+                ESP_LOGE(TAG, "Failed to subscribe");
+            } else {
+                ESP_LOGI(TAG, "Subscribed to %d topic filters", MQTT_SUBSCRIPTION_COUNT);
+            }
             
             // Отправка discovery сообщения
             mqtt_client_manager_send_discovery();
@@ -160,6 +227,7 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
         case MQTT_EVENT_DISCONNECTED:
             ESP_LOGW(TAG, "MQTT disconnected from broker");
             s_is_connected = false;
+            mqtt_metrics_on_disconnected();
             break;
 
         case MQTT_EVENT_SUBSCRIBED:
@@ -172,6 +240,8 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
 
         case MQTT_EVENT_PUBLISHED:
             ESP_LOGD(TAG, "MQTT published, msg_id=%d", event->msg_id);
+            mqtt_metrics_record_ack(event->msg_id);
+            TRACE_EVENT(TRACE_EV_MQTT_ACK, 0, event->msg_id);
             break;
 
         case MQTT_EVENT_DATA:
@@ -181,17 +251,28 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
             if (s_recv_cb) {
                 // Создание null-terminated строк
                 char topic[128] = {0};
-                char data[1024] = {0};
 
                 int topic_len = (event->topic_len < sizeof(topic) - 1) ? 
                                 event->topic_len : sizeof(topic) - 1;
-                int data_len = (event->data_len < sizeof(data) - 1) ? 
-                              event->data_len : sizeof(data) - 1;
+
+                // Фрагменты больше буфера клиента не собираем
+                if (event->data_len != event->total_data_len) {
+                    ESP_LOGW(TAG, "MQTT message too large (%d bytes), dropped", event->total_data_len);
+                    break;
+                }
+
+                char *data = malloc(event->data_len + 1);
+                if (data == NULL) {
+                    ESP_LOGE(TAG, "Failed to allocate MQTT data buffer");
+                    break;
+                }
 
                 memcpy(topic, event->topic, topic_len);
-                memcpy(data, event->data, data_len);
+                memcpy(data, event->data, event->data_len);
+                data[event->data_len] = '\0';
 
-                s_recv_cb(topic, data, data_len);
+                s_recv_cb(topic, data, event->data_len);
+                free(data);
             }
             break;
 
@@ -251,6 +332,7 @@ void mqtt_client_manager_send_discovery(void) {
     
     int msg_id = esp_mqtt_client_publish(s_mqtt_client, "hydro/discovery", 
                                         discovery_msg, strlen(discovery_msg), 1, 0);
+    mqtt_metrics_record_publish("hydro/discovery", msg_id, 1, strlen(discovery_msg), msg_id >= 0);
     if (msg_id >= 0) {
         ESP_LOGI(TAG, "Published discovery message (msg_id=%d, len=%d)", msg_id, strlen(discovery_msg));
     } else {
@@ -258,3 +340,42 @@ void mqtt_client_manager_send_discovery(void) {
     }
 }
 
+
+esp_err_t mqtt_client_manager_send_metrics(void) {
+    if (!s_mqtt_client || !s_is_connected) {
+        ESP_LOGW(TAG, "Cannot send metrics - MQTT not connected");
+        return ESP_FAIL;
+    }
+
+    cJSON *metrics = mqtt_metrics_to_json();
+    if (!metrics) {
+        return ESP_ERR_NO_MEM;
+    }
+    instrumentation_add_to_json(metrics);
+    cjson_arena_add_to_json(metrics, true);     // Пик арен по типам сообщений
+    pm_policy_add_to_json(metrics);             // Частота, доля занятости, задержка блокировок
+
+    char *json_str = cJSON_PrintUnformatted(metrics);
+    cJSON_Delete(metrics);
+    if (!json_str) {
+        ESP_LOGE(TAG, "Failed to serialize metrics");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // QoS 1: подтверждение брокера попадает в ack_latency гистограмму
+    int data_len = strlen(json_str);
+    TRACE_EVENT(TRACE_EV_MQTT_ENQUEUE, 0, data_len);
+    int msg_id = esp_mqtt_client_publish(s_mqtt_client, MQTT_METRICS_TOPIC,
+                                         json_str, data_len, 1, 0);
+    TRACE_EVENT(TRACE_EV_MQTT_PUBLISHED, 0, msg_id);
+    mqtt_metrics_record_publish(MQTT_METRICS_TOPIC, msg_id, 1, data_len, msg_id >= 0);
+    free(json_str);
+
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Failed to publish metrics");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Published metrics (msg_id=%d, len=%d)", msg_id, data_len);
+    return ESP_OK;
+}
@@ -11,6 +11,7 @@
 
 #include "esp_err.h"
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
 
 #ifdef __cplusplus
@@ -58,6 +59,16 @@ esp_err_t mqtt_client_manager_stop(void);
  */
 esp_err_t mqtt_client_manager_publish(const char *topic, const char *data);
 
+/**
+ * @brief Публикация бинарных данных (QoS 0)
+ * 
+ * @param topic MQTT топик
+ * @param data Данные
+ * @param len Длина данных
+ * @return ESP_OK при успехе
+ */
+esp_err_t mqtt_client_manager_publish_binary(const char *topic, const uint8_t *data, size_t len);
+
 /**
  * @brief Регистрация callback для обработки входящих сообщений
  * 
@@ -72,6 +83,13 @@ void mqtt_client_manager_register_recv_cb(mqtt_recv_callback_t cb);
  */
 bool mqtt_client_manager_is_connected(void);
 
+/**
+ * @brief Объём неотправленных данных в outbox клиента
+ * 
+ * @return Байт в outbox (0 если клиент не создан)
+ */
+int mqtt_client_manager_get_outbox_size(void);
+
 /**
  * @brief Переподключение к MQTT broker
  * 
@@ -87,6 +105,16 @@ esp_err_t mqtt_client_manager_reconnect(void);
  */
 void mqtt_client_manager_send_discovery(void);
 
+/**
+ * @brief Отправка метрик MQTT моста
+ * 
+ * Публикует счётчики и гистограммы задержек (см. mqtt_metrics.h)
+ * в hydro/metrics/root. Вызывается периодически вместе с discovery.
+ * 
+ * @return ESP_OK при успехе
+ */
+esp_err_t mqtt_client_manager_send_metrics(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,252 @@
+/**
+ * @file mqtt_metrics.c
+ * @brief Реализация счётчиков производительности MQTT моста
+ */
+
+#include "mqtt_metrics.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "mqtt_metrics";
+
+// Верхние границы корзин (мкс): 250us ... 1s, последняя корзина = +Inf
+static const uint32_t s_hist_bounds_us[MQTT_METRICS_HIST_BUCKETS - 1] = {
+    250, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 250000, 1000000
+};
+
+static const char *s_class_names[MQTT_TOPIC_CLASS_MAX] = {
+    "telemetry", "event", "heartbeat", "config_response", "discovery", "metrics", "rollup", "other"
+};
+
+typedef struct {
+    int msg_id;
+    int64_t publish_us;
+} pending_ack_t;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static mqtt_metrics_snapshot_t s_metrics;
+static pending_ack_t s_pending[MQTT_METRICS_MAX_PENDING];
+static int64_t s_connected_since_us = 0;
+
+static void hist_add(mqtt_latency_hist_t *hist, uint32_t value_us) {
+    int idx = 0;
+    while (idx < MQTT_METRICS_HIST_BUCKETS - 1 && value_us > s_hist_bounds_us[idx]) {
+        idx++;
+    }
+    hist->buckets[idx]++;
+    hist->count++;
+    hist->sum_us += value_us;
+    if (value_us > hist->max_us) {
+        hist->max_us = value_us;
+    }
+}
+
+void mqtt_metrics_init(void) {
+    portENTER_CRITICAL(&s_lock);
+    memset(&s_metrics, 0, sizeof(s_metrics));
+    memset(s_pending, 0, sizeof(s_pending));
+    s_connected_since_us = 0;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "MQTT metrics initialized");
+}
+
+mqtt_topic_class_t mqtt_metrics_classify_topic(const char *topic) {
+    if (!topic || strncmp(topic, "hydro/", 6) != 0) {
+        return MQTT_TOPIC_CLASS_OTHER;
+    }
+
+    const char *sub = topic + 6;
+    if (strncmp(sub, "telemetry", 9) == 0) return MQTT_TOPIC_CLASS_TELEMETRY;
+    if (strncmp(sub, "event", 5) == 0) return MQTT_TOPIC_CLASS_EVENT;
+    if (strncmp(sub, "heartbeat", 9) == 0) return MQTT_TOPIC_CLASS_HEARTBEAT;
+    if (strncmp(sub, "config_response", 15) == 0) return MQTT_TOPIC_CLASS_CONFIG_RESPONSE;
+    if (strncmp(sub, "discovery", 9) == 0) return MQTT_TOPIC_CLASS_DISCOVERY;
+    if (strncmp(sub, "metrics", 7) == 0) return MQTT_TOPIC_CLASS_METRICS;
+    if (strncmp(sub, "rollup", 6) == 0) return MQTT_TOPIC_CLASS_ROLLUP;
+    return MQTT_TOPIC_CLASS_OTHER;
+}
+
+void mqtt_metrics_record_publish(const char *topic, int msg_id, int qos, size_t bytes, bool ok) {
+    mqtt_topic_class_t cls = mqtt_metrics_classify_topic(topic);
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    if (ok) {
+        s_metrics.published[cls]++;
+        s_metrics.bytes_out += bytes;
+
+        // Для QoS 0 брокер не подтверждает публикацию - ack не ждём
+        if (qos > 0 && msg_id > 0) {
+            // Занимаем свободный слот, иначе вытесняем самый старый
+            int slot = 0;
+            for (int i = 0; i < MQTT_METRICS_MAX_PENDING; i++) {
+                if (s_pending[i].msg_id == 0) {
+                    slot = i;
+                    break;
+                }
+                if (s_pending[i].publish_us < s_pending[slot].publish_us) {
+                    slot = i;
+                }
+            }
+            s_pending[slot].msg_id = msg_id;
+            s_pending[slot].publish_us = now_us;
+        }
+    } else {
+        s_metrics.failed[cls]++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void mqtt_metrics_record_ack(int msg_id) {
+    if (msg_id <= 0) {
+        return;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < MQTT_METRICS_MAX_PENDING; i++) {
+        if (s_pending[i].msg_id == msg_id) {
+            hist_add(&s_metrics.ack_latency, (uint32_t)(now_us - s_pending[i].publish_us));
+            s_pending[i].msg_id = 0;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void mqtt_metrics_record_route_latency(int64_t latency_us) {
+    if (latency_us < 0) {
+        return;
+    }
+
+    uint32_t value = (latency_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)latency_us;
+
+    portENTER_CRITICAL(&s_lock);
+    hist_add(&s_metrics.route_latency, value);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void mqtt_metrics_record_mesh_latency(int64_t latency_us) {
+    if (latency_us < 0) {
+        return;
+    }
+
+    uint32_t value = (latency_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)latency_us;
+
+    portENTER_CRITICAL(&s_lock);
+    hist_add(&s_metrics.mesh_latency, value);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void mqtt_metrics_on_connected(void) {
+    portENTER_CRITICAL(&s_lock);
+    if (s_metrics.connects > 0) {
+        s_metrics.reconnects++;
+    }
+    s_metrics.connects++;
+    s_metrics.connected = true;
+    s_connected_since_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void mqtt_metrics_on_disconnected(void) {
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_metrics.connected) {
+        s_metrics.connected_ms += (now_us - s_connected_since_us) / 1000;
+        s_metrics.disconnects++;
+    }
+    s_metrics.connected = false;
+    // Неподтверждённые публикации прошлой сессии больше не придут
+    memset(s_pending, 0, sizeof(s_pending));
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void mqtt_metrics_get_snapshot(mqtt_metrics_snapshot_t *out) {
+    if (!out) {
+        return;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    memcpy(out, &s_metrics, sizeof(*out));
+    if (s_metrics.connected) {
+        out->connected_ms += (now_us - s_connected_since_us) / 1000;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+const uint32_t* mqtt_metrics_hist_bounds_us(void) {
+    return s_hist_bounds_us;
+}
+
+const char* mqtt_metrics_topic_class_to_str(mqtt_topic_class_t cls) {
+    if (cls < 0 || cls >= MQTT_TOPIC_CLASS_MAX) {
+        return "unknown";
+    }
+    return s_class_names[cls];
+}
+
+static cJSON* hist_to_json(const mqtt_latency_hist_t *hist) {
+    cJSON *obj = cJSON_CreateObject();
+    if (!obj) {
+        return NULL;
+    }
+
+    cJSON_AddNumberToObject(obj, "count", hist->count);
+    cJSON_AddNumberToObject(obj, "sum_us", (double)hist->sum_us);
+    cJSON_AddNumberToObject(obj, "max_us", hist->max_us);
+    cJSON_AddNumberToObject(obj, "avg_us",
+                            hist->count ? (double)hist->sum_us / hist->count : 0.0);
+
+    cJSON *le = cJSON_AddArrayToObject(obj, "le_us");
+    cJSON *buckets = cJSON_AddArrayToObject(obj, "buckets");
+    for (int i = 0; i < MQTT_METRICS_HIST_BUCKETS; i++) {
+        if (i < MQTT_METRICS_HIST_BUCKETS - 1) {
+            cJSON_AddItemToArray(le, cJSON_CreateNumber(s_hist_bounds_us[i]));
+        }
+        cJSON_AddItemToArray(buckets, cJSON_CreateNumber(hist->buckets[i]));
+    }
+
+    return obj;
+}
+
+cJSON* mqtt_metrics_to_json(void) {
+    mqtt_metrics_snapshot_t snap;
+    mqtt_metrics_get_snapshot(&snap);
+
+    cJSON *root = cJSON_CreateObject();
+    if (!root) {
+        ESP_LOGE(TAG, "Failed to create JSON object");
+        return NULL;
+    }
+
+    cJSON_AddStringToObject(root, "type", "metrics");
+    cJSON_AddNumberToObject(root, "uptime_ms", (double)(esp_timer_get_time() / 1000));
+
+    cJSON *published = cJSON_AddObjectToObject(root, "published");
+    cJSON *failed = cJSON_AddObjectToObject(root, "failed");
+    for (int i = 0; i < MQTT_TOPIC_CLASS_MAX; i++) {
+        cJSON_AddNumberToObject(published, s_class_names[i], snap.published[i]);
+        cJSON_AddNumberToObject(failed, s_class_names[i], snap.failed[i]);
+    }
+
+    cJSON_AddNumberToObject(root, "bytes_out", (double)snap.bytes_out);
+    cJSON_AddNumberToObject(root, "connects", snap.connects);
+    cJSON_AddNumberToObject(root, "reconnects", snap.reconnects);
+    cJSON_AddNumberToObject(root, "disconnects", snap.disconnects);
+    cJSON_AddNumberToObject(root, "connected_ms", (double)snap.connected_ms);
+    cJSON_AddBoolToObject(root, "connected", snap.connected);
+
+    cJSON_AddItemToObject(root, "route_latency", hist_to_json(&snap.route_latency));
+    cJSON_AddItemToObject(root, "ack_latency", hist_to_json(&snap.ack_latency));
+    cJSON_AddItemToObject(root, "mesh_latency", hist_to_json(&snap.mesh_latency));
+
+    return root;
+}
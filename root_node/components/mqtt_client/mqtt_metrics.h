@@ -0,0 +1,160 @@
+/**
+ * @file mqtt_metrics.h
+ * @brief Счётчики производительности MQTT моста ROOT узла
+ *
+ * Собирает счётчики публикаций/ошибок по классам топиков, объём исходящих
+ * данных, количество переподключений, время в сети и две гистограммы
+ * задержек:
+ * - mesh recv → publish (время прохождения сообщения через data_router)
+ * - publish → MQTT_EVENT_PUBLISHED (подтверждение брокером, только QoS >= 1)
+ *
+ * Все функции потокобезопасны (вызываются из mesh_recv и из задачи MQTT).
+ */
+
+#ifndef MQTT_METRICS_H
+#define MQTT_METRICS_H
+
+#include "cJSON.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MQTT_METRICS_TOPIC          "hydro/metrics/root"
+#define MQTT_METRICS_HIST_BUCKETS   12      ///< Количество корзин гистограммы (последняя = +Inf)
+#define MQTT_METRICS_MAX_PENDING    16      ///< Макс. отслеживаемых неподтверждённых публикаций
+
+/**
+ * @brief Класс MQTT топика (для раздельных счётчиков)
+ */
+typedef enum {
+    MQTT_TOPIC_CLASS_TELEMETRY = 0,     ///< hydro/telemetry/...
+    MQTT_TOPIC_CLASS_EVENT,             ///< hydro/event/...
+    MQTT_TOPIC_CLASS_HEARTBEAT,         ///< hydro/heartbeat/...
+    MQTT_TOPIC_CLASS_CONFIG_RESPONSE,   ///< hydro/config_response/...
+    MQTT_TOPIC_CLASS_DISCOVERY,         ///< hydro/discovery
+    MQTT_TOPIC_CLASS_METRICS,           ///< hydro/metrics/...
+    MQTT_TOPIC_CLASS_ROLLUP,            ///< hydro/rollup/...
+    MQTT_TOPIC_CLASS_OTHER,             ///< Всё остальное
+    MQTT_TOPIC_CLASS_MAX
+} mqtt_topic_class_t;
+
+/**
+ * @brief Гистограмма задержек (мкс)
+ */
+typedef struct {
+    uint32_t buckets[MQTT_METRICS_HIST_BUCKETS];  ///< Счётчики по корзинам (не кумулятивные)
+    uint32_t count;                               ///< Количество измерений
+    uint64_t sum_us;                              ///< Сумма задержек (мкс)
+    uint32_t max_us;                              ///< Максимальная задержка (мкс)
+} mqtt_latency_hist_t;
+
+/**
+ * @brief Снимок всех метрик
+ */
+typedef struct {
+    uint32_t published[MQTT_TOPIC_CLASS_MAX];   ///< Успешные публикации по классам
+    uint32_t failed[MQTT_TOPIC_CLASS_MAX];      ///< Неудачные публикации по классам
+    uint64_t bytes_out;                         ///< Отправлено байт payload
+    uint32_t connects;                          ///< Количество подключений
+    uint32_t reconnects;                        ///< Количество переподключений (connects - 1)
+    uint32_t disconnects;                       ///< Количество отключений
+    uint64_t connected_ms;                      ///< Суммарное время в сети (мс), включая текущую сессию
+    bool connected;                             ///< Текущее состояние
+    mqtt_latency_hist_t route_latency;          ///< mesh recv → publish
+    mqtt_latency_hist_t ack_latency;            ///< publish → MQTT_EVENT_PUBLISHED
+    mqtt_latency_hist_t mesh_latency;           ///< Отправка узлом ("ts_us") → приём ROOT
+} mqtt_metrics_snapshot_t;
+
+/**
+ * @brief Сброс всех метрик
+ */
+void mqtt_metrics_init(void);
+
+/**
+ * @brief Определение класса топика по префиксу
+ *
+ * @param topic MQTT топик
+ * @return Класс топика
+ */
+mqtt_topic_class_t mqtt_metrics_classify_topic(const char *topic);
+
+/**
+ * @brief Учёт результата публикации
+ *
+ * @param topic MQTT топик
+ * @param msg_id ID сообщения (результат esp_mqtt_client_publish)
+ * @param qos QoS публикации (для QoS >= 1 запоминается время для ack гистограммы)
+ * @param bytes Размер payload
+ * @param ok true если публикация принята клиентом
+ */
+void mqtt_metrics_record_publish(const char *topic, int msg_id, int qos, size_t bytes, bool ok);
+
+/**
+ * @brief Учёт подтверждения публикации (MQTT_EVENT_PUBLISHED)
+ *
+ * @param msg_id ID подтверждённого сообщения
+ */
+void mqtt_metrics_record_ack(int msg_id);
+
+/**
+ * @brief Учёт задержки mesh recv → publish
+ *
+ * @param latency_us Задержка в микросекундах
+ */
+void mqtt_metrics_record_route_latency(int64_t latency_us);
+
+/**
+ * @brief Учёт задержки mesh узел → ROOT по синхронизированным часам
+ *
+ * @param latency_us Задержка в микросекундах (отрицательная не учитывается)
+ */
+void mqtt_metrics_record_mesh_latency(int64_t latency_us);
+
+/**
+ * @brief Учёт подключения к брокеру
+ */
+void mqtt_metrics_on_connected(void);
+
+/**
+ * @brief Учёт отключения от брокера
+ */
+void mqtt_metrics_on_disconnected(void);
+
+/**
+ * @brief Получение согласованного снимка метрик
+ *
+ * @param out Структура для заполнения
+ */
+void mqtt_metrics_get_snapshot(mqtt_metrics_snapshot_t *out);
+
+/**
+ * @brief Верхние границы корзин гистограммы (мкс)
+ *
+ * @return Массив из MQTT_METRICS_HIST_BUCKETS - 1 границ (последняя корзина = +Inf)
+ */
+const uint32_t* mqtt_metrics_hist_bounds_us(void);
+
+/**
+ * @brief Название класса топика
+ *
+ * @param cls Класс топика
+ * @return Строка ("telemetry", "event", ...)
+ */
+const char* mqtt_metrics_topic_class_to_str(mqtt_topic_class_t cls);
+
+/**
+ * @brief Экспорт метрик в JSON (для hydro/metrics/root)
+ *
+ * @return cJSON объект (нужно освободить через cJSON_Delete)
+ */
+cJSON* mqtt_metrics_to_json(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MQTT_METRICS_H
@@ -4,42 +4,375 @@
  */
 
 #include "node_registry.h"
+#include "cjson_arena.h"
+#include "mem_policy.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_mac.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "rtos_static.h"
 #include <string.h>
+#include <stdlib.h>
+#include <math.h>
 
 static const char *TAG = "node_registry";
 
-// Внутренний массив узлов
+// Рабочая копия таблицы - только для писателей (под s_write_mutex)
 static node_info_t s_nodes[MAX_NODES];
 static int s_node_count = 0;
+static uint32_t s_slot_seq[MAX_NODES];      // Номер последнего изменения записи
+static uint32_t s_change_seq = 0;
+static uint32_t s_serial_seq = 0;           // node_info_t.serial последнего добавленного
+static bool s_unpublished = false;          // Есть изменения, не попавшие в версию
+static SemaphoreHandle_t s_write_mutex = NULL;
+RTOS_STATIC_MUTEX(registry_write);
+
+/*
+ * Опубликованная версия таблицы (RCU). После публикации не меняется,
+ * кроме счётчика ссылок. Версии образуют список от старой к новой;
+ * возвращаются в пул строго по порядку, когда версия не текущая и её
+ * никто не держит: last_data, вытесненный при публикации версии N+1,
+ * виден версиям <= N и освобождается вместе с версией N.
+ *
+ * Версии из пула, выделенного в init: при публикации в версию копируются
+ * только записи, изменённые с прошлой публикации в неё (slot_seq).
+ */
+typedef struct registry_version {
+    node_registry_view_t view;          // Первое поле: view* == version*
+    uint32_t refs;                      // Читатели, держащие версию
+    cJSON *retired;                     // Вытесненные last_data (цепочка через ->next)
+    struct registry_version *newer;     // Следующая версия (в пуле - следующая свободная)
+    uint32_t slot_seq[MAX_NODES];       // s_slot_seq записей на момент копирования
+} registry_version_t;
+
+static portMUX_TYPE s_version_lock = portMUX_INITIALIZER_UNLOCKED;   // Указатели и refs
+static registry_version_t *s_pool = NULL;
+static registry_version_t *s_free = NULL;   // Свободные версии (только писатель)
+static registry_version_t *s_current = NULL;
+static registry_version_t *s_oldest = NULL;
+static uint32_t s_version_seq = 0;
+static bool s_pool_exhausted = false;       // Для одного предупреждения на эпизод
+
+// Подписчики на события реестра
+typedef struct {
+    node_registry_event_cb_t cb;
+    void *ctx;
+} registry_listener_t;
+
+static registry_listener_t s_listeners[NODE_REGISTRY_MAX_LISTENERS];
+static int s_listener_count = 0;
+
+// Текущее поколение статистики интервалов (инкремент = сброс у всех узлов)
+static volatile uint32_t s_arrival_epoch = 0;
+
+// Неразобранные сообщения от MAC, которых нет в реестре (под s_write_mutex)
+static uint32_t s_unknown_parse_failures = 0;
+
+// Корни деревьев cJSON не входят в списки - next свободен для цепочки
+static void retire_data(registry_version_t *v, cJSON *data) {
+    if (data) {
+        data->next = v->retired;
+        v->retired = data;
+    }
+}
+
+static void recycle_version(registry_version_t *v) {
+    cJSON *item = v->retired;
+    while (item) {
+        cJSON *next = item->next;
+        item->next = NULL;
+        cJSON_Delete(item);
+        item = next;
+    }
+    v->retired = NULL;
+    v->newer = s_free;
+    s_free = v;
+}
+
+// Изменение записи рабочей копии (только писатель, под s_write_mutex)
+static void touch(const node_info_t *node) {
+    s_slot_seq[node - s_nodes] = ++s_change_seq;
+    s_unpublished = true;
+}
+
+// Возврат в пул старых версий, которые больше никто не держит (только писатель)
+static void reclaim_versions(void) {
+    while (1) {
+        registry_version_t *v = NULL;
+
+        portENTER_CRITICAL(&s_version_lock);
+        if (s_oldest && s_oldest != s_current && s_oldest->refs == 0) {
+            v = s_oldest;
+            s_oldest = v->newer;
+        }
+        portEXIT_CRITICAL(&s_version_lock);
+
+        if (!v) {
+            break;
+        }
+        recycle_version(v);
+    }
+}
+
+/*
+ * Публикация рабочей копии как новой версии (только писатель).
+ * retired - last_data, вытесненный этим изменением: старые версии
+ * ещё ссылаются на него.
+ */
+static void publish(cJSON *retired) {
+    reclaim_versions();
+
+    registry_version_t *v = s_free;
+    if (!v) {
+        // Все версии держат читатели: они остаются на текущей, она же
+        // видит retired; изменения уйдут со следующей публикацией
+        if (!s_pool_exhausted) {
+            ESP_LOGW(TAG, "All %d registry versions held by readers, publication deferred",
+                     NODE_REGISTRY_VERSIONS);
+            s_pool_exhausted = true;
+        }
+        if (s_current) {
+            retire_data(s_current, retired);
+        } else {
+            cJSON_Delete(retired);
+        }
+        s_unpublished = true;
+        return;
+    }
+    s_free = v->newer;
+    s_pool_exhausted = false;
+
+    // Версия из пула содержит таблицу своей прошлой публикации:
+    // копируются только записи, изменённые с тех пор
+    for (int i = 0; i < s_node_count; i++) {
+        if (v->slot_seq[i] != s_slot_seq[i]) {
+            memcpy(&v->view.nodes[i], &s_nodes[i], sizeof(node_info_t));
+            v->slot_seq[i] = s_slot_seq[i];
+        }
+    }
+    v->view.count = s_node_count;
+    v->view.version = ++s_version_seq;
+    v->refs = 0;
+    v->newer = NULL;
+    s_unpublished = false;
+
+    portENTER_CRITICAL(&s_version_lock);
+    registry_version_t *prev = s_current;
+    if (prev) {
+        prev->newer = v;
+    } else {
+        s_oldest = v;
+    }
+    s_current = v;
+    portEXIT_CRITICAL(&s_version_lock);
+
+    if (prev) {
+        retire_data(prev, retired);
+    } else {
+        cJSON_Delete(retired);
+    }
+}
+
+static node_info_t* find_node(const char *node_id) {
+    for (int i = 0; i < s_node_count; i++) {
+        if (strcmp(s_nodes[i].node_id, node_id) == 0) {
+            return &s_nodes[i];
+        }
+    }
+    return NULL;
+}
+
+static node_info_t* find_node_by_mac(const uint8_t *mac_addr) {
+    for (int i = 0; i < s_node_count; i++) {
+        if (memcmp(s_nodes[i].mac_addr, mac_addr, 6) == 0) {
+            return &s_nodes[i];
+        }
+    }
+    return NULL;
+}
+
+static void notify_listeners(node_registry_event_t event, const node_info_t *node) {
+    for (int i = 0; i < s_listener_count; i++) {
+        s_listeners[i].cb(event, node, s_listeners[i].ctx);
+    }
+}
+
+static void arrivals_add(node_arrival_stats_t *st, uint32_t interval_ms) {
+    if (st->count == NODE_PHI_WINDOW) {
+        uint32_t old = st->intervals_ms[st->next];
+        st->sum_ms -= old;
+        st->sum_sq_ms -= (uint64_t)old * old;
+    } else {
+        st->count++;
+    }
+
+    st->intervals_ms[st->next] = interval_ms;
+    st->next = (st->next + 1) % NODE_PHI_WINDOW;
+    st->sum_ms += interval_ms;
+    st->sum_sq_ms += (uint64_t)interval_ms * interval_ms;
+}
+
+// Окна темпа: текущее становится предыдущим, пропущенные окна - пустые
+static void traffic_roll_window(node_traffic_stats_t *t, uint64_t now_ms) {
+    uint64_t elapsed = now_ms - t->window_start_ms;
+    if (elapsed < NODE_TRAFFIC_WINDOW_MS) {
+        return;
+    }
+
+    if (elapsed < 2 * NODE_TRAFFIC_WINDOW_MS) {
+        memcpy(t->prev_window_msgs, t->window_msgs, sizeof(t->prev_window_msgs));
+    } else {
+        memset(t->prev_window_msgs, 0, sizeof(t->prev_window_msgs));
+    }
+    memset(t->window_msgs, 0, sizeof(t->window_msgs));
+    t->window_start_ms = now_ms - elapsed % NODE_TRAFFIC_WINDOW_MS;
+}
+
+static void traffic_add(node_traffic_stats_t *t, const mesh_message_t *msg, size_t len, uint64_t now_ms) {
+    int type = (msg->type < NODE_TRAFFIC_MSG_TYPES) ? (int)msg->type : MESH_MSG_UNKNOWN;
+
+    traffic_roll_window(t, now_ms);
+    t->msgs[type]++;
+    if (t->window_msgs[type] < UINT16_MAX) {
+        t->window_msgs[type]++;
+    }
+    t->bytes += len;
+
+    if (msg->has_seq) {
+        if (t->seq_valid && msg->seq > t->last_seq) {
+            t->seq_gaps += msg->seq - t->last_seq - 1;
+        } else if (t->seq_valid && msg->seq < t->last_seq) {
+            t->seq_resets++;    // Перезагрузка узла: нумерация с начала
+        }
+        t->last_seq = msg->seq;
+        t->seq_valid = true;
+    }
+
+    if (msg->rssi != 0) {
+        t->last_rssi = msg->rssi;
+    }
+}
+
+// Jitter по интервалам прихода (пачки уже склеены): J += (|D| - J) / 16
+static void traffic_add_interval(node_traffic_stats_t *t, uint32_t interval_ms) {
+    if (t->last_interval_ms != 0) {
+        float d = fabsf((float)interval_ms - (float)t->last_interval_ms);
+        t->jitter_ms += (d - t->jitter_ms) / NODE_TRAFFIC_JITTER_GAIN;
+    }
+    t->last_interval_ms = interval_ms;
+}
+
+uint32_t node_registry_traffic_rate(const node_info_t *node, int type, uint64_t now_ms) {
+    const node_traffic_stats_t *t = &node->traffic;
+    uint64_t elapsed = now_ms - t->window_start_ms;
+
+    // Версия неизменяема - окно "прокручиваем" при чтении
+    const uint16_t *counts;
+    if (elapsed < NODE_TRAFFIC_WINDOW_MS) {
+        counts = t->prev_window_msgs;
+    } else if (elapsed < 2 * NODE_TRAFFIC_WINDOW_MS) {
+        counts = t->window_msgs;
+    } else {
+        return 0;
+    }
+
+    if (type >= 0) {
+        return (type < NODE_TRAFFIC_MSG_TYPES) ? counts[type] : 0;
+    }
+
+    uint32_t sum = 0;
+    for (int i = 0; i < NODE_TRAFFIC_MSG_TYPES; i++) {
+        sum += counts[i];
+    }
+    return sum;
+}
+
+float node_registry_compute_phi(const node_info_t *node, uint64_t now_ms) {
+    const node_arrival_stats_t *st = &node->arrivals;
+    if (st->epoch != s_arrival_epoch || st->count < NODE_PHI_MIN_SAMPLES) {
+        return -1.0f;
+    }
+
+    float mean = (float)st->sum_ms / st->count;
+    float var = (float)st->sum_sq_ms / st->count - mean * mean;
+    float std = sqrtf(var > 0.0f ? var : 0.0f);
+    if (std < mean * NODE_PHI_MIN_STD_RATIO) {
+        std = mean * NODE_PHI_MIN_STD_RATIO;
+    }
+    if (std < NODE_PHI_MIN_STD_MS) {
+        std = NODE_PHI_MIN_STD_MS;
+    }
+
+    // Ожидаемый интервал с запасом на потерянные сообщения
+    float expected = mean * (1 + NODE_PHI_ACCEPTABLE_LOST);
+    float elapsed = (float)(now_ms - node->last_seen_ms);
+
+    // Логистическая аппроксимация CDF нормального распределения
+    float y = (elapsed - expected) / std;
+    float e = expf(-y * (1.5976f + 0.070566f * y * y));
+    float phi = (elapsed > expected) ? -log10f(e / (1.0f + e))
+                                     : -log10f(1.0f - 1.0f / (1.0f + e));
+
+    // expf переполняется/обнуляется на хвостах - ограничиваем для экспорта в JSON
+    if (!(phi < 99.0f)) {
+        phi = 99.0f;
+    }
+    return phi;
+}
+
+void node_registry_reset_arrivals(void) {
+    s_arrival_epoch++;
+    ESP_LOGI(TAG, "Arrival statistics reset (epoch %lu)", (unsigned long)s_arrival_epoch);
+}
 
 esp_err_t node_registry_init(void) {
     memset(s_nodes, 0, sizeof(s_nodes));
     s_node_count = 0;
+
+    s_write_mutex = rtos_static_mutex_create(&registry_write);
+    if (!s_write_mutex) {
+        ESP_LOGE(TAG, "Failed to create registry mutex");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Версии читаются на каждой маршрутизации: внутренняя RAM, один раз
+    s_pool = mem_policy_calloc("node_registry", MEM_HOT,
+                               NODE_REGISTRY_VERSIONS * sizeof(registry_version_t));
+    if (!s_pool) {
+        ESP_LOGE(TAG, "No memory for %d registry versions", NODE_REGISTRY_VERSIONS);
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < NODE_REGISTRY_VERSIONS; i++) {
+        recycle_version(&s_pool[i]);
+    }
+
+    // Пустая версия: acquire() после init никогда не возвращает NULL
+    publish(NULL);
+    if (!s_current) {
+        return ESP_ERR_NO_MEM;
+    }
     
-    ESP_LOGI(TAG, "Node Registry initialized (max %d nodes)", MAX_NODES);
+    ESP_LOGI(TAG, "Node Registry initialized (max %d nodes, %d versions)",
+             MAX_NODES, NODE_REGISTRY_VERSIONS);
     return ESP_OK;
 }
 
-void node_registry_update_last_seen(const char *node_id, const uint8_t *mac_addr) {
-    if (!node_id || !mac_addr) {
+void node_registry_update_last_seen(const char *node_id, const uint8_t *mac_addr,
+                                    const mesh_message_t *msg, size_t len) {
+    if (!node_id || !mac_addr || !s_write_mutex) {
         return;
     }
 
+    xSemaphoreTake(s_write_mutex, portMAX_DELAY);
+
     // Поиск существующего узла
-    node_info_t *node = NULL;
-    for (int i = 0; i < s_node_count; i++) {
-        if (strcmp(s_nodes[i].node_id, node_id) == 0) {
-            node = &s_nodes[i];
-            break;
-        }
-    }
+    node_info_t *node = find_node(node_id);
 
     // Если не найден - добавить новый
     if (node == NULL) {
         if (s_node_count >= MAX_NODES) {
+            xSemaphoreGive(s_write_mutex);
             ESP_LOGW(TAG, "Registry full, cannot add node %s", node_id);
             return;
         }
@@ -48,6 +381,7 @@ void node_registry_update_last_seen(const char *node_id, const uint8_t *mac_addr
         strncpy(node->node_id, node_id, sizeof(node->node_id) - 1);
         memcpy(node->mac_addr, mac_addr, 6);
         node->last_data = NULL;
+        node->serial = ++s_serial_seq;
 
         ESP_LOGI(TAG, "New node added: %s ("MACSTR")", 
                  node_id, MAC2STR(mac_addr));
@@ -55,69 +389,269 @@ void node_registry_update_last_seen(const char *node_id, const uint8_t *mac_addr
 
     // Обновление статуса
     bool was_offline = !node->online;
+    uint64_t now_ms = esp_timer_get_time() / 1000;
+
+    if (msg) {
+        traffic_add(&node->traffic, msg, len, now_ms);
+    }
+
+    if (node->arrivals.epoch != s_arrival_epoch) {
+        memset(&node->arrivals, 0, sizeof(node->arrivals));
+        node->arrivals.epoch = s_arrival_epoch;
+    }
+
+    // Интервал учитываем только между сообщениями online узла:
+    // пауза offline - это отказ, а не нормальный интервал
+    bool same_burst = false;
+    if (was_offline) {
+        node->traffic.last_interval_ms = 0;
+    } else {
+        uint64_t interval_ms = now_ms - node->last_seen_ms;
+        if (interval_ms < NODE_PHI_MERGE_MS) {
+            same_burst = true;  // Та же пачка (telemetry + heartbeat) - не новый приход
+        } else {
+            arrivals_add(&node->arrivals, (uint32_t)interval_ms);
+            traffic_add_interval(&node->traffic, (uint32_t)interval_ms);
+        }
+    }
+
+    if (!same_burst) {
+        node->last_seen_ms = now_ms;
+    }
     node->online = true;
-    node->last_seen_ms = esp_timer_get_time() / 1000;
+    node->phi = 0.0f;
+    touch(node);
 
+    // Время контакта и счётчики трафика публикуются с ближайшим изменением
+    // данных или проверкой таймаутов - версия нужна только для нового узла
+    // и перехода в online
     if (was_offline) {
+        publish(NULL);
         ESP_LOGI(TAG, "Node %s is now ONLINE", node_id);
+        notify_listeners(NODE_REGISTRY_EVENT_ONLINE, node);
+    }
+
+    xSemaphoreGive(s_write_mutex);
+}
+
+void node_registry_record_parse_failure(const uint8_t *mac_addr) {
+    if (!mac_addr || !s_write_mutex) {
+        return;
     }
+
+    xSemaphoreTake(s_write_mutex, portMAX_DELAY);
+
+    node_info_t *node = find_node_by_mac(mac_addr);
+    if (node) {
+        node->traffic.parse_failures++;
+        touch(node);    // Счётчик - без новой версии
+    } else {
+        s_unknown_parse_failures++;
+    }
+
+    xSemaphoreGive(s_write_mutex);
+}
+
+uint32_t node_registry_get_unknown_parse_failures(void) {
+    return s_unknown_parse_failures;
+}
+
+void node_registry_update_type(const char *node_id, const char *node_type) {
+    if (!node_id || !node_type || node_type[0] == '\0' || !s_write_mutex) {
+        return;
+    }
+
+    xSemaphoreTake(s_write_mutex, portMAX_DELAY);
+
+    node_info_t *node = find_node(node_id);
+    if (node && strncmp(node->node_type, node_type, sizeof(node->node_type) - 1) != 0) {
+        strncpy(node->node_type, node_type, sizeof(node->node_type) - 1);
+        touch(node);
+        publish(NULL);
+        ESP_LOGI(TAG, "Node %s type: %s", node_id, node->node_type);
+        notify_listeners(NODE_REGISTRY_EVENT_INFO, node);
+    }
+
+    xSemaphoreGive(s_write_mutex);
+}
+
+esp_err_t node_registry_register_event_cb(node_registry_event_cb_t cb, void *ctx) {
+    if (!cb) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_listener_count >= NODE_REGISTRY_MAX_LISTENERS) {
+        ESP_LOGE(TAG, "No free listener slots");
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_listeners[s_listener_count].cb = cb;
+    s_listeners[s_listener_count].ctx = ctx;
+    s_listener_count++;
+    return ESP_OK;
 }
 
 void node_registry_update_data(const char *node_id, cJSON *data) {
-    if (!node_id || !data) {
+    if (!node_id || !data || !s_write_mutex) {
         return;
     }
 
-    node_info_t *node = node_registry_get(node_id);
+    // Копия строится до захвата мьютекса - писатели не ждут cJSON_Duplicate.
+    // Живёт дольше сообщения - из heap, даже если вызывающий в арене cJSON
+    void *arena = cjson_arena_suspend();
+    cJSON *copy = cJSON_Duplicate(data, true);
+    cjson_arena_resume(arena);
+
+    xSemaphoreTake(s_write_mutex, portMAX_DELAY);
+
+    node_info_t *node = find_node(node_id);
     if (!node) {
+        xSemaphoreGive(s_write_mutex);
         ESP_LOGW(TAG, "Cannot update data: node %s not found", node_id);
+        cJSON_Delete(copy);
         return;
     }
 
-    // Освобождение старых данных
-    if (node->last_data) {
-        cJSON_Delete(node->last_data);
-    }
-
-    // Копирование новых данных
-    node->last_data = cJSON_Duplicate(data, true);
+    // Старые данные ещё видны опубликованным версиям - освобождаются вместе с ними
+    cJSON *retired = node->last_data;
+    node->last_data = copy;
 
     // Извлечение типа и зоны если есть
+    bool info_changed = false;
     cJSON *type = cJSON_GetObjectItem(data, "node_type");
-    if (type && cJSON_IsString(type)) {
+    if (type && cJSON_IsString(type) &&
+        strncmp(node->node_type, type->valuestring, sizeof(node->node_type) - 1) != 0) {
         strncpy(node->node_type, type->valuestring, sizeof(node->node_type) - 1);
+        info_changed = true;
     }
 
     cJSON *zone = cJSON_GetObjectItem(data, "zone");
-    if (zone && cJSON_IsString(zone)) {
+    if (zone && cJSON_IsString(zone) &&
+        strncmp(node->zone, zone->valuestring, sizeof(node->zone) - 1) != 0) {
         strncpy(node->zone, zone->valuestring, sizeof(node->zone) - 1);
+        info_changed = true;
+    }
+
+    touch(node);
+    publish(retired);
+
+    if (info_changed) {
+        notify_listeners(NODE_REGISTRY_EVENT_INFO, node);
+    }
+    notify_listeners(NODE_REGISTRY_EVENT_DATA, node);
+
+    xSemaphoreGive(s_write_mutex);
+}
+
+esp_err_t node_registry_remove(const char *node_id) {
+    if (!node_id || !s_write_mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_write_mutex, portMAX_DELAY);
+
+    node_info_t *node = find_node(node_id);
+    if (!node) {
+        xSemaphoreGive(s_write_mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    notify_listeners(NODE_REGISTRY_EVENT_REMOVED, node);
+
+    // Порядок записей сохраняется; сдвинутые копируются в версии заново
+    int idx = node - s_nodes;
+    cJSON *retired = node->last_data;
+    memmove(&s_nodes[idx], &s_nodes[idx + 1], (s_node_count - idx - 1) * sizeof(node_info_t));
+    s_node_count--;
+    memset(&s_nodes[s_node_count], 0, sizeof(node_info_t));
+    for (int i = idx; i < s_node_count; i++) {
+        touch(&s_nodes[i]);
     }
+    publish(retired);
+
+    xSemaphoreGive(s_write_mutex);
+    ESP_LOGI(TAG, "Node %s removed", node_id);
+    return ESP_OK;
 }
 
 void node_registry_check_timeouts(void) {
+    if (!s_write_mutex) {
+        return;
+    }
+
     uint64_t now_ms = esp_timer_get_time() / 1000;
+    bool timed_out[MAX_NODES] = {false};
+    bool any = false;
+
+    xSemaphoreTake(s_write_mutex, portMAX_DELAY);
 
     for (int i = 0; i < s_node_count; i++) {
         if (s_nodes[i].online) {
             uint64_t elapsed = now_ms - s_nodes[i].last_seen_ms;
+            float phi = node_registry_compute_phi(&s_nodes[i], now_ms);
+            s_nodes[i].phi = phi;
+            touch(&s_nodes[i]);
 
-            if (elapsed > NODE_TIMEOUT_MS) {
+            bool expired = (phi < 0.0f) ? (elapsed > NODE_BOOTSTRAP_TIMEOUT_MS)
+                                        : (phi > NODE_PHI_THRESHOLD);
+            if (expired) {
                 s_nodes[i].online = false;
-                ESP_LOGW(TAG, "Node %s TIMEOUT -> OFFLINE (elapsed: %llu ms)", 
-                         s_nodes[i].node_id, elapsed);
+                timed_out[i] = any = true;
+                ESP_LOGW(TAG, "Node %s TIMEOUT -> OFFLINE (elapsed: %llu ms, phi: %.1f, mean interval: %llu ms)", 
+                         s_nodes[i].node_id, elapsed, phi,
+                         s_nodes[i].arrivals.count ? s_nodes[i].arrivals.sum_ms / s_nodes[i].arrivals.count : 0);
+            }
+        }
+    }
+
+    // Заодно публикуются время контакта и счётчики, накопленные без версии
+    if (s_unpublished) {
+        publish(NULL);
+    } else {
+        // Читатели могли отпустить версии после последней публикации
+        reclaim_versions();
+    }
+    if (any) {
+        for (int i = 0; i < s_node_count; i++) {
+            if (timed_out[i]) {
+                notify_listeners(NODE_REGISTRY_EVENT_OFFLINE, &s_nodes[i]);
             }
         }
     }
+
+    xSemaphoreGive(s_write_mutex);
+}
+
+const node_registry_view_t* node_registry_acquire(void) {
+    portENTER_CRITICAL(&s_version_lock);
+    registry_version_t *v = s_current;
+    if (v) {
+        v->refs++;
+    }
+    portEXIT_CRITICAL(&s_version_lock);
+
+    return v ? &v->view : NULL;
 }
 
-node_info_t* node_registry_get(const char *node_id) {
-    if (!node_id) {
+void node_registry_release(const node_registry_view_t *view) {
+    if (!view) {
+        return;
+    }
+
+    registry_version_t *v = (registry_version_t *)view;    // view - первое поле версии
+    portENTER_CRITICAL(&s_version_lock);
+    v->refs--;
+    portEXIT_CRITICAL(&s_version_lock);
+}
+
+const node_info_t* node_registry_view_find(const node_registry_view_t *view, const char *node_id) {
+    if (!view || !node_id) {
         return NULL;
     }
 
-    for (int i = 0; i < s_node_count; i++) {
-        if (strcmp(s_nodes[i].node_id, node_id) == 0) {
-            return &s_nodes[i];
+    for (int i = 0; i < view->count; i++) {
+        if (strcmp(view->nodes[i].node_id, node_id) == 0) {
+            return &view->nodes[i];
         }
     }
 
@@ -125,12 +659,19 @@ node_info_t* node_registry_get(const char *node_id) {
 }
 
 int node_registry_get_count(void) {
+    const node_registry_view_t *view = node_registry_acquire();
+    if (!view) {
+        return 0;
+    }
+
     int count = 0;
-    for (int i = 0; i < s_node_count; i++) {
-        if (s_nodes[i].online) {
+    for (int i = 0; i < view->count; i++) {
+        if (view->nodes[i].online) {
             count++;
         }
     }
+
+    node_registry_release(view);
     return count;
 }
 
@@ -141,36 +682,65 @@ cJSON* node_registry_export_all_to_json(void) {
         return NULL;
     }
 
-    for (int i = 0; i < s_node_count; i++) {
-        if (s_nodes[i].online) {
+    const node_registry_view_t *view = node_registry_acquire();
+    if (!view) {
+        return root;
+    }
+
+    uint64_t now_ms = esp_timer_get_time() / 1000;
+
+    for (int i = 0; i < view->count; i++) {
+        const node_info_t *node = &view->nodes[i];
+        if (node->online) {
             cJSON *node_obj = cJSON_CreateObject();
             if (!node_obj) continue;
 
-            cJSON_AddStringToObject(node_obj, "node_id", s_nodes[i].node_id);
-            cJSON_AddStringToObject(node_obj, "node_type", s_nodes[i].node_type);
-            cJSON_AddStringToObject(node_obj, "zone", s_nodes[i].zone);
-            cJSON_AddBoolToObject(node_obj, "online", s_nodes[i].online);
+            cJSON_AddStringToObject(node_obj, "node_id", node->node_id);
+            cJSON_AddStringToObject(node_obj, "node_type", node->node_type);
+            cJSON_AddStringToObject(node_obj, "zone", node->zone);
+            cJSON_AddBoolToObject(node_obj, "online", node->online);
 
             // MAC адрес
             char mac_str[18];
-            snprintf(mac_str, sizeof(mac_str), MACSTR, MAC2STR(s_nodes[i].mac_addr));
+            snprintf(mac_str, sizeof(mac_str), MACSTR, MAC2STR(node->mac_addr));
             cJSON_AddStringToObject(node_obj, "mac_addr", mac_str);
 
-            // Последние данные
-            if (s_nodes[i].last_data) {
+            // Последние данные (дерево версии неизменяемо, пока версия удерживается)
+            if (node->last_data) {
                 cJSON_AddItemToObject(node_obj, "data", 
-                                     cJSON_Duplicate(s_nodes[i].last_data, true));
+                                     cJSON_Duplicate(node->last_data, true));
             }
 
             // Время последнего контакта
-            uint64_t now_ms = esp_timer_get_time() / 1000;
-            uint64_t seconds_ago = (now_ms - s_nodes[i].last_seen_ms) / 1000;
+            uint64_t seconds_ago = (now_ms - node->last_seen_ms) / 1000;
             cJSON_AddNumberToObject(node_obj, "last_seen_seconds_ago", (double)seconds_ago);
 
+            // Детектор отказов: подозрение и средний интервал сообщений
+            const node_arrival_stats_t *st = &node->arrivals;
+            cJSON_AddNumberToObject(node_obj, "phi",
+                                    roundf(node_registry_compute_phi(node, now_ms) * 100) / 100);
+            cJSON_AddNumberToObject(node_obj, "mean_interval_ms",
+                                    st->count ? (double)(st->sum_ms / st->count) : 0);
+
+            // Трафик: сводка без разбивки по типам (ответ Display ограничен 2 КБ)
+            const node_traffic_stats_t *t = &node->traffic;
+            cJSON *traffic = cJSON_CreateObject();
+            if (traffic) {
+                cJSON_AddNumberToObject(traffic, "msgs_per_min",
+                                        node_registry_traffic_rate(node, NODE_TRAFFIC_ALL_TYPES, now_ms));
+                cJSON_AddNumberToObject(traffic, "bytes", (double)t->bytes);
+                cJSON_AddNumberToObject(traffic, "seq_gaps", t->seq_gaps);
+                cJSON_AddNumberToObject(traffic, "jitter_ms", roundf(t->jitter_ms));
+                cJSON_AddNumberToObject(traffic, "parse_failures", t->parse_failures);
+                cJSON_AddNumberToObject(traffic, "rssi", t->last_rssi);
+                cJSON_AddItemToObject(node_obj, "traffic", traffic);
+            }
+
             cJSON_AddItemToArray(root, node_obj);
         }
     }
 
+    node_registry_release(view);
     return root;
 }
 
@@ -179,16 +749,22 @@ int node_registry_get_all(node_info_t *nodes) {
         return 0;
     }
 
+    const node_registry_view_t *view = node_registry_acquire();
+    if (!view) {
+        return 0;
+    }
+
     int count = 0;
-    for (int i = 0; i < s_node_count && count < MAX_NODES; i++) {
-        if (s_nodes[i].online) {
-            memcpy(&nodes[count], &s_nodes[i], sizeof(node_info_t));
-            // Не копируем указатель на cJSON, чтобы избежать двойного освобождения
+    for (int i = 0; i < view->count; i++) {
+        if (view->nodes[i].online) {
+            memcpy(&nodes[count], &view->nodes[i], sizeof(node_info_t));
+            // Не копируем указатель на cJSON: после release версия может быть освобождена
             nodes[count].last_data = NULL;
             count++;
         }
     }
 
+    node_registry_release(view);
     return count;
 }
 
@@ -197,12 +773,17 @@ bool node_registry_has_type(const char *node_type) {
         return false;
     }
 
-    for (int i = 0; i < s_node_count; i++) {
-        if (s_nodes[i].online && strcmp(s_nodes[i].node_type, node_type) == 0) {
-            return true;
-        }
+    const node_registry_view_t *view = node_registry_acquire();
+    if (!view) {
+        return false;
+    }
+
+    bool found = false;
+    for (int i = 0; i < view->count && !found; i++) {
+        found = view->nodes[i].online && strcmp(view->nodes[i].node_type, node_type) == 0;
     }
 
-    return false;
+    node_registry_release(view);
+    return found;
 }
 
@@ -4,6 +4,13 @@
  * 
  * Отслеживает статус всех подключенных узлов, их MAC адреса,
  * последние данные и проверяет таймауты.
+ *
+ * Писатели (mesh_recv, root_monitor) меняют рабочую копию под мьютексом и
+ * публикуют неизменяемую версию таблицы при изменении данных, типа/зоны
+ * или online. Время контакта и счётчики трафика попадают в версию со
+ * следующей публикацией (не реже проверки таймаутов).
+ * Читатели на любой задаче/ядре берут версию через node_registry_acquire()
+ * без блокировок и копирования (RCU).
  */
 
 #ifndef NODE_REGISTRY_H
@@ -11,6 +18,8 @@
 
 #include "esp_err.h"
 #include "cJSON.h"
+#include "mesh_protocol.h"
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -18,8 +27,71 @@
 extern "C" {
 #endif
 
+// Переопределяется только host бенчмарком (host_test) для замеров на 200/2000 узлах
+#ifndef MAX_NODES
 #define MAX_NODES 20
-#define NODE_TIMEOUT_MS 20000  // 20 секунд (синхронизировано с backend)
+#endif
+
+// Пул версий таблицы: текущая, удерживаемые читателями и заполняемая
+#ifndef NODE_REGISTRY_VERSIONS
+#define NODE_REGISTRY_VERSIONS 4
+#endif
+
+/*
+ * Phi-accrual детектор отказов (Hayashibara et al.): вместо единого таймаута
+ * для каждого узла накапливается статистика интервалов между ЛЮБЫМИ
+ * сообщениями, и узел считается offline, когда phi = -log10(P(интервал > t))
+ * превышает порог. Узел с heartbeat раз в 5 с и узел с раз в 60 с получают
+ * каждый свой таймаут.
+ */
+#define NODE_PHI_THRESHOLD          8.0f    ///< Порог phi (P ложного offline ~1e-8)
+#define NODE_PHI_WINDOW             16      ///< Интервалов в скользящем окне
+#define NODE_PHI_MIN_SAMPLES        3       ///< Меньше - работает NODE_BOOTSTRAP_TIMEOUT_MS
+#define NODE_PHI_ACCEPTABLE_LOST    1       ///< Сколько подряд потерянных сообщений терпим
+#define NODE_PHI_MIN_STD_RATIO      0.25f   ///< Мин. σ относительно среднего интервала
+#define NODE_PHI_MIN_STD_MS         100     ///< Абсолютный минимум σ
+#define NODE_PHI_MERGE_MS           250     ///< Сообщения ближе этого - один приход (пачка)
+#define NODE_BOOTSTRAP_TIMEOUT_MS   90000   ///< Таймаут, пока статистики недостаточно
+
+/**
+ * @brief Статистика интервалов прихода сообщений (для phi-accrual)
+ */
+typedef struct {
+    uint32_t intervals_ms[NODE_PHI_WINDOW]; ///< Кольцевой буфер интервалов
+    uint8_t count;                          ///< Заполнено элементов
+    uint8_t next;                           ///< Индекс следующей записи
+    uint64_t sum_ms;                        ///< Сумма интервалов окна
+    uint64_t sum_sq_ms;                     ///< Сумма квадратов интервалов окна
+    uint32_t epoch;                         ///< Поколение статистики (см. node_registry_reset_arrivals)
+} node_arrival_stats_t;
+
+/*
+ * Статистика трафика узла: кто и чем занимает ёмкость mesh. Все поля
+ * обновляются за O(1) на каждое принятое сообщение.
+ */
+#define NODE_TRAFFIC_MSG_TYPES      (MESH_MSG_UNKNOWN + 1)
+#define NODE_TRAFFIC_WINDOW_MS      60000   ///< Окно подсчёта темпа (сообщений в минуту)
+#define NODE_TRAFFIC_JITTER_GAIN    16      ///< Сглаживание jitter 1/16 (как в RFC 3550)
+#define NODE_TRAFFIC_ALL_TYPES      (-1)    ///< Для node_registry_traffic_rate(): сумма по типам
+
+/**
+ * @brief Статистика трафика узла
+ */
+typedef struct {
+    uint32_t msgs[NODE_TRAFFIC_MSG_TYPES];          ///< Сообщений по типам всего
+    uint16_t window_msgs[NODE_TRAFFIC_MSG_TYPES];   ///< Сообщений по типам в текущем окне
+    uint16_t prev_window_msgs[NODE_TRAFFIC_MSG_TYPES]; ///< То же за предыдущее окно
+    uint64_t window_start_ms;                       ///< Начало текущего окна
+    uint64_t bytes;                                 ///< Принято байт
+    uint32_t last_seq;                              ///< Последний seq узла
+    bool seq_valid;                                 ///< last_seq заполнен
+    uint32_t seq_gaps;                              ///< Пропущено номеров seq (потери)
+    uint32_t seq_resets;                            ///< seq пошёл назад (перезагрузка узла)
+    uint32_t last_interval_ms;                      ///< Предыдущий интервал прихода
+    float jitter_ms;                                ///< Сглаженное |Δ интервала прихода|
+    uint32_t parse_failures;                        ///< Неразобранные сообщения с MAC узла
+    int8_t last_rssi;                               ///< Последний RSSI к родителю (0 - неизвестен)
+} node_traffic_stats_t;
 
 /**
  * @brief Информация об узле
@@ -32,8 +104,52 @@ typedef struct {
     bool online;                ///< Статус онлайн
     uint64_t last_seen_ms;      ///< Время последнего контакта (мс)
     cJSON *last_data;           ///< Последние данные от узла
+    node_arrival_stats_t arrivals;  ///< Интервалы прихода сообщений
+    float phi;                  ///< Подозрение отказа на последней проверке
+    node_traffic_stats_t traffic;   ///< Статистика трафика
+    uint32_t serial;            ///< Номер добавления: слот узла сдвигается при удалении других
 } node_info_t;
 
+/**
+ * @brief Неизменяемая версия таблицы узлов
+ * 
+ * Содержит и offline узлы. last_data записей тоже неизменяем и живёт,
+ * пока версия удерживается.
+ */
+typedef struct {
+    uint32_t version;               ///< Номер версии (растёт с каждой публикацией)
+    int count;                      ///< Заполнено записей в nodes
+    node_info_t nodes[MAX_NODES];
+} node_registry_view_t;
+
+/**
+ * @brief События реестра (для подписчиков)
+ */
+typedef enum {
+    NODE_REGISTRY_EVENT_ONLINE = 0,     ///< Узел перешёл в online (новый или после таймаута)
+    NODE_REGISTRY_EVENT_OFFLINE,        ///< Узел перешёл в offline по таймауту
+    NODE_REGISTRY_EVENT_DATA,           ///< Обновлены последние данные (telemetry)
+    NODE_REGISTRY_EVENT_INFO,           ///< Стал известен/изменился тип или зона узла
+    NODE_REGISTRY_EVENT_REMOVED         ///< Узел удалён из реестра (node_registry_remove)
+} node_registry_event_t;
+
+#define NODE_REGISTRY_MAX_LISTENERS 4
+
+/**
+ * @brief Callback событий реестра
+ * 
+ * Вызывается синхронно в контексте задачи, изменившей реестр
+ * (mesh_recv или root_monitor), под мьютексом писателей и после
+ * публикации новой версии - обработчик должен быть коротким, не
+ * блокироваться (например, отправить событие в очередь) и не вызывать
+ * функции обновления реестра.
+ * 
+ * @param event Тип события
+ * @param node Узел (указатель действителен только внутри callback)
+ * @param ctx Пользовательский контекст из регистрации
+ */
+typedef void (*node_registry_event_cb_t)(node_registry_event_t event, const node_info_t *node, void *ctx);
+
 /**
  * @brief Инициализация реестра узлов
  * 
@@ -45,11 +161,42 @@ esp_err_t node_registry_init(void);
  * @brief Обновление времени последнего контакта с узлом
  * 
  * Если узел не существует - добавляет его в реестр.
+ * Вызывается для любого сообщения: интервал с прошлого контакта
+ * пополняет статистику phi-accrual детектора, а само сообщение -
+ * статистику трафика (тип, байты, seq, RSSI). Новую версию публикует
+ * только для нового узла или перехода в online.
  * 
  * @param node_id ID узла
  * @param mac_addr MAC адрес узла
+ * @param msg Разобранное сообщение (NULL - только отметка контакта)
+ * @param len Размер сообщения в байтах
  */
-void node_registry_update_last_seen(const char *node_id, const uint8_t *mac_addr);
+void node_registry_update_last_seen(const char *node_id, const uint8_t *mac_addr,
+                                    const mesh_message_t *msg, size_t len);
+
+/**
+ * @brief Учёт сообщения, которое не удалось разобрать
+ * 
+ * node_id из такого сообщения не известен - узел ищется по MAC.
+ * 
+ * @param mac_addr MAC адрес отправителя
+ */
+void node_registry_record_parse_failure(const uint8_t *mac_addr);
+
+/**
+ * @brief Неразобранные сообщения с MAC, которых нет в реестре
+ */
+uint32_t node_registry_get_unknown_parse_failures(void);
+
+/**
+ * @brief Темп сообщений узла за последнее полное окно
+ * 
+ * @param node Узел
+ * @param type Тип сообщения (mesh_msg_type_t) или NODE_TRAFFIC_ALL_TYPES
+ * @param now_ms Текущее время (мс)
+ * @return Сообщений в минуту
+ */
+uint32_t node_registry_traffic_rate(const node_info_t *node, int type, uint64_t now_ms);
 
 /**
  * @brief Обновление данных узла
@@ -59,20 +206,96 @@ void node_registry_update_last_seen(const char *node_id, const uint8_t *mac_addr
  */
 void node_registry_update_data(const char *node_id, cJSON *data);
 
+/**
+ * @brief Обновление типа узла
+ * 
+ * Тип приходит в корне telemetry/heartbeat сообщений (msg.node_type).
+ * При изменении генерирует NODE_REGISTRY_EVENT_INFO.
+ * 
+ * @param node_id ID узла
+ * @param node_type Тип узла ("climate", "ph", ...)
+ */
+void node_registry_update_type(const char *node_id, const char *node_type);
+
+/**
+ * @brief Подписка на события реестра
+ * 
+ * @param cb Callback
+ * @param ctx Пользовательский контекст (передаётся в callback)
+ * @return ESP_OK при успехе, ESP_ERR_NO_MEM если нет свободных слотов
+ */
+esp_err_t node_registry_register_event_cb(node_registry_event_cb_t cb, void *ctx);
+
+/**
+ * @brief Удаление узла из реестра
+ * 
+ * Для узлов, которых больше не будет (виртуальные узлы load_generator).
+ * Записи после удалённой сдвигаются на слот вперёд - у кого состояние
+ * по слоту, сверяет node_info_t.serial. NODE_REGISTRY_EVENT_REMOVED
+ * вызывается до удаления (node - ещё рабочая копия).
+ * 
+ * @param node_id ID узла
+ * @return ESP_OK, ESP_ERR_NOT_FOUND если узла нет
+ */
+esp_err_t node_registry_remove(const char *node_id);
+
 /**
  * @brief Проверка таймаутов всех узлов
  * 
- * Помечает узлы как offline если не было контакта > NODE_TIMEOUT_MS
+ * Помечает узлы как offline, если phi превысил NODE_PHI_THRESHOLD
+ * (или, пока интервалов меньше NODE_PHI_MIN_SAMPLES, если не было
+ * контакта > NODE_BOOTSTRAP_TIMEOUT_MS), и публикует версию с
+ * накопленными временем контакта, phi и счётчиками трафика.
  */
 void node_registry_check_timeouts(void);
 
 /**
- * @brief Получение информации об узле
+ * @brief Захват текущей версии таблицы
  * 
+ * Не блокируется (короткая критическая секция на инкремент счётчика).
+ * Версия остаётся согласованной, сколько бы писатель ни публиковал
+ * новых; каждый acquire должен завершаться node_registry_release().
+ * Не держать версию долго - версии возвращаются в пул по порядку, и
+ * пока все NODE_REGISTRY_VERSIONS заняты, публикация откладывается.
+ * 
+ * @return Версия таблицы, NULL до node_registry_init()
+ */
+const node_registry_view_t* node_registry_acquire(void);
+
+/**
+ * @brief Освобождение версии, полученной через node_registry_acquire()
+ * 
+ * @param view Версия (NULL допускается)
+ */
+void node_registry_release(const node_registry_view_t *view);
+
+/**
+ * @brief Поиск узла в версии таблицы
+ * 
+ * @param view Версия из node_registry_acquire()
  * @param node_id ID узла
- * @return Указатель на node_info_t или NULL если не найден
+ * @return Запись (действительна до release) или NULL если не найден
  */
-node_info_t* node_registry_get(const char *node_id);
+const node_info_t* node_registry_view_find(const node_registry_view_t *view, const char *node_id);
+
+/**
+ * @brief Сброс статистики интервалов всех узлов
+ * 
+ * Вызывается, когда узлы меняют темп отправки по подсказке ROOT (rate hint):
+ * старые интервалы больше не описывают узел, и до накопления новых
+ * действует NODE_BOOTSTRAP_TIMEOUT_MS. Сброс ленивый - статистика узла
+ * обнуляется при следующем его сообщении, поэтому безопасен из любой задачи.
+ */
+void node_registry_reset_arrivals(void);
+
+/**
+ * @brief Текущее значение phi для узла
+ * 
+ * @param node Узел
+ * @param now_ms Текущее время (мс)
+ * @return phi (0 - узел только что был на связи), -1 если статистики недостаточно
+ */
+float node_registry_compute_phi(const node_info_t *node, uint64_t now_ms);
 
 /**
  * @brief Получение количества онлайн узлов
@@ -91,6 +314,9 @@ cJSON* node_registry_export_all_to_json(void);
 /**
  * @brief Получение списка всех узлов
  * 
+ * Копирует online узлы из текущей версии (last_data = NULL).
+ * Если копия не нужна - использовать node_registry_acquire().
+ * 
  * @param nodes Массив для заполнения (размер MAX_NODES)
  * @return Количество заполненных элементов
  */
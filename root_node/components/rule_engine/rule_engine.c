@@ -0,0 +1,890 @@
+/**
+ * @file rule_engine.c
+ * @brief Реализация движка правил: компилятор выражений в RPN байткод,
+ *        индекс метрика → правила и инкрементальное вычисление
+ */
+
+#include "rule_engine.h"
+#include "node_registry.h"
+#include "mesh_manager.h"
+#include "mesh_protocol.h"
+#include "mqtt_client_manager.h"
+#include "mem_policy.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "rtos_static.h"
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <math.h>
+
+static const char *TAG = "rule_engine";
+
+#define RULE_STACK_DEPTH        8       // Глубина стека вычислителя
+#define RULE_METRIC_NAME_LEN    16
+#define RULE_NVS_NAMESPACE      "rule_engine"
+#define RULE_NVS_KEY            "rules"
+#define RULE_MAX_JSON_SIZE      4000    // Ограничение NVS строки (~4000 байт)
+
+// Байткод: 1 байт опкода + операнды
+typedef enum {
+    OP_END = 0,
+    OP_METRIC,      // +1 байт: индекс метрики
+    OP_CONST,       // +4 байта: float
+    OP_GT, OP_GE, OP_LT, OP_LE, OP_EQ, OP_NE,
+    OP_AND, OP_OR, OP_NOT
+} rule_op_t;
+
+typedef struct {
+    char target[48];                ///< "<node_id>", "type:<t>" или "zone:<z>"
+    char command[32];
+    cJSON *params;                  ///< Может быть NULL
+    bool valid;
+} rule_action_t;
+
+// Состояние правила для одного источника (слота реестра)
+typedef struct {
+    int64_t true_since_us;          ///< 0 - условие ложно
+    bool active;                    ///< then уже выполнено
+    uint32_t serial;                ///< node_info_t.serial узла, чьё это состояние
+} rule_source_state_t;
+
+typedef struct {
+    char id[24];
+    char match_node_id[32];         ///< Пустая строка - любой
+    char match_type[16];
+    char match_zone[32];
+    uint8_t code[RULE_ENGINE_MAX_CODE];
+    uint8_t code_len;
+    uint32_t hold_ms;               ///< Условие должно держаться столько мс
+    uint32_t metric_mask;           ///< Метрики, которые читает условие
+    rule_action_t then_action;
+    rule_action_t else_action;
+
+    // Состояние (hold и active - по источникам в rule_table_t.state)
+    uint32_t evals;
+    uint32_t fires;
+} rule_t;
+
+typedef struct {
+    rule_t rules[RULE_ENGINE_MAX_RULES];
+    int rule_count;
+    rule_source_state_t *state;     ///< [rule_count][MAX_NODES], индекс - слот реестра
+    char metrics[RULE_ENGINE_MAX_METRICS][RULE_METRIC_NAME_LEN];
+    int metric_count;
+    uint32_t metric_rules[RULE_ENGINE_MAX_METRICS];  ///< Битовая маска правил на метрику
+} rule_table_t;
+
+// Сработавшее действие (выполняется вне мьютекса)
+typedef struct {
+    char rule_id[24];
+    char target[48];
+    char command[32];
+    cJSON *params;
+} rule_pending_t;
+
+// Адресат команды, скопированный из версии реестра
+typedef struct {
+    char node_id[32];
+    uint8_t mac[6];
+} command_dest_t;
+
+static SemaphoreHandle_t s_mutex = NULL;
+RTOS_STATIC_MUTEX(rule_engine);
+static rule_table_t *s_table = NULL;
+
+// Сработавшие действия одного сообщения (~3.5 КБ - не на стеке mesh_recv).
+// s_fire_mutex держится всю обработку, включая отправку вне s_mutex:
+// телеметрию обрабатывают mesh_recv и load_generator
+static SemaphoreHandle_t s_fire_mutex = NULL;
+RTOS_STATIC_MUTEX(rule_fire);
+static rule_pending_t s_pending[RULE_ENGINE_MAX_RULES];
+
+// ============================================================================
+// КОМПИЛЯТОР
+// ============================================================================
+
+typedef struct {
+    const char *p;
+    rule_table_t *table;
+    rule_t *rule;
+    int depth;
+    int max_depth;
+    const char *error;
+} rule_compiler_t;
+
+static void skip_ws(rule_compiler_t *c) {
+    while (isspace((unsigned char)*c->p)) {
+        c->p++;
+    }
+}
+
+static bool emit(rule_compiler_t *c, uint8_t op) {
+    if (c->rule->code_len >= RULE_ENGINE_MAX_CODE - 1) {   // Последний байт - OP_END
+        c->error = "expression too long";
+        return false;
+    }
+    c->rule->code[c->rule->code_len++] = op;
+    return true;
+}
+
+static void push_depth(rule_compiler_t *c) {
+    if (++c->depth > c->max_depth) {
+        c->max_depth = c->depth;
+    }
+}
+
+static int intern_metric(rule_table_t *t, const char *name, size_t len) {
+    for (int i = 0; i < t->metric_count; i++) {
+        if (strlen(t->metrics[i]) == len && strncmp(t->metrics[i], name, len) == 0) {
+            return i;
+        }
+    }
+    if (t->metric_count >= RULE_ENGINE_MAX_METRICS || len >= RULE_METRIC_NAME_LEN) {
+        return -1;
+    }
+    memcpy(t->metrics[t->metric_count], name, len);
+    t->metrics[t->metric_count][len] = '\0';
+    return t->metric_count++;
+}
+
+static bool accept(rule_compiler_t *c, const char *tok) {
+    skip_ws(c);
+    size_t len = strlen(tok);
+    if (strncmp(c->p, tok, len) != 0) {
+        return false;
+    }
+    // Ключевые слова and/or/not не должны быть префиксом идентификатора
+    if (isalpha((unsigned char)tok[0]) && (isalnum((unsigned char)c->p[len]) || c->p[len] == '_')) {
+        return false;
+    }
+    c->p += len;
+    return true;
+}
+
+static bool parse_or(rule_compiler_t *c);
+
+static bool parse_primary(rule_compiler_t *c) {
+    skip_ws(c);
+
+    if (accept(c, "(")) {
+        if (!parse_or(c)) {
+            return false;
+        }
+        if (!accept(c, ")")) {
+            c->error = "expected ')'";
+            return false;
+        }
+        return true;
+    }
+
+    if (isdigit((unsigned char)*c->p) || *c->p == '-' || *c->p == '.') {
+        char *end = NULL;
+        float value = strtof(c->p, &end);
+        if (end == c->p) {
+            c->error = "bad number";
+            return false;
+        }
+        c->p = end;
+        if (!emit(c, OP_CONST) || c->rule->code_len + sizeof(float) >= RULE_ENGINE_MAX_CODE) {
+            c->error = "expression too long";
+            return false;
+        }
+        memcpy(&c->rule->code[c->rule->code_len], &value, sizeof(float));
+        c->rule->code_len += sizeof(float);
+        push_depth(c);
+        return true;
+    }
+
+    if (isalpha((unsigned char)*c->p) || *c->p == '_') {
+        const char *start = c->p;
+        while (isalnum((unsigned char)*c->p) || *c->p == '_') {
+            c->p++;
+        }
+        int idx = intern_metric(c->table, start, c->p - start);
+        if (idx < 0) {
+            c->error = "too many metrics or metric name too long";
+            return false;
+        }
+        if (!emit(c, OP_METRIC) || !emit(c, (uint8_t)idx)) {
+            return false;
+        }
+        push_depth(c);
+        return true;
+    }
+
+    c->error = "expected metric, number or '('";
+    return false;
+}
+
+static bool parse_cmp(rule_compiler_t *c) {
+    if (!parse_primary(c)) {
+        return false;
+    }
+
+    // Двухсимвольные операторы проверяются первыми
+    static const struct { const char *tok; uint8_t op; } ops[] = {
+        { ">=", OP_GE }, { "<=", OP_LE }, { "==", OP_EQ }, { "!=", OP_NE },
+        { ">",  OP_GT }, { "<",  OP_LT },
+    };
+
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (accept(c, ops[i].tok)) {
+            if (!parse_primary(c) || !emit(c, ops[i].op)) {
+                return false;
+            }
+            c->depth--;
+            return true;
+        }
+    }
+    return true;
+}
+
+static bool parse_not(rule_compiler_t *c) {
+    if (accept(c, "!") || accept(c, "not")) {
+        return parse_not(c) && emit(c, OP_NOT);
+    }
+    return parse_cmp(c);
+}
+
+static bool parse_and(rule_compiler_t *c) {
+    if (!parse_not(c)) {
+        return false;
+    }
+    while (accept(c, "&&") || accept(c, "and")) {
+        if (!parse_not(c) || !emit(c, OP_AND)) {
+            return false;
+        }
+        c->depth--;
+    }
+    return true;
+}
+
+static bool parse_or(rule_compiler_t *c) {
+    if (!parse_and(c)) {
+        return false;
+    }
+    while (accept(c, "||") || accept(c, "or")) {
+        if (!parse_and(c) || !emit(c, OP_OR)) {
+            return false;
+        }
+        c->depth--;
+    }
+    return true;
+}
+
+static bool compile_expr(rule_table_t *t, rule_t *rule, const char *expr, const char **error) {
+    rule_compiler_t c = { .p = expr, .table = t, .rule = rule };
+
+    rule->code_len = 0;
+    if (!parse_or(&c)) {
+        *error = c.error;
+        return false;
+    }
+    skip_ws(&c);
+    if (*c.p != '\0') {
+        *error = "unexpected trailing input";
+        return false;
+    }
+    if (c.max_depth > RULE_STACK_DEPTH) {
+        *error = "expression too deep";
+        return false;
+    }
+    rule->code[rule->code_len++] = OP_END;
+    return true;
+}
+
+// Метрики, которые читает правило (для индекса)
+static uint32_t code_metric_mask(const rule_t *rule) {
+    uint32_t mask = 0;
+    for (int pc = 0; pc < rule->code_len && rule->code[pc] != OP_END; pc++) {
+        if (rule->code[pc] == OP_METRIC) {
+            mask |= 1u << rule->code[++pc];
+        } else if (rule->code[pc] == OP_CONST) {
+            pc += sizeof(float);
+        }
+    }
+    return mask;
+}
+
+// ============================================================================
+// ВЫЧИСЛЕНИЕ
+// ============================================================================
+
+// Все метрики правила есть в values (см. metric_mask)
+static bool eval_rule(const rule_t *rule, const float *values) {
+    float stack[RULE_STACK_DEPTH];
+    int sp = 0;
+
+    for (int pc = 0; pc < rule->code_len; pc++) {
+        uint8_t op = rule->code[pc];
+        float a, b;
+
+        switch (op) {
+            case OP_END:
+                return sp == 1 && stack[0] != 0.0f && !isnan(stack[0]);
+            case OP_METRIC:
+                stack[sp++] = values[rule->code[++pc]];
+                continue;
+            case OP_CONST:
+                memcpy(&stack[sp++], &rule->code[pc + 1], sizeof(float));
+                pc += sizeof(float);
+                continue;
+            case OP_NOT:
+                stack[sp - 1] = (stack[sp - 1] == 0.0f || isnan(stack[sp - 1])) ? 1.0f : 0.0f;
+                continue;
+            default:
+                break;
+        }
+
+        b = stack[--sp];
+        a = stack[sp - 1];
+        bool r;
+        switch (op) {
+            case OP_GT:  r = a > b;  break;
+            case OP_GE:  r = a >= b; break;
+            case OP_LT:  r = a < b;  break;
+            case OP_LE:  r = a <= b; break;
+            case OP_EQ:  r = a == b; break;
+            case OP_NE:  r = !isnan(a) && !isnan(b) && a != b; break;
+            case OP_AND: r = (a != 0.0f && !isnan(a)) && (b != 0.0f && !isnan(b)); break;
+            case OP_OR:  r = (a != 0.0f && !isnan(a)) || (b != 0.0f && !isnan(b)); break;
+            default:     return false;
+        }
+        stack[sp - 1] = r ? 1.0f : 0.0f;
+    }
+    return false;
+}
+
+static bool rule_matches(const rule_t *rule, const char *node_id, const char *node_type, const char *zone) {
+    if (rule->match_node_id[0] && strcmp(rule->match_node_id, node_id) != 0) {
+        return false;
+    }
+    if (rule->match_type[0] && strcmp(rule->match_type, node_type) != 0) {
+        return false;
+    }
+    if (rule->match_zone[0] && strcmp(rule->match_zone, zone) != 0) {
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// ЗАГРУЗКА
+// ============================================================================
+
+static void copy_json_str(char *dst, size_t dst_len, const cJSON *obj, const char *key) {
+    const cJSON *item = cJSON_GetObjectItem(obj, key);
+    if (item && cJSON_IsString(item)) {
+        strncpy(dst, item->valuestring, dst_len - 1);
+        dst[dst_len - 1] = '\0';
+    }
+}
+
+static bool parse_action(const cJSON *obj, rule_action_t *action) {
+    if (!obj) {
+        return true;    // Действие не задано
+    }
+    if (!cJSON_IsObject(obj)) {
+        return false;
+    }
+
+    copy_json_str(action->target, sizeof(action->target), obj, "target");
+    copy_json_str(action->command, sizeof(action->command), obj, "command");
+    if (!action->target[0] || !action->command[0]) {
+        return false;
+    }
+
+    const cJSON *params = cJSON_GetObjectItem(obj, "params");
+    if (params && cJSON_IsObject(params)) {
+        action->params = cJSON_Duplicate(params, true);
+    }
+    action->valid = true;
+    return true;
+}
+
+static void free_table(rule_table_t *t) {
+    if (!t) {
+        return;
+    }
+    for (int i = 0; i < t->rule_count; i++) {
+        cJSON_Delete(t->rules[i].then_action.params);
+        cJSON_Delete(t->rules[i].else_action.params);
+    }
+    free(t->state);
+    free(t);
+}
+
+static void set_error(char *err_buf, size_t err_len, const char *rule_id, const char *msg) {
+    if (err_buf && err_len) {
+        snprintf(err_buf, err_len, "%s%s%s", rule_id ? rule_id : "", rule_id ? ": " : "", msg);
+    }
+    ESP_LOGW(TAG, "Rule compile error: %s%s%s", rule_id ? rule_id : "", rule_id ? ": " : "", msg);
+}
+
+static rule_table_t* compile_rules(const cJSON *root, char *err_buf, size_t err_len) {
+    const cJSON *rules = cJSON_GetObjectItem(root, "rules");
+    if (!rules || !cJSON_IsArray(rules)) {
+        set_error(err_buf, err_len, NULL, "missing \"rules\" array");
+        return NULL;
+    }
+    if (cJSON_GetArraySize(rules) > RULE_ENGINE_MAX_RULES) {
+        set_error(err_buf, err_len, NULL, "too many rules");
+        return NULL;
+    }
+
+    // Таблица проверяется на каждой telemetry: внутренняя RAM, не PSRAM
+    rule_table_t *t = mem_policy_calloc(NULL, MEM_HOT, sizeof(rule_table_t));
+    if (!t) {
+        set_error(err_buf, err_len, NULL, "out of memory");
+        return NULL;
+    }
+
+    const cJSON *item;
+    cJSON_ArrayForEach(item, rules) {
+        rule_t *rule = &t->rules[t->rule_count++];
+        const char *error = NULL;
+
+        copy_json_str(rule->id, sizeof(rule->id), item, "id");
+        if (!rule->id[0]) {
+            snprintf(rule->id, sizeof(rule->id), "rule_%d", t->rule_count - 1);
+        }
+
+        const cJSON *match = cJSON_GetObjectItem(item, "match");
+        if (match) {
+            copy_json_str(rule->match_node_id, sizeof(rule->match_node_id), match, "node_id");
+            copy_json_str(rule->match_type, sizeof(rule->match_type), match, "node_type");
+            copy_json_str(rule->match_zone, sizeof(rule->match_zone), match, "zone");
+        }
+
+        const cJSON *when = cJSON_GetObjectItem(item, "when");
+        if (!when || !cJSON_IsString(when)) {
+            error = "missing \"when\"";
+        } else if (!compile_expr(t, rule, when->valuestring, &error)) {
+            // error заполнен компилятором
+        } else if (!parse_action(cJSON_GetObjectItem(item, "then"), &rule->then_action) ||
+                   !rule->then_action.valid) {
+            error = "bad \"then\" action";
+        } else if (!parse_action(cJSON_GetObjectItem(item, "else"), &rule->else_action)) {
+            error = "bad \"else\" action";
+        }
+
+        if (error) {
+            set_error(err_buf, err_len, rule->id, error);
+            free_table(t);
+            return NULL;
+        }
+
+        const cJSON *for_s = cJSON_GetObjectItem(item, "for_s");
+        if (for_s && cJSON_IsNumber(for_s) && for_s->valuedouble > 0) {
+            rule->hold_ms = (uint32_t)(for_s->valuedouble * 1000);
+        }
+
+        // Индекс: метрика → правила
+        uint32_t mask = code_metric_mask(rule);
+        rule->metric_mask = mask;
+        for (int m = 0; m < t->metric_count; m++) {
+            if (mask & (1u << m)) {
+                t->metric_rules[m] |= 1u << (t->rule_count - 1);
+            }
+        }
+    }
+
+    // Правило с match по типу/зоне видит несколько источников - у каждого свой "for"
+    t->state = mem_policy_calloc(NULL, MEM_HOT, (size_t)t->rule_count * MAX_NODES * sizeof(rule_source_state_t));
+    if (t->rule_count > 0 && !t->state) {
+        set_error(err_buf, err_len, NULL, "out of memory");
+        free_table(t);
+        return NULL;
+    }
+
+    return t;
+}
+
+static esp_err_t save_to_nvs(const char *json_str) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(RULE_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NVS open failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_set_str(handle, RULE_NVS_KEY, json_str);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save rules: %s", esp_err_to_name(err));
+    }
+
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t rule_engine_load_json(const char *json_str, bool persist, char *err_buf, size_t err_len) {
+    if (!json_str || !s_mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Набор, который не сохранится, пропал бы после перезагрузки - не применяем
+    if (persist && strlen(json_str) > RULE_MAX_JSON_SIZE) {
+        set_error(err_buf, err_len, NULL, "rules JSON too large for NVS");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    cJSON *root = cJSON_Parse(json_str);
+    if (!root) {
+        set_error(err_buf, err_len, NULL, "invalid JSON");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    rule_table_t *t = compile_rules(root, err_buf, err_len);
+    cJSON_Delete(root);
+    if (!t) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Сохранение до замены: при ошибке NVS текущие правила не меняются
+    if (persist) {
+        esp_err_t err = save_to_nvs(json_str);
+        if (err != ESP_OK) {
+            set_error(err_buf, err_len, NULL, "failed to save rules to NVS");
+            free_table(t);
+            return err;
+        }
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    rule_table_t *old = s_table;
+    // Состояние одноимённых правил переносим, чтобы перезагрузка не сбрасывала "for"
+    if (old) {
+        for (int i = 0; i < t->rule_count; i++) {
+            for (int j = 0; j < old->rule_count; j++) {
+                if (strcmp(t->rules[i].id, old->rules[j].id) == 0) {
+                    memcpy(&t->state[i * MAX_NODES], &old->state[j * MAX_NODES],
+                           MAX_NODES * sizeof(rule_source_state_t));
+                    break;
+                }
+            }
+        }
+    }
+    s_table = t;
+    xSemaphoreGive(s_mutex);
+
+    free_table(old);
+
+    ESP_LOGI(TAG, "Loaded %d rules (%d metrics indexed)", t->rule_count, t->metric_count);
+    return ESP_OK;
+}
+
+esp_err_t rule_engine_init(void) {
+    if (s_mutex) {
+        return ESP_OK;
+    }
+
+    // s_fire_mutex - первым: по s_mutex != NULL rule_engine_on_telemetry считает модуль готовым
+    s_fire_mutex = rtos_static_mutex_create(&rule_fire);
+    s_mutex = s_fire_mutex ? rtos_static_mutex_create(&rule_engine) : NULL;
+    if (!s_mutex) {
+        ESP_LOGE(TAG, "Failed to create mutex");
+        return ESP_ERR_NO_MEM;
+    }
+
+    nvs_handle_t handle;
+    if (nvs_open(RULE_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        ESP_LOGI(TAG, "Rule engine initialized (no stored rules)");
+        return ESP_OK;
+    }
+
+    size_t len = 0;
+    esp_err_t err = nvs_get_str(handle, RULE_NVS_KEY, NULL, &len);
+    if (err == ESP_OK && len > 0) {
+        char *json_str = malloc(len);
+        if (json_str && nvs_get_str(handle, RULE_NVS_KEY, json_str, &len) == ESP_OK) {
+            rule_engine_load_json(json_str, false, NULL, 0);
+        }
+        free(json_str);
+    }
+    nvs_close(handle);
+
+    ESP_LOGI(TAG, "Rule engine initialized (%d rules)", rule_engine_get_rule_count());
+    return ESP_OK;
+}
+
+// ============================================================================
+// ДЕЙСТВИЯ
+// ============================================================================
+
+static bool target_matches(const char *target, const node_info_t *node) {
+    if (strncmp(target, "type:", 5) == 0) {
+        return strcmp(node->node_type, target + 5) == 0;
+    }
+    if (strncmp(target, "zone:", 5) == 0) {
+        return strcmp(node->zone, target + 5) == 0;
+    }
+    return strcmp(node->node_id, target) == 0;
+}
+
+esp_err_t rule_engine_send_command(const char *target, const char *command, cJSON *params) {
+    if (!target || !command) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const node_registry_view_t *view = node_registry_acquire();
+    if (!view) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Адресаты копируются, версия отпускается до отправки: mesh_manager_send
+    // может блокироваться, а удерживаемая версия не возвращается в пул
+    int count = 0;
+    for (int i = 0; i < view->count; i++) {
+        count += view->nodes[i].online && target_matches(target, &view->nodes[i]);
+    }
+    command_dest_t *dest = count ? mem_policy_malloc(MEM_HOT, count * sizeof(command_dest_t)) : NULL;
+    int dest_count = 0;
+    for (int i = 0; dest && i < view->count; i++) {
+        const node_info_t *node = &view->nodes[i];
+        if (node->online && target_matches(target, node)) {
+            memcpy(dest[dest_count].node_id, node->node_id, sizeof(dest[dest_count].node_id));
+            memcpy(dest[dest_count].mac, node->mac_addr, 6);
+            dest_count++;
+        }
+    }
+    node_registry_release(view);
+
+    if (count && !dest) {
+        ESP_LOGE(TAG, "No memory for %d recipients of %s", count, command);
+        return ESP_ERR_NO_MEM;
+    }
+
+    cJSON *empty = NULL;
+    if (!params) {
+        params = empty = cJSON_CreateObject();
+    }
+
+    int sent = 0;
+    char json_buf[256];
+    for (int i = 0; i < dest_count; i++) {
+        if (!mesh_protocol_create_command(dest[i].node_id, command, params,
+                                          json_buf, sizeof(json_buf))) {
+            continue;
+        }
+        esp_err_t err = mesh_manager_send(dest[i].mac, (uint8_t *)json_buf, strlen(json_buf));
+        if (err == ESP_OK) {
+            ESP_LOGI(TAG, "Command %s → %s", command, dest[i].node_id);
+            sent++;
+        } else {
+            ESP_LOGE(TAG, "Failed to send %s to %s: %s", command, dest[i].node_id, esp_err_to_name(err));
+        }
+    }
+
+    free(dest);
+    cJSON_Delete(empty);
+
+    if (sent == 0) {
+        ESP_LOGW(TAG, "No online node for target '%s', command %s dropped", target, command);
+        return ESP_ERR_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+static void queue_action(rule_pending_t *pending, int *count, const rule_t *rule, const rule_action_t *action) {
+    if (!action->valid) {
+        return;
+    }
+    rule_pending_t *p = &pending[(*count)++];
+    strcpy(p->rule_id, rule->id);
+    strcpy(p->target, action->target);
+    strcpy(p->command, action->command);
+    p->params = action->params ? cJSON_Duplicate(action->params, true) : NULL;
+}
+
+void rule_engine_on_telemetry(const char *node_id, const cJSON *data) {
+    if (!s_mutex || !node_id || !data) {
+        return;
+    }
+
+    // Копируем тип/зону из версии реестра - действия отправляются уже после release.
+    // Слот реестра - индекс состояния правил этого источника
+    char node_type[16] = {0};
+    char zone[32] = {0};
+    const node_registry_view_t *view = node_registry_acquire();
+    const node_info_t *node = node_registry_view_find(view, node_id);
+    int slot = node ? (int)(node - view->nodes) : -1;
+    uint32_t serial = node ? node->serial : 0;
+    if (node) {
+        strncpy(node_type, node->node_type, sizeof(node_type) - 1);
+        strncpy(zone, node->zone, sizeof(zone) - 1);
+    }
+    node_registry_release(view);
+    if (slot < 0) {
+        return;     // Не в реестре (переполнен) - состояние правил негде хранить
+    }
+
+    rule_pending_t *pending = s_pending;
+    int pending_count = 0;
+    int64_t now_us = esp_timer_get_time();
+
+    xSemaphoreTake(s_fire_mutex, portMAX_DELAY);
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    rule_table_t *t = s_table;
+    if (!t || t->rule_count == 0) {
+        xSemaphoreGive(s_mutex);
+        xSemaphoreGive(s_fire_mutex);
+        return;
+    }
+
+    // Значения метрик из этого сообщения, их маска и маска затронутых правил
+    float values[RULE_ENGINE_MAX_METRICS];
+    uint32_t present = 0;
+    uint32_t affected = 0;
+
+    const cJSON *item;
+    cJSON_ArrayForEach(item, data) {
+        if (!item->string || !(cJSON_IsNumber(item) || cJSON_IsBool(item))) {
+            continue;
+        }
+        for (int m = 0; m < t->metric_count; m++) {
+            if (strcmp(t->metrics[m], item->string) == 0) {
+                values[m] = cJSON_IsBool(item) ? (cJSON_IsTrue(item) ? 1.0f : 0.0f)
+                                               : (float)item->valuedouble;
+                present |= 1u << m;
+                affected |= t->metric_rules[m];
+                break;
+            }
+        }
+    }
+
+    while (affected) {
+        int i = __builtin_ctz(affected);
+        affected &= affected - 1;
+
+        rule_t *rule = &t->rules[i];
+        if (!rule_matches(rule, node_id, node_type, zone)) {
+            continue;
+        }
+        // Сообщение без части метрик (другой тип телеметрии) правило не
+        // вычисляет: иначе "ложь" сбросила бы for_s и выполнила else
+        if ((rule->metric_mask & present) != rule->metric_mask) {
+            continue;
+        }
+
+        rule_source_state_t *st = &t->state[i * MAX_NODES + slot];
+        if (st->serial != serial) {
+            // Слот занял другой узел (удаление из реестра сдвигает записи)
+            memset(st, 0, sizeof(*st));
+            st->serial = serial;
+        }
+        rule->evals++;
+        if (eval_rule(rule, values)) {
+            if (st->true_since_us == 0) {
+                st->true_since_us = now_us;
+            }
+            if (!st->active && now_us - st->true_since_us >= (int64_t)rule->hold_ms * 1000) {
+                st->active = true;
+                rule->fires++;
+                queue_action(pending, &pending_count, rule, &rule->then_action);
+            }
+        } else {
+            st->true_since_us = 0;
+            if (st->active) {
+                st->active = false;
+                queue_action(pending, &pending_count, rule, &rule->else_action);
+            }
+        }
+    }
+    xSemaphoreGive(s_mutex);
+
+    for (int i = 0; i < pending_count; i++) {
+        ESP_LOGI(TAG, "Rule %s fired (source %s): %s → %s",
+                 pending[i].rule_id, node_id, pending[i].command, pending[i].target);
+        rule_engine_send_command(pending[i].target, pending[i].command, pending[i].params);
+        cJSON_Delete(pending[i].params);
+    }
+    xSemaphoreGive(s_fire_mutex);
+}
+
+// ============================================================================
+// MQTT / ЭКСПОРТ
+// ============================================================================
+
+void rule_engine_handle_mqtt(const char *data) {
+    char error[96] = {0};
+    esp_err_t err = rule_engine_load_json(data, true, error, sizeof(error));
+
+    cJSON *status = cJSON_CreateObject();
+    if (!status) {
+        return;
+    }
+    cJSON_AddStringToObject(status, "type", "rules_status");
+    cJSON_AddBoolToObject(status, "ok", err == ESP_OK);
+    cJSON_AddNumberToObject(status, "count", rule_engine_get_rule_count());
+    if (err != ESP_OK) {
+        cJSON_AddStringToObject(status, "error", error[0] ? error : esp_err_to_name(err));
+    }
+
+    char *json_str = cJSON_PrintUnformatted(status);
+    if (json_str) {
+        if (mqtt_client_manager_is_connected()) {
+            mqtt_client_manager_publish(RULE_ENGINE_MQTT_TOPIC_STATUS, json_str);
+        }
+        free(json_str);
+    }
+    cJSON_Delete(status);
+}
+
+int rule_engine_get_rule_count(void) {
+    if (!s_mutex) {
+        return 0;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    int count = s_table ? s_table->rule_count : 0;
+    xSemaphoreGive(s_mutex);
+    return count;
+}
+
+cJSON* rule_engine_export_json(void) {
+    cJSON *array = cJSON_CreateArray();
+    if (!array || !s_mutex) {
+        return array;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    for (int i = 0; s_table && i < s_table->rule_count; i++) {
+        const rule_t *rule = &s_table->rules[i];
+        cJSON *obj = cJSON_CreateObject();
+        if (!obj) {
+            break;
+        }
+
+        // Сводка по источникам: сколько активно и дольше всех истинное условие
+        int active = 0;
+        int64_t true_since_us = 0;
+        for (int s = 0; s < MAX_NODES; s++) {
+            const rule_source_state_t *st = &s_table->state[i * MAX_NODES + s];
+            active += st->active;
+            if (st->true_since_us && (!true_since_us || st->true_since_us < true_since_us)) {
+                true_since_us = st->true_since_us;
+            }
+        }
+
+        cJSON_AddStringToObject(obj, "id", rule->id);
+        cJSON_AddNumberToObject(obj, "code_bytes", rule->code_len);
+        cJSON_AddNumberToObject(obj, "for_s", rule->hold_ms / 1000.0);
+        cJSON_AddBoolToObject(obj, "active", active > 0);
+        cJSON_AddNumberToObject(obj, "active_sources", active);
+        cJSON_AddNumberToObject(obj, "true_for_s", true_since_us ? (now_us - true_since_us) / 1e6 : 0);
+        cJSON_AddNumberToObject(obj, "evals", rule->evals);
+        cJSON_AddNumberToObject(obj, "fires", rule->fires);
+        cJSON_AddItemToArray(array, obj);
+    }
+    xSemaphoreGive(s_mutex);
+
+    return array;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file rule_engine.h
+ * @brief Декларативные правила автоматизации на ROOT узле
+ *
+ * Правила вида "зона A: co2 > 900 в течение 2 мин → relay start_fan"
+ * компилируются в компактный байткод (RPN) и индексируются по метрикам,
+ * которые они читают. При приходе телеметрии вычисляются только правила,
+ * затронутые полями этой телеметрии.
+ *
+ * Правила загружаются через MQTT (hydro/rules/set) и сохраняются в NVS.
+ *
+ * Формат:
+ * @code
+ * {"rules":[{
+ *     "id": "zone_a_co2",
+ *     "match": {"zone": "A", "node_type": "climate"},   // опционально, также "node_id"
+ *     "when": "co2 > 900 && temperature > 18",
+ *     "for_s": 120,                                      // опционально
+ *     "then": {"target": "type:relay", "command": "start_fan", "params": {}},
+ *     "else": {"target": "type:relay", "command": "stop_fan"}   // опционально
+ * }]}
+ * @endcode
+ *
+ * target: "<node_id>", "type:<node_type>" или "zone:<zone>".
+ * when: метрики, числа, > >= < <= == !=, && || !, скобки.
+ */
+
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include "esp_err.h"
+#include "cJSON.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RULE_ENGINE_MAX_RULES       32      ///< Макс. правил (индекс - битовая маска uint32_t)
+#define RULE_ENGINE_MAX_METRICS     32      ///< Макс. различных метрик во всех правилах
+#define RULE_ENGINE_MAX_CODE        64      ///< Макс. размер байткода одного правила
+#define RULE_ENGINE_MQTT_TOPIC_SET      "hydro/rules/set"
+#define RULE_ENGINE_MQTT_TOPIC_STATUS   "hydro/rules/status"
+
+/**
+ * @brief Инициализация движка и загрузка правил из NVS
+ *
+ * @return ESP_OK при успехе (отсутствие сохранённых правил - не ошибка)
+ */
+esp_err_t rule_engine_init(void);
+
+/**
+ * @brief Компиляция и атомарная замена всех правил
+ *
+ * При ошибке компиляции или сохранения текущие правила не меняются.
+ *
+ * @param json_str JSON с массивом "rules"
+ * @param persist true - сохранить исходный JSON в NVS (до замены правил)
+ * @param err_buf Буфер для текста ошибки (может быть NULL)
+ * @param err_len Размер буфера
+ * @return ESP_OK при успехе, ESP_ERR_INVALID_ARG при ошибке синтаксиса,
+ *         ESP_ERR_INVALID_SIZE если JSON не помещается в NVS, ошибка NVS
+ */
+esp_err_t rule_engine_load_json(const char *json_str, bool persist, char *err_buf, size_t err_len);
+
+/**
+ * @brief Обработка входящей телеметрии (вызывается из data_router)
+ *
+ * Вычисляет только правила, читающие хотя бы одно поле из data,
+ * и выполняет сработавшие действия через mesh.
+ *
+ * @param node_id ID узла-источника
+ * @param data Объект data телеметрии
+ */
+void rule_engine_on_telemetry(const char *node_id, const cJSON *data);
+
+/**
+ * @brief Отправка команды всем online узлам цели
+ *
+ * Используется действиями правил и climate_logic.
+ *
+ * @param target "<node_id>", "type:<node_type>" или "zone:<zone>"
+ * @param command Имя команды
+ * @param params Параметры (может быть NULL)
+ * @return ESP_OK если команда ушла хотя бы одному узлу, ESP_ERR_NOT_FOUND если узлов нет
+ */
+esp_err_t rule_engine_send_command(const char *target, const char *command, cJSON *params);
+
+/**
+ * @brief Обработка MQTT сообщения hydro/rules/set
+ *
+ * Загружает правила и публикует результат в hydro/rules/status.
+ *
+ * @param data JSON правил
+ */
+void rule_engine_handle_mqtt(const char *data);
+
+/**
+ * @brief Количество загруженных правил
+ */
+int rule_engine_get_rule_count(void);
+
+/**
+ * @brief Экспорт правил и их состояния в JSON
+ *
+ * @return cJSON массив (нужно освободить через cJSON_Delete)
+ */
+cJSON* rule_engine_export_json(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RULE_ENGINE_H
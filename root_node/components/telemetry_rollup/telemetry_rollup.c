@@ -0,0 +1,399 @@
+/**
+ * @file telemetry_rollup.c
+ * @brief Реализация агрегации telemetry на ROOT
+ */
+
+#include "telemetry_rollup.h"
+#include "node_registry.h"
+#include "mesh_protocol.h"
+#include "mqtt_client_manager.h"
+#include "mem_policy.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "rtos_static.h"
+#include <string.h>
+#include <stdlib.h>
+#include <float.h>
+
+static const char *TAG = "rollup";
+
+#ifndef CONFIG_ROOT_ROLLUP_WINDOW_S
+#define CONFIG_ROOT_ROLLUP_WINDOW_S     60
+#endif
+#ifdef CONFIG_ROOT_ROLLUP_RAW_DEFAULT
+#define ROLLUP_RAW_DEFAULT              true
+#else
+#define ROLLUP_RAW_DEFAULT              false
+#endif
+
+#define ROLLUP_NVS_NAMESPACE    "rollup"
+#define ROLLUP_NVS_KEY          "raw_cfg"
+#define ROLLUP_NODES_SIZE       (sizeof(rollup_node_t) * MAX_NODES)
+
+/**
+ * @brief Накопитель одной метрики за окно
+ */
+typedef struct {
+    char name[ROLLUP_METRIC_NAME_LEN];
+    float min;
+    float max;
+    double sum;
+    float last;
+    uint32_t count;
+} rollup_metric_t;
+
+/**
+ * @brief Окно одного узла
+ */
+typedef struct {
+    char node_id[32];
+    char node_type[16];
+    uint8_t metric_count;
+    rollup_metric_t metrics[ROLLUP_MAX_METRICS];
+} rollup_node_t;
+
+/**
+ * @brief Переопределение сырого потока для узла
+ */
+typedef struct {
+    char node_id[32];
+    bool raw;
+} rollup_raw_override_t;
+
+// Окна узлов и снимки для публикации - холодные (раз в окно), в PSRAM
+static rollup_node_t *s_nodes = NULL;
+static rollup_raw_override_t s_raw[MAX_NODES];
+static int s_raw_count = 0;
+static bool s_raw_default = ROLLUP_RAW_DEFAULT;
+static SemaphoreHandle_t s_mutex = NULL;
+static TaskHandle_t s_task = NULL;
+RTOS_STATIC_MUTEX(rollup_mutex);
+RTOS_STATIC_TASK(rollup, 4096);
+
+// ============================================================================
+// НАСТРОЙКА СЫРОГО ПОТОКА
+// ============================================================================
+
+// Вызывается под мьютексом
+static esp_err_t apply_raw_config(const char *json_str) {
+    cJSON *root = cJSON_Parse(json_str);
+    if (!root) {
+        ESP_LOGW(TAG, "Invalid rollup config JSON");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const cJSON *def = cJSON_GetObjectItem(root, "raw_default");
+    if (def && cJSON_IsBool(def)) {
+        s_raw_default = cJSON_IsTrue(def);
+    }
+
+    const cJSON *raw = cJSON_GetObjectItem(root, "raw");
+    if (raw && cJSON_IsObject(raw)) {
+        s_raw_count = 0;
+        const cJSON *item;
+        cJSON_ArrayForEach(item, raw) {
+            if (s_raw_count >= MAX_NODES || !cJSON_IsBool(item)) {
+                continue;
+            }
+            strncpy(s_raw[s_raw_count].node_id, item->string, sizeof(s_raw[0].node_id) - 1);
+            s_raw[s_raw_count].node_id[sizeof(s_raw[0].node_id) - 1] = '\0';
+            s_raw[s_raw_count].raw = cJSON_IsTrue(item);
+            s_raw_count++;
+        }
+    }
+
+    cJSON_Delete(root);
+    ESP_LOGI(TAG, "Raw passthrough: default=%s, %d overrides", s_raw_default ? "on" : "off", s_raw_count);
+    return ESP_OK;
+}
+
+static bool raw_enabled_locked(const char *node_id) {
+    for (int i = 0; i < s_raw_count; i++) {
+        if (strcmp(s_raw[i].node_id, node_id) == 0) {
+            return s_raw[i].raw;
+        }
+    }
+    return s_raw_default;
+}
+
+bool telemetry_rollup_is_raw_enabled(const char *node_id) {
+    if (!s_mutex || !node_id) {
+        return true;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool raw = raw_enabled_locked(node_id);
+    xSemaphoreGive(s_mutex);
+    return raw;
+}
+
+void telemetry_rollup_handle_mqtt(const char *data) {
+    if (!s_mutex || !data) {
+        return;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    esp_err_t err = apply_raw_config(data);
+    xSemaphoreGive(s_mutex);
+
+    if (err != ESP_OK) {
+        return;
+    }
+
+    nvs_handle_t handle;
+    if (nvs_open(ROLLUP_NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+        if (nvs_set_str(handle, ROLLUP_NVS_KEY, data) != ESP_OK || nvs_commit(handle) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to persist rollup config");
+        }
+        nvs_close(handle);
+    }
+}
+
+// ============================================================================
+// НАКОПЛЕНИЕ
+// ============================================================================
+
+static void metric_reset(rollup_metric_t *m) {
+    m->min = FLT_MAX;
+    m->max = -FLT_MAX;
+    m->sum = 0.0;
+    m->count = 0;
+}
+
+// Вызывается под мьютексом
+static rollup_node_t* find_or_create(const char *node_id) {
+    rollup_node_t *free_slot = NULL;
+    for (int i = 0; i < MAX_NODES; i++) {
+        if (s_nodes[i].node_id[0] == '\0') {
+            if (!free_slot) {
+                free_slot = &s_nodes[i];
+            }
+        } else if (strcmp(s_nodes[i].node_id, node_id) == 0) {
+            return &s_nodes[i];
+        }
+    }
+
+    if (free_slot) {
+        memset(free_slot, 0, sizeof(*free_slot));
+        strncpy(free_slot->node_id, node_id, sizeof(free_slot->node_id) - 1);
+    }
+    return free_slot;
+}
+
+static rollup_metric_t* find_metric(rollup_node_t *node, const char *name) {
+    for (int i = 0; i < node->metric_count; i++) {
+        if (strcmp(node->metrics[i].name, name) == 0) {
+            return &node->metrics[i];
+        }
+    }
+
+    if (node->metric_count >= ROLLUP_MAX_METRICS || strlen(name) >= ROLLUP_METRIC_NAME_LEN) {
+        return NULL;
+    }
+
+    rollup_metric_t *m = &node->metrics[node->metric_count++];
+    strcpy(m->name, name);
+    metric_reset(m);
+    return m;
+}
+
+bool telemetry_rollup_add(const char *node_id, const char *node_type, const cJSON *data) {
+    if (!s_mutex || !node_id || !data) {
+        return true;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+    rollup_node_t *node = find_or_create(node_id);
+    if (node) {
+        if (node_type && node_type[0]) {
+            strncpy(node->node_type, node_type, sizeof(node->node_type) - 1);
+        }
+
+        const cJSON *item;
+        cJSON_ArrayForEach(item, data) {
+            if (!item->string || !cJSON_IsNumber(item)) {
+                continue;
+            }
+            rollup_metric_t *m = find_metric(node, item->string);
+            if (!m) {
+                continue;
+            }
+
+            float v = (float)item->valuedouble;
+            if (v < m->min) m->min = v;
+            if (v > m->max) m->max = v;
+            m->sum += v;
+            m->last = v;
+            m->count++;
+        }
+    } else {
+        ESP_LOGW(TAG, "No rollup slot for %s", node_id);
+    }
+
+    bool raw = raw_enabled_locked(node_id);
+    xSemaphoreGive(s_mutex);
+    return raw;
+}
+
+void telemetry_rollup_remove(const char *node_id) {
+    if (!s_mutex || !node_id) {
+        return;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    for (int i = 0; i < MAX_NODES; i++) {
+        if (strcmp(s_nodes[i].node_id, node_id) == 0) {
+            s_nodes[i].node_id[0] = '\0';     // Свободный слот для find_or_create
+            break;
+        }
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+// ============================================================================
+// ПУБЛИКАЦИЯ
+// ============================================================================
+
+static void publish_node(const rollup_node_t *node) {
+    cJSON *root = cJSON_CreateObject();
+    if (!root) {
+        return;
+    }
+
+    cJSON_AddStringToObject(root, "type", "rollup");
+    cJSON_AddStringToObject(root, "node_id", node->node_id);
+    cJSON_AddStringToObject(root, "node_type", node->node_type);
+    cJSON_AddNumberToObject(root, "timestamp", mesh_protocol_get_timestamp());
+    cJSON_AddNumberToObject(root, "window_s", CONFIG_ROOT_ROLLUP_WINDOW_S);
+
+    cJSON *metrics = cJSON_AddObjectToObject(root, "metrics");
+    for (int i = 0; i < node->metric_count; i++) {
+        const rollup_metric_t *m = &node->metrics[i];
+        if (m->count == 0) {
+            continue;
+        }
+        cJSON *obj = cJSON_AddObjectToObject(metrics, m->name);
+        cJSON_AddNumberToObject(obj, "min", m->min);
+        cJSON_AddNumberToObject(obj, "max", m->max);
+        cJSON_AddNumberToObject(obj, "mean", m->sum / m->count);
+        cJSON_AddNumberToObject(obj, "last", m->last);
+        cJSON_AddNumberToObject(obj, "count", m->count);
+    }
+
+    char *json_str = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (!json_str) {
+        return;
+    }
+
+    char topic[64];
+    snprintf(topic, sizeof(topic), "%s/%s", ROLLUP_MQTT_TOPIC, node->node_id);
+
+    esp_err_t err = mqtt_client_manager_publish(topic, json_str);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to publish rollup for %s: %s", node->node_id, esp_err_to_name(err));
+    }
+    free(json_str);
+}
+
+esp_err_t telemetry_rollup_flush(void) {
+    if (!s_mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Снимок окна под мьютексом, публикация без него - приём telemetry не ждёт MQTT
+    rollup_node_t *snapshot = mem_policy_malloc(MEM_COLD, ROLLUP_NODES_SIZE);
+    if (!snapshot) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    memcpy(snapshot, s_nodes, ROLLUP_NODES_SIZE);
+    for (int i = 0; i < MAX_NODES; i++) {
+        for (int m = 0; m < s_nodes[i].metric_count; m++) {
+            metric_reset(&s_nodes[i].metrics[m]);
+        }
+    }
+    xSemaphoreGive(s_mutex);
+
+    int published = 0;
+    bool connected = mqtt_client_manager_is_connected();
+    for (int i = 0; i < MAX_NODES; i++) {
+        const rollup_node_t *node = &snapshot[i];
+        bool has_data = false;
+        for (int m = 0; m < node->metric_count; m++) {
+            has_data |= node->metrics[m].count > 0;
+        }
+        if (!node->node_id[0] || !has_data) {
+            continue;
+        }
+        if (connected) {
+            publish_node(node);
+            published++;
+        }
+    }
+
+    free(snapshot);
+
+    if (!connected) {
+        ESP_LOGW(TAG, "MQTT offline, rollup window dropped");
+        return ESP_ERR_INVALID_STATE;
+    }
+    ESP_LOGI(TAG, "Published %d rollups", published);
+    return ESP_OK;
+}
+
+static void rollup_task(void *arg) {
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(CONFIG_ROOT_ROLLUP_WINDOW_S * 1000));
+        telemetry_rollup_flush();
+    }
+}
+
+esp_err_t telemetry_rollup_init(void) {
+    if (s_mutex) {
+        return ESP_OK;
+    }
+
+    if (!s_nodes) {
+        s_nodes = mem_policy_calloc("telemetry_rollup", MEM_COLD, ROLLUP_NODES_SIZE);
+        if (!s_nodes) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    s_mutex = rtos_static_mutex_create(&rollup_mutex);
+    if (!s_mutex) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Настройки сырого потока из NVS
+    nvs_handle_t handle;
+    if (nvs_open(ROLLUP_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        size_t len = 0;
+        if (nvs_get_str(handle, ROLLUP_NVS_KEY, NULL, &len) == ESP_OK && len > 0) {
+            char *json_str = malloc(len);
+            if (json_str && nvs_get_str(handle, ROLLUP_NVS_KEY, json_str, &len) == ESP_OK) {
+                apply_raw_config(json_str);
+            }
+            free(json_str);
+        }
+        nvs_close(handle);
+    }
+
+    if (rtos_static_task_create(&rollup, rollup_task, "rollup", NULL, 3, &s_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create rollup task");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Telemetry rollups started (window %d s, raw default %s)",
+             CONFIG_ROOT_ROLLUP_WINDOW_S, s_raw_default ? "on" : "off");
+    return ESP_OK;
+}
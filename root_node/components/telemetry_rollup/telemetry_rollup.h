@@ -0,0 +1,92 @@
+/**
+ * @file telemetry_rollup.h
+ * @brief Агрегация telemetry на ROOT (edge rollups)
+ *
+ * Для каждого узла и каждой числовой метрики инкрементально считает
+ * min/max/mean/last/count за окно (по умолчанию 1 минута) и публикует
+ * результат в hydro/rollup/{node_id}. Сырой поток telemetry можно
+ * отключить для отдельных узлов - тогда backend получает одно сообщение
+ * в минуту вместо двенадцати.
+ *
+ * Формат rollup:
+ * @code
+ * {"type":"rollup","node_id":"climate_001","node_type":"climate",
+ *  "timestamp":1700000000,"window_s":60,
+ *  "metrics":{"temperature":{"min":23.9,"max":24.4,"mean":24.1,"last":24.2,"count":12}}}
+ * @endcode
+ *
+ * Настройка сырого потока (hydro/rollup/set, сохраняется в NVS):
+ * @code
+ * {"raw_default": true, "raw": {"climate_001": false}}
+ * @endcode
+ */
+
+#ifndef TELEMETRY_ROLLUP_H
+#define TELEMETRY_ROLLUP_H
+
+#include "esp_err.h"
+#include "cJSON.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ROLLUP_MAX_METRICS          8       ///< Числовых метрик на узел
+#define ROLLUP_METRIC_NAME_LEN      16
+#define ROLLUP_MQTT_TOPIC           "hydro/rollup"          ///< + "/{node_id}"
+#define ROLLUP_MQTT_TOPIC_SET       "hydro/rollup/set"
+
+/**
+ * @brief Инициализация: загрузка настроек сырого потока из NVS и запуск задачи публикации
+ *
+ * @return ESP_OK при успехе
+ */
+esp_err_t telemetry_rollup_init(void);
+
+/**
+ * @brief Учёт telemetry узла в текущем окне
+ *
+ * @param node_id ID узла
+ * @param node_type Тип узла (может быть пустым)
+ * @param data Объект data telemetry
+ * @return true - сырую telemetry тоже нужно публиковать
+ *         (всегда true, если rollups не инициализированы)
+ */
+bool telemetry_rollup_add(const char *node_id, const char *node_type, const cJSON *data);
+
+/**
+ * @brief Удаление окна узла без публикации
+ *
+ * Для узлов, которых больше не будет (виртуальные узлы load_generator).
+ *
+ * @param node_id ID узла
+ */
+void telemetry_rollup_remove(const char *node_id);
+
+/**
+ * @brief Включена ли публикация сырой telemetry для узла
+ *
+ * @param node_id ID узла
+ */
+bool telemetry_rollup_is_raw_enabled(const char *node_id);
+
+/**
+ * @brief Обработка MQTT сообщения hydro/rollup/set
+ *
+ * @param data JSON настроек сырого потока
+ */
+void telemetry_rollup_handle_mqtt(const char *data);
+
+/**
+ * @brief Немедленная публикация и сброс текущего окна
+ *
+ * @return ESP_OK при успехе
+ */
+esp_err_t telemetry_rollup_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_ROLLUP_H
@@ -17,16 +17,32 @@
 // Common компоненты
 #include "mesh_manager.h"
 #include "mesh_protocol.h"
+#include "mesh_time.h"
+#include "instrumentation.h"
+#include "trace_ring.h"
+#include "dlog.h"
+#include "cjson_arena.h"
+#include "mem_policy.h"
+#include "pm_policy.h"
+#include "rtos_static.h"
 
 // ROOT компоненты
 #include "node_registry.h"
 #include "mqtt_client_manager.h"
 #include "data_router.h"
 #include "climate_logic.h"
+#include "rule_engine.h"
+#include "local_api.h"
+#include "telemetry_rollup.h"
+#include "backpressure.h"
+#include "load_generator.h"
 #include "root_config.h"
 
 static const char *TAG = "ROOT";
 
+// Stack увеличен в 2 раза для безопасности: 4096 → 8192
+RTOS_STATIC_TASK(root_monitor, 8192);
+
 /**
  * @brief Задача мониторинга системы
  * 
@@ -66,8 +82,10 @@ static void root_monitoring_task(void *arg) {
             ESP_LOGI(TAG, "========================================");
             
             // Отправка discovery сообщения (для регистрации на сервере)
+            // и метрик MQTT моста (hydro/metrics/root)
             if (mqtt_online) {
                 mqtt_client_manager_send_discovery();
+                mqtt_client_manager_send_metrics();
             }
             
             // Предупреждение при низкой памяти
@@ -102,10 +120,15 @@ void app_main(void) {
     }
     ESP_ERROR_CHECK(ret);
     ESP_LOGI(TAG, "NVS initialized");
+    pm_policy_init();  // DFS и light sleep (если включено в Kconfig)
     
     // Шаг 2: Инициализация Node Registry
     ESP_LOGI(TAG, "[Step 2/7] Initializing Node Registry...");
     ESP_ERROR_CHECK(node_registry_init());
+    ESP_ERROR_CHECK(rule_engine_init());  // Правила из NVS, до приёма телеметрии
+    trace_ring_init();  // Трасса горячего пути mesh → MQTT (если включена в Kconfig)
+    dlog_init();        // Отложенный вывод логов горячего пути (если включён в Kconfig)
+    cjson_arena_install();  // cJSON сообщений - из арен задач (если включено в Kconfig)
     
     // Шаг 3: Инициализация Mesh Manager (ROOT режим)
     ESP_LOGI(TAG, "[Step 3/7] Initializing Mesh (ROOT mode)...");
@@ -121,6 +144,7 @@ void app_main(void) {
     };
     ESP_ERROR_CHECK(mesh_manager_init(&mesh_config));
     ESP_LOGI(TAG, "Mesh ID: %s, Channel: %d", ROOT_MESH_ID, ROOT_MESH_CHANNEL);
+    mesh_time_init(true);      // SNTP и маяки времени узлам (если включено в Kconfig)
     
     // Шаг 4: Запуск Mesh
     ESP_LOGI(TAG, "[Step 4/7] Starting Mesh network...");
@@ -186,6 +210,30 @@ void app_main(void) {
     ESP_ERROR_CHECK(climate_logic_init());
     ESP_LOGI(TAG, "Climate Fallback Logic initialized");
     
+    // CPU/стек задач, heap и очереди - в hydro/metrics и /metrics (если включено в Kconfig)
+    instrumentation_start();
+    
+#ifdef CONFIG_ROOT_ROLLUP_ENABLE
+    // Минутные агрегаты telemetry (hydro/rollup/{node_id})
+    if (telemetry_rollup_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Telemetry rollups not started");
+    }
+#endif
+
+#ifdef CONFIG_ROOT_BACKPRESSURE_ENABLE
+    // Подсказки темпа узлам при перегрузке очередей / MQTT offline
+    if (backpressure_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Backpressure not started");
+    }
+#endif
+
+#ifdef CONFIG_ROOT_HTTP_API_ENABLE
+    // Локальный HTTP/WebSocket API (не критичен для работы - ошибка не фатальна)
+    if (local_api_start() != ESP_OK) {
+        ESP_LOGW(TAG, "Local HTTP API not started");
+    }
+#endif
+    
     ESP_LOGI(TAG, "========================================");
     ESP_LOGI(TAG, "=== ROOT NODE Running ===");
     ESP_LOGI(TAG, "Mesh ID: %s", ROOT_MESH_ID);
@@ -193,8 +241,15 @@ void app_main(void) {
     ESP_LOGI(TAG, "========================================");
     
     // Запуск задачи мониторинга
-    // Stack увеличен в 2 раза для безопасности: 4096 → 8192
-    xTaskCreate(root_monitoring_task, "root_monitor", 8192, NULL, 5, NULL);
+    rtos_static_task_create(&root_monitor, root_monitoring_task, "root_monitor", NULL, 5, NULL);
+    
+#ifdef CONFIG_ROOT_LOADGEN_ENABLE
+    // Синтетическая нагрузка для измерения ёмкости (только для стенда!)
+    load_generator_start();
+#endif
+    
+    // Где оказались буферы и сколько внутренней RAM осталось радио и DMA
+    mem_policy_report();
     
     ESP_LOGI(TAG, "All systems operational. ROOT node ready.");
 }
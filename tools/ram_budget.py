@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""
+Таблица RAM бюджета прошивки по ELF (common/rtos_static)
+
+При RTOS_STATIC_ALLOC=y стеки, TCB, очереди, мьютексы и таймеры лежат в
+.bss под именами rtos_budget_<вид>_<имя>. Скрипт собирает их в таблицу
+по объектам и добавляет крупнейшие остальные статические буферы.
+
+    idf.py ram_budget                       # build/ram_budget.md
+    python tools/ram_budget.py build/node_ph.elf
+    python tools/ram_budget.py build/root_node.elf --limit 180000
+"""
+
+import argparse
+import shutil
+import subprocess
+import sys
+
+PREFIX = "rtos_budget_"
+
+# Вид хранилища -> колонка таблицы
+KINDS = [
+    ("stack", "stack"),
+    ("tcb", "tcb"),
+    ("qbuf", "queue"),
+    ("queue", "queue"),
+    ("mutex", "mutex"),
+    ("timer", "timer"),
+]
+COLUMNS = ["stack", "tcb", "queue", "mutex", "timer"]
+
+# .bss / .data (nm: b B d D), PSRAM (.ext_ram.bss) учитывается отдельно
+STATIC_TYPES = "bBdD"
+
+
+def find_nm(explicit):
+    if explicit:
+        return explicit
+    for name in ("xtensa-esp32s3-elf-nm", "xtensa-esp32-elf-nm", "riscv32-esp-elf-nm", "nm"):
+        path = shutil.which(name)
+        if path:
+            return path
+    sys.exit("nm not found, use --nm")
+
+
+def read_symbols(nm, elf):
+    """(name, size, type, addr) статических объектов"""
+    out = subprocess.run([nm, "-S", elf], check=True, capture_output=True, text=True).stdout
+    symbols = []
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) != 4 or parts[2] not in STATIC_TYPES:
+            continue
+        addr, size, kind, name = parts
+        symbols.append((name, int(size, 16), kind, int(addr, 16)))
+    return symbols
+
+
+def split_budget(name):
+    """rtos_budget_stack_ph_main -> ("stack", "ph_main")"""
+    rest = name[len(PREFIX):]
+    for kind, column in KINDS:
+        if rest.startswith(kind + "_"):
+            return column, rest[len(kind) + 1:]
+    return None, rest
+
+
+def is_psram(addr):
+    # Окно внешней RAM ESP32 / ESP32-S3
+    return 0x3F800000 <= addr < 0x3FC00000 or 0x3C000000 <= addr < 0x3E000000
+
+
+def build_report(symbols, top):
+    objects = {}
+    other = []
+    internal = 0
+    psram = 0
+
+    for name, size, _, addr in symbols:
+        if is_psram(addr):
+            psram += size
+        else:
+            internal += size
+
+        if name.startswith(PREFIX):
+            column, obj = split_budget(name)
+            if column is None:
+                other.append((name, size, addr))
+                continue
+            row = objects.setdefault(obj, dict.fromkeys(COLUMNS, 0))
+            row[column] += size
+        else:
+            other.append((name, size, addr))
+
+    lines = ["# RAM budget", ""]
+    budget_total = 0
+    if objects:
+        lines.append("| object | " + " | ".join(COLUMNS) + " | total |")
+        lines.append("|---" * (len(COLUMNS) + 2) + "|")
+        totals = dict.fromkeys(COLUMNS, 0)
+        for obj, row in sorted(objects.items(), key=lambda kv: -sum(kv[1].values())):
+            row_total = sum(row.values())
+            budget_total += row_total
+            for c in COLUMNS:
+                totals[c] += row[c]
+            cells = [str(row[c]) if row[c] else "" for c in COLUMNS]
+            lines.append(f"| {obj} | " + " | ".join(cells) + f" | {row_total} |")
+        lines.append("| **total** | " + " | ".join(str(totals[c]) for c in COLUMNS)
+                     + f" | **{budget_total}** |")
+    else:
+        lines.append("No rtos_budget_* symbols: RTOS_STATIC_ALLOC=n, "
+                     "tasks and queues are allocated from heap at runtime.")
+
+    lines += ["", f"## Largest other static objects (top {top})", "",
+              "| symbol | bytes | region |", "|---|---|---|"]
+    for name, size, addr in sorted(other, key=lambda s: -s[1])[:top]:
+        lines.append(f"| {name} | {size} | {'psram' if is_psram(addr) else 'internal'} |")
+
+    lines += ["", "## Totals", "",
+              f"- RTOS static objects: {budget_total} bytes",
+              f"- all .bss/.data internal: {internal} bytes",
+              f"- all .bss/.data psram: {psram} bytes"]
+    return "\n".join(lines) + "\n", internal
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Static RAM budget of firmware ELF")
+    parser.add_argument("elf", help="Firmware ELF (build/<project>.elf)")
+    parser.add_argument("--nm", help="nm of the target toolchain (default: search PATH)")
+    parser.add_argument("--top", type=int, default=15, help="Other static objects to list")
+    parser.add_argument("--out", help="Also write the table to this markdown file")
+    parser.add_argument("--limit", type=int,
+                        help="Fail if internal .bss/.data exceeds this many bytes")
+    args = parser.parse_args()
+
+    report, internal = build_report(read_symbols(find_nm(args.nm), args.elf), args.top)
+    print(report, end="")
+
+    if args.out:
+        with open(args.out, "w", encoding="utf-8") as f:
+            f.write(report)
+
+    if args.limit is not None and internal > args.limit:
+        print(f"RAM budget exceeded: {internal} > {args.limit} bytes", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
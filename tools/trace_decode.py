@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+"""
+Декодер бинарной трассы ROOT (common/trace_ring) - гистограммы задержек по этапам
+
+Вход: бинарный дамп из hydro/trace/data или лог монитора с блоком
+TRACE-BEGIN ... TRACE-END (дамп в UART).
+
+    mosquitto_sub -t hydro/trace/data -C 1 > trace.bin &
+    mosquitto_pub -t hydro/trace/dump -n
+    python tools/trace_decode.py trace.bin
+
+    python tools/trace_decode.py monitor.log
+"""
+
+import argparse
+import base64
+import struct
+import sys
+
+TRACE_RING_MAGIC = 0x31525448
+
+EV_SYNC = 0
+EV_MESH_RECV = 1
+EV_PARSED = 2
+EV_REGISTRY = 3
+EV_MQTT_ENQUEUE = 4
+EV_MQTT_PUBLISHED = 5
+EV_MQTT_ACK = 6
+
+EVENT_NAMES = {
+    EV_SYNC: "sync",
+    EV_MESH_RECV: "mesh_recv",
+    EV_PARSED: "parsed",
+    EV_REGISTRY: "registry",
+    EV_MQTT_ENQUEUE: "mqtt_enqueue",
+    EV_MQTT_PUBLISHED: "mqtt_published",
+    EV_MQTT_ACK: "mqtt_ack",
+}
+
+# Этапы одного сообщения (по flow)
+FLOW_STAGES = [
+    ("recv -> parsed", EV_MESH_RECV, EV_PARSED),
+    ("parsed -> registry", EV_PARSED, EV_REGISTRY),
+    ("registry -> enqueue", EV_REGISTRY, EV_MQTT_ENQUEUE),
+    ("enqueue -> published", EV_MQTT_ENQUEUE, EV_MQTT_PUBLISHED),
+    ("recv -> published (total)", EV_MESH_RECV, EV_MQTT_PUBLISHED),
+]
+
+HEADER = struct.Struct("<IBBHII")
+CORE_HEADER = struct.Struct("<BBH")
+RECORD = struct.Struct("<IIHBB")
+
+
+def load_dump(path):
+    """Бинарный дамп или base64 блок из лога"""
+    with open(path, "rb") as f:
+        raw = f.read()
+
+    if len(raw) >= 4 and struct.unpack_from("<I", raw)[0] == TRACE_RING_MAGIC:
+        return raw
+
+    text = raw.decode("utf-8", errors="ignore").splitlines()
+    chunks = None
+    for line in text:
+        # Префикс монитора (время, цвет) допускается
+        if "TRACE-BEGIN" in line:
+            chunks = []
+        elif "TRACE-END" in line and chunks is not None:
+            return base64.b64decode("".join(chunks))
+        elif chunks is not None:
+            chunks.append(line.strip().split()[-1] if line.strip() else "")
+
+    raise ValueError("No trace dump found (neither binary nor TRACE-BEGIN block)")
+
+
+def parse_dump(data):
+    magic, version, cores, record_size, cpu_mhz, dropped = HEADER.unpack_from(data, 0)
+    if magic != TRACE_RING_MAGIC:
+        raise ValueError("Bad magic")
+    if version != 1 or record_size != RECORD.size:
+        raise ValueError(f"Unsupported dump version {version} / record size {record_size}")
+
+    pos = HEADER.size
+    rings = {}
+    for _ in range(cores):
+        core, _, count = CORE_HEADER.unpack_from(data, pos)
+        pos += CORE_HEADER.size
+        records = []
+        for _ in range(count):
+            cycles, arg, flow, event, _ = RECORD.unpack_from(data, pos)
+            pos += RECORD.size
+            records.append((cycles, arg, flow, event))
+        rings[core] = records
+
+    return {"cpu_mhz": cpu_mhz, "dropped": dropped, "rings": rings}
+
+
+def signed32(value):
+    value &= 0xFFFFFFFF
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def core_rate_mhz(records, default_mhz):
+    """Частота ядра по соседним SYNC (DFS меняет её на ходу)"""
+    syncs = [(c, a) for c, a, _, e in records if e == EV_SYNC]
+    rates = []
+    for (c0, a0), (c1, a1) in zip(syncs, syncs[1:]):
+        dus = (a1 - a0) & 0xFFFFFFFF
+        # Счётчик тактов переполняется за ~18 с - длинные интервалы неоднозначны
+        if 0 < dus < 10_000_000:
+            rates.append(((c1 - c0) & 0xFFFFFFFF) / dus)
+    if not rates:
+        return float(default_mhz)
+    rates.sort()
+    return rates[len(rates) // 2]
+
+
+def to_timeline(dump):
+    """Записи всех ядер -> (время мкс, core, event, flow, arg)"""
+    events = []
+    for core, records in dump["rings"].items():
+        mhz = core_rate_mhz(records, dump["cpu_mhz"])
+        sync_idx = [i for i, r in enumerate(records) if r[3] == EV_SYNC]
+        if not sync_idx:
+            continue
+
+        # Развёртка 32-битного esp_timer в SYNC (переполняется за ~71 мин)
+        anchors = {}
+        base = 0
+        prev = None
+        for i in sync_idx:
+            us = records[i][1]
+            if prev is not None and us < prev:
+                base += 1 << 32
+            prev = us
+            anchors[i] = (records[i][0], base + us)
+
+        # Каждая запись - от ближайшего предшествующего SYNC (вперёд до ~18 с);
+        # начало кольца до первого SYNC - назад от него
+        anchor = anchors[sync_idx[0]]
+        for i, (cycles, arg, flow, event) in enumerate(records):
+            if i in anchors:
+                anchor = anchors[i]
+            a_cycles, a_us = anchor
+            if i < sync_idx[0]:
+                t_us = a_us + signed32(cycles - a_cycles) / mhz
+            else:
+                t_us = a_us + ((cycles - a_cycles) & 0xFFFFFFFF) / mhz
+            if event != EV_SYNC:
+                events.append((t_us, core, event, flow, arg))
+
+    events.sort()
+    return events
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return 0.0
+    k = min(len(sorted_values) - 1, int(round(p / 100.0 * (len(sorted_values) - 1))))
+    return sorted_values[k]
+
+
+def print_histogram(name, values):
+    values = sorted(values)
+    print(f"\n{name}: n={len(values)}", end="")
+    if not values:
+        print()
+        return
+    print(f"  p50={percentile(values, 50):.1f}us  p90={percentile(values, 90):.1f}us  "
+          f"p99={percentile(values, 99):.1f}us  max={values[-1]:.1f}us")
+
+    # Логарифмические корзины (степени двойки мкс)
+    buckets = {}
+    for v in values:
+        b = 0
+        while (1 << b) < v:
+            b += 1
+        buckets[b] = buckets.get(b, 0) + 1
+
+    peak = max(buckets.values())
+    for b in range(min(buckets), max(buckets) + 1):
+        count = buckets.get(b, 0)
+        bar = "#" * (count * 40 // peak) if count else ""
+        print(f"  <= {1 << b:>8} us | {count:>6} {bar}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode ROOT hot-path trace dump")
+    parser.add_argument("dump", help="Binary dump or monitor log with TRACE-BEGIN block")
+    parser.add_argument("--events", action="store_true", help="Print decoded event timeline")
+    args = parser.parse_args()
+
+    try:
+        dump = parse_dump(load_dump(args.dump))
+    except (OSError, ValueError, struct.error) as e:
+        print(f"Error: {e}", file=sys.stderr)
+        return 1
+
+    total = sum(len(r) for r in dump["rings"].values())
+    print(f"Cores: {len(dump['rings'])}, records: {total}, cpu: {dump['cpu_mhz']} MHz, "
+          f"overwritten since last dump: {dump['dropped']}")
+
+    events = to_timeline(dump)
+
+    if args.events:
+        t0 = events[0][0] if events else 0
+        for t_us, core, event, flow, arg in events:
+            print(f"{(t_us - t0) / 1000:12.3f} ms  core{core}  {EVENT_NAMES.get(event, event):<15} "
+                  f"flow={flow:<5} arg={arg}")
+
+    # Первое появление каждого события в flow
+    flows = {}
+    for t_us, core, event, flow, arg in events:
+        if flow:
+            flows.setdefault(flow, {}).setdefault(event, t_us)
+
+    for name, start, end in FLOW_STAGES:
+        deltas = [f[end] - f[start] for f in flows.values()
+                  if start in f and end in f and f[end] >= f[start]]
+        print_histogram(name, deltas)
+
+    # publish -> ack (QoS 1) по msg_id
+    published = {}
+    acks = []
+    for t_us, core, event, flow, arg in events:
+        if event == EV_MQTT_PUBLISHED and arg:
+            published[arg] = t_us
+        elif event == EV_MQTT_ACK and arg in published:
+            acks.append(t_us - published.pop(arg))
+    print_histogram("published -> broker ack (QoS 1)", acks)
+
+    incomplete = sum(1 for f in flows.values() if EV_MESH_RECV in f and EV_MQTT_PUBLISHED not in f)
+    print(f"\nFlows: {len(flows)}, not published (dropped/filtered/cut by ring): {incomplete}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())